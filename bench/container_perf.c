@@ -0,0 +1,609 @@
+/*
+ *  Container and allocator benchmarks.
+ *
+ *  Measures the basic operations of csnip's containers, to help
+ *  choose between them:
+ *
+ *  - ringbuf and ringbuf2:  pushing and then popping batches of
+ *    elements; the time is per element pushed and popped.  ringbuf
+ *    does it one element at a time with the value macros, ringbuf2
+ *    through its contiguous areas.
+ *
+ *  - mempool versus malloc:  allocating a batch of items and freeing
+ *    them again; replacing random items of a large live set, which
+ *    fragments the heap; and scanning the live items after such
+ *    churn, which shows the effect of fragmentation on locality.  As
+ *    a reference, the churn is also done with malloc and mixed sizes.
+ *
+ *  - arr:  appending with csnip_arr_Push(), growing the array from
+ *    empty, versus into reserved space.
+ *
+ *  - list:  traversing a dlist, with nodes linked in memory order or
+ *    shuffled, versus scanning an array of the nodes or of the values.
+ *
+ *  The output is JSON by default, for archiving and comparing the
+ *  results over time; the "bench_results" build target runs the suite
+ *  and writes it to bench-results/container_perf.json.
+ *
+ *  Usage:  container_perf [options], see -h.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/arr.h>
+#include <csnip/bench.h>
+#include <csnip/cext.h>
+#include <csnip/list.h>
+#include <csnip/mem.h>
+#include <csnip/mempool.h>
+#include <csnip/perfctr.h>
+#include <csnip/ringbuf.h>
+#include <csnip/ringbuf2.h>
+#include <csnip/rng.h>
+#include <csnip/rng_mt.h>
+#include <csnip/runif.h>
+#include <csnip/util.h>
+#include <csnip/x.h>
+
+static const size_t batch_sizes[] = { 1, 8, 64, 512 };
+
+/* Ring buffer capacity; at least the largest batch */
+#define RB_CAP		1024
+
+/* Live set sizes for the allocators, and array and list lengths */
+static const size_t alloc_sizes[] = { 1024, 1 << 18 };
+static const size_t arr_sizes[] = { 1024, 1 << 16, 1 << 20, 1 << 24 };
+static const size_t list_sizes[] = { 1024, 1 << 16, 1 << 20, 1 << 22 };
+
+/* Random replacements per iteration of the churn benchmarks */
+#define CHURN_OPS	(1 << 16)
+
+static rng R;
+
+/* Random permutation of 0 .. n - 1 */
+static size_t* random_perm(size_t n)
+{
+	size_t* p;
+	mem_Alloc(n, p, _);
+	for (size_t i = 0; i < n; ++i)
+		p[i] = i;
+	for (size_t i = n - 1; i > 0; --i) {
+		const size_t j = (size_t)runif_getull(&R, i);
+		Swap(p[i], p[j]);
+	}
+	return p;
+}
+
+/* Ring buffers */
+
+typedef struct {
+	size_t batch;
+	uint64_t arr[RB_CAP];
+} rb_bench;
+
+static void bm_ringbuf(bench* B, void* arg, uint64_t iters)
+{
+	rb_bench* rb = arg;
+	const size_t batch = rb->batch;
+	int head, len;
+	const int N = RB_CAP;
+	int err = 0;
+	uint64_t sum = 0;
+
+	ringbuf_Init(head, len, N);
+	for (uint64_t i = 0; i < iters; ++i) {
+		for (size_t j = 0; j < batch; ++j)
+			ringbuf_PushTail(head, len, N, rb->arr, j, err);
+		for (size_t j = 0; j < batch; ++j) {
+			uint64_t v;
+			ringbuf_PopHead(head, len, N, rb->arr, v, err);
+			sum += v;
+		}
+	}
+	bench_DoNotOptimize(sum);
+	if (err != 0) {
+		fprintf(stderr, "error: ringbuf error %d\n", err);
+		exit(1);
+	}
+}
+
+static void bm_ringbuf2(bench* B, void* arg, uint64_t iters)
+{
+	rb_bench* rb = arg;
+	const size_t batch = rb->batch;
+	ringbuf2 Q = ringbuf2_make(RB_CAP);
+	uint64_t sum = 0;
+
+	for (uint64_t i = 0; i < iters; ++i) {
+		size_t idx[2], len[2];
+		size_t n;
+
+		/* Write the batch */
+		n = 0;
+		const int nw = ringbuf2_get_write_areas(&Q, &idx[0], &len[0],
+						&idx[1], &len[1]);
+		for (int a = 0; a < nw && n < batch; ++a) {
+			const size_t k = Min(len[a], batch - n);
+			for (size_t j = 0; j < k; ++j)
+				rb->arr[idx[a] + j] = n + j;
+			n += k;
+		}
+		ringbuf2_add_written(&Q, n);
+
+		/* Read it back */
+		n = 0;
+		const int nr = ringbuf2_get_read_areas(&Q, &idx[0], &len[0],
+						&idx[1], &len[1]);
+		for (int a = 0; a < nr && n < batch; ++a) {
+			const size_t k = Min(len[a], batch - n);
+			for (size_t j = 0; j < k; ++j)
+				sum += rb->arr[idx[a] + j];
+			n += k;
+		}
+		ringbuf2_add_read(&Q, n);
+	}
+	bench_DoNotOptimize(sum);
+}
+
+static void run_ringbuf(bench* B)
+{
+	rb_bench rb;
+	char name[64];
+	for (size_t i = 0; i < Static_len(batch_sizes); ++i) {
+		rb.batch = batch_sizes[i];
+		snprintf(name, sizeof name, "ringbuf/push-pop/batch=%zu",
+			rb.batch);
+		bench_run(B, name, bm_ringbuf, &rb, rb.batch, NULL);
+		snprintf(name, sizeof name, "ringbuf2/push-pop/batch=%zu",
+			rb.batch);
+		bench_run(B, name, bm_ringbuf2, &rb, rb.batch, NULL);
+	}
+}
+
+/* Allocators */
+
+/* Pool item, the size of a typical small node */
+typedef struct {
+	uint64_t v[8];
+} item;
+
+CSNIP_MEMPOOL_DEF_TYPE(item_pool_s, item)
+typedef struct item_pool_s item_pool;
+CSNIP_MEMPOOL_DECL_FUNCS(static cext_unused, item_pool_, item, item_pool)
+CSNIP_MEMPOOL_DEF_FUNCS(static cext_unused, item_pool_, item, item_pool)
+
+typedef struct {
+	size_t n;		/* Live set size */
+	item** live;
+	item_pool pool;
+	const size_t* victims;	/* Items to replace, CHURN_OPS of them */
+	const size_t* sizes;	/* Allocation sizes for malloc-mixed */
+} alloc_bench;
+
+/* Allocate and free items by the given allocator.  The pool allocator
+ * is inlined, the same as malloc would be called directly.
+ */
+#define ALLOC_pool(A, sz)	item_pool_alloc_item(&(A)->pool, &err)
+#define FREE_pool(A, p)		item_pool_free_item(&(A)->pool, (p))
+#define ALLOC_malloc(A, sz)	((item*)malloc(sizeof(item)))
+#define FREE_malloc(A, p)	free(p)
+#define ALLOC_mixed(A, sz)	((item*)malloc(sz))
+#define FREE_mixed(A, p)	free(p)
+
+#define DEFINE_ALLOC_BENCH(kind) \
+	/* Allocate n items and free them in the same order */ \
+	static void bm_burst_##kind(bench* B, void* arg, uint64_t iters) \
+	{ \
+		alloc_bench* A = arg; \
+		int err = 0; \
+		for (uint64_t i = 0; i < iters; ++i) { \
+			for (size_t j = 0; j < A->n; ++j) { \
+				A->live[j] = ALLOC_##kind(A, sizeof(item)); \
+				A->live[j]->v[0] = j; \
+			} \
+			for (size_t j = 0; j < A->n; ++j) \
+				FREE_##kind(A, A->live[j]); \
+		} \
+		if (err) { \
+			fprintf(stderr, "error: out of memory\n"); \
+			exit(1); \
+		} \
+	} \
+	\
+	/* Replace random items of the live set */ \
+	static void churn_##kind(alloc_bench* A) \
+	{ \
+		int err = 0; \
+		for (size_t j = 0; j < CHURN_OPS; ++j) { \
+			const size_t k = A->victims[j]; \
+			FREE_##kind(A, A->live[k]); \
+			A->live[k] = ALLOC_##kind(A, A->sizes[j]); \
+			A->live[k]->v[0] = k; \
+		} \
+		if (err) { \
+			fprintf(stderr, "error: out of memory\n"); \
+			exit(1); \
+		} \
+	} \
+	\
+	static void bm_churn_##kind(bench* B, void* arg, uint64_t iters) \
+	{ \
+		for (uint64_t i = 0; i < iters; ++i) \
+			churn_##kind(arg); \
+	} \
+	\
+	static void setup_##kind(alloc_bench* A) \
+	{ \
+		int err = 0; \
+		for (size_t j = 0; j < A->n; ++j) { \
+			A->live[j] = ALLOC_##kind(A, A->sizes[j % CHURN_OPS]); \
+			A->live[j]->v[0] = j; \
+		} \
+		if (err) { \
+			fprintf(stderr, "error: out of memory\n"); \
+			exit(1); \
+		} \
+	} \
+	\
+	static void teardown_##kind(alloc_bench* A) \
+	{ \
+		for (size_t j = 0; j < A->n; ++j) \
+			FREE_##kind(A, A->live[j]); \
+	}
+
+DEFINE_ALLOC_BENCH(pool)
+DEFINE_ALLOC_BENCH(malloc)
+DEFINE_ALLOC_BENCH(mixed)
+
+/* Read the live items, in the order of the live set */
+static void bm_scan(bench* B, void* arg, uint64_t iters)
+{
+	alloc_bench* A = arg;
+	uint64_t sum = 0;
+	for (uint64_t i = 0; i < iters; ++i) {
+		for (size_t j = 0; j < A->n; ++j)
+			sum += A->live[j]->v[0];
+	}
+	bench_DoNotOptimize(sum);
+}
+
+static void run_alloc(bench* B)
+{
+	/* Random victims and sizes, 16 to 256 bytes for malloc-mixed */
+	size_t* victims;
+	size_t* sizes;
+	mem_Alloc(CHURN_OPS, victims, _);
+	mem_Alloc(CHURN_OPS, sizes, _);
+	for (size_t j = 0; j < CHURN_OPS; ++j)
+		sizes[j] = sizeof(item) + (size_t)runif_getull(&R, 192);
+
+	char name[64];
+	for (size_t i = 0; i < Static_len(alloc_sizes); ++i) {
+		alloc_bench A = {
+			.n = alloc_sizes[i],
+			.victims = victims,
+			.sizes = sizes,
+		};
+		mem_Alloc(A.n, A.live, _);
+		for (size_t j = 0; j < CHURN_OPS; ++j)
+			victims[j] = (size_t)runif_getull(&R, A.n - 1);
+
+#define RUN(kind, label) \
+		do { \
+			snprintf(name, sizeof name, "%s/burst/n=%zu", \
+				label, A.n); \
+			bench_run(B, name, bm_burst_##kind, &A, A.n, NULL); \
+			setup_##kind(&A); \
+			snprintf(name, sizeof name, "%s/churn/n=%zu", \
+				label, A.n); \
+			bench_run(B, name, bm_churn_##kind, &A, \
+				CHURN_OPS, NULL); \
+			snprintf(name, sizeof name, "%s/scan-after-churn/n=%zu", \
+				label, A.n); \
+			bench_run(B, name, bm_scan, &A, A.n, NULL); \
+			teardown_##kind(&A); \
+		} while (0)
+
+		/* The pool starts with the capacity for the live set */
+		int err = 0;
+		A.pool = item_pool_init_with_cap(A.n, &err);
+		if (err) {
+			fprintf(stderr, "error: out of memory\n");
+			exit(1);
+		}
+		RUN(pool, "mempool");
+		item_pool_deinit(&A.pool);
+
+		RUN(malloc, "malloc");
+		RUN(mixed, "malloc-mixed");
+#undef RUN
+
+		mem_Free(A.live);
+	}
+
+	mem_Free(victims);
+	mem_Free(sizes);
+}
+
+/* Arrays */
+
+typedef struct {
+	size_t n;
+	int reserve;
+} arr_bench;
+
+static void bm_arr_push(bench* B, void* arg, uint64_t iters)
+{
+	arr_bench* P = arg;
+	for (uint64_t i = 0; i < iters; ++i) {
+		uint64_t* a = NULL;
+		size_t n = 0, cap = 0;
+		int err = 0;
+		if (P->reserve) {
+			bench_pause(B);
+			arr_Reserve(a, n, cap, P->n, err);
+			bench_resume(B);
+		}
+		for (size_t j = 0; j < P->n; ++j)
+			arr_Push(a, n, cap, j, err);
+		bench_ClobberMemory();
+		bench_pause(B);
+		if (err) {
+			fprintf(stderr, "error: out of memory\n");
+			exit(1);
+		}
+		arr_Deinit(a, n, cap);
+		bench_resume(B);
+	}
+}
+
+static void run_arr(bench* B)
+{
+	char name[64];
+	for (size_t i = 0; i < Static_len(arr_sizes); ++i) {
+		arr_bench P = { .n = arr_sizes[i], .reserve = 0 };
+		snprintf(name, sizeof name, "arr/push-grow/n=%zu", P.n);
+		bench_run(B, name, bm_arr_push, &P, P.n, NULL);
+		P.reserve = 1;
+		snprintf(name, sizeof name, "arr/push-reserved/n=%zu", P.n);
+		bench_run(B, name, bm_arr_push, &P, P.n, NULL);
+	}
+}
+
+/* Lists */
+
+typedef struct node_s node;
+struct node_s {
+	node* prev;
+	node* next;
+	uint64_t val;
+};
+
+typedef struct {
+	size_t n;
+	node* nodes;
+	uint64_t* vals;
+	node* head;
+	node* tail;
+} list_bench;
+
+/* Link the nodes in the order given by perm, or in memory order */
+static void link_nodes(list_bench* L, const size_t* perm)
+{
+	dlist_Init(L->head, L->tail, prev, next);
+	for (size_t i = 0; i < L->n; ++i) {
+		node* el = &L->nodes[perm ? perm[i] : i];
+		dlist_PushTail(L->head, L->tail, prev, next, el);
+	}
+}
+
+static void bm_dlist(bench* B, void* arg, uint64_t iters)
+{
+	list_bench* L = arg;
+	uint64_t sum = 0;
+	for (uint64_t i = 0; i < iters; ++i) {
+		for (const node* p = L->head; p != NULL; p = p->next)
+			sum += p->val;
+	}
+	bench_DoNotOptimize(sum);
+}
+
+static void bm_array_nodes(bench* B, void* arg, uint64_t iters)
+{
+	list_bench* L = arg;
+	uint64_t sum = 0;
+	for (uint64_t i = 0; i < iters; ++i) {
+		for (size_t j = 0; j < L->n; ++j)
+			sum += L->nodes[j].val;
+	}
+	bench_DoNotOptimize(sum);
+}
+
+static void bm_array(bench* B, void* arg, uint64_t iters)
+{
+	list_bench* L = arg;
+	uint64_t sum = 0;
+	for (uint64_t i = 0; i < iters; ++i) {
+		for (size_t j = 0; j < L->n; ++j)
+			sum += L->vals[j];
+	}
+	bench_DoNotOptimize(sum);
+}
+
+static void run_list(bench* B)
+{
+	char name[64];
+	for (size_t i = 0; i < Static_len(list_sizes); ++i) {
+		list_bench L = { .n = list_sizes[i] };
+		mem_Alloc(L.n, L.nodes, _);
+		mem_Alloc(L.n, L.vals, _);
+		for (size_t j = 0; j < L.n; ++j)
+			L.nodes[j].val = L.vals[j] = j;
+
+		link_nodes(&L, NULL);
+		snprintf(name, sizeof name, "list/dlist-seq/n=%zu", L.n);
+		bench_run(B, name, bm_dlist, &L, L.n, NULL);
+
+		size_t* perm = random_perm(L.n);
+		link_nodes(&L, perm);
+		mem_Free(perm);
+		snprintf(name, sizeof name, "list/dlist-shuffled/n=%zu", L.n);
+		bench_run(B, name, bm_dlist, &L, L.n, NULL);
+
+		snprintf(name, sizeof name, "list/array-nodes/n=%zu", L.n);
+		bench_run(B, name, bm_array_nodes, &L, L.n, NULL);
+		snprintf(name, sizeof name, "list/array/n=%zu", L.n);
+		bench_run(B, name, bm_array, &L, L.n, NULL);
+
+		mem_Free(L.nodes);
+		mem_Free(L.vals);
+	}
+}
+
+/* Driver */
+
+typedef enum {
+	G_RINGBUF,
+	G_ALLOC,
+	G_ARR,
+	G_LIST,
+	G_N
+} group_t;
+
+static const char* const group_name[] = { "ringbuf", "alloc", "arr", "list" };
+
+static unsigned parse_groups(const char* s)
+{
+	if (strcmp(s, "all") == 0)
+		return (1u << G_N) - 1;
+	unsigned mask = 0;
+	while (*s) {
+		const size_t l = strcspn(s, ",");
+		int i;
+		for (i = 0; i < G_N; ++i) {
+			if (strlen(group_name[i]) == l
+			  && strncmp(group_name[i], s, l) == 0)
+			{
+				break;
+			}
+		}
+		if (i == G_N) {
+			fprintf(stderr, "error: group `%.*s' unknown.\n",
+				(int)l, s);
+			exit(1);
+		}
+		mask |= 1u << i;
+		s += l;
+		if (*s == ',')
+			++s;
+	}
+	return mask;
+}
+
+static void usage(void)
+{
+	puts(
+	"Container and allocator benchmarks.\n"
+	"\n"
+	"-h             Display help and exit.\n"
+	"-g groups      Benchmark groups (comma separated):  ringbuf, alloc,\n"
+	"               arr, list, or all (default).\n"
+	"-f format      Output format:  text, csv or json (default).\n"
+	"-o file        Write the results to file instead of stdout.\n"
+	"-s #           Number of samples.\n"
+	"-T #           Minimum time per sample in seconds.\n"
+	"-c #           CPU to pin the process to.\n"
+	"-p events      Performance counters to report (none).\n"
+	"\n"
+	"Times and event counts are reported per element or item.\n"
+	);
+}
+
+int main(int argc, char** argv)
+{
+	unsigned groups = (1u << G_N) - 1;
+	const char* outfile = NULL;
+	bench_opts opts;
+	bench_opts_init(&opts);
+	opts.format = CSNIP_BENCH_JSON;
+
+	int c;
+	while ((c = x_getopt(argc, argv, "c:f:g:ho:p:s:T:")) != -1) {
+		switch (c) {
+		case 'c':
+			opts.cpu = atoi(x_optarg);
+			break;
+		case 'f':
+			if (bench_parse_format(x_optarg, &opts.format) != 0) {
+				fprintf(stderr, "error: output format `%s' "
+				  "unknown.\n", x_optarg);
+				exit(1);
+			}
+			break;
+		case 'g':
+			groups = parse_groups(x_optarg);
+			break;
+		case 'o':
+			outfile = x_optarg;
+			break;
+		case 'p':
+			if (perfctr_parse(x_optarg, &opts.counters) != 0) {
+				fprintf(stderr, "error: event list `%s' "
+				  "invalid.\n", x_optarg);
+				exit(1);
+			}
+			break;
+		case 's':
+			opts.samples = atoi(x_optarg);
+			break;
+		case 'T':
+			opts.min_time = atof(x_optarg);
+			break;
+		case 'h':
+			usage();
+			return 0;
+		default:
+			usage();
+			return 1;
+		}
+	}
+
+	if (outfile) {
+		opts.out = fopen(outfile, "w");
+		if (opts.out == NULL) {
+			perror(outfile);
+			exit(1);
+		}
+	}
+
+	rng_mt_state S;
+	const uint32_t seed = 12345;
+	rng_mt_seed(&S, 1, &seed);
+	R = rng_mt_makerng(&S);
+
+	bench B;
+	if (bench_init(&B, &opts) != 0) {
+		fprintf(stderr, "warning: could not pin to CPU %d.\n",
+			opts.cpu);
+	}
+	if (groups & (1u << G_RINGBUF))
+		run_ringbuf(&B);
+	if (groups & (1u << G_ALLOC))
+		run_alloc(&B);
+	if (groups & (1u << G_ARR))
+		run_arr(&B);
+	if (groups & (1u << G_LIST))
+		run_list(&B);
+	bench_finish(&B);
+
+	if (outfile && fclose(opts.out) != 0) {
+		perror(outfile);
+		exit(1);
+	}
+
+	return 0;
+}
@@ -0,0 +1,772 @@
+/*
+ *  Hash table benchmark.
+ *
+ *  Measures insertion, successful and unsuccessful lookup, erasure and
+ *  iteration for lphash_table, and for std::unordered_map as a
+ *  reference when built with C++ support.  The tables map integer or
+ *  string keys to integers.
+ *
+ *  The table sizes sweep from L1 cache resident up to a given maximum
+ *  (up to several GB), at load factors from 0.25 to 0.66, the maximum
+ *  of lphash_table.  The load factor is set by reserving the
+ *  capacity before inserting; std::unordered_map is given the same
+ *  number of entries.  Lookups draw keys uniformly or by a Zipf
+ *  distribution, where a few keys are looked up most of the time.
+ *
+ *  Times are per operation.  The bytes_per_entry metric is the memory
+ *  of the table (excluding key strings) divided by the number of
+ *  entries.
+ *
+ *  Usage:  hashtable_perf [options], see -h.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/bench.h>
+#include <csnip/cext.h>
+#include <csnip/lphash_table.h>
+#include <csnip/mem.h>
+#include <csnip/perfctr.h>
+#include <csnip/rng.h>
+#include <csnip/rng_mt.h>
+#include <csnip/runif.h>
+#include <csnip/util.h>
+#include <csnip/x.h>
+
+#include "hashtable_perf.h"
+
+/* lphash_table */
+
+typedef uint64_t int_key_t;
+typedef const char* str_key_t;
+
+typedef struct {
+	int_key_t key;
+	uint64_t val;
+} int_entry;
+
+typedef struct {
+	str_key_t key;
+	uint64_t val;
+} str_entry;
+
+CSNIP_LPHASH_TABLE_DEF_TYPE(int_table_s, int_entry)
+typedef struct int_table_s int_table;
+CSNIP_LPHASH_TABLE_DEF_FUNCS(static cext_unused, int_table_,
+		int_key_t, int_entry, int_table,
+		k1, k2, e,
+		ht_hash_int(k1),
+		k1 == k2,
+		e.key)
+
+CSNIP_LPHASH_TABLE_DEF_TYPE(str_table_s, str_entry)
+typedef struct str_table_s str_table;
+CSNIP_LPHASH_TABLE_DEF_FUNCS(static cext_unused, str_table_,
+		str_key_t, str_entry, str_table,
+		k1, k2, e,
+		ht_hash_str(k1),
+		strcmp(k1, k2) == 0,
+		e.key)
+
+/* Implementation of ht_impl for a table type */
+#define DEFINE_LPHASH_IMPL(kt) \
+	static void* lp_##kt##_make(size_t n, size_t cap) \
+	{ \
+		int err = 0; \
+		kt##_table* T = kt##_table_make(&err); \
+		if (err == 0) \
+			kt##_table_reserve(T, &err, cap * 2 / 3); \
+		if (err) { \
+			fprintf(stderr, "error: out of memory\n"); \
+			exit(1); \
+		} \
+		return T; \
+	} \
+	\
+	static void lp_##kt##_destroy(void* T) \
+	{ \
+		kt##_table_free(T); \
+	} \
+	\
+	static void lp_##kt##_insert(void* T, const void* keys, size_t n) \
+	{ \
+		const kt##_key_t* k = keys; \
+		int err; \
+		for (size_t i = 0; i < n; ++i) { \
+			const kt##_entry e = { k[i], i }; \
+			kt##_table_insert(T, &err, e); \
+		} \
+	} \
+	\
+	static size_t lp_##kt##_find(void* T, const void* keys, size_t n) \
+	{ \
+		const kt##_key_t* k = keys; \
+		size_t found = 0; \
+		for (size_t i = 0; i < n; ++i) \
+			found += (kt##_table_find(T, k[i]) != NULL); \
+		return found; \
+	} \
+	\
+	static size_t lp_##kt##_erase(void* T, const void* keys, size_t n) \
+	{ \
+		const kt##_key_t* k = keys; \
+		size_t found = 0; \
+		int err; \
+		for (size_t i = 0; i < n; ++i) \
+			found += kt##_table_remove(T, &err, k[i]); \
+		return found; \
+	} \
+	\
+	static uint64_t lp_##kt##_iterate(void* T) \
+	{ \
+		const kt##_table* t = T; \
+		uint64_t sum = 0; \
+		for (size_t i = kt##_table_firstoccupiedslot(t); \
+		  i < t->cap; \
+		  i = kt##_table_nextoccupiedslot(t, i)) \
+		{ \
+			sum += t->entry[i].val; \
+		} \
+		return sum; \
+	} \
+	\
+	static size_t lp_##kt##_bytes(void* T) \
+	{ \
+		const kt##_table* t = T; \
+		return sizeof *t + t->cap * (sizeof(kt##_entry) + 1); \
+	} \
+	\
+	static double lp_##kt##_load(void* T) \
+	{ \
+		const kt##_table* t = T; \
+		return (double)t->size / t->cap; \
+	} \
+	\
+	static const ht_impl lp_##kt##_impl = { \
+		"lphash", \
+		lp_##kt##_make, lp_##kt##_destroy, \
+		lp_##kt##_insert, lp_##kt##_find, lp_##kt##_erase, \
+		lp_##kt##_iterate, lp_##kt##_bytes, lp_##kt##_load \
+	};
+
+DEFINE_LPHASH_IMPL(int)
+DEFINE_LPHASH_IMPL(str)
+
+/* Keys */
+
+typedef enum {
+	K_INT,
+	K_STR,
+} keytype_t;
+
+static const char* const keytype_name[] = { "int", "str" };
+
+static const ht_impl* const impls[][2] = {
+	{ &lp_int_impl, &lp_str_impl },
+#if defined(HASHTABLE_PERF_STD)
+	{ &std_int_impl, &std_str_impl },
+#endif
+};
+
+/* Length of the strings, including the terminator and padding */
+#define STR_STRIDE	24
+
+/* The i-th key.  Distinct i give distinct keys, since the mix is a
+ * bijection, so the keys from 0 .. n are in the table, and the keys
+ * from a disjoint range are not.
+ */
+static uint64_t int_key(uint64_t i)
+{
+	/* SplitMix64 output function */
+	i += 0x9e3779b97f4a7c15ull;
+	i = (i ^ (i >> 30)) * 0xbf58476d1ce4e5b9ull;
+	i = (i ^ (i >> 27)) * 0x94d049bb133111ebull;
+	return i ^ (i >> 31);
+}
+
+static void str_key(char* buf, uint64_t i)
+{
+	snprintf(buf, STR_STRIDE, "%016llx", (unsigned long long)int_key(i));
+}
+
+/* Key arrays, 8 bytes per key, with the string storage if needed */
+typedef struct {
+	void* keys;
+	char* pool;
+} keyset;
+
+/* Allocate a keyset for n keys */
+static void keyset_alloc(keyset* K, keytype_t kt, size_t n)
+{
+	K->pool = NULL;
+	if (kt == K_INT) {
+		uint64_t* ik;
+		mem_Alloc(n, ik, _);
+		K->keys = ik;
+	} else {
+		const char** sk;
+		mem_Alloc(n, sk, _);
+		mem_Alloc(n * STR_STRIDE, K->pool, _);
+		K->keys = sk;
+	}
+}
+
+/* Set the i-th key of K to the key with index j */
+static void keyset_set(keyset* K, keytype_t kt, size_t i, uint64_t j)
+{
+	if (kt == K_INT) {
+		((uint64_t*)K->keys)[i] = int_key(j);
+	} else {
+		char* p = &K->pool[i * STR_STRIDE];
+		str_key(p, j);
+		((const char**)K->keys)[i] = p;
+	}
+}
+
+static void keyset_make(keyset* K, keytype_t kt, uint64_t first, size_t n)
+{
+	keyset_alloc(K, kt, n);
+	for (size_t i = 0; i < n; ++i)
+		keyset_set(K, kt, i, first + i);
+}
+
+static void keyset_free(keyset* K)
+{
+	mem_Free(K->keys);
+	if (K->pool)
+		mem_Free(K->pool);
+}
+
+/* Key distributions */
+
+typedef enum {
+	D_UNIFORM,
+	D_ZIPF,
+} dist_t;
+
+static const char* const dist_name[] = { "uniform", "zipf" };
+
+/* Zipf distribution on 1 .. n with exponent s, by rejection-inversion
+ * (Hörmann and Derflinger, 1996).
+ */
+typedef struct {
+	double s, n;
+	double h_x1, h_n, sv;
+} zipf;
+
+static double zipf_helper1(double x)	/* log1p(x) / x */
+{
+	return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x / 2;
+}
+
+static double zipf_helper2(double x)	/* expm1(x) / x */
+{
+	return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x / 2;
+}
+
+static double zipf_H(const zipf* Z, double x)
+{
+	const double lx = log(x);
+	return zipf_helper2((1 - Z->s) * lx) * lx;
+}
+
+static double zipf_h(const zipf* Z, double x)
+{
+	return exp(-Z->s * log(x));
+}
+
+static double zipf_Hinv(const zipf* Z, double x)
+{
+	double t = x * (1 - Z->s);
+	if (t < -1)
+		t = -1;
+	return exp(zipf_helper1(t) * x);
+}
+
+static void zipf_init(zipf* Z, size_t n, double s)
+{
+	Z->s = s;
+	Z->n = (double)n;
+	Z->h_x1 = zipf_H(Z, 1.5) - 1;
+	Z->h_n = zipf_H(Z, Z->n + 0.5);
+	Z->sv = 2 - zipf_Hinv(Z, zipf_H(Z, 2.5) - zipf_h(Z, 2));
+}
+
+/* Rank in 0 .. n - 1 */
+static size_t zipf_get(const zipf* Z, const rng* R)
+{
+	for (;;) {
+		const double u = Z->h_n
+			+ runif_getd(R, 1.0) * (Z->h_x1 - Z->h_n);
+		const double x = zipf_Hinv(Z, u);
+		double k = floor(x + 0.5);
+		if (k < 1)
+			k = 1;
+		else if (k > Z->n)
+			k = Z->n;
+		if (k - x <= Z->sv || u >= zipf_H(Z, k + 0.5) - zipf_h(Z, k))
+			return (size_t)k - 1;
+	}
+}
+
+/* Make a sequence of L lookup keys for a table with keys 0 .. n; keys
+ * first + r for rank r drawn from the distribution.
+ */
+static void make_lookups(keyset* K,
+			keytype_t kt,
+			dist_t dist,
+			double s,
+			const rng* R,
+			uint64_t first,
+			size_t n,
+			size_t L)
+{
+	zipf Z;
+	zipf_init(&Z, n, s);
+	keyset_alloc(K, kt, L);
+	for (size_t i = 0; i < L; ++i) {
+		const size_t r = (dist == D_ZIPF ? zipf_get(&Z, R)
+				: (size_t)runif_getull(R, n - 1));
+		keyset_set(K, kt, i, first + r);
+	}
+}
+
+/* Benchmark functions */
+
+typedef struct {
+	const ht_impl* I;
+	void* T;
+	size_t n, cap;
+	const void* keys;	/* The keys in the table */
+	const void* lookups;	/* Keys to look up or erase */
+	size_t nlookups;
+	size_t expect;		/* Number of lookups to succeed */
+} ht_bench;
+
+static void check(const ht_bench* H, size_t found)
+{
+	if (found != H->expect) {
+		fprintf(stderr, "error: %s: found %zu keys, expected %zu\n",
+			H->I->name, found, H->expect);
+		exit(1);
+	}
+}
+
+static void bm_insert(bench* B, void* arg, uint64_t iters)
+{
+	ht_bench* H = arg;
+	for (uint64_t i = 0; i < iters; ++i) {
+		bench_pause(B);
+		void* T = H->I->make(H->n, H->cap);
+		bench_resume(B);
+		H->I->insert(T, H->keys, H->n);
+		bench_ClobberMemory();
+		bench_pause(B);
+		H->I->destroy(T);
+		bench_resume(B);
+	}
+}
+
+static void bm_find(bench* B, void* arg, uint64_t iters)
+{
+	ht_bench* H = arg;
+	for (uint64_t i = 0; i < iters; ++i) {
+		size_t found = H->I->find(H->T, H->lookups, H->nlookups);
+		bench_DoNotOptimize(found);
+		check(H, found);
+	}
+}
+
+/* Erases keys, and inserts them again untimed */
+static void bm_erase(bench* B, void* arg, uint64_t iters)
+{
+	ht_bench* H = arg;
+	for (uint64_t i = 0; i < iters; ++i) {
+		size_t found = H->I->erase(H->T, H->keys, H->nlookups);
+		bench_DoNotOptimize(found);
+		bench_pause(B);
+		check(H, found);
+		H->I->insert(H->T, H->keys, H->nlookups);
+		bench_resume(B);
+	}
+}
+
+static void bm_iterate(bench* B, void* arg, uint64_t iters)
+{
+	ht_bench* H = arg;
+	for (uint64_t i = 0; i < iters; ++i) {
+		uint64_t sum = H->I->iterate(H->T);
+		bench_DoNotOptimize(sum);
+	}
+}
+
+/* Driver */
+
+typedef struct {
+	unsigned keytypes;	/* Bit masks */
+	unsigned dists;
+	unsigned impls;
+	const char* ops;	/* Comma separated */
+	double lf[8];
+	int nlf;
+	size_t min_bytes, max_bytes;
+	size_t nlookups;
+	double zipf_s;
+} config;
+
+static int has_op(const config* C, const char* op)
+{
+	const size_t len = strlen(op);
+	for (const char* p = C->ops; *p; ) {
+		const size_t l = strcspn(p, ",");
+		if (l == len && strncmp(p, op, len) == 0)
+			return 1;
+		p += l;
+		if (*p == ',')
+			++p;
+	}
+	return 0;
+}
+
+static void run(bench* B, const config* C, const ht_impl* I, keytype_t kt,
+		const keyset* keys, keyset look[2][2],
+		size_t n, size_t cap)
+{
+	char name[128];
+	ht_bench H = {
+		.I = I, .T = NULL, .n = n, .cap = cap,
+		.keys = keys->keys,
+	};
+
+#define NAME(op) \
+	snprintf(name, sizeof name, "%s/%s/%s/%zu", I->name, \
+		keytype_name[kt], op, n)
+
+	/* Build the table once for metrics and the other operations */
+	H.T = I->make(n, cap);
+	I->insert(H.T, keys->keys, n);
+	const double bpe = (double)I->bytes(H.T) / n;
+	const double load = I->load(H.T);
+
+#define METRICS() \
+	do { \
+		bench_metric(B, "bytes_per_entry", bpe); \
+		bench_metric(B, "load_factor", load); \
+	} while (0)
+
+	if (has_op(C, "insert")) {
+		/* Don't keep two tables around for large sizes */
+		I->destroy(H.T);
+		NAME("insert");
+		METRICS();
+		bench_run(B, name, bm_insert, &H, n, NULL);
+		H.T = I->make(n, cap);
+		I->insert(H.T, keys->keys, n);
+	}
+
+	for (int d = 0; d < 2; ++d) {
+		if (!(C->dists & (1u << d)))
+			continue;
+		char op[32];
+		H.nlookups = C->nlookups;
+		if (has_op(C, "find-hit")) {
+			snprintf(op, sizeof op, "find-hit-%s", dist_name[d]);
+			NAME(op);
+			METRICS();
+			H.lookups = look[d][0].keys;
+			H.expect = H.nlookups;
+			bench_run(B, name, bm_find, &H, H.nlookups, NULL);
+		}
+		if (has_op(C, "find-miss")) {
+			snprintf(op, sizeof op, "find-miss-%s", dist_name[d]);
+			NAME(op);
+			METRICS();
+			H.lookups = look[d][1].keys;
+			H.expect = 0;
+			bench_run(B, name, bm_find, &H, H.nlookups, NULL);
+		}
+	}
+
+	if (has_op(C, "erase")) {
+		NAME("erase");
+		METRICS();
+		H.nlookups = (n < C->nlookups ? n : C->nlookups);
+		H.expect = H.nlookups;
+		bench_run(B, name, bm_erase, &H, H.nlookups, NULL);
+	}
+
+	if (has_op(C, "iterate")) {
+		NAME("iterate");
+		METRICS();
+		bench_run(B, name, bm_iterate, &H, n, NULL);
+	}
+
+#undef NAME
+#undef METRICS
+
+	I->destroy(H.T);
+}
+
+static void run_keytype(bench* B, const config* C, keytype_t kt,
+			const rng* R)
+{
+	/* Bytes per slot of lphash_table, which determines the sizes */
+	const size_t slot = (kt == K_INT ? sizeof(int_entry)
+				: sizeof(str_entry)) + 1;
+
+	/* Capacities:  powers of 4, and the largest fitting power of 2 */
+	size_t caps[64];
+	int ncaps = 0;
+	for (size_t cap = 64; cap * slot <= C->max_bytes; cap *= 2) {
+		if (cap * slot < C->min_bytes)
+			continue;
+		const int pow4 = ((cap & 0x5555555555555555ull) != 0);
+		if (pow4 || 2 * cap * slot > C->max_bytes)
+			caps[ncaps++] = cap;
+	}
+	if (ncaps == 0)
+		return;
+
+	/* All keys in any of the tables */
+	double max_lf = 0;
+	for (int l = 0; l < C->nlf; ++l)
+		max_lf = (C->lf[l] > max_lf ? C->lf[l] : max_lf);
+	const size_t max_n = (size_t)(max_lf * caps[ncaps - 1]);
+	keyset keys;
+	keyset_make(&keys, kt, 0, max_n);
+
+	for (int c = 0; c < ncaps; ++c) {
+		for (int l = 0; l < C->nlf; ++l) {
+			const size_t n = (size_t)(C->lf[l] * caps[c]);
+			if (n == 0)
+				continue;
+
+			/* Lookups that hit (keys 0 .. n) and miss (from
+			 * max_n on), by distribution
+			 */
+			keyset look[2][2];
+			for (int d = 0; d < 2; ++d) {
+				if (!(C->dists & (1u << d)))
+					continue;
+				make_lookups(&look[d][0], kt, d, C->zipf_s,
+					R, 0, n, C->nlookups);
+				make_lookups(&look[d][1], kt, d, C->zipf_s,
+					R, max_n, n, C->nlookups);
+			}
+
+			for (size_t i = 0; i < Static_len(impls); ++i) {
+				if (C->impls & (1u << i))
+					run(B, C, impls[i][kt], kt, &keys,
+						look, n, caps[c]);
+			}
+
+			for (int d = 0; d < 2; ++d) {
+				if (!(C->dists & (1u << d)))
+					continue;
+				keyset_free(&look[d][0]);
+				keyset_free(&look[d][1]);
+			}
+		}
+	}
+
+	keyset_free(&keys);
+}
+
+/* Options */
+
+static size_t parse_size(const char* s)
+{
+	char* end;
+	double v = strtod(s, &end);
+	switch (*end) {
+	case 'k': case 'K':	v *= 1024; break;
+	case 'm': case 'M':	v *= 1024 * 1024; break;
+	case 'g': case 'G':	v *= 1024. * 1024 * 1024; break;
+	}
+	return (size_t)v;
+}
+
+/* Parse a comma separated list of names into a bit mask */
+static unsigned parse_names(const char* s,
+			const char* const* names,
+			int nnames,
+			const char* what)
+{
+	if (strcmp(s, "all") == 0)
+		return (1u << nnames) - 1;
+	unsigned mask = 0;
+	while (*s) {
+		const size_t l = strcspn(s, ",");
+		int i;
+		for (i = 0; i < nnames; ++i) {
+			if (strlen(names[i]) == l
+			  && strncmp(names[i], s, l) == 0)
+			{
+				break;
+			}
+		}
+		if (i == nnames) {
+			fprintf(stderr, "error: %s `%.*s' unknown.\n",
+				what, (int)l, s);
+			exit(1);
+		}
+		mask |= 1u << i;
+		s += l;
+		if (*s == ',')
+			++s;
+	}
+	return mask;
+}
+
+static void usage(void)
+{
+	puts(
+	"Hash table benchmark.\n"
+	"\n"
+	"-h             Display help and exit.\n"
+	"-i impls       Implementations:  lphash, std (C++ builds), or all.\n"
+	"-k keys        Key types:  int, str, or all.\n"
+	"-o ops         Operations (comma separated):  insert, find-hit,\n"
+	"               find-miss, erase, iterate.  Default:  all.\n"
+	"-d dists       Lookup key distributions:  uniform, zipf, or all.\n"
+	"-z s           Exponent of the Zipf distribution (0.99).\n"
+	"-l lfs         Load factors (comma separated; 0.25,0.33,0.5,0.66).\n"
+	"-m size        Minimum table size in bytes, with suffix K, M or G\n"
+	"               (0).\n"
+	"-M size        Maximum table size, e.g. 4G (64M).\n"
+	"-L #           Lookups per iteration (65536).\n"
+	"-f format      Output format:  text, csv or json.\n"
+	"-s #           Number of samples.\n"
+	"-T #           Minimum time per sample in seconds.\n"
+	"-c #           CPU to pin the process to.\n"
+	"-p events      Performance counters to report (none).\n"
+	"\n"
+	"Times and event counts are reported per operation.  Table sizes\n"
+	"are the powers of 4 (in slots of lphash_table) between the\n"
+	"minimum and maximum, and the largest power of 2.\n"
+	);
+}
+
+int main(int argc, char** argv)
+{
+	static const char* const impl_names[] = { "lphash", "std" };
+	config C = {
+		.keytypes = 3,
+		.dists = 3,
+		.impls = (1u << Static_len(impls)) - 1,
+		.ops = "insert,find-hit,find-miss,erase,iterate",
+		.lf = { 0.25, 0.33, 0.5, 0.66 },
+		.nlf = 4,
+		.min_bytes = 0,
+		.max_bytes = 64 << 20,
+		.nlookups = 1 << 16,
+		.zipf_s = 0.99,
+	};
+	bench_opts opts;
+	bench_opts_init(&opts);
+
+	int c;
+	while ((c = x_getopt(argc, argv, "c:d:f:hi:k:l:L:m:M:o:p:s:T:z:"))
+		!= -1)
+	{
+		switch (c) {
+		case 'c':
+			opts.cpu = atoi(x_optarg);
+			break;
+		case 'd':
+			C.dists = parse_names(x_optarg, dist_name, 2,
+					"distribution");
+			break;
+		case 'f':
+			if (bench_parse_format(x_optarg, &opts.format) != 0) {
+				fprintf(stderr, "error: output format `%s' "
+				  "unknown.\n", x_optarg);
+				exit(1);
+			}
+			break;
+		case 'i':
+			C.impls = parse_names(x_optarg, impl_names,
+					Static_len(impls), "implementation");
+			break;
+		case 'k':
+			C.keytypes = parse_names(x_optarg, keytype_name, 2,
+					"key type");
+			break;
+		case 'l': {
+			C.nlf = 0;
+			char* p = x_optarg;
+			while (*p && C.nlf < (int)Static_len(C.lf)) {
+				const double lf = strtod(p, &p);
+				if (lf <= 0 || lf > 2. / 3) {
+					fprintf(stderr, "error: load factor "
+					  "must be in (0, 2/3].\n");
+					exit(1);
+				}
+				C.lf[C.nlf++] = lf;
+				if (*p == ',')
+					++p;
+			}
+			break;
+		}
+		case 'L':
+			C.nlookups = strtoul(x_optarg, NULL, 10);
+			break;
+		case 'm':
+			C.min_bytes = parse_size(x_optarg);
+			break;
+		case 'M':
+			C.max_bytes = parse_size(x_optarg);
+			break;
+		case 'o':
+			C.ops = x_optarg;
+			break;
+		case 'p':
+			if (perfctr_parse(x_optarg, &opts.counters) != 0) {
+				fprintf(stderr, "error: event list `%s' "
+				  "invalid.\n", x_optarg);
+				exit(1);
+			}
+			break;
+		case 's':
+			opts.samples = atoi(x_optarg);
+			break;
+		case 'T':
+			opts.min_time = atof(x_optarg);
+			break;
+		case 'z':
+			C.zipf_s = atof(x_optarg);
+			break;
+		case 'h':
+			usage();
+			return 0;
+		default:
+			usage();
+			return 1;
+		}
+	}
+	if (C.nlookups == 0)
+		C.nlookups = 1;
+
+	rng_mt_state S;
+	const uint32_t seed = 12345;
+	rng_mt_seed(&S, 1, &seed);
+	const rng R = rng_mt_makerng(&S);
+
+	bench B;
+	if (bench_init(&B, &opts) != 0) {
+		fprintf(stderr, "warning: could not pin to CPU %d.\n",
+			opts.cpu);
+	}
+	for (int kt = 0; kt < 2; ++kt) {
+		if (C.keytypes & (1u << kt))
+			run_keytype(&B, &C, kt, &R);
+	}
+	bench_finish(&B);
+
+	return 0;
+}
@@ -0,0 +1,73 @@
+#ifndef HASHTABLE_PERF_H
+#define HASHTABLE_PERF_H
+
+/*  Hash table implementations measured by hashtable_perf.
+ *
+ *  Each implementation provides the operations on whole arrays of
+ *  keys, so that the indirect call through the table doesn't count
+ *  towards the time per operation.  Keys are uint64_t for integer
+ *  tables, and const char* for string tables; the tables map them to
+ *  uint64_t values.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <csnip/hash.h>
+
+typedef struct {
+	const char* name;
+
+	/* Create a table for n entries.  cap is the capacity of the
+	 * linear probing table for the load factor to be measured,
+	 * which other implementations may ignore.
+	 */
+	void* (*make)(size_t n, size_t cap);
+	void (*destroy)(void* T);
+
+	/* Insert keys[0 .. n), with values 0 .. n - 1 */
+	void (*insert)(void* T, const void* keys, size_t n);
+
+	/* Look up, or erase, keys[0 .. n); returns the number found */
+	size_t (*find)(void* T, const void* keys, size_t n);
+	size_t (*erase)(void* T, const void* keys, size_t n);
+
+	/* Sum of the values of all entries */
+	uint64_t (*iterate)(void* T);
+
+	/* Memory used by the table, in bytes, and its load factor */
+	size_t (*bytes)(void* T);
+	double (*load)(void* T);
+} ht_impl;
+
+/* Hash functions, the same for all implementations */
+
+static inline size_t ht_hash_int(uint64_t k)
+{
+	/* MurmurHash3's finalizer */
+	k ^= k >> 33;
+	k *= 0xff51afd7ed558ccdull;
+	k ^= k >> 33;
+	k *= 0xc4ceb9fe1a85ec53ull;
+	k ^= k >> 33;
+	return (size_t)k;
+}
+
+static inline size_t ht_hash_str(const char* s)
+{
+	return (size_t)csnip_hash_fnv64_s(s, CSNIP_FNV64_INIT);
+}
+
+#if defined(HASHTABLE_PERF_STD)
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* std::unordered_map, in hashtable_perf_std.cc */
+extern const ht_impl std_int_impl;
+extern const ht_impl std_str_impl;
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#endif /* HASHTABLE_PERF_H */
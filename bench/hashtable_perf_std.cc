@@ -0,0 +1,162 @@
+/*  std::unordered_map for hashtable_perf, as a reference.
+ *
+ *  The memory used by a table is counted by its allocator.  The
+ *  benchmark only has one table at a time, so a global count will do.
+ */
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+#include "hashtable_perf.h"
+
+namespace {
+
+size_t alloc_bytes = 0;
+
+template <class T>
+struct counting_allocator {
+	typedef T value_type;
+
+	counting_allocator() { }
+	template <class U>
+	counting_allocator(const counting_allocator<U>&) { }
+
+	T* allocate(size_t n)
+	{
+		alloc_bytes += n * sizeof(T);
+		return std::allocator<T>().allocate(n);
+	}
+
+	void deallocate(T* p, size_t n)
+	{
+		alloc_bytes -= n * sizeof(T);
+		std::allocator<T>().deallocate(p, n);
+	}
+};
+
+template <class T, class U>
+bool operator==(const counting_allocator<T>&, const counting_allocator<U>&)
+{
+	return true;
+}
+
+template <class T, class U>
+bool operator!=(const counting_allocator<T>&, const counting_allocator<U>&)
+{
+	return false;
+}
+
+struct int_hash {
+	size_t operator()(uint64_t k) const { return ht_hash_int(k); }
+};
+
+struct str_hash {
+	size_t operator()(const char* s) const { return ht_hash_str(s); }
+};
+
+struct str_equal {
+	bool operator()(const char* a, const char* b) const
+	{
+		return std::strcmp(a, b) == 0;
+	}
+};
+
+typedef std::unordered_map<uint64_t, uint64_t, int_hash,
+		std::equal_to<uint64_t>,
+		counting_allocator<std::pair<const uint64_t, uint64_t> > >
+	int_map;
+
+typedef std::unordered_map<const char*, uint64_t, str_hash, str_equal,
+		counting_allocator<std::pair<const char* const, uint64_t> > >
+	str_map;
+
+template <class Map>
+void* make(size_t n, size_t)
+{
+	Map* M = new Map;
+	M->reserve(n);
+	return M;
+}
+
+template <class Map>
+void destroy(void* T)
+{
+	delete static_cast<Map*>(T);
+}
+
+template <class Map>
+void insert(void* T, const void* keys, size_t n)
+{
+	Map& M = *static_cast<Map*>(T);
+	const typename Map::key_type* k =
+		static_cast<const typename Map::key_type*>(keys);
+	for (size_t i = 0; i < n; ++i)
+		M.insert(typename Map::value_type(k[i], i));
+}
+
+template <class Map>
+size_t find(void* T, const void* keys, size_t n)
+{
+	const Map& M = *static_cast<Map*>(T);
+	const typename Map::key_type* k =
+		static_cast<const typename Map::key_type*>(keys);
+	size_t found = 0;
+	for (size_t i = 0; i < n; ++i)
+		found += (M.find(k[i]) != M.end());
+	return found;
+}
+
+template <class Map>
+size_t erase(void* T, const void* keys, size_t n)
+{
+	Map& M = *static_cast<Map*>(T);
+	const typename Map::key_type* k =
+		static_cast<const typename Map::key_type*>(keys);
+	size_t found = 0;
+	for (size_t i = 0; i < n; ++i)
+		found += M.erase(k[i]);
+	return found;
+}
+
+template <class Map>
+uint64_t iterate(void* T)
+{
+	const Map& M = *static_cast<Map*>(T);
+	uint64_t sum = 0;
+	for (typename Map::const_iterator it = M.begin(); it != M.end(); ++it)
+		sum += it->second;
+	return sum;
+}
+
+template <class Map>
+size_t bytes(void*)
+{
+	return sizeof(Map) + alloc_bytes;
+}
+
+template <class Map>
+double load(void* T)
+{
+	return static_cast<Map*>(T)->load_factor();
+}
+
+template <class Map>
+ht_impl make_impl()
+{
+	ht_impl I = {
+		"std",
+		make<Map>, destroy<Map>,
+		insert<Map>, find<Map>, erase<Map>, iterate<Map>,
+		bytes<Map>, load<Map>
+	};
+	return I;
+}
+
+} // namespace
+
+extern "C" {
+const ht_impl std_int_impl = make_impl<int_map>();
+const ht_impl std_str_impl = make_impl<str_map>();
+}
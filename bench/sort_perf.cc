@@ -1,6 +1,7 @@
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 
 #include <algorithm>
@@ -8,6 +9,8 @@
 #define CSNIP_SHORT_NAMES
 #include <csnip/util.h>
 #include <csnip/arr.h>
+#include <csnip/bench.h>
+#include <csnip/perfctr.h>
 #include <csnip/sort.h>
 #include <csnip/x.h>
 
@@ -33,11 +36,6 @@ typedef enum {
 	K_CSTR,
 } sortkey_t;
 
-static double get_delta(struct timespec* b, struct timespec* a)
-{
-	return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec)/1.e9;
-}
-
 /* Integer sorting test */
 
 static int intcmp(const void* A, const void* B)
@@ -331,70 +329,80 @@ void check_cstr_instance(char** strarr, int nItem)
 
 /* Test execution */
 
-void sort_test(int nItem,
-		sort_method_t meth,
-		task_t task,
-		sortkey_t key_type)
-{
-	/* Allocate instance memory */
-	int* intarr = NULL;
-	char** strarr = NULL;
-	switch(key_type) {
-	case K_INT:	intarr = new int[nItem];	break;
-	case K_CSTR:	strarr = new char*[nItem];	break;
-	};
+struct sort_bench {
+	int nItem;
+	sort_method_t meth;
+	task_t task;
+	sortkey_t key_type;
+	int* intarr;
+	char** strarr;
+};
 
-	/* Execute test runs */
-	double t_total = 0;
-	int nIter = 0;
-	while (t_total < 10)
-	{
+static void sort_bench_fn(bench* B, void* arg, uint64_t iters)
+{
+	sort_bench* S = (sort_bench*)arg;
+	for (uint64_t i = 0; i < iters; ++i) {
 		/* Create instance to solve */
-		switch(key_type) {
+		bench_pause(B);
+		switch(S->key_type) {
 		case K_INT:
-			create_int_instance(intarr, nItem, task);
+			create_int_instance(S->intarr, S->nItem, S->task);
 			break;
 		case K_CSTR:
-			create_cstr_instance(strarr, nItem, task);
+			create_cstr_instance(S->strarr, S->nItem, S->task);
 			break;
 		};
+		bench_resume(B);
 
 		/* Test sort */
-		struct timespec t_start, t_end;
-		x_clock_gettime(X_CLOCK_MAYBE_MONOTONIC, &t_start);
-		switch(key_type) {
+		switch(S->key_type) {
 		case K_INT:
-			sort_int_instance(intarr, nItem, meth);
+			sort_int_instance(S->intarr, S->nItem, S->meth);
 			break;
 		case K_CSTR:
-			sort_cstr_instance(strarr, nItem, meth);
+			sort_cstr_instance(S->strarr, S->nItem, S->meth);
 			break;
 		};
-		x_clock_gettime(X_CLOCK_MAYBE_MONOTONIC, &t_end);
+		bench_ClobberMemory();
 
 		/* Check */
-		switch(key_type) {
+		bench_pause(B);
+		switch(S->key_type) {
 		case K_INT:
-			check_int_instance(intarr, nItem);
+			check_int_instance(S->intarr, S->nItem);
 			break;
 		case K_CSTR:
-			check_cstr_instance(strarr, nItem);
+			check_cstr_instance(S->strarr, S->nItem);
 			break;
 		};
+		bench_resume(B);
+	}
+}
 
-		/* Move up */
-		t_total += get_delta(&t_end, &t_start);
-		++nIter;
+void sort_test(bench* B,
+		const char* meth_name,
+		const char* task_name,
+		int nItem,
+		sort_method_t meth,
+		task_t task,
+		sortkey_t key_type)
+{
+	/* Allocate instance memory */
+	sort_bench S = { nItem, meth, task, key_type, NULL, NULL };
+	switch(key_type) {
+	case K_INT:	S.intarr = new int[nItem];	break;
+	case K_CSTR:	S.strarr = new char*[nItem];	break;
+	};
 
-	}
+	/* Run; times are per item sorted */
+	char name[128];
+	snprintf(name, sizeof name, "%s/%s/%s/%d", meth_name, task_name,
+		key_type == K_INT ? "int" : "cstr", nItem);
+	bench_run(B, name, sort_bench_fn, &S, nItem, NULL);
 
 	/* Free memory */
-	if (strarr)	delete[] strarr;
-	if (intarr)	delete[] intarr;
-
-	/* Output result */
-	std::printf("%g s for %d iterations -> %g s per iteration.\n",
-		t_total, nIter, t_total/nIter);
+	if (S.strarr)	delete[] S.strarr;
+	if (S.intarr)	delete[] S.intarr;
 }
 
 static void usage()
@@ -405,6 +413,7 @@ static void usage()
         "-h             Display help and exit.\n"
         "-N #           Number of items to sort.\n"
         "-m meth        Sort method to use. Possible choices:\n"
+        "                 all         (all of the following)\n"
         "                 std::sort   (STL algorithm)\n"
         "                 std::qsort  (libc qsort)\n"
         "                 Qsort       (csnip's Quicksort)\n"
@@ -421,19 +430,67 @@ static void usage()
 	"-k key		Key type. Possible choices:\n"
 	"                 int         (integer keys)\n"
 	"                 cstr        (C string keys)\n"
+	"-f format	Output format:  text, csv or json.\n"
+	"-s #		Number of samples.\n"
+	"-T #		Minimum time per sample in seconds.\n"
+	"-c #		CPU to pin the process to.\n"
+	"-p events	Performance counters to report:  all, hw (default),\n"
+	"		none, or a comma separated list of cycles,\n"
+	"		instructions, cache-misses, branch-misses,\n"
+	"		dTLB-misses and page-faults.\n"
+	"\n"
+	"Times and event counts are reported per item.\n"
 	);
 }
 
+static const struct {
+	const char* name;
+	sort_method_t m;
+} mtable[] = {
+	{ "std::sort",	M_STD_SORT },
+	{ "std::qsort",	M_STD_QSORT },
+	{ "Qsort",	M_CSNIP_QSORT },
+	{ "Heapsort",	M_CSNIP_HEAPSORT },
+	{ "Shellsort",	M_CSNIP_SHELLSORT },
+	{ NULL, M_STD_SORT }
+};
+
+static const struct {
+	const char* name;
+	task_t task;
+} ttable[] = {
+	{ "random",	T_RANDOM },
+	{ "inc",	T_INCREASING },
+	{ "dec",	T_DECREASING },
+	{ "dnf",	T_DNF },
+	{ "alleq",	T_ALLEQ },
+	{ "organpipe",	T_ORGANPIPE },
+	{ NULL, T_RANDOM }
+};
+
 int main(int argc, char** argv)
 {
-	sort_method_t meth = M_CSNIP_QSORT;
-	task_t task = T_RANDOM;
+	int meth = 2;		/* Index in mtable, or -1 for all */
+	int task = 0;		/* Index in ttable */
 	sortkey_t key_type = K_INT;
 	int nItem = 10000;
+	bench_opts opts;
+	bench_opts_init(&opts);
+	opts.counters = CSNIP_PERFCTR_HW;
 
 	int c;
-	while ((c = x_getopt(argc, argv, "k:m:N:t:h")) != -1) {
+	while ((c = x_getopt(argc, argv, "c:f:k:m:N:p:s:t:T:h")) != -1) {
 		switch (c) {
+		case 'c':
+			opts.cpu = atoi(x_optarg);
+			break;
+		case 'f':
+			if (bench_parse_format(x_optarg, &opts.format) != 0) {
+				fprintf(stderr, "error: output format `%s' "
+				  "unknown.\n", x_optarg);
+				exit(1);
+			}
+			break;
 		case 'k': {
 			if (strcmp(x_optarg, "int") == 0) {
 				key_type = K_INT;
@@ -443,21 +500,14 @@ int main(int argc, char** argv)
 			break;
 		}
 		case 'm': {
-			struct {
-				const char* name;
-				sort_method_t m;
-			} mtable[] = {
-			  { "std::sort",	M_STD_SORT },
-			  { "std::qsort",	M_STD_QSORT },
-			  { "Qsort",		M_CSNIP_QSORT },
-			  { "Heapsort",		M_CSNIP_HEAPSORT },
-			  { "Shellsort",	M_CSNIP_SHELLSORT },
-			  { NULL }
-			};
+			if (strcmp(x_optarg, "all") == 0) {
+				meth = -1;
+				break;
+			}
 			int i;
 			for (i = 0; mtable[i].name; ++i) {
 				if (strcmp(mtable[i].name, x_optarg) == 0) {
-					meth = mtable[i].m;
+					meth = i;
 					break;
 				}
 			}
@@ -472,23 +522,21 @@ int main(int argc, char** argv)
 			nItem = atoi(x_optarg);
 			break;
 		}
+		case 'p':
+			if (perfctr_parse(x_optarg, &opts.counters) != 0) {
+				fprintf(stderr, "error: event list `%s' "
+				  "invalid.\n", x_optarg);
+				exit(1);
+			}
+			break;
+		case 's':
+			opts.samples = atoi(x_optarg);
+			break;
 		case 't': {
-			struct {
-				const char* name;
-				task_t task;
-			} ttable[] = {
-			  { "random",		T_RANDOM },
-			  { "inc",		T_INCREASING },
-			  { "dec",		T_DECREASING },
-			  { "dnf",		T_DNF },
-			  { "alleq",		T_ALLEQ },
-			  { "organpipe",	T_ORGANPIPE },
-			  { NULL }
-			};
 			int i;
 			for (i = 0; ttable[i].name; ++i) {
 				if (strcmp(ttable[i].name, x_optarg) == 0) {
-					task = ttable[i].task;
+					task = i;
 					break;
 				}
 			}
@@ -499,6 +547,9 @@ int main(int argc, char** argv)
 			}
 			break;
 		}
+		case 'T':
+			opts.min_time = atof(x_optarg);
+			break;
 		case 'h':
 			usage();
 			exit(0);
@@ -509,7 +560,18 @@ int main(int argc, char** argv)
 	std::srand((unsigned int)time(NULL));
 
 	/* Run test */
-	sort_test(nItem, meth, task, key_type);
+	bench B;
+	if (bench_init(&B, &opts) != 0) {
+		fprintf(stderr, "warning: could not pin to CPU %d.\n",
+			opts.cpu);
+	}
+	for (int i = 0; mtable[i].name; ++i) {
+		if (meth >= 0 && i != meth)
+			continue;
+		sort_test(&B, mtable[i].name, ttable[task].name, nItem,
+			mtable[i].m, ttable[task].task, key_type);
+	}
+	bench_finish(&B);
 
 	return 0;
 }
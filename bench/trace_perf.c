@@ -0,0 +1,139 @@
+/*
+ *  Tracing overhead.
+ *
+ *  Measures the cost of recording trace events, per event, with
+ *  tracing enabled and disabled at run time.  A span recorded with
+ *  CSNIP_TRACE_SCOPE() is one event; CSNIP_TRACE_BEGIN() and
+ *  CSNIP_TRACE_END() are two.
+ *
+ *  Usage:  trace_perf [options], see -h.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/bench.h>
+#include <csnip/perfctr.h>
+#include <csnip/trace.h>
+#include <csnip/x.h>
+
+static void bm_instant(bench* B, void* arg, uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; ++i)
+		CSNIP_TRACE_INSTANT("instant");
+}
+
+static void bm_counter(bench* B, void* arg, uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; ++i)
+		CSNIP_TRACE_COUNTER("counter", (double)i);
+}
+
+static void bm_begin_end(bench* B, void* arg, uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; ++i) {
+		CSNIP_TRACE_BEGIN("span");
+		CSNIP_TRACE_END("span");
+	}
+}
+
+static void bm_scope(bench* B, void* arg, uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; ++i) {
+		CSNIP_TRACE_SCOPE("scope");
+		bench_ClobberMemory();
+	}
+}
+
+static void run_all(bench* B, const char* state)
+{
+	char name[64];
+	snprintf(name, sizeof name, "trace/instant/%s", state);
+	bench_run(B, name, bm_instant, NULL, 1, NULL);
+	snprintf(name, sizeof name, "trace/counter/%s", state);
+	bench_run(B, name, bm_counter, NULL, 1, NULL);
+	snprintf(name, sizeof name, "trace/begin-end/%s", state);
+	bench_run(B, name, bm_begin_end, NULL, 2, NULL);
+	snprintf(name, sizeof name, "trace/scope/%s", state);
+	bench_run(B, name, bm_scope, NULL, 1, NULL);
+}
+
+static void usage(void)
+{
+	puts(
+	"Tracing overhead.\n"
+	"\n"
+	"-h             Display help and exit.\n"
+	"-n #           Events per thread buffer (65536).\n"
+	"-f format      Output format:  text, csv or json.\n"
+	"-s #           Number of samples.\n"
+	"-T #           Minimum time per sample in seconds.\n"
+	"-c #           CPU to pin the process to.\n"
+	"-p events      Performance counters to report (none).\n"
+	"\n"
+	"Times and event counts are reported per trace event.\n"
+	);
+}
+
+int main(int argc, char** argv)
+{
+	size_t cap = 1 << 16;
+	bench_opts opts;
+	bench_opts_init(&opts);
+
+	int c;
+	while ((c = x_getopt(argc, argv, "c:f:hn:p:s:T:")) != -1) {
+		switch (c) {
+		case 'c':
+			opts.cpu = atoi(x_optarg);
+			break;
+		case 'f':
+			if (bench_parse_format(x_optarg, &opts.format) != 0) {
+				fprintf(stderr, "error: output format `%s' "
+				  "unknown.\n", x_optarg);
+				exit(1);
+			}
+			break;
+		case 'n':
+			cap = strtoul(x_optarg, NULL, 10);
+			break;
+		case 'p':
+			if (perfctr_parse(x_optarg, &opts.counters) != 0) {
+				fprintf(stderr, "error: event list `%s' "
+				  "invalid.\n", x_optarg);
+				exit(1);
+			}
+			break;
+		case 's':
+			opts.samples = atoi(x_optarg);
+			break;
+		case 'T':
+			opts.min_time = atof(x_optarg);
+			break;
+		case 'h':
+			usage();
+			return 0;
+		default:
+			usage();
+			return 1;
+		}
+	}
+
+	bench B;
+	if (bench_init(&B, &opts) != 0) {
+		fprintf(stderr, "warning: could not pin to CPU %d.\n",
+			opts.cpu);
+	}
+	run_all(&B, "disabled");
+	if (trace_enable(cap) != 0) {
+		fprintf(stderr, "error: invalid buffer size.\n");
+		exit(1);
+	}
+	run_all(&B, "enabled");
+	trace_disable();
+	bench_finish(&B);
+
+	return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ *  Throughput of format string expansion.
+ *
+ *  Expands a report line template with csnip_fmt_Str(), and with a
+ *  template compiled once by csnip_fmt_Compile() and rendered by
+ *  csnip_fmt_Render(), and reports the time per expansion.
+ *
+ *  Usage:  fmt_perf [n]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/fmt.h>
+#include <csnip/time.h>
+#include <csnip/x.h>
+
+static double now(void)
+{
+	struct timespec ts;
+	x_clock_gettime(CSNIP_X_CLOCK_MONOTONIC, &ts);
+	return time_timespec_as_double(ts);
+}
+
+static void report(const char* name, double t, size_t n, size_t nbytes)
+{
+	printf("%-28s %8.2f ns/expansion   (%.2f bytes)\n", name,
+		t * 1e9 / n, (double)nbytes / n);
+}
+
+static const char* fmtstr =
+	"${date} ${host} ${service}[${pid}]: request ${id} from ${client} "
+	"took ${ms} ms, status ${status}, ${bytes} bytes sent";
+
+static const char* keys[] = {
+	"date", "host", "service", "pid", "id", "client", "ms", "status",
+	"bytes", NULL
+};
+
+static const char* vals[] = {
+	"2024-03-01T12:00:00", "web-frontend-07", "httpd", "31337",
+	"8f14e45fceea167a", "203.0.113.45", "12.5", "200", "48213"
+};
+
+int main(int argc, char** argv)
+{
+	const size_t n = (argc > 1 ? (size_t)atol(argv[1]) : 200000);
+
+	const char* kv[2 * sizeof vals / sizeof *vals + 1];
+	size_t nkv = 0;
+	for (size_t i = 0; keys[i]; ++i) {
+		kv[nkv++] = keys[i];
+		kv[nkv++] = vals[i];
+	}
+	kv[nkv] = NULL;
+
+	size_t nbytes = 0;
+	double t = now();
+	for (size_t i = 0; i < n; ++i) {
+		char* r = NULL;
+		fmt_Str(fmtstr, '$', s, e, val, next,
+			fmt_ScanShStyle(s, e, next),
+			fmt_ListMatch(s, e, val, kv),
+			/* Nop */,
+			r,
+			_);
+		nbytes += strlen(r);
+		free(r);
+	}
+	report("fmt_Str", now() - t, n, nbytes);
+
+	nbytes = 0;
+	t = now();
+	fmt_template T;
+	fmt_Compile(fmtstr, '$', s, e, next,
+		fmt_ScanShStyle(s, e, next), keys, &T, _);
+	for (size_t i = 0; i < n; ++i) {
+		char* r = NULL;
+		fmt_Render(&T, vals, r, _);
+		nbytes += strlen(r);
+		free(r);
+	}
+	report("fmt_Compile + fmt_Render", now() - t, n, nbytes);
+
+	/* Rendering into a reused buffer */
+	size_t vlens[sizeof vals / sizeof *vals];
+	for (size_t i = 0; i < sizeof vals / sizeof *vals; ++i)
+		vlens[i] = strlen(vals[i]);
+	char* buf = malloc(fmt_template_size(&T, vals, vlens) + 1);
+	nbytes = 0;
+	t = now();
+	for (size_t i = 0; i < n; ++i)
+		nbytes += fmt_template_render_to(&T, vals, vlens, buf);
+	report("fmt_template_render_to", now() - t, n, nbytes);
+
+	free(buf);
+	fmt_template_free(&T);
+	return 0;
+}
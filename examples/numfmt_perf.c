@@ -0,0 +1,84 @@
+/*
+ *  Throughput of the numfmt conversions.
+ *
+ *  Formats random integers and doubles with numfmt and, as a
+ *  baseline, with snprintf(), and reports the time per conversion.
+ *
+ *  Usage:  numfmt_perf [n]
+ */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/mem.h>
+#include <csnip/numfmt.h>
+#include <csnip/time.h>
+#include <csnip/x.h>
+
+static double now(void)
+{
+	struct timespec ts;
+	x_clock_gettime(CSNIP_X_CLOCK_MONOTONIC, &ts);
+	return time_timespec_as_double(ts);
+}
+
+static void report(const char* name, double t, size_t n, size_t nbytes)
+{
+	printf("%-28s %8.2f ns/conversion   (%.2f bytes)\n", name,
+		t * 1e9 / n, (double)nbytes / n);
+}
+
+int main(int argc, char** argv)
+{
+	const size_t n = (argc > 1 ? (size_t)atol(argv[1]) : 1000000);
+	uint64_t* iv;
+	double* dv;
+	mem_Alloc(n, iv, _);
+	mem_Alloc(n, dv, _);
+
+	uint64_t s = 0x9e3779b97f4a7c15U;
+	for (size_t i = 0; i < n; ++i) {
+		s ^= s << 13;
+		s ^= s >> 7;
+		s ^= s << 17;
+		iv[i] = s >> (s % 64);
+		dv[i] = (double)(s >> 11) / 9007199254740992.0
+			* (double)(1 + i % 1000);
+	}
+
+	char buf[64];
+	size_t nbytes;
+	double t;
+
+	nbytes = 0;
+	t = now();
+	for (size_t i = 0; i < n; ++i)
+		nbytes += (size_t)snprintf(buf, sizeof buf, "%" PRIu64, iv[i]);
+	report("snprintf %" PRIu64, now() - t, n, nbytes);
+
+	nbytes = 0;
+	t = now();
+	for (size_t i = 0; i < n; ++i)
+		nbytes += numfmt_u64(buf, iv[i]);
+	report("numfmt_u64", now() - t, n, nbytes);
+
+	nbytes = 0;
+	t = now();
+	for (size_t i = 0; i < n; ++i)
+		nbytes += (size_t)snprintf(buf, sizeof buf, "%.17g", dv[i]);
+	report("snprintf %.17g", now() - t, n, nbytes);
+
+	nbytes = 0;
+	t = now();
+	for (size_t i = 0; i < n; ++i)
+		nbytes += numfmt_double(buf, dv[i]);
+	report("numfmt_double", now() - t, n, nbytes);
+
+	mem_Free(iv);
+	mem_Free(dv);
+	return 0;
+}
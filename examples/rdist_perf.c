@@ -0,0 +1,139 @@
+/*
+ *  Throughput of the rdist samplers.
+ *
+ *  Reports the time per variate for each sampler, together with
+ *  textbook reference methods (Box-Muller for normals, inversion for
+ *  exponentials) as a baseline.
+ *
+ *  Usage:  rdist_perf [n]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/mem.h>
+#include <csnip/rdist.h>
+#include <csnip/rng.h>
+#include <csnip/rng_mt.h>
+#include <csnip/runif.h>
+#include <csnip/time.h>
+#include <csnip/x.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static double now(void)
+{
+	struct timespec ts;
+	x_clock_gettime(CSNIP_X_CLOCK_MONOTONIC, &ts);
+	return time_timespec_as_double(ts);
+}
+
+static double checksum;
+
+static void report(const char* name, double t, size_t n, const double* a)
+{
+	double s = 0;
+	for (size_t i = 0; i < n; ++i)
+		s += a[i];
+	checksum += s;
+	printf("%-28s %8.2f ns/variate   (mean %.4f)\n", name,
+		t * 1e9 / n, s / n);
+}
+
+static void report_ul(const char* name,
+			double t,
+			size_t n,
+			const unsigned long* a)
+{
+	double s = 0;
+	for (size_t i = 0; i < n; ++i)
+		s += a[i];
+	checksum += s;
+	printf("%-28s %8.2f ns/variate   (mean %.4f)\n", name,
+		t * 1e9 / n, s / n);
+}
+
+static void box_muller(const rng* R, size_t n, double* out)
+{
+	for (size_t i = 0; i + 1 < n; i += 2) {
+		const double u1 = 1.0 - runif_getd(R, 1.0);
+		const double u2 = runif_getd(R, 1.0);
+		const double r = sqrt(-2.0 * log(u1));
+		out[i] = r * cos(2 * M_PI * u2);
+		out[i + 1] = r * sin(2 * M_PI * u2);
+	}
+	if (n % 2)
+		out[n - 1] = 0;
+}
+
+static void exp_inversion(const rng* R, size_t n, double* out)
+{
+	for (size_t i = 0; i < n; ++i)
+		out[i] = -log1p(-runif_getd(R, 1.0));
+}
+
+int main(int argc, char** argv)
+{
+	size_t n = 10000000;
+	if (argc > 1)
+		n = strtoul(argv[1], NULL, 10);
+
+	rng_mt_state S;
+	const uint32_t seed = 12345;
+	rng_mt_seed(&S, 1, &seed);
+	const rng R = rng_mt_makerng(&S);
+
+	double* a;
+	unsigned long* u;
+	mem_Alloc(n, a, _);
+	mem_Alloc(n, u, _);
+
+	double t;
+
+	/* Raw uniform cost for reference */
+	t = now();
+	for (size_t i = 0; i < n; ++i)
+		a[i] = runif_getd(&R, 1.0);
+	report("uniform (runif_getd)", now() - t, n, a);
+
+#define TIME(name, call) \
+	do { \
+		t = now(); \
+		call; \
+		report(name, now() - t, n, a); \
+	} while (0)
+
+#define TIME_UL(name, call) \
+	do { \
+		t = now(); \
+		call; \
+		report_ul(name, now() - t, n, u); \
+	} while (0)
+
+	TIME("normal (Box-Muller)", box_muller(&R, n, a));
+	TIME("normal (ziggurat)", rdist_normal_fill(&R, n, a));
+	TIME("exponential (inversion)", exp_inversion(&R, n, a));
+	TIME("exponential (ziggurat)", rdist_exp_fill(&R, n, a));
+	TIME("gamma(0.5)", rdist_gamma_fill(&R, 0.5, n, a));
+	TIME("gamma(4)", rdist_gamma_fill(&R, 4, n, a));
+	TIME_UL("poisson(4)", rdist_poisson_fill(&R, 4, n, u));
+	TIME_UL("poisson(100)", rdist_poisson_fill(&R, 100, n, u));
+	TIME_UL("binomial(20, 0.3)", rdist_binomial_fill(&R, 20, 0.3, n, u));
+	TIME_UL("binomial(1000, 0.4)",
+		rdist_binomial_fill(&R, 1000, 0.4, n, u));
+
+#undef TIME
+#undef TIME_UL
+
+	/* Defeat dead code elimination */
+	if (checksum == 42.0)
+		puts("");
+
+	mem_Free(a);
+	mem_Free(u);
+	return 0;
+}
@@ -0,0 +1,711 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <csnip/csnip_conf.h>
+
+#ifdef CSNIP_CONF__HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+#include <pthread.h>
+#endif
+
+/* io_uring, via the raw system calls.  IORING_FEAT_CUR_PERSONALITY
+ * came with Linux 5.6, as did the IORING_OP_READ and IORING_OP_WRITE
+ * operations that we need.
+ */
+#if defined(CSNIP_CONF__HAVE_LINUX_IO_URING_H) \
+  && defined(CSNIP_CONF__HAVE_SYS_MMAN_H)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(IORING_FEAT_CUR_PERSONALITY)
+#define HAVE_URING
+#endif
+#endif
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/aio.h>
+#include <csnip/err.h>
+#include <csnip/mem.h>
+#include <csnip/ringbuf2.h>
+#include <csnip/util.h>
+
+#ifdef CSNIP_CONF__HAVE_UNISTD_H
+
+/* Operations */
+enum { OP_READ, OP_WRITE, OP_FSYNC };
+
+/* Request, for the thread pool */
+struct req {
+	int op;
+	int fd;
+	void* buf;
+	size_t len;
+	uint64_t off;
+	uint64_t tag;
+};
+
+/* Maximum number of worker threads */
+#define MAX_THREADS	16
+
+/* Largest transfer per request; Linux's per call maximum (MAX_RW_COUNT),
+ * which also fits the 32 bit length of an io_uring submission entry.
+ */
+#define MAX_LEN		((size_t)0x7ffff000)
+
+struct csnip_aio {
+	int backend;
+	unsigned depth;
+	unsigned inflight;	/* Queued or submitted, not yet polled */
+
+	/* Registered buffers */
+	struct csnip_x_iovec* bufs;
+	unsigned nbufs;
+
+#ifdef HAVE_URING
+	int ring_fd;
+	void* sq_ptr;
+	size_t sq_len;
+	void* cq_ptr;
+	size_t cq_len;
+	struct io_uring_sqe* sqes;
+	size_t sqes_len;
+	unsigned* sq_tail;
+	unsigned* sq_mask;
+	unsigned* sq_array;
+	unsigned* cq_head;
+	unsigned* cq_tail;
+	unsigned* cq_mask;
+	struct io_uring_cqe* cqes;
+	unsigned to_submit;	/* SQEs queued but not submitted */
+#endif
+
+	/* Thread pool: requests staged by the caller, the shared
+	 * queue of requests for the workers, and the completions.
+	 */
+	struct req* staged;
+	unsigned nstaged;
+	struct req* q;
+	ringbuf2 qrb;
+	aio_completion* c;
+	ringbuf2 crb;
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_mutex_t mtx;
+	pthread_cond_t work_cv;
+	pthread_cond_t done_cv;
+	pthread_t threads[MAX_THREADS];
+	unsigned nthreads;
+	bool quit;
+#endif
+};
+
+/* io_uring backend */
+
+#ifdef HAVE_URING
+
+static int sys_setup(unsigned entries, struct io_uring_params* p)
+{
+	return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_enter(int fd, unsigned to_submit, unsigned min_complete,
+			unsigned flags)
+{
+	return (int)syscall(__NR_io_uring_enter, fd, to_submit,
+				min_complete, flags, NULL, 0);
+}
+
+static int sys_register(int fd, unsigned opcode, const void* arg,
+			unsigned nr_args)
+{
+	return (int)syscall(__NR_io_uring_register, fd, opcode, arg,
+				nr_args);
+}
+
+static void uring_unmap(aio* A)
+{
+	if (A->sqes)
+		munmap(A->sqes, A->sqes_len);
+	if (A->cq_ptr && A->cq_ptr != A->sq_ptr)
+		munmap(A->cq_ptr, A->cq_len);
+	if (A->sq_ptr)
+		munmap(A->sq_ptr, A->sq_len);
+	close(A->ring_fd);
+}
+
+/* Set up the rings; returns nonzero if io_uring can't be used. */
+static int uring_init(aio* A)
+{
+	struct io_uring_params p;
+	memset(&p, 0, sizeof p);
+	A->ring_fd = sys_setup(A->depth, &p);
+	if (A->ring_fd < 0)
+		return csnip_err_ERRNO;
+	if (!(p.features & IORING_FEAT_CUR_PERSONALITY)) {
+		/* Kernel older than 5.6 */
+		close(A->ring_fd);
+		return csnip_err_UNSUPPORTED;
+	}
+
+	A->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	A->cq_len = p.cq_off.cqes
+		+ p.cq_entries * sizeof(struct io_uring_cqe);
+	const bool single = (p.features & IORING_FEAT_SINGLE_MMAP);
+	if (single)
+		A->sq_len = A->cq_len = csnip_Max(A->sq_len, A->cq_len);
+
+	A->sq_ptr = mmap(NULL, A->sq_len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, A->ring_fd,
+			IORING_OFF_SQ_RING);
+	if (A->sq_ptr == MAP_FAILED) {
+		A->sq_ptr = NULL;
+		goto fail;
+	}
+	if (single) {
+		A->cq_ptr = A->sq_ptr;
+	} else {
+		A->cq_ptr = mmap(NULL, A->cq_len, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, A->ring_fd,
+				IORING_OFF_CQ_RING);
+		if (A->cq_ptr == MAP_FAILED) {
+			A->cq_ptr = NULL;
+			goto fail;
+		}
+	}
+	A->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+	A->sqes = mmap(NULL, A->sqes_len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, A->ring_fd,
+			IORING_OFF_SQES);
+	if (A->sqes == MAP_FAILED) {
+		A->sqes = NULL;
+		goto fail;
+	}
+
+	char* sq = A->sq_ptr;
+	char* cq = A->cq_ptr;
+	A->sq_tail = (unsigned*)(sq + p.sq_off.tail);
+	A->sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+	A->sq_array = (unsigned*)(sq + p.sq_off.array);
+	A->cq_head = (unsigned*)(cq + p.cq_off.head);
+	A->cq_tail = (unsigned*)(cq + p.cq_off.tail);
+	A->cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+	A->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+	A->to_submit = 0;
+	return 0;
+
+fail:
+	{
+		const int errno_save = errno;
+		uring_unmap(A);
+		errno = errno_save;
+	}
+	return csnip_err_ERRNO;
+}
+
+/* Index of the registered buffer containing the memory, or -1. */
+static int find_buf(const aio* A, const void* buf, size_t len)
+{
+	const char* p = buf;
+	for (unsigned i = 0; i < A->nbufs; ++i) {
+		const char* b = A->bufs[i].iov_base;
+		if (p >= b && len <= A->bufs[i].iov_len
+		  && (size_t)(p - b) <= A->bufs[i].iov_len - len)
+		{
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+static void uring_queue(aio* A, int op, int fd, void* buf, size_t len,
+			uint64_t off, uint64_t tag)
+{
+	const unsigned tail = *A->sq_tail;
+	const unsigned idx = tail & *A->sq_mask;
+	struct io_uring_sqe* sqe = &A->sqes[idx];
+	memset(sqe, 0, sizeof *sqe);
+	sqe->fd = fd;
+	sqe->user_data = tag;
+	if (op == OP_FSYNC) {
+		sqe->opcode = IORING_OP_FSYNC;
+	} else {
+		const int bi = find_buf(A, buf, len);
+		if (bi >= 0) {
+			sqe->opcode = (op == OP_READ ? IORING_OP_READ_FIXED
+						: IORING_OP_WRITE_FIXED);
+			sqe->buf_index = (uint16_t)bi;
+		} else {
+			sqe->opcode = (op == OP_READ ? IORING_OP_READ
+						: IORING_OP_WRITE);
+		}
+		sqe->addr = (uint64_t)(uintptr_t)buf;
+		sqe->len = (uint32_t)len;
+		sqe->off = off;
+	}
+	A->sq_array[idx] = idx;
+
+	/* Publish the entry; the kernel reads it at submission */
+	__atomic_store_n(A->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	++A->to_submit;
+}
+
+static int uring_enter(aio* A, unsigned min_complete)
+{
+	while (A->to_submit > 0 || min_complete > 0) {
+		const unsigned flags = (min_complete > 0
+					? IORING_ENTER_GETEVENTS : 0);
+		const int r = sys_enter(A->ring_fd, A->to_submit,
+					min_complete, flags);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			return csnip_err_ERRNO;
+		}
+		A->to_submit -= (unsigned)r;
+		if (min_complete > 0)
+			break;
+	}
+	return 0;
+}
+
+static int uring_reap(aio* A, aio_completion* out, int max)
+{
+	unsigned head = *A->cq_head;
+	const unsigned tail = __atomic_load_n(A->cq_tail, __ATOMIC_ACQUIRE);
+	int n = 0;
+	while (head != tail && n < max) {
+		const struct io_uring_cqe* cqe = &A->cqes[head & *A->cq_mask];
+		out[n].tag = cqe->user_data;
+		out[n].res = cqe->res;
+		++n;
+		++head;
+	}
+	__atomic_store_n(A->cq_head, head, __ATOMIC_RELEASE);
+	return n;
+}
+
+static unsigned uring_ready(const aio* A)
+{
+	return __atomic_load_n(A->cq_tail, __ATOMIC_ACQUIRE) - *A->cq_head;
+}
+
+#endif /* HAVE_URING */
+
+/* Thread pool backend */
+
+static int64_t execute(const struct req* r)
+{
+	ssize_t n;
+	switch (r->op) {
+	case OP_READ:
+		do {
+			n = pread(r->fd, r->buf, r->len, (off_t)r->off);
+		} while (n < 0 && errno == EINTR);
+		break;
+	case OP_WRITE:
+		do {
+			n = pwrite(r->fd, r->buf, r->len, (off_t)r->off);
+		} while (n < 0 && errno == EINTR);
+		break;
+	default:
+		n = fsync(r->fd);
+		break;
+	}
+	return (n < 0 ? -(int64_t)errno : (int64_t)n);
+}
+
+/* Append a completion; the ring has room for all requests in flight. */
+static void push_completion(aio* A, uint64_t tag, int64_t res)
+{
+	const size_t i = ringbuf2_get_write_idx(&A->crb, NULL);
+	A->c[i].tag = tag;
+	A->c[i].res = res;
+	ringbuf2_add_written(&A->crb, 1);
+}
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+static void* worker(void* arg)
+{
+	aio* A = arg;
+	pthread_mutex_lock(&A->mtx);
+	while (1) {
+		while (!A->quit && ringbuf2_used_size(&A->qrb) == 0)
+			pthread_cond_wait(&A->work_cv, &A->mtx);
+		if (ringbuf2_used_size(&A->qrb) == 0)
+			break;	/* Quit */
+		const struct req r = A->q[ringbuf2_get_read_idx(&A->qrb,
+								NULL)];
+		ringbuf2_add_read(&A->qrb, 1);
+		pthread_mutex_unlock(&A->mtx);
+
+		const int64_t res = execute(&r);
+
+		pthread_mutex_lock(&A->mtx);
+		push_completion(A, r.tag, res);
+		pthread_cond_signal(&A->done_cv);
+	}
+	pthread_mutex_unlock(&A->mtx);
+	return NULL;
+}
+#endif
+
+static int pool_init(aio* A)
+{
+	int err = 0;
+	mem_Alloc(A->depth, A->staged, err);
+	if (err == 0)
+		mem_Alloc(ringbuf2_init(&A->qrb, A->depth), A->q, err);
+	if (err == 0)
+		mem_Alloc(ringbuf2_init(&A->crb, A->depth), A->c, err);
+	if (err)
+		return err;
+	A->nstaged = 0;
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_mutex_init(&A->mtx, NULL);
+	pthread_cond_init(&A->work_cv, NULL);
+	pthread_cond_init(&A->done_cv, NULL);
+	A->quit = false;
+	const unsigned nt = csnip_Min(A->depth, (unsigned)MAX_THREADS);
+	for (A->nthreads = 0; A->nthreads < nt; ++A->nthreads) {
+		const int r = pthread_create(&A->threads[A->nthreads], NULL,
+						worker, A);
+		if (r != 0) {
+			if (A->nthreads > 0)
+				break;	/* Make do with fewer threads */
+			errno = r;
+			return csnip_err_ERRNO;
+		}
+	}
+#endif
+	return 0;
+}
+
+static void pool_stop(aio* A)
+{
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_mutex_lock(&A->mtx);
+	A->quit = true;
+	pthread_cond_broadcast(&A->work_cv);
+	pthread_mutex_unlock(&A->mtx);
+	for (unsigned i = 0; i < A->nthreads; ++i)
+		pthread_join(A->threads[i], NULL);
+	A->nthreads = 0;
+	pthread_cond_destroy(&A->done_cv);
+	pthread_cond_destroy(&A->work_cv);
+	pthread_mutex_destroy(&A->mtx);
+#else
+	(void)A;
+#endif
+}
+
+static void pool_flush(aio* A)
+{
+	if (A->nstaged == 0)
+		return;
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_mutex_lock(&A->mtx);
+	for (unsigned i = 0; i < A->nstaged; ++i) {
+		A->q[ringbuf2_get_write_idx(&A->qrb, NULL)] = A->staged[i];
+		ringbuf2_add_written(&A->qrb, 1);
+	}
+	if (A->nstaged == 1)
+		pthread_cond_signal(&A->work_cv);
+	else
+		pthread_cond_broadcast(&A->work_cv);
+	pthread_mutex_unlock(&A->mtx);
+#else
+	/* No threads: execute synchronously */
+	for (unsigned i = 0; i < A->nstaged; ++i) {
+		push_completion(A, A->staged[i].tag,
+				execute(&A->staged[i]));
+	}
+#endif
+	A->nstaged = 0;
+}
+
+static int pool_poll(aio* A, aio_completion* out, int max,
+			unsigned need)
+{
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_mutex_lock(&A->mtx);
+	while (ringbuf2_used_size(&A->crb) < need)
+		pthread_cond_wait(&A->done_cv, &A->mtx);
+#endif
+	int n = 0;
+	while (n < max && ringbuf2_used_size(&A->crb) > 0) {
+		out[n++] = A->c[ringbuf2_get_read_idx(&A->crb, NULL)];
+		ringbuf2_add_read(&A->crb, 1);
+	}
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_mutex_unlock(&A->mtx);
+#endif
+	return n;
+}
+
+/* Common interface */
+
+aio* csnip_aio_make(unsigned depth, int backend, int* err)
+{
+	if (err)
+		*err = 0;
+	if (depth == 0 || depth > 4096
+	  || (backend != AIO_AUTO && backend != AIO_URING
+	    && backend != AIO_THREADS))
+	{
+		csnip_err_Raise(csnip_err_INVAL, *err);
+		return NULL;
+	}
+
+	aio* A;
+	mem_Alloc(1, A, *err);
+	if (A == NULL)
+		return NULL;
+	memset(A, 0, sizeof *A);
+	A->depth = depth;
+
+	int e = csnip_err_UNSUPPORTED;
+#ifdef HAVE_URING
+	if (backend != AIO_THREADS) {
+		e = uring_init(A);
+		if (e == 0) {
+			A->backend = AIO_URING;
+			return A;
+		}
+	}
+#endif
+	if (backend == AIO_URING) {
+		mem_Free(A);
+		csnip_err_Raise(e == csnip_err_ERRNO
+			? csnip_err_UNSUPPORTED : e, *err);
+		return NULL;
+	}
+
+	A->backend = AIO_THREADS;
+	e = pool_init(A);
+	if (e != 0) {
+		mem_Free(A->staged);
+		mem_Free(A->q);
+		mem_Free(A->c);
+		mem_Free(A);
+		csnip_err_Raise(e, *err);
+		return NULL;
+	}
+	return A;
+}
+
+void csnip_aio_free(aio* A)
+{
+	if (A == NULL)
+		return;
+
+	/* Drain the requests in flight */
+	aio_completion c[16];
+	while (A->inflight > 0) {
+		if (aio_poll(A, c, 16, 1) < 0)
+			break;
+	}
+
+#ifdef HAVE_URING
+	if (A->backend == AIO_URING) {
+		uring_unmap(A);
+	} else
+#endif
+	{
+		pool_stop(A);
+		mem_Free(A->staged);
+		mem_Free(A->q);
+		mem_Free(A->c);
+	}
+	mem_Free(A->bufs);
+	mem_Free(A);
+}
+
+int csnip_aio_backend(const aio* A)
+{
+	return A->backend;
+}
+
+int csnip_aio_register_buffers(aio* A,
+				const struct csnip_x_iovec* bufs,
+				unsigned n)
+{
+	if (A->inflight > 0)
+		return csnip_err_CALLFLOW;
+
+#ifdef HAVE_URING
+	if (A->backend == AIO_URING) {
+		if (A->nbufs > 0)
+			sys_register(A->ring_fd, IORING_UNREGISTER_BUFFERS,
+					NULL, 0);
+		if (n > 0 && sys_register(A->ring_fd,
+				IORING_REGISTER_BUFFERS, bufs, n) != 0)
+		{
+			A->nbufs = 0;
+			return csnip_err_ERRNO;
+		}
+	}
+#endif
+
+	int err = 0;
+	mem_Free(A->bufs);
+	A->nbufs = 0;
+	if (n > 0) {
+		mem_Alloc(n, A->bufs, err);
+		if (err)
+			return err;
+		memcpy(A->bufs, bufs, n * sizeof *bufs);
+		A->nbufs = n;
+	}
+	return 0;
+}
+
+static int queue(aio* A, int op, int fd, void* buf, size_t len,
+		uint64_t off, uint64_t tag)
+{
+	if (A->inflight >= A->depth)
+		return csnip_err_RANGE;
+	++A->inflight;
+	if (len > MAX_LEN)
+		len = MAX_LEN;
+
+#ifdef HAVE_URING
+	if (A->backend == AIO_URING) {
+		uring_queue(A, op, fd, buf, len, off, tag);
+		return 0;
+	}
+#endif
+	struct req* r = &A->staged[A->nstaged++];
+	r->op = op;
+	r->fd = fd;
+	r->buf = buf;
+	r->len = len;
+	r->off = off;
+	r->tag = tag;
+	return 0;
+}
+
+int csnip_aio_submit_read(aio* A, int fd, void* buf, size_t len,
+			uint64_t offset, uint64_t tag)
+{
+	return queue(A, OP_READ, fd, buf, len, offset, tag);
+}
+
+int csnip_aio_submit_write(aio* A, int fd, const void* buf,
+			size_t len, uint64_t offset, uint64_t tag)
+{
+	return queue(A, OP_WRITE, fd, (void*)buf, len, offset, tag);
+}
+
+int csnip_aio_submit_fsync(aio* A, int fd, uint64_t tag)
+{
+	return queue(A, OP_FSYNC, fd, NULL, 0, 0, tag);
+}
+
+int csnip_aio_flush(aio* A)
+{
+#ifdef HAVE_URING
+	if (A->backend == AIO_URING)
+		return uring_enter(A, 0);
+#endif
+	pool_flush(A);
+	return 0;
+}
+
+int csnip_aio_poll(aio* A, aio_completion* out, int max, int min_wait)
+{
+	if (max <= 0)
+		return 0;
+	unsigned need = (min_wait > 0 ? (unsigned)min_wait : 0);
+	need = csnip_Min(need, csnip_Min(A->inflight, (unsigned)max));
+
+	int n;
+#ifdef HAVE_URING
+	if (A->backend == AIO_URING) {
+		const unsigned ready = uring_ready(A);
+		const int err = uring_enter(A,
+				ready < need ? need - ready : 0);
+		if (err)
+			return err;
+		n = uring_reap(A, out, max);
+	} else
+#endif
+	{
+		pool_flush(A);
+		n = pool_poll(A, out, max, need);
+	}
+	A->inflight -= (unsigned)n;
+	return n;
+}
+
+unsigned csnip_aio_inflight(const aio* A)
+{
+	return A->inflight;
+}
+
+#else /* CSNIP_CONF__HAVE_UNISTD_H */
+
+/* Stubs for systems without pread() and pwrite() */
+
+aio* csnip_aio_make(unsigned depth, int backend, int* err)
+{
+	(void)depth;
+	(void)backend;
+	csnip_err_Raise(csnip_err_UNSUPPORTED, *err);
+	return NULL;
+}
+
+void csnip_aio_free(aio* A)
+{
+	(void)A;
+}
+
+int csnip_aio_backend(const aio* A)
+{
+	(void)A;
+	return AIO_AUTO;
+}
+
+int csnip_aio_register_buffers(aio* A,
+				const struct csnip_x_iovec* bufs,
+				unsigned n)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+int csnip_aio_submit_read(aio* A, int fd, void* buf, size_t len,
+			uint64_t offset, uint64_t tag)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+int csnip_aio_submit_write(aio* A, int fd, const void* buf,
+			size_t len, uint64_t offset, uint64_t tag)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+int csnip_aio_submit_fsync(aio* A, int fd, uint64_t tag)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+int csnip_aio_flush(aio* A)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+int csnip_aio_poll(aio* A, aio_completion* out, int max, int min_wait)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+unsigned csnip_aio_inflight(const aio* A)
+{
+	return 0;
+}
+
+#endif /* CSNIP_CONF__HAVE_UNISTD_H */
@@ -0,0 +1,181 @@
+#ifndef CSNIP_AIO_H
+#define CSNIP_AIO_H
+
+/**	@file aio.h
+ *	@brief			Asynchronous file I/O
+ *	@defgroup aio		Asynchronous file I/O
+ *	@{
+ *
+ *	Keeps many positioned reads and writes (and fsyncs) in flight at
+ *	once, so that the storage device sees a queue depth larger than
+ *	1.
+ *
+ *	Requests are first queued with csnip_aio_submit_read(),
+ *	csnip_aio_submit_write() and csnip_aio_submit_fsync(), and then
+ *	handed to the backend in a batch by csnip_aio_flush() (or
+ *	implicitly by csnip_aio_poll()).  Completions are collected
+ *	with csnip_aio_poll(); they carry the caller's 64 bit tag and
+ *	the result of the operation, and may arrive in any order.
+ *
+ *	There are two backends:
+ *
+ *	* io_uring (Linux 5.6 and later), used through the raw system
+ *	  calls.  Buffers registered with csnip_aio_register_buffers()
+ *	  are pinned once by the kernel, and requests on them use the
+ *	  READ_FIXED / WRITE_FIXED operations.
+ *
+ *	* A pool of worker threads issuing pread(), pwrite() and
+ *	  fsync().  It is used where io_uring is not available, e.g.
+ *	  on other systems, on old kernels, or when it is disabled by a
+ *	  seccomp policy.  Without threading support, requests are
+ *	  executed synchronously when they are flushed.
+ *
+ *	Both backends have the same semantics:  Reads and writes may
+ *	transfer fewer bytes than requested, like pread() and pwrite();
+ *	errors are reported as negative errno values in the completion.
+ *	A request transfers at most 0x7ffff000 bytes (just under 2 GiB,
+ *	the most Linux transfers in one call); longer requests complete
+ *	as short transfers.
+ *
+ *	An aio context must only be used by one thread at a time.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <csnip/x.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @name Backends */
+/**@{*/
+#define CSNIP_AIO_AUTO		0	/**< io_uring if possible */
+#define CSNIP_AIO_URING		1	/**< io_uring */
+#define CSNIP_AIO_THREADS	2	/**< Worker thread pool */
+/**@}*/
+
+/** Asynchronous I/O context (opaque). */
+typedef struct csnip_aio csnip_aio;
+
+/** Completion of a request. */
+typedef struct {
+	uint64_t tag;	/**< The tag given at submission */
+	int64_t res;	/**< Bytes transferred, or -errno */
+} csnip_aio_completion;
+
+/**	Create an aio context.
+ *
+ *	@param	depth
+ *		the maximum number of requests in flight (queued,
+ *		submitted and not yet polled).
+ *
+ *	@param	backend
+ *		CSNIP_AIO_AUTO, CSNIP_AIO_URING or CSNIP_AIO_THREADS.
+ *
+ *	@param	err
+ *		error return; csnip_err_UNSUPPORTED if io_uring was
+ *		requested explicitly but is not available,
+ *		csnip_err_INVAL, csnip_err_NOMEM or csnip_err_ERRNO.
+ */
+csnip_aio* csnip_aio_make(unsigned depth, int backend, int* err);
+
+/**	Free an aio context.
+ *
+ *	Waits for the requests in flight to complete first.
+ */
+void csnip_aio_free(csnip_aio* A);
+
+/**	The backend in use, CSNIP_AIO_URING or CSNIP_AIO_THREADS. */
+int csnip_aio_backend(const csnip_aio* A);
+
+/**	Register buffers.
+ *
+ *	Reads and writes whose buffers lie within a registered buffer
+ *	avoid the per-request cost of mapping the user pages with
+ *	io_uring.  Registering replaces any previous registration, and
+ *	is only allowed with no requests in flight.  The thread pool
+ *	backend accepts the registration but doesn't use it.
+ *
+ *	@return	0 on success, csnip_err_CALLFLOW if requests are in
+ *		flight, csnip_err_NOMEM or csnip_err_ERRNO.
+ */
+int csnip_aio_register_buffers(csnip_aio* A,
+				const struct csnip_x_iovec* bufs,
+				unsigned n);
+
+/** @name Queueing requests
+ *
+ *  These functions return 0 on success, or csnip_err_RANGE if the
+ *  context has the maximum number of requests in flight already; in
+ *  that case, poll for completions first.
+ */
+/**@{*/
+
+/**	Queue a read of @a len bytes at @a offset into @a buf. */
+int csnip_aio_submit_read(csnip_aio* A, int fd, void* buf, size_t len,
+			uint64_t offset, uint64_t tag);
+
+/**	Queue a write of @a len bytes from @a buf at @a offset. */
+int csnip_aio_submit_write(csnip_aio* A, int fd, const void* buf,
+			size_t len, uint64_t offset, uint64_t tag);
+
+/**	Queue an fsync().
+ *
+ *	The fsync is not ordered with respect to other requests in
+ *	flight; to make sure that writes are durable, wait for their
+ *	completion before queueing the fsync.
+ */
+int csnip_aio_submit_fsync(csnip_aio* A, int fd, uint64_t tag);
+/**@}*/
+
+/**	Hand the queued requests to the backend.
+ *
+ *	@return	0 on success, or csnip_err_ERRNO.
+ */
+int csnip_aio_flush(csnip_aio* A);
+
+/**	Collect completions.
+ *
+ *	Flushes queued requests, then waits until at least @a min_wait
+ *	completions are available (bounded by the number of requests in
+ *	flight), and returns up to @a max of them.
+ *
+ *	@return	the number of completions stored in @a out, or a
+ *		negative error code.
+ */
+int csnip_aio_poll(csnip_aio* A,
+		csnip_aio_completion* out,
+		int max,
+		int min_wait);
+
+/**	Number of requests in flight. */
+unsigned csnip_aio_inflight(const csnip_aio* A);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* CSNIP_AIO_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_AIO_HAVE_SHORT_NAMES)
+#define AIO_AUTO			CSNIP_AIO_AUTO
+#define AIO_URING			CSNIP_AIO_URING
+#define AIO_THREADS			CSNIP_AIO_THREADS
+#define aio				csnip_aio
+#define aio_completion			csnip_aio_completion
+#define aio_make			csnip_aio_make
+#define aio_free			csnip_aio_free
+#define aio_backend			csnip_aio_backend
+#define aio_register_buffers		csnip_aio_register_buffers
+#define aio_submit_read			csnip_aio_submit_read
+#define aio_submit_write		csnip_aio_submit_write
+#define aio_submit_fsync		csnip_aio_submit_fsync
+#define aio_flush			csnip_aio_flush
+#define aio_poll			csnip_aio_poll
+#define aio_inflight			csnip_aio_inflight
+#define CSNIP_AIO_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_AIO_HAVE_SHORT_NAMES */
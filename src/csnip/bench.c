@@ -0,0 +1,464 @@
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/csnip_conf.h>
+#include <csnip/bench.h>
+#include <csnip/cpu.h>
+#include <csnip/err.h>
+#include <csnip/meanvar.h>
+#include <csnip/mem.h>
+#include <csnip/sort.h>
+#include <csnip/time.h>
+#include <csnip/util.h>
+
+#if defined(CSNIP_CONF__HAVE_SCHED_SETAFFINITY)
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+/* Options */
+
+void csnip_bench_opts_init(csnip_bench_opts* O)
+{
+	O->warmup = 0.1;
+	O->min_time = 0.01;
+	O->samples = 10;
+	O->cpu = -1;
+	O->format = CSNIP_BENCH_TEXT;
+	O->out = stdout;
+	O->counters = 0;
+}
+
+int csnip_bench_parse_format(const char* s, int* format)
+{
+	if (strcmp(s, "text") == 0) {
+		*format = CSNIP_BENCH_TEXT;
+	} else if (strcmp(s, "csv") == 0) {
+		*format = CSNIP_BENCH_CSV;
+	} else if (strcmp(s, "json") == 0) {
+		*format = CSNIP_BENCH_JSON;
+	} else {
+		return csnip_err_INVAL;
+	}
+	return 0;
+}
+
+int csnip_bench_pin_cpu(int cpu)
+{
+	if (cpu < 0)
+		return csnip_err_INVAL;
+#if defined(CSNIP_CONF__HAVE_SCHED_SETAFFINITY)
+	if (cpu >= CPU_SETSIZE)
+		return csnip_err_INVAL;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof set, &set) != 0)
+		return csnip_err_ERRNO;
+	return 0;
+#elif defined(_WIN32)
+	if (cpu >= (int)(8 * sizeof(DWORD_PTR)))
+		return csnip_err_INVAL;
+	if (SetThreadAffinityMask(GetCurrentThread(),
+				(DWORD_PTR)1 << cpu) == 0)
+	{
+		return csnip_err_UNSUPPORTED;
+	}
+	return 0;
+#else
+	return csnip_err_UNSUPPORTED;
+#endif
+}
+
+int csnip_bench_init(csnip_bench* B, const csnip_bench_opts* O)
+{
+	if (O) {
+		B->opts = *O;
+	} else {
+		csnip_bench_opts_init(&B->opts);
+	}
+	if (B->opts.out == NULL)
+		B->opts.out = stdout;
+	if (B->opts.samples < 1)
+		B->opts.samples = 1;
+	B->pause_start = 0;
+	B->paused = 0;
+	B->nrows = 0;
+	B->counting = 0;
+	B->nmetrics = 0;
+	B->csv_nmetrics = 0;
+
+	/* Calibrate the cycle counter now rather than in a timed run */
+	(void)csnip_time_cycles_per_ns();
+
+	if (B->opts.cpu >= 0)
+		return csnip_bench_pin_cpu(B->opts.cpu);
+	return 0;
+}
+
+int csnip_bench_metric(csnip_bench* B, const char* name, double value)
+{
+	if (B->nmetrics >= CSNIP_BENCH_MAX_METRICS)
+		return csnip_err_RANGE;
+	B->metric_name[B->nmetrics] = name;
+	B->metric[B->nmetrics] = value;
+	++B->nmetrics;
+	return 0;
+}
+
+/* Timing */
+
+void csnip_bench_pause(csnip_bench* B)
+{
+	if (B->counting)
+		csnip_perfctr_pause(&B->perf);
+	B->pause_start = csnip_time_cycles_fenced();
+}
+
+void csnip_bench_resume(csnip_bench* B)
+{
+	B->paused += csnip_time_cycles() - B->pause_start;
+	if (B->counting)
+		csnip_perfctr_resume(&B->perf);
+}
+
+/* Run fn for iters iterations; returns the time in ns. */
+static double run_once(csnip_bench* B,
+			csnip_bench_fn* fn,
+			void* arg,
+			uint64_t iters)
+{
+	B->paused = 0;
+	const uint64_t t0 = csnip_time_cycles();
+	fn(B, arg, iters);
+	const uint64_t t1 = csnip_time_cycles_fenced();
+	const uint64_t d = t1 - t0;
+	return csnip_time_cycles_to_ns(d > B->paused ? d - B->paused : 0);
+}
+
+/* Find the iteration count for a sample to take at least min_time,
+ * running the function for at least the warmup time on the way.  The
+ * first run is never accepted, as it tends to include one-time costs
+ * such as page faults.
+ */
+static uint64_t calibrate(csnip_bench* B, csnip_bench_fn* fn, void* arg)
+{
+	const double target = B->opts.min_time * 1e9;
+	const double warmup = B->opts.warmup * 1e9;
+	uint64_t iters = 1;
+	double total = 0;
+	for (int first = 1;; first = 0) {
+		const double t = run_once(B, fn, arg, iters);
+		total += t;
+		if (first)
+			continue;
+		if (t >= target) {
+			if (total >= warmup)
+				break;
+			continue;
+		}
+
+		/* Grow by at most 10x per step, aiming a bit past the
+		 * target, since short runs are less accurate.
+		 */
+		double next = iters * 10.0;
+		if (t > target / 10)
+			next = iters * 1.2 * target / t;
+		if (next > 1e18)
+			break;
+		const uint64_t n = (uint64_t)next;
+		iters = (n > iters ? n : iters + 1);
+	}
+	return iters;
+}
+
+/* Run with performance counters, and store the events per op in R */
+static void count_events(csnip_bench* B,
+			csnip_bench_fn* fn,
+			void* arg,
+			uint64_t iters,
+			double div,
+			csnip_bench_result* R)
+{
+	csnip_perfctr_counts C;
+	csnip_perfctr_open(&B->perf, B->opts.counters);
+	B->counting = 1;
+	B->paused = 0;
+	csnip_perfctr_Scoped(&B->perf, &C,
+		fn(B, arg, iters);
+	);
+	B->counting = 0;
+	csnip_perfctr_close(&B->perf);
+
+	R->counters_valid = C.valid & B->opts.counters;
+	for (int i = 0; i < CSNIP_PERFCTR_N; ++i)
+		R->counters[i] = C.value[i] / div;
+}
+
+/* Output */
+
+/* Print a number as JSON, where inf and nan are not allowed */
+static void json_num(FILE* fp, double v)
+{
+	if (isfinite(v)) {
+		fprintf(fp, "%.6g", v);
+	} else {
+		fputs("null", fp);
+	}
+}
+
+static void json_str(FILE* fp, const char* s)
+{
+	putc('"', fp);
+	for (; *s; ++s) {
+		const unsigned char c = (unsigned char)*s;
+		if (c == '"' || c == '\\') {
+			fprintf(fp, "\\%c", c);
+		} else if (c < 0x20) {
+			fprintf(fp, "\\u%04x", c);
+		} else {
+			putc(c, fp);
+		}
+	}
+	putc('"', fp);
+}
+
+static void csv_str(FILE* fp, const char* s)
+{
+	if (strpbrk(s, ",\"\r\n") == NULL) {
+		fputs(s, fp);
+		return;
+	}
+	putc('"', fp);
+	for (; *s; ++s) {
+		if (*s == '"')
+			putc('"', fp);
+		putc(*s, fp);
+	}
+	putc('"', fp);
+}
+
+static void write_header(csnip_bench* B, const csnip_bench_result* R)
+{
+	FILE* fp = B->opts.out;
+	const unsigned ev = B->opts.counters;
+	switch (B->opts.format) {
+	case CSNIP_BENCH_TEXT:
+		fprintf(fp, "%-32s %12s %11s %11s %11s %11s %11s",
+			"benchmark", "iterations", "mean", "stddev",
+			"min", "median", "max");
+		for (int i = 0; i < CSNIP_PERFCTR_N; ++i) {
+			if (ev & (1u << i))
+				fprintf(fp, " %13s", csnip_perfctr_name(i));
+		}
+		putc('\n', fp);
+		break;
+	case CSNIP_BENCH_CSV:
+		fputs("name,iterations,samples,mean_ns,stddev_ns,"
+			"min_ns,median_ns,max_ns", fp);
+		for (int i = 0; i < CSNIP_PERFCTR_N; ++i) {
+			if (ev & (1u << i))
+				fprintf(fp, ",%s", csnip_perfctr_name(i));
+		}
+		B->csv_nmetrics = R ? R->nmetrics : 0;
+		for (int i = 0; i < B->csv_nmetrics; ++i) {
+			B->csv_metric[i] = R->metric_name[i];
+			putc(',', fp);
+			csv_str(fp, R->metric_name[i]);
+		}
+		putc('\n', fp);
+		break;
+	case CSNIP_BENCH_JSON:
+		fprintf(fp, "{\n  \"context\": {\n"
+			"    \"cpu_level\": \"%s\",\n"
+			"    \"timer\": \"%s\",\n"
+			"    \"samples\": %d,\n"
+			"    \"min_time\": ",
+			csnip_cpu_level_name(csnip_cpu_level()),
+			csnip_time_cycles_source(),
+			B->opts.samples);
+		json_num(fp, B->opts.min_time);
+		fputs("\n  },\n  \"benchmarks\": [", fp);
+		break;
+	}
+}
+
+static void write_row(csnip_bench* B, const csnip_bench_result* R)
+{
+	FILE* fp = B->opts.out;
+	const unsigned ev = B->opts.counters;
+	if (B->nrows++ == 0)
+		write_header(B, R);
+
+	/* Unavailable counters are written as "unavailable", as empty
+	 * fields, and as null, respectively.
+	 */
+	switch (B->opts.format) {
+	case CSNIP_BENCH_TEXT:
+		fprintf(fp, "%-32s %12llu %11.2f %11.2f %11.2f %11.2f %11.2f",
+			R->name, (unsigned long long)R->iters,
+			R->mean, R->stddev, R->min, R->median, R->max);
+		for (int i = 0; i < CSNIP_PERFCTR_N; ++i) {
+			if (!(ev & (1u << i)))
+				continue;
+			if (R->counters_valid & (1u << i)) {
+				fprintf(fp, " %13.3f", R->counters[i]);
+			} else {
+				fprintf(fp, " %13s", "unavailable");
+			}
+		}
+		for (int i = 0; i < R->nmetrics; ++i) {
+			fprintf(fp, " %s=%.6g", R->metric_name[i],
+				R->metric[i]);
+		}
+		putc('\n', fp);
+		break;
+	case CSNIP_BENCH_CSV:
+		csv_str(fp, R->name);
+		fprintf(fp, ",%llu,%d,%.6g,%.6g,%.6g,%.6g,%.6g",
+			(unsigned long long)R->iters, R->samples,
+			R->mean, R->stddev, R->min, R->median, R->max);
+		for (int i = 0; i < CSNIP_PERFCTR_N; ++i) {
+			if (!(ev & (1u << i)))
+				continue;
+			putc(',', fp);
+			if (R->counters_valid & (1u << i))
+				fprintf(fp, "%.6g", R->counters[i]);
+		}
+		for (int i = 0; i < B->csv_nmetrics; ++i) {
+			putc(',', fp);
+			for (int j = 0; j < R->nmetrics; ++j) {
+				if (strcmp(R->metric_name[j],
+					B->csv_metric[i]) == 0)
+				{
+					fprintf(fp, "%.6g", R->metric[j]);
+					break;
+				}
+			}
+		}
+		putc('\n', fp);
+		break;
+	case CSNIP_BENCH_JSON: {
+		const struct { const char* key; double v; } f[] = {
+			{ "mean_ns", R->mean },
+			{ "stddev_ns", R->stddev },
+			{ "min_ns", R->min },
+			{ "median_ns", R->median },
+			{ "max_ns", R->max },
+		};
+		fputs(B->nrows > 1 ? ",\n    {\"name\": " : "\n    {\"name\": ",
+			fp);
+		json_str(fp, R->name);
+		fprintf(fp, ", \"iterations\": %llu, \"samples\": %d",
+			(unsigned long long)R->iters, R->samples);
+		for (size_t i = 0; i < Static_len(f); ++i) {
+			fprintf(fp, ", \"%s\": ", f[i].key);
+			json_num(fp, f[i].v);
+		}
+		if (ev) {
+			const char* sep = "{";
+			fputs(", \"counters\": ", fp);
+			for (int i = 0; i < CSNIP_PERFCTR_N; ++i) {
+				if (!(ev & (1u << i)))
+					continue;
+				fprintf(fp, "%s\"%s\": ", sep,
+					csnip_perfctr_name(i));
+				json_num(fp, R->counters_valid & (1u << i)
+					? R->counters[i] : NAN);
+				sep = ", ";
+			}
+			putc('}', fp);
+		}
+		if (R->nmetrics) {
+			fputs(", \"metrics\": {", fp);
+			for (int i = 0; i < R->nmetrics; ++i) {
+				if (i)
+					fputs(", ", fp);
+				json_str(fp, R->metric_name[i]);
+				fputs(": ", fp);
+				json_num(fp, R->metric[i]);
+			}
+			putc('}', fp);
+		}
+		putc('}', fp);
+		break;
+	}
+	}
+}
+
+void csnip_bench_finish(csnip_bench* B)
+{
+	FILE* fp = B->opts.out;
+	if (B->opts.format == CSNIP_BENCH_JSON) {
+		if (B->nrows == 0)
+			write_header(B, NULL);
+		fputs("\n  ]\n}\n", fp);
+	}
+	fflush(fp);
+	B->nrows = 0;
+}
+
+/* Running */
+
+int csnip_bench_run(csnip_bench* B,
+			const char* name,
+			csnip_bench_fn* fn,
+			void* arg,
+			double ops,
+			csnip_bench_result* R)
+{
+	const int n = B->opts.samples;
+	double* t;
+	int err = 0;
+	mem_Alloc(n, t, err);
+	if (err)
+		return err;
+
+	const uint64_t iters = calibrate(B, fn, arg);
+	const double div = (double)iters * (ops > 0 ? ops : 1);
+	meanvar mv = { 0 };
+	for (int i = 0; i < n; ++i) {
+		t[i] = run_once(B, fn, arg, iters) / div;
+		meanvar_add(&mv, t[i]);
+	}
+	Qsort(u, v, t[u] < t[v], Tswap(double, t[u], t[v]), n);
+
+	csnip_bench_result res = {
+		.name = name,
+		.iters = iters,
+		.samples = n,
+		.mean = meanvar_mean(&mv),
+		.stddev = (n > 1 ? sqrt(meanvar_var(&mv, 1)) : 0),
+		.min = t[0],
+		.median = (n % 2 ? t[n / 2] : (t[n / 2 - 1] + t[n / 2]) / 2),
+		.max = t[n - 1],
+		.counters_valid = 0,
+		.nmetrics = B->nmetrics,
+	};
+	mem_Free(t);
+	for (int i = 0; i < B->nmetrics; ++i) {
+		res.metric_name[i] = B->metric_name[i];
+		res.metric[i] = B->metric[i];
+	}
+	B->nmetrics = 0;
+	if (B->opts.counters)
+		count_events(B, fn, arg, iters, div, &res);
+
+	write_row(B, &res);
+	if (R)
+		*R = res;
+	return 0;
+}
+
+void csnip_bench__escape(const void* p)
+{
+	static const void* volatile sink;
+	sink = p;
+	(void)sink;
+}
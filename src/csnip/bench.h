@@ -0,0 +1,311 @@
+#ifndef CSNIP_BENCH_H
+#define CSNIP_BENCH_H
+
+/**	@file bench.h
+ *	@brief			Micro-benchmark harness
+ *	@defgroup bench		Micro-benchmark harness
+ *	@{
+ *
+ *	Runs benchmark functions repeatedly and reports statistics of
+ *	the time per operation.
+ *
+ *	A benchmark function runs a given number of iterations of the
+ *	code to be measured:
+ *
+ *	@code{.c}
+ *	static void bm_sum(csnip_bench* B, void* arg, uint64_t iters)
+ *	{
+ *		const int* a = arg;
+ *		for (uint64_t i = 0; i < iters; ++i) {
+ *			int s = 0;
+ *			for (int j = 0; j < 1000; ++j)
+ *				s += a[j];
+ *			csnip_bench_DoNotOptimize(s);
+ *		}
+ *	}
+ *
+ *	csnip_bench B;
+ *	csnip_bench_init(&B, NULL);
+ *	csnip_bench_run(&B, "sum", bm_sum, a, 1000, NULL);
+ *	csnip_bench_finish(&B);
+ *	@endcode
+ *
+ *	csnip_bench_run() proceeds in three phases:
+ *
+ *	1. Warmup:  the function is run with growing iteration counts
+ *	   for the warmup time, to fault in memory, warm up caches and
+ *	   branch predictors, and let the CPU clock ramp up.
+ *
+ *	2. Calibration:  the iteration count is scaled up until a run
+ *	   takes at least the minimum sample time, so that the timer
+ *	   resolution and overhead are negligible.
+ *
+ *	3. Sampling:  the function is run the given number of times with
+ *	   the calibrated iteration count, each run giving one sample of
+ *	   the time per operation.  The samples are aggregated with
+ *	   csnip_meanvar into mean and standard deviation; the minimum
+ *	   and median are reported as well, being more robust against
+ *	   interference from other processes.
+ *
+ *	Times are taken with the cycle counter of time.h.  Work in the
+ *	benchmark function that shouldn't be timed, such as resetting
+ *	the input, is bracketed by csnip_bench_pause() and
+ *	csnip_bench_resume().
+ *
+ *	If requested in the options, hardware performance counters
+ *	(perfctr.h) are read in a separate run after the samples, so
+ *	that the counting overhead doesn't affect the times, and reported
+ *	per operation as well.  Counters that aren't available are
+ *	reported as such.
+ *
+ *	The results are written as a text table, as CSV, or as JSON.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <csnip/perfctr.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @name Output formats */
+/**@{*/
+#define CSNIP_BENCH_TEXT	0
+#define CSNIP_BENCH_CSV		1
+#define CSNIP_BENCH_JSON	2
+/**@}*/
+
+/** Maximum number of metrics per result. */
+#define CSNIP_BENCH_MAX_METRICS	8
+
+/** Benchmark options. */
+typedef struct {
+	double warmup;		/**< Warmup time in seconds (0.1) */
+	double min_time;	/**< Minimum sample time in seconds (0.01) */
+	int samples;		/**< Number of samples (10) */
+	int cpu;		/**< CPU to pin the thread to, or -1 (-1) */
+	int format;		/**< Output format (CSNIP_BENCH_TEXT) */
+	FILE* out;		/**< Output stream (stdout) */
+	unsigned counters;	/**< CSNIP_PERFCTR_* events to report (0) */
+} csnip_bench_opts;
+
+/** Benchmark result.
+ *
+ *  Times are in nanoseconds per operation.
+ */
+typedef struct {
+	const char* name;	/**< Benchmark name */
+	uint64_t iters;		/**< Iterations per sample */
+	int samples;		/**< Number of samples */
+	double mean;		/**< Mean */
+	double stddev;		/**< Sample standard deviation */
+	double min;		/**< Minimum */
+	double median;		/**< Median */
+	double max;		/**< Maximum */
+	unsigned counters_valid;/**< Counters available */
+	double counters[CSNIP_PERFCTR_N];
+				/**< Events per operation, by index */
+	int nmetrics;		/**< Number of metrics */
+	const char* metric_name[CSNIP_BENCH_MAX_METRICS];
+				/**< Metric names */
+	double metric[CSNIP_BENCH_MAX_METRICS];
+				/**< Metric values */
+} csnip_bench_result;
+
+/** Benchmark harness.
+ *
+ *  Initialize with csnip_bench_init(); the members other than the
+ *  options are internal.
+ */
+typedef struct csnip_bench {
+	csnip_bench_opts opts;	/**< Options */
+	/** @cond */
+	uint64_t pause_start;	/* Counter at csnip_bench_pause() */
+	uint64_t paused;	/* Counter ticks paused in this run */
+	int nrows;		/* Results written */
+	csnip_perfctr perf;	/* Counters, in the counting run */
+	int counting;		/* Whether perf is in use */
+	int nmetrics;		/* Metrics for the next result */
+	const char* metric_name[CSNIP_BENCH_MAX_METRICS];
+	double metric[CSNIP_BENCH_MAX_METRICS];
+	int csv_nmetrics;	/* Metric columns in the CSV header */
+	const char* csv_metric[CSNIP_BENCH_MAX_METRICS];
+	/** @endcond */
+} csnip_bench;
+
+/**	Benchmark function.
+ *
+ *	@param	B
+ *		the harness, for csnip_bench_pause() and
+ *		csnip_bench_resume().
+ *
+ *	@param	arg
+ *		the argument given to csnip_bench_run().
+ *
+ *	@param	iters
+ *		the number of iterations to run.
+ */
+typedef void csnip_bench_fn(csnip_bench* B, void* arg, uint64_t iters);
+
+/**	Initialize options with the defaults. */
+void csnip_bench_opts_init(csnip_bench_opts* O);
+
+/**	Parse an output format name.
+ *
+ *	@param	s
+ *		"text", "csv" or "json".
+ *
+ *	@return	0 on success, or csnip_err_INVAL if the name is not
+ *		known.
+ */
+int csnip_bench_parse_format(const char* s, int* format);
+
+/**	Initialize a harness.
+ *
+ *	@param	O
+ *		the options, or NULL for the defaults.
+ *
+ *	@return	0 on success.  If pinning the thread to the requested
+ *		CPU fails, the error of csnip_bench_pin_cpu() is
+ *		returned, and the harness is usable nonetheless.
+ */
+int csnip_bench_init(csnip_bench* B, const csnip_bench_opts* O);
+
+/**	Run a benchmark.
+ *
+ *	Runs, times and reports the benchmark as described above.
+ *
+ *	@param	name
+ *		the benchmark name.
+ *
+ *	@param	fn, arg
+ *		the benchmark function and its argument.
+ *
+ *	@param	ops
+ *		the number of operations per iteration, by which the
+ *		time per iteration is divided; e.g., the number of
+ *		elements for a benchmark iteration processing an array.
+ *
+ *	@param	R
+ *		if not NULL, the result is returned here.
+ *
+ *	@return	0 on success, or csnip_err_NOMEM.
+ */
+int csnip_bench_run(csnip_bench* B,
+			const char* name,
+			csnip_bench_fn* fn,
+			void* arg,
+			double ops,
+			csnip_bench_result* R);
+
+/**	Attach a metric to the next result.
+ *
+ *	Adds a benchmark specific value, such as the memory used per
+ *	element, to the result of the next csnip_bench_run() call.  In
+ *	text output, metrics are appended to the row as name=value; in
+ *	JSON, they are members of the "metrics" object.  The CSV columns
+ *	are those of the metrics of the first result, so all results
+ *	should have the same metrics in that case.
+ *
+ *	@param	name
+ *		the metric name; not copied, so it must remain valid
+ *		until the result is written.
+ *
+ *	@return	0 on success, or csnip_err_RANGE if there are already
+ *		CSNIP_BENCH_MAX_METRICS metrics for the next result.
+ */
+int csnip_bench_metric(csnip_bench* B, const char* name, double value);
+
+/**	Stop timing.
+ *
+ *	To be called by a benchmark function before work that shouldn't
+ *	be timed.  Each call costs some tens of nanoseconds, which
+ *	should be small compared to the timed work; in the counting run,
+ *	it also pauses the performance counters, at the cost of a system
+ *	call.
+ */
+void csnip_bench_pause(csnip_bench* B);
+
+/**	Resume timing after csnip_bench_pause(). */
+void csnip_bench_resume(csnip_bench* B);
+
+/**	Finish the output.
+ *
+ *	Completes the JSON document, and flushes the output stream.
+ */
+void csnip_bench_finish(csnip_bench* B);
+
+/**	Pin the calling thread to a CPU.
+ *
+ *	@return	0 on success, csnip_err_ERRNO if the system call
+ *		failed, or csnip_err_UNSUPPORTED if the platform doesn't
+ *		support it.
+ */
+int csnip_bench_pin_cpu(int cpu);
+
+/** @cond */
+void csnip_bench__escape(const void* p);
+/** @endcond */
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @name Optimization barriers */
+/**@{*/
+
+/**	Keep a value from being optimized away.
+ *
+ *	Statement macro.  Makes the compiler assume that the value of
+ *	@a x is used, so that its computation can't be eliminated, and
+ *	that all memory may have been read and written.  @a x should be
+ *	an lvalue, since that is required on compilers other than GCC
+ *	and clang.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define csnip_bench_DoNotOptimize(x) \
+	__asm__ __volatile__("" : : "r,m"(x) : "memory")
+#else
+#define csnip_bench_DoNotOptimize(x) \
+	csnip_bench__escape((const void*)&(x))
+#endif
+
+/**	Force pending memory writes.
+ *
+ *	Statement macro.  Makes the compiler assume that all memory may
+ *	have been read and written, so that stores into buffers the
+ *	benchmark doesn't read back are not eliminated.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#define csnip_bench_ClobberMemory() \
+	__asm__ __volatile__("" : : : "memory")
+#else
+#define csnip_bench_ClobberMemory() \
+	csnip_bench__escape(NULL)
+#endif
+/**@}*/
+
+/** @} */
+
+#endif /* CSNIP_BENCH_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_BENCH_HAVE_SHORT_NAMES)
+#define bench				csnip_bench
+#define bench_opts			csnip_bench_opts
+#define bench_result			csnip_bench_result
+#define bench_fn			csnip_bench_fn
+#define bench_opts_init			csnip_bench_opts_init
+#define bench_parse_format		csnip_bench_parse_format
+#define bench_init			csnip_bench_init
+#define bench_run			csnip_bench_run
+#define bench_metric			csnip_bench_metric
+#define bench_pause			csnip_bench_pause
+#define bench_resume			csnip_bench_resume
+#define bench_finish			csnip_bench_finish
+#define bench_pin_cpu			csnip_bench_pin_cpu
+#define bench_DoNotOptimize		csnip_bench_DoNotOptimize
+#define bench_ClobberMemory		csnip_bench_ClobberMemory
+#define CSNIP_BENCH_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_BENCH_HAVE_SHORT_NAMES */
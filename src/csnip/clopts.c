@@ -1,11 +1,14 @@
 #include <errno.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 
 #define CSNIP_SHORT_NAMES
 #include "clopts.h"
 
 #include <csnip/arr.h>
+#include <csnip/numparse.h>
 #include <csnip/podtypes.h>
 #include <csnip/preproc.h>
 #include <csnip/util.h>
@@ -255,24 +258,23 @@ int csnip_clopts_parser_uchar(const csnip_clopts* opts,
 			  "in %s.\n", __func__); \
 			return err_UNEXPECTED_NULL; \
 		} \
-		char* endptr = NULL; \
 		type* ret = (type*)optinfo->usr; \
-		errno = 0; \
-		ullong v = strtoull(argval, &endptr, 0); \
-		if (errno != 0 && errno != ERANGE) \
-			return err_ERRNO; \
-		if (errno == ERANGE || maxval < v) { \
+		const size_t len = strlen(argval); \
+		uint64_t v; \
+		size_t used; \
+		const int err = numparse_u64(argval, len, 0, &v, &used); \
+		if (err == err_RANGE || (err == 0 && maxval < v)) { \
 			fprintf(stderr, "Error:  Argument value " \
 			 "\"%s\" out of range for storage type.\n", \
 			 argval); \
 			return err_RANGE; \
 		} \
-		if (endptr == argval) { \
+		if (used == 0) { \
 			fprintf(stderr, "Error:  Can't convert \"%s\" " \
 			  "to an integer.\n", argval); \
 			return err_FORMAT; \
 		} \
-		if (*endptr != '\0') { \
+		if (used != len) { \
 			fprintf(stderr, "Error:  Trailing garbage " \
 			  "after integer argument \"%s\".\n", \
 			  argval); \
@@ -300,26 +302,27 @@ DEF_INT_PARSER(ullong, ULLONG_MAX)
 			  "in %s.\n", __func__); \
 			return err_UNEXPECTED_NULL; \
 		} \
-		char* endptr = NULL; \
 		type* ret = (type*)optinfo->usr; \
-		errno = 0; \
-		ldouble v = strtold(argval, &endptr); \
-		if (errno != 0 && errno != ERANGE) \
-			return err_ERRNO; \
+		const size_t len = strlen(argval); \
+		double v; \
+		size_t used; \
+		const int err = numparse_double(argval, len, &v, &used); \
+		if (err != 0 && err != err_RANGE && err != err_FORMAT) \
+			return err; \
 		/* XXX: Check for overflow when converting down \
 		   Currenly missing limit_Maxf macro for this. */ \
-		if (errno == ERANGE) { \
+		if (err == err_RANGE) { \
 			fprintf(stderr, "Error:  Argument value " \
 			 "\"%s\" out of range for storage type.\n", \
 			 argval); \
 			return err_RANGE; \
 		} \
-		if (endptr == argval) { \
+		if (used == 0) { \
 			fprintf(stderr, "Error:  Can't convert \"%s\" " \
 			  "to a floating point value.\n", argval); \
 			return err_FORMAT; \
 		} \
-		if (*endptr != '\0') { \
+		if (used != len) { \
 			fprintf(stderr, "Error:  Trailing garbage " \
 			  "after floating point argument \"%s\".\n", \
 			  argval); \
@@ -331,9 +334,46 @@ DEF_INT_PARSER(ullong, ULLONG_MAX)
 
 DEF_FLOAT_PARSER(float)
 DEF_FLOAT_PARSER(double)
-DEF_FLOAT_PARSER(ldouble)
 #undef DEF_FLOAT_PARSER
 
+/* Long doubles need more precision than numparse provides. */
+int csnip_clopts_parser_ldouble(const csnip_clopts* opts,
+			const csnip_clopts_optinfo* optinfo,
+			const char* argval)
+{
+	if (argval == NULL) {
+		fprintf(stderr, "Error:  Unexpected NULL "
+		  "pointer arg string as argval argument "
+		  "in %s.\n", __func__);
+		return err_UNEXPECTED_NULL;
+	}
+	char* endptr = NULL;
+	ldouble* ret = (ldouble*)optinfo->usr;
+	errno = 0;
+	ldouble v = strtold(argval, &endptr);
+	if (errno != 0 && errno != ERANGE)
+		return err_ERRNO;
+	if (errno == ERANGE) {
+		fprintf(stderr, "Error:  Argument value "
+		 "\"%s\" out of range for storage type.\n",
+		 argval);
+		return err_RANGE;
+	}
+	if (endptr == argval) {
+		fprintf(stderr, "Error:  Can't convert \"%s\" "
+		  "to a floating point value.\n", argval);
+		return err_FORMAT;
+	}
+	if (*endptr != '\0') {
+		fprintf(stderr, "Error:  Trailing garbage "
+		  "after floating point argument \"%s\".\n",
+		  argval);
+		return err_FORMAT;
+	}
+	*ret = v;
+	return 0;
+}
+
 int csnip_clopts_parser_pchar(const csnip_clopts* opts,
 			const csnip_clopts_optinfo* optinfo,
 			const char* argval)
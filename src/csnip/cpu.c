@@ -0,0 +1,323 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) \
+  && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define HAVE_CPUID
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define HAVE_CPUID
+#endif
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/cpu.h>
+#include <csnip/simd.h>
+
+/* Detection */
+
+#if defined(HAVE_CPUID)
+static void cpuid(unsigned leaf, unsigned sub, unsigned r[4])
+{
+#if defined(_MSC_VER)
+	int v[4];
+	__cpuidex(v, (int)leaf, (int)sub);
+	for (int i = 0; i < 4; ++i)
+		r[i] = (unsigned)v[i];
+#else
+	__cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+}
+
+/* The register state enabled by the OS (XCR0) */
+static uint64_t xgetbv0(void)
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32_t a, d;
+	__asm__ volatile ("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+	return ((uint64_t)d << 32) | a;
+#endif
+}
+#endif
+
+static unsigned detect(void)
+{
+	unsigned f = 0;
+#if defined(HAVE_CPUID)
+	unsigned r[4];
+	cpuid(0, 0, r);
+	const unsigned max_leaf = r[0];
+	if (max_leaf < 1)
+		return 0;
+
+	cpuid(1, 0, r);
+	const unsigned ecx1 = r[2], edx1 = r[3];
+	if (edx1 & (1u << 26))
+		f |= CSNIP_CPU_SSE2;
+	if (ecx1 & (1u << 9))
+		f |= CSNIP_CPU_SSSE3;
+	if (ecx1 & (1u << 19))
+		f |= CSNIP_CPU_SSE41;
+	if (ecx1 & (1u << 20))
+		f |= CSNIP_CPU_SSE42;
+	if (ecx1 & (1u << 23))
+		f |= CSNIP_CPU_POPCNT;
+
+	/* AVX and later need the OS to save the ymm (and zmm) state */
+	uint64_t xcr0 = 0;
+	if (ecx1 & (1u << 27))
+		xcr0 = xgetbv0();
+	const int os_ymm = ((xcr0 & 0x06) == 0x06);
+	const int os_zmm = ((xcr0 & 0xe6) == 0xe6);
+	if (os_ymm && (ecx1 & (1u << 28)))
+		f |= CSNIP_CPU_AVX;
+
+	if (max_leaf >= 7) {
+		cpuid(7, 0, r);
+		const unsigned ebx7 = r[1];
+		if (ebx7 & (1u << 8))
+			f |= CSNIP_CPU_BMI2;
+		if ((f & CSNIP_CPU_AVX) && (ebx7 & (1u << 5)))
+			f |= CSNIP_CPU_AVX2;
+		if (os_zmm && (ebx7 & (1u << 16))) {
+			f |= CSNIP_CPU_AVX512F;
+			if (ebx7 & (1u << 30))
+				f |= CSNIP_CPU_AVX512BW;
+			if (ebx7 & (1u << 17))
+				f |= CSNIP_CPU_AVX512DQ;
+			if (ebx7 & (1u << 31))
+				f |= CSNIP_CPU_AVX512VL;
+		}
+	}
+#elif defined(__aarch64__)
+	/* Advanced SIMD is mandatory on AArch64 */
+	f |= CSNIP_CPU_NEON;
+#endif
+	return f;
+}
+
+/* Environment */
+
+#if defined(CSNIP_CPU__USE_IFUNC)
+/* The indirect function resolvers may run while the library is being
+ * relocated (e.g., with LD_BIND_NOW), when no calls through the PLT
+ * can be made and environ isn't set up yet.  So the environment is
+ * read from /proc/self/environ with raw system calls.
+ */
+static long sys3(long nr, long a1, long a2, long a3)
+{
+#if defined(__x86_64__)
+	long r;
+	__asm__ volatile ("syscall"
+		: "=a"(r)
+		: "a"(nr), "D"(a1), "S"(a2), "d"(a3)
+		: "rcx", "r11", "memory");
+	return r;
+#elif defined(__aarch64__)
+	register long x8 __asm__("x8") = nr;
+	register long x0 __asm__("x0") = a1;
+	register long x1 __asm__("x1") = a2;
+	register long x2 __asm__("x2") = a3;
+	__asm__ volatile ("svc 0"
+		: "+r"(x0)
+		: "r"(x8), "r"(x1), "r"(x2)
+		: "memory");
+	return x0;
+#endif
+}
+
+#if defined(__x86_64__)
+#  define SYS_READ	0
+#  define SYS_CLOSE	3
+#  define SYS_OPENAT	257
+#elif defined(__aarch64__)
+#  define SYS_READ	63
+#  define SYS_CLOSE	57
+#  define SYS_OPENAT	56
+#endif
+#define AT_FDCWD_	(-100)
+
+/* Look up a variable; returns 1 and the (truncated) value in val if
+ * it is set.
+ */
+static int get_env(const char* name, char* val, size_t size)
+{
+	const long fd = sys3(SYS_OPENAT, AT_FDCWD_,
+				(long)"/proc/self/environ", 0);
+	if (fd < 0)
+		return 0;
+
+	size_t pos = 0;		/* Position in the current entry */
+	int match = 1;		/* Entry matches so far */
+	int in_val = 0;		/* Past the '=' of a matching entry */
+	size_t vlen = 0;
+	char buf[512];
+	long n;
+	while ((n = sys3(SYS_READ, fd, (long)buf, sizeof buf)) > 0) {
+		for (long i = 0; i < n; ++i) {
+			const char c = buf[i];
+			if (c == '\0') {
+				if (in_val) {
+					val[vlen] = '\0';
+					sys3(SYS_CLOSE, fd, 0, 0);
+					return 1;
+				}
+				pos = 0;
+				match = 1;
+				continue;
+			}
+			if (in_val) {
+				if (vlen + 1 < size)
+					val[vlen++] = c;
+			} else if (name[pos] != '\0') {
+				match = match && (c == name[pos]);
+				++pos;
+			} else {
+				in_val = match && (c == '=');
+				match = 0;
+			}
+		}
+	}
+	sys3(SYS_CLOSE, fd, 0, 0);
+	return 0;
+}
+#else
+static int get_env(const char* name, char* val, size_t size)
+{
+	const char* v = getenv(name);
+	if (v == NULL)
+		return 0;
+	size_t i = 0;
+	for (; v[i] && i + 1 < size; ++i)
+		val[i] = v[i];
+	val[i] = '\0';
+	return 1;
+}
+#endif
+
+/* Compare strings; the library's strcmp() can't be called from
+ * resolvers either.
+ */
+static int str_eq(const char* a, const char* b)
+{
+	while (*a && *a == *b) {
+		++a;
+		++b;
+	}
+	return *a == *b;
+}
+
+/* Get the level cap from the environment, or -1 if there is none. */
+static int env_level(void)
+{
+	char v[16];
+	if (!get_env("CSNIP_CPU_LEVEL", v, sizeof v))
+		return -1;
+
+	if (str_eq(v, "scalar"))
+		return CSNIP_CPU_LEVEL_SCALAR;
+	if (str_eq(v, "sse2"))
+		return CSNIP_CPU_LEVEL_SSE2;
+	if (str_eq(v, "neon"))
+		return CSNIP_CPU_LEVEL_NEON;
+	if (str_eq(v, "avx2"))
+		return CSNIP_CPU_LEVEL_AVX2;
+	if (str_eq(v, "avx512"))
+		return CSNIP_CPU_LEVEL_AVX512;
+	return -1;
+}
+
+static int detect_level(unsigned f)
+{
+	int level = CSNIP_CPU_LEVEL_SCALAR;
+#if defined(CSNIP_SIMD_HAVE_SSE2)
+	if (f & CSNIP_CPU_SSE2)
+		level = CSNIP_CPU_LEVEL_SSE2;
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX2)
+	if (f & CSNIP_CPU_AVX2)
+		level = CSNIP_CPU_LEVEL_AVX2;
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX512)
+	const unsigned avx512 = CSNIP_CPU_AVX512F | CSNIP_CPU_AVX512BW
+				| CSNIP_CPU_AVX512DQ;
+	if ((f & avx512) == avx512)
+		level = CSNIP_CPU_LEVEL_AVX512;
+#endif
+#if defined(CSNIP_SIMD_HAVE_NEON)
+	if (f & CSNIP_CPU_NEON)
+		level = CSNIP_CPU_LEVEL_NEON;
+#endif
+	const int cap = env_level();
+	if (cap >= 0 && cap < level)
+		level = cap;
+	return level;
+}
+
+/* Cached values, computed on first use; racing threads compute the
+ * same values.  Only static functions are called on the way to
+ * csnip_cpu__level(), see cpu.h.
+ */
+
+static unsigned features_cache;
+static int level_cache = -1;
+
+static unsigned features(void)
+{
+	unsigned f = csnip_cpu__Load(features_cache);
+	if (f == 0) {
+		/* Bit 31 marks the value as computed */
+		f = detect() | (1u << 31);
+		csnip_cpu__Store(features_cache, f);
+	}
+	return f & ~(1u << 31);
+}
+
+int csnip_cpu__level(void)
+{
+	int level = csnip_cpu__Load(level_cache);
+	if (level < 0) {
+		level = detect_level(features());
+		csnip_cpu__Store(level_cache, level);
+	}
+	return level;
+}
+
+/* Public interface */
+
+unsigned csnip_cpu_features(void)
+{
+	return features();
+}
+
+int csnip_cpu_has(unsigned f)
+{
+	return (features() & f) == f;
+}
+
+int csnip_cpu_level(void)
+{
+	return csnip_cpu__level();
+}
+
+const char* csnip_cpu_level_name(int level)
+{
+	switch (level) {
+	case CSNIP_CPU_LEVEL_SCALAR:
+		return "scalar";
+	case 1:
+#if defined(CSNIP_SIMD_HAVE_NEON)
+		return "neon";
+#else
+		return "sse2";
+#endif
+	case CSNIP_CPU_LEVEL_AVX2:
+		return "avx2";
+	case CSNIP_CPU_LEVEL_AVX512:
+		return "avx512";
+	}
+	return "unknown";
+}
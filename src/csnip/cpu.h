@@ -0,0 +1,221 @@
+#ifndef CSNIP_CPU_H
+#define CSNIP_CPU_H
+
+/**	@file cpu.h
+ *	@brief			CPU feature detection and dispatch
+ *	@defgroup cpu		CPU feature detection and dispatch
+ *	@{
+ *
+ *	Detects the instruction set extensions supported by the CPU (and
+ *	enabled by the operating system), and selects function
+ *	implementations accordingly at load time.
+ *
+ *	Kernels with implementations for several backends of simd.h
+ *	choose one by the SIMD level, csnip_cpu_level():  the widest
+ *	backend that is compiled in and usable on the CPU.  The level can
+ *	be capped by setting the environment variable CSNIP_CPU_LEVEL to
+ *	one of "scalar", "sse2", "avx2", "avx512" or "neon"; e.g.,
+ *	CSNIP_CPU_LEVEL=scalar forces the portable code paths, which is
+ *	useful for testing and for comparing performance.  Where the
+ *	level is determined at load time, later changes to the
+ *	environment (by setenv(), etc.) have no effect.
+ *
+ *	The csnip kernels dispatched this way are csnip_tokenize_find(),
+ *	csnip_search_lower_bound_i32_batch() and
+ *	csnip_hash_fnv32_batch().
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <csnip/csnip_conf.h>
+
+/** @name Feature flags */
+/**@{*/
+#define CSNIP_CPU_SSE2		(1u << 0)
+#define CSNIP_CPU_SSSE3		(1u << 1)
+#define CSNIP_CPU_SSE41		(1u << 2)
+#define CSNIP_CPU_SSE42		(1u << 3)
+#define CSNIP_CPU_POPCNT	(1u << 4)
+#define CSNIP_CPU_AVX		(1u << 5)
+#define CSNIP_CPU_AVX2		(1u << 6)
+#define CSNIP_CPU_BMI2		(1u << 7)
+#define CSNIP_CPU_AVX512F	(1u << 8)
+#define CSNIP_CPU_AVX512BW	(1u << 9)
+#define CSNIP_CPU_AVX512DQ	(1u << 10)
+#define CSNIP_CPU_AVX512VL	(1u << 11)
+#define CSNIP_CPU_NEON		(1u << 16)
+/**@}*/
+
+/** @name SIMD levels */
+/**@{*/
+#define CSNIP_CPU_LEVEL_SCALAR	0
+#define CSNIP_CPU_LEVEL_SSE2	1
+#define CSNIP_CPU_LEVEL_NEON	1
+#define CSNIP_CPU_LEVEL_AVX2	2
+#define CSNIP_CPU_LEVEL_AVX512	3
+/**@}*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**	The CPU features.
+ *
+ *	@return	the CSNIP_CPU_* flags of the features supported by
+ *		the CPU and the operating system.  Features that need
+ *		OS support for saving extended register state (AVX and
+ *		later) are only reported if the OS provides it.
+ *
+ *	The features are detected once and cached.
+ */
+unsigned csnip_cpu_features(void);
+
+/**	Test for a CPU feature.
+ *
+ *	@return	nonzero if all features in @a f are supported.
+ */
+int csnip_cpu_has(unsigned f);
+
+/**	The SIMD level.
+ *
+ *	@return	the CSNIP_CPU_LEVEL_* constant of the widest simd.h
+ *		backend that is both compiled in and supported by the
+ *		CPU, capped by the CSNIP_CPU_LEVEL environment variable.
+ *
+ *	Can be called from indirect function resolvers, i.e., before the
+ *	C library is fully initialized.
+ */
+int csnip_cpu_level(void);
+
+/**	Name of a SIMD level.
+ *
+ *	@return	the name as used in CSNIP_CPU_LEVEL, e.g., "avx2".
+ */
+const char* csnip_cpu_level_name(int level);
+
+/** @cond */
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(_WIN32)
+#  define csnip_cpu__hidden	__attribute__((visibility("hidden")))
+#else
+#  define csnip_cpu__hidden
+#endif
+
+/* Same as csnip_cpu_level(), for the library's own resolvers.  Hidden
+ * so that the call doesn't go through the PLT, which may not be
+ * relocated yet when the resolvers run.
+ */
+int csnip_cpu__level(void) csnip_cpu__hidden;
+
+/* GNU indirect functions need the glibc dynamic linker; musl, for
+ * one, doesn't support them.  Also, cpu.c needs to make raw system
+ * calls for them, see there.
+ */
+#if defined(CSNIP_CONF__HAVE_IFUNC) && defined(__GLIBC__) \
+  && defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#  define CSNIP_CPU__USE_IFUNC
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define csnip_cpu__Load(p)		__atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#  define csnip_cpu__Store(p, v) \
+	__atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+#else
+#  define csnip_cpu__Load(p)		(p)
+#  define csnip_cpu__Store(p, v)	((p) = (v))
+#endif
+/** @endcond */
+
+/** @name Dispatch */
+/**@{*/
+
+/**	Define a function dispatched on the CPU.
+ *
+ *	Defines the function
+ *
+ *		ret name params
+ *
+ *	as forwarding its arguments @a args to the implementation
+ *	returned by @a resolver.  The resolver is a function in the same
+ *	translation unit, without parameters, returning a pointer to a
+ *	function of the same type; it typically switches on
+ *	csnip_cpu_level().  For example:
+ *
+ *	@code{.c}
+ *		typedef size_t count_fn(const char* p, size_t n);
+ *		static count_fn* resolve_count(void)
+ *		{
+ *			if (csnip_cpu_level() >= CSNIP_CPU_LEVEL_AVX2)
+ *				return count_avx2;
+ *			return count_scalar;
+ *		}
+ *		csnip_cpu_Dispatch(size_t, count,
+ *			(const char* p, size_t n), (p, n), resolve_count)
+ *	@endcode
+ *
+ *	Where GNU indirect functions are supported (glibc on ELF
+ *	platforms), the function is one, and the resolver runs when the
+ *	dynamic linker binds the symbol, so that calls cost no more than
+ *	calls to any other function in a shared library.  Otherwise, the
+ *	resolver runs on the first call, and its result is cached in a
+ *	function pointer.  In either case, the resolver must be
+ *	idempotent.
+ *
+ *	@a ret must not be void; see csnip_cpu_DispatchVoid() for that.
+ */
+#if defined(CSNIP_CPU__USE_IFUNC)
+#define csnip_cpu_Dispatch(ret, name, params, args, resolver) \
+	ret name params __attribute__((ifunc(#resolver)));
+#else
+#define csnip_cpu_Dispatch(ret, name, params, args, resolver) \
+	ret name params \
+	{ \
+		static ret (*csnip__impl) params; \
+		ret (*csnip__f) params = csnip_cpu__Load(csnip__impl); \
+		if (csnip__f == NULL) { \
+			csnip__f = resolver(); \
+			csnip_cpu__Store(csnip__impl, csnip__f); \
+		} \
+		return csnip__f args; \
+	}
+#endif
+
+/**	Define a dispatched function without return value.
+ *
+ *	Like csnip_cpu_Dispatch(), for functions returning void.
+ */
+#if defined(CSNIP_CPU__USE_IFUNC)
+#define csnip_cpu_DispatchVoid(name, params, args, resolver) \
+	void name params __attribute__((ifunc(#resolver)));
+#else
+#define csnip_cpu_DispatchVoid(name, params, args, resolver) \
+	void name params \
+	{ \
+		static void (*csnip__impl) params; \
+		void (*csnip__f) params = csnip_cpu__Load(csnip__impl); \
+		if (csnip__f == NULL) { \
+			csnip__f = resolver(); \
+			csnip_cpu__Store(csnip__impl, csnip__f); \
+		} \
+		csnip__f args; \
+	}
+#endif
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* CSNIP_CPU_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_CPU_HAVE_SHORT_NAMES)
+#define cpu_features			csnip_cpu_features
+#define cpu_has				csnip_cpu_has
+#define cpu_level			csnip_cpu_level
+#define cpu_level_name			csnip_cpu_level_name
+#define cpu_Dispatch			csnip_cpu_Dispatch
+#define cpu_DispatchVoid		csnip_cpu_DispatchVoid
+#define CSNIP_CPU_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_CPU_HAVE_SHORT_NAMES */
@@ -15,6 +15,7 @@ static char* errstr_static(int errnum)
 	case csnip_err_UNEXPECTED_NULL:	return "Unexpected NULL pointer";
 	case csnip_err_INVAL:		return "Invalid argument";
 	case csnip_err_CALLFLOW:	return "Wrong call flow";
+	case csnip_err_UNSUPPORTED:	return "Operation not supported";
 	default:			return NULL;
 	};
 }
@@ -99,6 +99,7 @@
 #define csnip_err_UNEXPECTED_NULL	(-6)	/**< Invalid NULL pointer */
 #define csnip_err_INVAL			(-7)	/**< Invalid value */
 #define csnip_err_CALLFLOW		(-8)	/**< Invalid call flow */
+#define csnip_err_UNSUPPORTED		(-9)	/**< Unsupported operation */
 /** @} */
 
 #ifdef __cplusplus
@@ -141,5 +142,6 @@ void csnip_err_str(int errnum, char* buf, size_t buf_len);
 #define err_UNEXPECTED_NULL	csnip_err_UNEXPECTED_NULL
 #define err_INVAL		csnip_err_INVAL
 #define err_CALLFLOW		csnip_err_CALLFLOW
+#define err_UNSUPPORTED		csnip_err_UNSUPPORTED
 #define CSNIP_ERR_HAVE_SHORT_NAMES
 #endif /* CSNIP_SHORT_NAMES && !CSNIP_ERR_HAVE_SHORT_NAMES */
@@ -0,0 +1,616 @@
+#include <errno.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <csnip/csnip_conf.h>
+
+#if defined(CSNIP_CONF__HAVE_SYS_EPOLL_H) \
+  && defined(CSNIP_CONF__HAVE_SYS_TIMERFD_H) \
+  && defined(CSNIP_CONF__HAVE_SYS_EVENTFD_H)
+#define HAVE_EVLOOP
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/arr.h>
+#include <csnip/err.h>
+#include <csnip/evloop.h>
+#include <csnip/heap.h>
+#include <csnip/mem.h>
+
+#ifdef HAVE_EVLOOP
+
+/* File descriptor watcher; the watchers are stored in an array indexed
+ * by the file descriptor.
+ */
+struct watcher {
+	csnip_evloop_fd_cb cb;
+	void* arg;
+	unsigned events;	/* 0 if unused */
+	uint32_t gen;		/* Generation, to discard stale events */
+};
+
+/* Timer slot. */
+struct timer {
+	int64_t when;		/* Deadline */
+	int64_t period;		/* Period, 0 for one-shot timers */
+	uint64_t seq;		/* Insertion sequence number */
+	csnip_evloop_timer_cb cb;
+	void* arg;
+	size_t hpos;		/* Heap position, or NOPOS if free */
+	uint32_t gen;		/* Generation, part of the timer ID */
+	size_t next_free;	/* Next slot in the free list */
+};
+
+#define NOPOS	((size_t)-1)
+
+struct csnip_evloop {
+	int epfd;		/* epoll instance */
+	int tfd;		/* timerfd */
+	int efd;		/* eventfd for wakeups */
+
+	/* Watchers, indexed by fd */
+	struct watcher* w;
+	size_t nw, capw;
+
+	/* Timer slots and the heap of active timers (slot indices) */
+	struct timer* t;
+	size_t nt, capt;
+	size_t free_head;
+	size_t* heap;
+	size_t nheap, capheap;
+	uint64_t seq;
+
+	/* Deadline the timerfd is armed for, INT64_MAX if disarmed */
+	int64_t armed;
+
+	int stop;
+
+	csnip_evloop_wake_cb wake_cb;
+	void* wake_arg;
+};
+
+int64_t csnip_evloop_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Timer heap */
+
+static bool timer_less(const evloop* L, size_t a, size_t b)
+{
+	const struct timer* ta = &L->t[a];
+	const struct timer* tb = &L->t[b];
+	return ta->when < tb->when
+		|| (ta->when == tb->when && ta->seq < tb->seq);
+}
+
+static void heap_swap(evloop* L, size_t u, size_t v)
+{
+	const size_t s = L->heap[u];
+	L->heap[u] = L->heap[v];
+	L->heap[v] = s;
+	L->t[L->heap[u]].hpos = u;
+	L->t[L->heap[v]].hpos = v;
+}
+
+#define HEAP_LESS(u, v)	timer_less(L, L->heap[u], L->heap[v])
+#define HEAP_SWAP(u, v)	heap_swap(L, u, v)
+
+/* Insert into the heap, which must have room. */
+static void heap_push(evloop* L, size_t slot)
+{
+	L->heap[L->nheap++] = slot;
+	L->t[slot].hpos = L->nheap - 1;
+	L->t[slot].seq = L->seq++;
+	heap_SiftUp(u, v, HEAP_LESS(u, v), HEAP_SWAP(u, v),
+		2, L->nheap, L->nheap - 1);
+}
+
+static int heap_insert(evloop* L, size_t slot)
+{
+	if (L->nheap == L->capheap) {
+		int err = 0;
+		arr_Reserve(L->heap, L->nheap, L->capheap, L->nheap + 1, err);
+		if (err)
+			return err;
+	}
+	heap_push(L, slot);
+	return 0;
+}
+
+static void heap_remove(evloop* L, size_t pos)
+{
+	const size_t last = L->nheap - 1;
+	L->t[L->heap[pos]].hpos = NOPOS;
+	if (pos != last) {
+		L->heap[pos] = L->heap[last];
+		L->t[L->heap[pos]].hpos = pos;
+		--L->nheap;
+		heap_Sift(u, v, HEAP_LESS(u, v), HEAP_SWAP(u, v),
+			2, L->nheap, pos);
+	} else {
+		--L->nheap;
+	}
+}
+
+static void slot_release(evloop* L, size_t slot)
+{
+	++L->t[slot].gen;
+	L->t[slot].next_free = L->free_head;
+	L->free_head = slot;
+}
+
+static csnip_evloop_timer make_id(const evloop* L, size_t slot)
+{
+	return ((uint64_t)L->t[slot].gen << 32) | (uint64_t)slot;
+}
+
+/* Look up the slot of an active timer, or return NOPOS. */
+static size_t id_slot(const evloop* L, csnip_evloop_timer id)
+{
+	const size_t slot = (size_t)(id & 0xFFFFFFFFu);
+	if (slot >= L->nt
+	  || L->t[slot].gen != (uint32_t)(id >> 32)
+	  || L->t[slot].hpos == NOPOS)
+	{
+		return NOPOS;
+	}
+	return slot;
+}
+
+/* Arm the timerfd for the earliest deadline, if it changed. */
+static void arm_timerfd(evloop* L)
+{
+	const int64_t want = (L->nheap > 0 ? L->t[L->heap[0]].when
+					: INT64_MAX);
+	if (want == L->armed)
+		return;
+
+	struct itimerspec its;
+	memset(&its, 0, sizeof its);
+	if (want != INT64_MAX) {
+		/* An all-zero it_value would disarm the timer */
+		const int64_t w = (want > 0 ? want : 1);
+		its.it_value.tv_sec = w / 1000000000;
+		its.it_value.tv_nsec = w % 1000000000;
+	}
+	timerfd_settime(L->tfd, TFD_TIMER_ABSTIME, &its, NULL);
+	L->armed = want;
+}
+
+/* Run the timers that expired, return the number of callbacks
+ * invoked.  Timers added during this pass are deferred to the next
+ * iteration, so that timers re-adding themselves with zero delay can't
+ * starve the loop.
+ */
+static int run_timers(evloop* L)
+{
+	const int64_t now = csnip_evloop_now();
+	const uint64_t seq_limit = L->seq;
+	int ncalled = 0;
+	while (L->nheap > 0) {
+		const size_t slot = L->heap[0];
+		struct timer* T = &L->t[slot];
+		if (T->when > now || T->seq >= seq_limit)
+			break;
+
+		const csnip_evloop_timer id = make_id(L, slot);
+		const csnip_evloop_timer_cb cb = T->cb;
+		void* const arg = T->arg;
+		heap_remove(L, 0);
+		if (T->period > 0) {
+			/* Keep the phase, skip missed expiries */
+			T->when += ((now - T->when) / T->period + 1)
+				* T->period;
+
+			/* Can't fail:  the removal left room */
+			heap_push(L, slot);
+		} else {
+			slot_release(L, slot);
+		}
+
+		(*cb)(L, id, arg);
+		++ncalled;
+	}
+	return ncalled;
+}
+
+/* Internal watchers */
+
+static void timerfd_cb(evloop* L, int fd, unsigned revents, void* arg)
+{
+	(void)revents;
+	(void)arg;
+	uint64_t n;
+	if (read(fd, &n, sizeof n) < 0) {
+		/* EAGAIN: spurious, nothing to do */
+	}
+
+	/* The timerfd is disarmed after expiry */
+	L->armed = INT64_MAX;
+}
+
+static void eventfd_cb(evloop* L, int fd, unsigned revents, void* arg)
+{
+	(void)revents;
+	(void)arg;
+	uint64_t n;
+	if (read(fd, &n, sizeof n) == (ssize_t)sizeof n && L->wake_cb)
+		(*L->wake_cb)(L, L->wake_arg);
+}
+
+/* Creation and deletion */
+
+evloop* csnip_evloop_make(int* err)
+{
+	if (err)
+		*err = 0;
+	evloop* L;
+	mem_Alloc(1, L, *err);
+	if (L == NULL)
+		return NULL;
+	memset(L, 0, sizeof *L);
+	L->free_head = NOPOS;
+	L->armed = INT64_MAX;
+	L->tfd = L->efd = -1;
+
+	int e = 0;
+	L->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (L->epfd < 0) {
+		mem_Free(L);
+		csnip_err_Raise(csnip_err_ERRNO, *err);
+		return NULL;
+	}
+	L->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	L->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (L->tfd < 0 || L->efd < 0) {
+		e = csnip_err_ERRNO;
+	} else {
+		e = evloop_add_fd(L, L->tfd, EVLOOP_READ, timerfd_cb, NULL);
+		if (e == 0) {
+			e = evloop_add_fd(L, L->efd, EVLOOP_READ,
+				eventfd_cb, NULL);
+		}
+	}
+	if (e != 0) {
+		const int errno_save = errno;
+		evloop_free(L);
+		errno = errno_save;
+		csnip_err_Raise(e, *err);
+		return NULL;
+	}
+	return L;
+}
+
+void csnip_evloop_free(evloop* L)
+{
+	if (L == NULL)
+		return;
+	if (L->tfd >= 0)
+		close(L->tfd);
+	if (L->efd >= 0)
+		close(L->efd);
+	close(L->epfd);
+	mem_Free(L->w);
+	mem_Free(L->t);
+	mem_Free(L->heap);
+	mem_Free(L);
+}
+
+/* File descriptor watchers */
+
+static uint32_t to_epoll(unsigned events)
+{
+	uint32_t e = 0;
+	if (events & EVLOOP_READ)
+		e |= EPOLLIN | EPOLLRDHUP;
+	if (events & EVLOOP_WRITE)
+		e |= EPOLLOUT;
+	if (events & EVLOOP_EDGE)
+		e |= EPOLLET;
+	return e;
+}
+
+static unsigned from_epoll(uint32_t e)
+{
+	unsigned r = 0;
+	if (e & EPOLLIN)
+		r |= EVLOOP_READ;
+	if (e & EPOLLOUT)
+		r |= EVLOOP_WRITE;
+	if (e & EPOLLERR)
+		r |= EVLOOP_ERROR;
+	if (e & (EPOLLHUP | EPOLLRDHUP))
+		r |= EVLOOP_HUP;
+	return r;
+}
+
+static int epoll_update(evloop* L, int op, int fd)
+{
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof ev);
+	ev.events = to_epoll(L->w[fd].events);
+	ev.data.u64 = ((uint64_t)L->w[fd].gen << 32) | (uint32_t)fd;
+	if (epoll_ctl(L->epfd, op, fd, &ev) != 0)
+		return csnip_err_ERRNO;
+	return 0;
+}
+
+int csnip_evloop_add_fd(evloop* L,
+			int fd,
+			unsigned events,
+			csnip_evloop_fd_cb cb,
+			void* arg)
+{
+	if (fd < 0 || cb == NULL
+	  || (events & (EVLOOP_READ | EVLOOP_WRITE)) == 0)
+	{
+		return csnip_err_INVAL;
+	}
+
+	/* Grow the watcher array as needed */
+	if ((size_t)fd >= L->nw) {
+		int err = 0;
+		arr_Reserve(L->w, L->nw, L->capw, (size_t)fd + 1, err);
+		if (err)
+			return err;
+		memset(&L->w[L->nw], 0,
+			(L->capw - L->nw) * sizeof(struct watcher));
+		L->nw = L->capw;
+	}
+	struct watcher* W = &L->w[fd];
+	if (W->events != 0)
+		return csnip_err_INVAL;
+
+	W->cb = cb;
+	W->arg = arg;
+	W->events = events & (EVLOOP_READ | EVLOOP_WRITE | EVLOOP_EDGE);
+	++W->gen;
+	const int err = epoll_update(L, EPOLL_CTL_ADD, fd);
+	if (err)
+		W->events = 0;
+	return err;
+}
+
+int csnip_evloop_mod_fd(evloop* L, int fd, unsigned events)
+{
+	if (fd < 0 || (size_t)fd >= L->nw || L->w[fd].events == 0
+	  || (events & (EVLOOP_READ | EVLOOP_WRITE)) == 0)
+	{
+		return csnip_err_INVAL;
+	}
+	L->w[fd].events = events
+		& (EVLOOP_READ | EVLOOP_WRITE | EVLOOP_EDGE);
+	return epoll_update(L, EPOLL_CTL_MOD, fd);
+}
+
+int csnip_evloop_del_fd(evloop* L, int fd)
+{
+	if (fd < 0 || (size_t)fd >= L->nw || L->w[fd].events == 0)
+		return csnip_err_INVAL;
+	struct watcher* W = &L->w[fd];
+	W->events = 0;
+	W->cb = NULL;
+	++W->gen;
+
+	/* If the fd was closed already, the kernel has dropped it from
+	 * the interest list already.
+	 */
+	if (epoll_ctl(L->epfd, EPOLL_CTL_DEL, fd, NULL) != 0
+	  && errno != EBADF && errno != ENOENT)
+	{
+		return csnip_err_ERRNO;
+	}
+	return 0;
+}
+
+/* Timers */
+
+int csnip_evloop_add_timer(evloop* L,
+			int64_t delay_ns,
+			int64_t period_ns,
+			csnip_evloop_timer_cb cb,
+			void* arg,
+			csnip_evloop_timer* id)
+{
+	if (cb == NULL || period_ns < 0)
+		return csnip_err_INVAL;
+	if (delay_ns < 0)
+		delay_ns = 0;
+
+	/* Get a slot */
+	size_t slot;
+	if (L->free_head != NOPOS) {
+		slot = L->free_head;
+		L->free_head = L->t[slot].next_free;
+	} else {
+		if (L->nt >= 0xFFFFFFFFu)
+			return csnip_err_RANGE;
+		int err = 0;
+		const struct timer Tnew = { .gen = 1, .hpos = NOPOS };
+		arr_Push(L->t, L->nt, L->capt, Tnew, err);
+		if (err)
+			return err;
+		slot = L->nt - 1;
+	}
+
+	struct timer* T = &L->t[slot];
+	T->when = csnip_evloop_now() + delay_ns;
+	T->period = period_ns;
+	T->cb = cb;
+	T->arg = arg;
+	const int err = heap_insert(L, slot);
+	if (err) {
+		slot_release(L, slot);
+		return err;
+	}
+	if (id)
+		*id = make_id(L, slot);
+	arm_timerfd(L);
+	return 0;
+}
+
+int csnip_evloop_cancel_timer(evloop* L, csnip_evloop_timer id)
+{
+	const size_t slot = id_slot(L, id);
+	if (slot == NOPOS)
+		return csnip_err_INVAL;
+	heap_remove(L, L->t[slot].hpos);
+	slot_release(L, slot);
+	return 0;
+}
+
+/* Running */
+
+int csnip_evloop_run_once(evloop* L, int timeout_ms)
+{
+	struct epoll_event ev[CSNIP_EVLOOP_BATCH];
+
+	/* Don't block if timers are due already */
+	if (L->nheap > 0 && L->t[L->heap[0]].when <= csnip_evloop_now())
+		timeout_ms = 0;
+
+	int n = epoll_wait(L->epfd, ev, CSNIP_EVLOOP_BATCH, timeout_ms);
+	if (n < 0) {
+		if (errno != EINTR)
+			return csnip_err_ERRNO;
+		n = 0;
+	}
+
+	int ncalled = 0;
+	for (int i = 0; i < n; ++i) {
+		const int fd = (int)(uint32_t)ev[i].data.u64;
+		const uint32_t gen = (uint32_t)(ev[i].data.u64 >> 32);
+		if ((size_t)fd >= L->nw)
+			continue;
+		const struct watcher* W = &L->w[fd];
+		if (W->events == 0 || W->gen != gen)
+			continue;	/* Removed in this batch */
+		const csnip_evloop_fd_cb cb = W->cb;
+		(*cb)(L, fd, from_epoll(ev[i].events), W->arg);
+		if (cb != timerfd_cb && cb != eventfd_cb)
+			++ncalled;
+	}
+
+	ncalled += run_timers(L);
+	arm_timerfd(L);
+	return ncalled;
+}
+
+int csnip_evloop_run(evloop* L)
+{
+	while (!__atomic_load_n(&L->stop, __ATOMIC_ACQUIRE)) {
+		const int r = evloop_run_once(L, -1);
+		if (r < 0)
+			return r;
+	}
+	__atomic_store_n(&L->stop, 0, __ATOMIC_RELAXED);
+	return 0;
+}
+
+void csnip_evloop_stop(evloop* L)
+{
+	__atomic_store_n(&L->stop, 1, __ATOMIC_RELEASE);
+	evloop_wakeup(L);
+}
+
+void csnip_evloop_set_wake_cb(evloop* L, csnip_evloop_wake_cb cb, void* arg)
+{
+	L->wake_cb = cb;
+	L->wake_arg = arg;
+}
+
+int csnip_evloop_wakeup(evloop* L)
+{
+	const uint64_t one = 1;
+	if (write(L->efd, &one, sizeof one) < 0 && errno != EAGAIN)
+		return csnip_err_ERRNO;
+	return 0;
+}
+
+#else /* HAVE_EVLOOP */
+
+/* Stubs for systems without epoll */
+
+evloop* csnip_evloop_make(int* err)
+{
+	csnip_err_Raise(csnip_err_UNSUPPORTED, *err);
+	return NULL;
+}
+
+void csnip_evloop_free(evloop* L)
+{
+	(void)L;
+}
+
+int csnip_evloop_add_fd(evloop* L,
+			int fd,
+			unsigned events,
+			csnip_evloop_fd_cb cb,
+			void* arg)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+int csnip_evloop_mod_fd(evloop* L, int fd, unsigned events)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+int csnip_evloop_del_fd(evloop* L, int fd)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+int64_t csnip_evloop_now(void)
+{
+	return 0;
+}
+
+int csnip_evloop_add_timer(evloop* L,
+			int64_t delay_ns,
+			int64_t period_ns,
+			csnip_evloop_timer_cb cb,
+			void* arg,
+			csnip_evloop_timer* id)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+int csnip_evloop_cancel_timer(evloop* L, csnip_evloop_timer id)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+int csnip_evloop_run_once(evloop* L, int timeout_ms)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+int csnip_evloop_run(evloop* L)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+void csnip_evloop_stop(evloop* L)
+{
+}
+
+void csnip_evloop_set_wake_cb(evloop* L, csnip_evloop_wake_cb cb, void* arg)
+{
+}
+
+int csnip_evloop_wakeup(evloop* L)
+{
+	return csnip_err_UNSUPPORTED;
+}
+
+#endif /* HAVE_EVLOOP */
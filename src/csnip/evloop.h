@@ -0,0 +1,242 @@
+#ifndef CSNIP_EVLOOP_H
+#define CSNIP_EVLOOP_H
+
+/**	@file evloop.h
+ *	@brief			Event loop
+ *	@defgroup evloop	Event loop
+ *	@{
+ *
+ *	An event loop (reactor) for Linux, based on epoll.
+ *
+ *	The loop dispatches three kinds of events to callbacks:
+ *
+ *	* File descriptor readiness.  Watchers can be level-triggered
+ *	  (the default) or edge-triggered (CSNIP_EVLOOP_EDGE).
+ *
+ *	* Timers, one-shot or periodic, with nanosecond resolution.  The
+ *	  timers are kept in a binary heap (see heap.h), and a single
+ *	  timerfd is armed for the earliest deadline.
+ *
+ *	* Wakeups from other threads, delivered through an eventfd.
+ *
+ *	Each iteration fetches up to CSNIP_EVLOOP_BATCH ready events
+ *	with a single epoll_wait() call and dispatches them in order,
+ *	followed by the expired timers.
+ *
+ *	Apart from csnip_evloop_wakeup() and csnip_evloop_stop(), an
+ *	event loop must only be used by one thread at a time.  Callbacks
+ *	may add and remove watchers and timers, including their own.
+ *
+ *	On systems without epoll, timerfd and eventfd, csnip_evloop_make()
+ *	fails with csnip_err_UNSUPPORTED.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @name Event flags */
+/**@{*/
+#define CSNIP_EVLOOP_READ	1	/**< Readable */
+#define CSNIP_EVLOOP_WRITE	2	/**< Writable */
+#define CSNIP_EVLOOP_EDGE	4	/**< Edge-triggered (request only) */
+#define CSNIP_EVLOOP_ERROR	8	/**< Error condition (report only) */
+#define CSNIP_EVLOOP_HUP	16	/**< Hang up (report only) */
+/**@}*/
+
+#ifndef CSNIP_EVLOOP_BATCH
+/** Maximum number of events fetched per loop iteration. */
+#define CSNIP_EVLOOP_BATCH	64
+#endif
+
+/** Event loop (opaque). */
+typedef struct csnip_evloop csnip_evloop;
+
+/** Timer identifier.
+ *
+ *  Identifiers of expired one-shot and cancelled timers are not
+ *  reused.  0 is never a valid identifier.
+ */
+typedef uint64_t csnip_evloop_timer;
+
+/** File descriptor callback.
+ *
+ *  @param	revents
+ *		the events that occurred, a combination of
+ *		CSNIP_EVLOOP_READ, _WRITE, _ERROR and _HUP.
+ */
+typedef void (*csnip_evloop_fd_cb)(csnip_evloop* L,
+				int fd,
+				unsigned revents,
+				void* arg);
+
+/** Timer callback. */
+typedef void (*csnip_evloop_timer_cb)(csnip_evloop* L,
+				csnip_evloop_timer id,
+				void* arg);
+
+/** Wakeup callback. */
+typedef void (*csnip_evloop_wake_cb)(csnip_evloop* L, void* arg);
+
+/** Create an event loop.
+ *
+ *  @param	err
+ *		error return; csnip_err_NOMEM, csnip_err_ERRNO if one
+ *		of the kernel objects could not be created, or
+ *		csnip_err_UNSUPPORTED.
+ *
+ *  @return	the event loop, or NULL on error.
+ */
+csnip_evloop* csnip_evloop_make(int* err);
+
+/** Free an event loop.
+ *
+ *  Watched file descriptors are not closed.
+ */
+void csnip_evloop_free(csnip_evloop* L);
+
+/** @name File descriptor watchers */
+/**@{*/
+
+/** Watch a file descriptor.
+ *
+ *  @param	events
+ *		combination of CSNIP_EVLOOP_READ, CSNIP_EVLOOP_WRITE and
+ *		optionally CSNIP_EVLOOP_EDGE.
+ *
+ *  @return	0 on success, csnip_err_INVAL if the fd is already
+ *		watched, csnip_err_NOMEM, or csnip_err_ERRNO.
+ */
+int csnip_evloop_add_fd(csnip_evloop* L,
+			int fd,
+			unsigned events,
+			csnip_evloop_fd_cb cb,
+			void* arg);
+
+/** Change the events of a watched file descriptor. */
+int csnip_evloop_mod_fd(csnip_evloop* L, int fd, unsigned events);
+
+/** Stop watching a file descriptor.
+ *
+ *  Events already fetched for the descriptor in the current batch are
+ *  discarded.  This should be called before the descriptor is closed.
+ */
+int csnip_evloop_del_fd(csnip_evloop* L, int fd);
+/**@}*/
+
+/** @name Timers */
+/**@{*/
+
+/** Current time of the loop's clock (CLOCK_MONOTONIC) in ns. */
+int64_t csnip_evloop_now(void);
+
+/** Add a timer.
+ *
+ *  @param	delay_ns
+ *		time until the first expiry, in nanoseconds.
+ *
+ *  @param	period_ns
+ *		period for periodic timers, or 0 for one-shot timers.
+ *		Periodic timers keep their phase; expiries that were
+ *		missed (e.g. because a callback blocked the loop) are
+ *		skipped rather than delivered in a burst.
+ *
+ *  @param	id
+ *		if not NULL, receives the timer's identifier.
+ */
+int csnip_evloop_add_timer(csnip_evloop* L,
+			int64_t delay_ns,
+			int64_t period_ns,
+			csnip_evloop_timer_cb cb,
+			void* arg,
+			csnip_evloop_timer* id);
+
+/** Cancel a timer.
+ *
+ *  @return	0 on success, or csnip_err_INVAL if there is no such
+ *		timer (e.g., because the one-shot timer expired).
+ */
+int csnip_evloop_cancel_timer(csnip_evloop* L, csnip_evloop_timer id);
+/**@}*/
+
+/** @name Running the loop */
+/**@{*/
+
+/** Run one iteration of the loop.
+ *
+ *  Waits for events, dispatches them, and runs the expired timers.
+ *
+ *  @param	timeout_ms
+ *		maximum time to wait for events in milliseconds; -1 to
+ *		wait indefinitely, 0 to not wait.
+ *
+ *  @return	the number of callbacks invoked, or a negative csnip
+ *		error code.
+ */
+int csnip_evloop_run_once(csnip_evloop* L, int timeout_ms);
+
+/** Run the loop until csnip_evloop_stop() is called.
+ *
+ *  @return	0, or a negative csnip error code.
+ */
+int csnip_evloop_run(csnip_evloop* L);
+
+/** Stop csnip_evloop_run().
+ *
+ *  Can be called from callbacks and from other threads.
+ */
+void csnip_evloop_stop(csnip_evloop* L);
+
+/** Set the wakeup callback.
+ *
+ *  The callback is invoked in the loop's thread after one or more
+ *  csnip_evloop_wakeup() calls.
+ */
+void csnip_evloop_set_wake_cb(csnip_evloop* L,
+			csnip_evloop_wake_cb cb,
+			void* arg);
+
+/** Wake up the loop.
+ *
+ *  Thread-safe and async-signal-safe.  Multiple wakeups before the
+ *  loop gets to run are coalesced.
+ */
+int csnip_evloop_wakeup(csnip_evloop* L);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* CSNIP_EVLOOP_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_EVLOOP_HAVE_SHORT_NAMES)
+#define EVLOOP_READ			CSNIP_EVLOOP_READ
+#define EVLOOP_WRITE			CSNIP_EVLOOP_WRITE
+#define EVLOOP_EDGE			CSNIP_EVLOOP_EDGE
+#define EVLOOP_ERROR			CSNIP_EVLOOP_ERROR
+#define EVLOOP_HUP			CSNIP_EVLOOP_HUP
+#define evloop				csnip_evloop
+#define evloop_timer			csnip_evloop_timer
+#define evloop_fd_cb			csnip_evloop_fd_cb
+#define evloop_timer_cb			csnip_evloop_timer_cb
+#define evloop_wake_cb			csnip_evloop_wake_cb
+#define evloop_make			csnip_evloop_make
+#define evloop_free			csnip_evloop_free
+#define evloop_add_fd			csnip_evloop_add_fd
+#define evloop_mod_fd			csnip_evloop_mod_fd
+#define evloop_del_fd			csnip_evloop_del_fd
+#define evloop_now			csnip_evloop_now
+#define evloop_add_timer		csnip_evloop_add_timer
+#define evloop_cancel_timer		csnip_evloop_cancel_timer
+#define evloop_run_once			csnip_evloop_run_once
+#define evloop_run			csnip_evloop_run
+#define evloop_stop			csnip_evloop_stop
+#define evloop_set_wake_cb		csnip_evloop_set_wake_cb
+#define evloop_wakeup			csnip_evloop_wakeup
+#define CSNIP_EVLOOP_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_EVLOOP_HAVE_SHORT_NAMES */
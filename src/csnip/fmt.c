@@ -0,0 +1,151 @@
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/arr.h>
+#include <csnip/err.h>
+#include <csnip/fmt.h>
+#include <csnip/mem.h>
+#include <csnip/util.h>
+
+void csnip_fmt_template_init(fmt_template* T)
+{
+	T->lit = NULL;
+	T->lit_len = 0;
+	T->lit_cap = 0;
+	T->ops = NULL;
+	T->n_ops = 0;
+	T->ops_cap = 0;
+	T->max_key = -1;
+}
+
+int csnip_fmt_template_add_literal(fmt_template* T,
+				const char* s,
+				size_t len)
+{
+	if (len == 0)
+		return 0;
+
+	int err = 0;
+	if (T->lit_len + len > T->lit_cap) {
+		arr_Reserve(T->lit, T->lit_len, T->lit_cap,
+			T->lit_len + len, err);
+		if (err)
+			return err;
+	}
+	memcpy(T->lit + T->lit_len, s, len);
+	T->lit_len += len;
+
+	/* Adjacent literals are merged into one span */
+	if (T->n_ops > 0 && T->ops[T->n_ops - 1].key < 0) {
+		T->ops[T->n_ops - 1].len += len;
+		return 0;
+	}
+	const struct csnip_fmt__op op = { len, -1 };
+	arr_Push(T->ops, T->n_ops, T->ops_cap, op, err);
+	return err;
+}
+
+int csnip_fmt_template_add_key(fmt_template* T, int key)
+{
+	int err = 0;
+	const struct csnip_fmt__op op = { 0, key };
+	arr_Push(T->ops, T->n_ops, T->ops_cap, op, err);
+	if (err == 0 && key > T->max_key)
+		T->max_key = key;
+	return err;
+}
+
+int csnip_fmt_template_key(const char* const* keys,
+			const char* s,
+			size_t len)
+{
+	for (int i = 0; keys[i]; ++i) {
+		if (strncmp(keys[i], s, len) == 0 && keys[i][len] == '\0')
+			return i;
+	}
+	return -1;
+}
+
+size_t csnip_fmt_template_size(const fmt_template* T,
+				const char* const* vals,
+				const size_t* vlens)
+{
+	size_t n = T->lit_len;
+	for (int i = 0; i < T->n_ops; ++i) {
+		const int k = T->ops[i].key;
+		if (k >= 0)
+			n += (vlens ? vlens[k] : strlen(vals[k]));
+	}
+	return n;
+}
+
+size_t csnip_fmt_template_render_to(const fmt_template* T,
+				const char* const* vals,
+				const size_t* vlens,
+				char* buf)
+{
+	const char* lit = T->lit;
+	char* out = buf;
+	for (int i = 0; i < T->n_ops; ++i) {
+		const int k = T->ops[i].key;
+		if (k < 0) {
+			const size_t l = T->ops[i].len;
+			memcpy(out, lit, l);
+			lit += l;
+			out += l;
+		} else {
+			const size_t l = (vlens ? vlens[k] : strlen(vals[k]));
+			memcpy(out, vals[k], l);
+			out += l;
+		}
+	}
+	*out = '\0';
+	return (size_t)(out - buf);
+}
+
+char* csnip_fmt_template_render(const fmt_template* T,
+				const char* const* vals,
+				const size_t* vlens,
+				size_t* len,
+				int* err)
+{
+	if (err)
+		*err = 0;
+
+	/* Value lengths, measured once */
+	size_t small[16];
+	size_t* l = small;
+	if (vlens == NULL && T->max_key >= 0) {
+		if (T->max_key >= (int)Static_len(small)) {
+			mem_Alloc((size_t)T->max_key + 1, l, *err);
+			if (l == NULL)
+				return NULL;
+		}
+		for (int i = 0; i < T->n_ops; ++i) {
+			const int k = T->ops[i].key;
+			if (k >= 0)
+				l[k] = strlen(vals[k]);
+		}
+		vlens = l;
+	}
+
+	char* out;
+	const size_t n = fmt_template_size(T, vals, vlens);
+	mem_Alloc(n + 1, out, *err);
+	if (out) {
+		fmt_template_render_to(T, vals, vlens, out);
+		if (len)
+			*len = n;
+	}
+	if (l != small)
+		free(l);
+	return out;
+}
+
+void csnip_fmt_template_free(fmt_template* T)
+{
+	mem_Free(T->lit);
+	mem_Free(T->ops);
+	fmt_template_init(T);
+}
@@ -25,14 +25,53 @@
  *	\include fmt.c
  *
  *	The source code can be found in examples/fmt.c.
+ *
+ *	When the same format string is expanded many times, it can
+ *	instead be compiled once with csnip_fmt_Compile() into a
+ *	template, a list of literal text spans and key IDs.  The key IDs
+ *	are the indices of the keys in a key table, and rendering the
+ *	template with csnip_fmt_Render() only takes an array of values
+ *	indexed by key ID.  Rendering computes the output size up front,
+ *	allocates once, and copies literals and values with memcpy(),
+ *	instead of rescanning the format string, matching keys and
+ *	appending the output character by character.
  */
 
+#include <stddef.h>
 #include <string.h>
 #include <ctype.h>
 
 #include <csnip/arr.h>
 #include <csnip/err.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Compiled format template.
+ *
+ *  Created with csnip_fmt_Compile(), and released with
+ *  csnip_fmt_template_free(); the members are internal.
+ */
+typedef struct {
+	/** @cond */
+	char* lit;		/* Literal text of all spans */
+	size_t lit_len;
+	size_t lit_cap;
+	struct csnip_fmt__op {
+		size_t len;	/* Literal span length */
+		int key;	/* Key ID, or -1 for a literal span */
+	} *ops;
+	int n_ops;
+	int ops_cap;
+	int max_key;		/* Largest key ID used, or -1 */
+	/** @endcond */
+} csnip_fmt_template;
+
+#ifdef __cplusplus
+}
+#endif
+
 /**	Format / interpolate a string.
  *
  *	@param		fmtstr
@@ -350,6 +389,227 @@
 		} \
 	} while (0)
 
+/** @name Compiled templates */
+/**@{*/
+
+/**	Compile a format string into a template.
+ *
+ *	The format string syntax is that of csnip_fmt_Str(): keys start
+ *	with the key character and are delimited by the @a scan_key
+ *	statement, and a doubled key character stands for a literal
+ *	one.  Keys are resolved at compile time by looking them up in
+ *	the key table @a keys; a key's ID is its index in the table.
+ *
+ *	@param		fmtstr
+ *			Format string.
+ *
+ *	@param		keychar
+ *			The key character.
+ *
+ *	@param		key_start, key_end, p
+ *			Dummy variables, as for csnip_fmt_Gen().
+ *
+ *	@param		scan_key
+ *			Key scanner statement, as for csnip_fmt_Gen().
+ *
+ *	@param		keys
+ *			NULL terminated array of key names.
+ *
+ *	@param[out]	T
+ *			Pointer to the template to initialize.  It must
+ *			be released with csnip_fmt_template_free(), also
+ *			after an error.
+ *
+ *	@param[out]	err
+ *			Error return.  csnip_err_FORMAT is raised for
+ *			key parsing errors and unknown keys,
+ *			csnip_err_NOMEM if out of memory.
+ */
+#define csnip_fmt_Compile(fmtstr, \
+			keychar, \
+			key_start, \
+			key_end, \
+			p, \
+			scan_key, \
+			keys, \
+			T, \
+			err) \
+	do { \
+		csnip_fmt_template* csnip_fmt__T = (T); \
+		int csnip_fmt__err = 0; \
+		const char* p = (fmtstr); \
+		csnip_fmt_template_init(csnip_fmt__T); \
+	\
+		while (csnip_fmt__err == 0) { \
+			/* Scan the next literal */ \
+			const char* csnip_fmt__lit = p; \
+			while (*p != '\0') { \
+				if (*p == (keychar)) { \
+					if (p[1] != (keychar)) \
+						break; \
+					/* Keep one key character */ \
+					++p; \
+					csnip_fmt__err = \
+					  csnip_fmt_template_add_literal( \
+						csnip_fmt__T, \
+						csnip_fmt__lit, \
+						(size_t)(p - csnip_fmt__lit)); \
+					csnip_fmt__lit = ++p; \
+					continue; \
+				} \
+				++p; \
+			} \
+			if (csnip_fmt__err == 0) { \
+				csnip_fmt__err = \
+				  csnip_fmt_template_add_literal( \
+					csnip_fmt__T, \
+					csnip_fmt__lit, \
+					(size_t)(p - csnip_fmt__lit)); \
+			} \
+			if (*p == '\0' || *++p == '\0') \
+				break; \
+	\
+			/* Find the end of the key name */ \
+			const char* key_start = p; \
+			const char* key_end = NULL; \
+			do { scan_key; } while (0); \
+			if (key_end == NULL) { \
+				csnip_fmt__err = csnip_err_FORMAT; \
+				break; \
+			} \
+	\
+			/* Resolve it */ \
+			const int csnip_fmt__key = csnip_fmt_template_key( \
+				(keys), \
+				key_start, \
+				(size_t)(key_end - key_start)); \
+			if (csnip_fmt__key < 0) { \
+				csnip_fmt__err = csnip_err_FORMAT; \
+				break; \
+			} \
+			csnip_fmt__err = csnip_fmt_template_add_key( \
+				csnip_fmt__T, csnip_fmt__key); \
+		} \
+		if (csnip_fmt__err) \
+			csnip_err_Raise(csnip_fmt__err, err); \
+	} while (0)
+
+/**	Render a compiled template.
+ *
+ *	@param		T
+ *			Pointer to the template.
+ *
+ *	@param		vals
+ *			Array of NUL terminated values, indexed by key
+ *			ID.
+ *
+ *	@param[out]	out
+ *			Target variable to hold the newly allocated
+ *			output string, of type char*.  NULL on error.
+ *
+ *	@param[out]	err
+ *			Error return.
+ */
+#define csnip_fmt_Render(T, vals, out, err) \
+	do { \
+		int csnip_fmt__err = 0; \
+		(out) = csnip_fmt_template_render((T), \
+					(vals), \
+					NULL, \
+					NULL, \
+					&csnip_fmt__err); \
+		if (csnip_fmt__err) \
+			csnip_err_Raise(csnip_fmt__err, err); \
+	} while (0)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**	Initialize an empty template. */
+void csnip_fmt_template_init(csnip_fmt_template* T);
+
+/**	Append a literal span to a template.
+ *
+ *	@return	0 on success, or csnip_err_NOMEM.
+ */
+int csnip_fmt_template_add_literal(csnip_fmt_template* T,
+				const char* s,
+				size_t len);
+
+/**	Append a key to a template.
+ *
+ *	@return	0 on success, or csnip_err_NOMEM.
+ */
+int csnip_fmt_template_add_key(csnip_fmt_template* T, int key);
+
+/**	Look up a key in a key table.
+ *
+ *	@param	keys
+ *		NULL terminated array of key names.
+ *
+ *	@return	the index of the key s[0 .. len) in @a keys, or -1 if it
+ *		is not found.
+ */
+int csnip_fmt_template_key(const char* const* keys,
+			const char* s,
+			size_t len);
+
+/**	Length of a rendered template.
+ *
+ *	@param	vals
+ *		Array of values, indexed by key ID.
+ *
+ *	@param	vlens
+ *		Array of the lengths of the values, or NULL to use the
+ *		string lengths of the values.
+ *
+ *	@return	the output length, not counting the terminating '\0'.
+ */
+size_t csnip_fmt_template_size(const csnip_fmt_template* T,
+				const char* const* vals,
+				const size_t* vlens);
+
+/**	Render a template into a buffer.
+ *
+ *	The buffer must have room for csnip_fmt_template_size() + 1
+ *	bytes; the output is '\0' terminated.  Arguments are as for
+ *	csnip_fmt_template_size().
+ *
+ *	@return	the output length.
+ */
+size_t csnip_fmt_template_render_to(const csnip_fmt_template* T,
+				const char* const* vals,
+				const size_t* vlens,
+				char* buf);
+
+/**	Render a template into a new string.
+ *
+ *	Like csnip_fmt_template_render_to(), but allocates the output.
+ *
+ *	@param[out]	len
+ *			If not NULL, the output length is returned here.
+ *
+ *	@param[out]	err
+ *			Error return: csnip_err_NOMEM if out of memory.
+ *
+ *	@return	the output string, to be released with free(), or NULL
+ *		on error.
+ */
+char* csnip_fmt_template_render(const csnip_fmt_template* T,
+				const char* const* vals,
+				const size_t* vlens,
+				size_t* len,
+				int* err);
+
+/**	Release the memory held by a template. */
+void csnip_fmt_template_free(csnip_fmt_template* T);
+
+#ifdef __cplusplus
+}
+#endif
+/**@}*/
+
 #endif /* CSNIP_FMT_H */
 
 #if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_FMT_HAVE_SHORT_NAMES)
@@ -358,5 +618,16 @@
 #define fmt_ScanToChar		csnip_fmt_ScanToChar
 #define fmt_ScanShStyle		csnip_fmt_ScanShStyle
 #define fmt_ListMatch		csnip_fmt_ListMatch
+#define fmt_Compile		csnip_fmt_Compile
+#define fmt_Render		csnip_fmt_Render
+#define fmt_template		csnip_fmt_template
+#define fmt_template_init	csnip_fmt_template_init
+#define fmt_template_add_literal	csnip_fmt_template_add_literal
+#define fmt_template_add_key	csnip_fmt_template_add_key
+#define fmt_template_key	csnip_fmt_template_key
+#define fmt_template_size	csnip_fmt_template_size
+#define fmt_template_render_to	csnip_fmt_template_render_to
+#define fmt_template_render	csnip_fmt_template_render
+#define fmt_template_free	csnip_fmt_template_free
 #define CSNIP_FMT_HAVE_SHORT_NAMES
 #endif /* CSNIP_SHORT_NAMES && !CSNIP_FMT_HAVE_SHORT_NAMES */
@@ -1,5 +1,9 @@
+#include <limits.h>
+
 #define CSNIP_SHORT_NAMES
+#include <csnip/cpu.h>
 #include <csnip/hash.h>
+#include <csnip/simd.h>
 
 #define	FNV_p32		((uint32_t)0x01000193ul)
 #define FNV_p64		((uint64_t)0x00000100000001B3ull)
@@ -37,6 +41,161 @@ uint32_t csnip_hash_fnv32_s(const char* str, uint32_t h0)
 	return h0;
 }
 
+/* Batched FNV32, with one key per vector lane.  The keys are read 4
+ * bytes at a time with gathers, which assumes little endian byte
+ * order.  The multiplications have a long latency, so the hashes of
+ * U vectors of keys are computed in an interleaved fashion.  Keys
+ * shorter than 4 bytes and the leftover keys are hashed serially.
+ */
+#define V(be, name)	csnip_simd_ ## be ## _ ## name
+
+#define U		4
+
+/* h = (h ^ ((w >> s) & 0xff)) * prime, lanewise */
+#define FNV32_STEP(be, h, w, s) \
+	h = V(be, i32_mullo)(V(be, i32_xor)(h, \
+		V(be, i32_and)(V(be, i32_shr)(w, s), ff)), prime)
+
+#define DEFINE_FNV32_BATCH(be, W, target) \
+	/* Hash u <= U vectors of keys from g on. */ \
+	target static void fnv32_vectors_ ## be(const char* g, \
+						size_t key_size, \
+						uint32_t h0, \
+						uint32_t* out, \
+						int u) \
+	{ \
+		enum { L = W / 4 }; \
+		int32_t off[L]; \
+		for (int i = 0; i < L; ++i) \
+			off[i] = (int32_t)(i * key_size); \
+		const V(be, i32) voff = V(be, i32_load)(off); \
+		const V(be, i32) prime = V(be, i32_splat)(FNV_p32); \
+		const V(be, i32) ff = V(be, i32_splat)(0xff); \
+		const size_t stride = L * key_size; \
+		V(be, i32) h[U]; \
+		for (int q = 0; q < u; ++q) \
+			h[q] = V(be, i32_splat)((int32_t)h0); \
+		size_t j = 0; \
+		for (; j + 4 <= key_size; j += 4) { \
+			for (int q = 0; q < u; ++q) { \
+				const V(be, i32) w = V(be, i32_gather)( \
+						g + q * stride + j, voff); \
+				for (int s = 0; s < 32; s += 8) \
+					FNV32_STEP(be, h[q], w, s); \
+			} \
+		} \
+		if (j < key_size) { \
+			/* The tail bytes are the top ones of the last 4 */ \
+			const int s0 = (int)(4 - (key_size - j)) * 8; \
+			for (int q = 0; q < u; ++q) { \
+				const V(be, i32) w = V(be, i32_gather)( \
+					g + q * stride + key_size - 4, voff); \
+				for (int s = s0; s < 32; s += 8) \
+					FNV32_STEP(be, h[q], w, s); \
+			} \
+		} \
+		for (int q = 0; q < u; ++q) \
+			V(be, i32_store)(out + q * L, h[q]); \
+	} \
+	\
+	target static void fnv32_batch_ ## be(const void* keys, \
+						size_t key_size, \
+						size_t n, \
+						uint32_t h0, \
+						uint32_t* out) \
+	{ \
+		enum { L = W / 4 }; \
+		const char* base = (const char*)keys; \
+		size_t k = 0; \
+		if (key_size >= 4 && key_size <= INT32_MAX / L) { \
+			for (; k + U * L <= n; k += U * L) { \
+				fnv32_vectors_ ## be(base + k * key_size, \
+					key_size, h0, out + k, U); \
+			} \
+			for (; k + L <= n; k += L) { \
+				fnv32_vectors_ ## be(base + k * key_size, \
+					key_size, h0, out + k, 1); \
+			} \
+		} \
+		for (; k < n; ++k) { \
+			out[k] = fnv32_serial(base + k * key_size, \
+						key_size, h0); \
+		} \
+	}
+
+static uint32_t fnv32_serial(const void* buf, size_t sz, uint32_t h0)
+{
+	hash_buf(buf, sz, h0, FNV_p32);
+	return h0;
+}
+
+static void fnv32_batch_portable(const void* keys,
+				size_t key_size,
+				size_t n,
+				uint32_t h0,
+				uint32_t* out)
+{
+	const char* base = (const char*)keys;
+	for (size_t k = 0; k < n; ++k)
+		out[k] = fnv32_serial(base + k * key_size, key_size, h0);
+}
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+#  if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#    define LITTLE_ENDIAN_HOST
+#  endif
+#elif defined(_MSC_VER)
+#  define LITTLE_ENDIAN_HOST
+#endif
+
+#if defined(CSNIP_SIMD_HAVE_SSE2)
+DEFINE_FNV32_BATCH(sse2, 16, CSNIP_SIMD_TARGET_SSE2)
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX2)
+DEFINE_FNV32_BATCH(avx2, 32, CSNIP_SIMD_TARGET_AVX2)
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX512)
+DEFINE_FNV32_BATCH(avx512, 64, CSNIP_SIMD_TARGET_AVX512)
+#endif
+#if defined(CSNIP_SIMD_HAVE_NEON) && defined(LITTLE_ENDIAN_HOST)
+DEFINE_FNV32_BATCH(neon, 16, )
+#endif
+
+typedef void fnv32_batch_fn(const void* keys,
+			size_t key_size,
+			size_t n,
+			uint32_t h0,
+			uint32_t* out);
+
+static fnv32_batch_fn* resolve_fnv32_batch(void)
+{
+	const int level = csnip_cpu__level();
+	(void)level;
+#if defined(CSNIP_SIMD_HAVE_AVX512)
+	if (level >= CSNIP_CPU_LEVEL_AVX512)
+		return fnv32_batch_avx512;
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX2)
+	if (level >= CSNIP_CPU_LEVEL_AVX2)
+		return fnv32_batch_avx2;
+#endif
+#if defined(CSNIP_SIMD_HAVE_SSE2)
+	if (level >= CSNIP_CPU_LEVEL_SSE2)
+		return fnv32_batch_sse2;
+#endif
+#if defined(CSNIP_SIMD_HAVE_NEON) && defined(LITTLE_ENDIAN_HOST)
+	if (level >= CSNIP_CPU_LEVEL_NEON)
+		return fnv32_batch_neon;
+#endif
+	return fnv32_batch_portable;
+}
+
+csnip_cpu_DispatchVoid(csnip_hash_fnv32_batch,
+	(const void* keys, size_t key_size, size_t n, uint32_t h0,
+	 uint32_t* out),
+	(keys, key_size, n, h0, out),
+	resolve_fnv32_batch)
+
 uint64_t csnip_hash_fnv64_b(const void* buf, size_t sz, uint64_t h0)
 {
 	hash_buf(buf, sz, h0, FNV_p64);
@@ -22,6 +22,10 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /** FNV32's initialization constant. */
 #define CSNIP_FNV32_INIT ((uint32_t)0x811C9DC5ul)
 
@@ -73,6 +77,24 @@ uint32_t csnip_hash_fnv32_b(const void* buf, size_t sz, uint32_t h0);
  */
 uint32_t csnip_hash_fnv32_s(const char* str, uint32_t h0);
 
+/** Compute FNV32 hashes of many keys.
+ *
+ *  Hashes @a n keys of @a key_size bytes each, stored consecutively
+ *  at @a keys, as by
+ *
+ *	out[k] = csnip_hash_fnv32_b((const char*)keys + k * key_size,
+ *				key_size, h0);
+ *
+ *  for k < n.  FNV is inherently serial within a key, so the keys
+ *  are hashed in parallel instead, one per vector lane, with the
+ *  widest vector instruction set the CPU supports (see cpu.h).
+ */
+void csnip_hash_fnv32_batch(const void* keys,
+			size_t key_size,
+			size_t n,
+			uint32_t h0,
+			uint32_t* out);
+
 /** FNV64's initialization constant. */
 #define CSNIP_FNV64_INIT ((uint64_t)0xCBF29CE484222325ull)
 
@@ -107,6 +129,10 @@ uint64_t csnip_hash_fnv64_b(const void* buf, size_t sz, uint64_t h0);
  */
 uint64_t csnip_hash_fnv64_s(const char* str, uint64_t h0);
 
+#ifdef __cplusplus
+}
+#endif
+
 /** @} */
 
 #endif /* CSNIP_HASH_H */
@@ -116,6 +142,7 @@ uint64_t csnip_hash_fnv64_s(const char* str, uint64_t h0);
 #define FNV64_INIT	CSNIP_FNV64_INIT
 #define hash_fnv32_b	csnip_hash_fnv32_b
 #define hash_fnv32_s	csnip_hash_fnv32_s
+#define hash_fnv32_batch	csnip_hash_fnv32_batch
 #define hash_fnv64_b	csnip_hash_fnv64_b
 #define hash_fnv64_s	csnip_hash_fnv64_s
 #define CSNIP_HASH_HAVE_SHORT_NAMES
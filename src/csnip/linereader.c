@@ -0,0 +1,182 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/err.h>
+#include <csnip/linereader.h>
+#include <csnip/mem.h>
+#include <csnip/x.h>
+#include <csnip/x_unistd.h>
+
+struct csnip_linereader {
+	int fd;			/* Source descriptor, or -1 */
+	FILE* fp;		/* Source stream, or NULL */
+	bool eof;		/* End of input reached */
+
+	char* buf;
+	size_t cap;
+	size_t start;		/* Start of the unconsumed data */
+	size_t scan;		/* Where the delimiter search resumes */
+	size_t end;		/* End of the valid data */
+};
+
+static linereader* make(int fd, FILE* fp, size_t bufsize, int* err)
+{
+	if (err)
+		*err = 0;
+	if (bufsize == 0)
+		bufsize = LINEREADER_BUFSIZE;
+
+	linereader* R;
+	mem_Alloc(1, R, *err);
+	if (R == NULL)
+		return NULL;
+	mem_Alloc(bufsize, R->buf, *err);
+	if (R->buf == NULL) {
+		mem_Free(R);
+		return NULL;
+	}
+	R->fd = fd;
+	R->fp = fp;
+	R->eof = false;
+	R->cap = bufsize;
+	R->start = R->scan = R->end = 0;
+	return R;
+}
+
+linereader* csnip_linereader_from_fd(int fd, size_t bufsize, int* err)
+{
+	return make(fd, NULL, bufsize, err);
+}
+
+linereader* csnip_linereader_from_file(FILE* fp, size_t bufsize, int* err)
+{
+	return make(-1, fp, bufsize, err);
+}
+
+void csnip_linereader_free(linereader* R)
+{
+	if (R == NULL)
+		return;
+	mem_Free(R->buf);
+	mem_Free(R);
+}
+
+/* Read more data into the buffer, after compacting it or growing it
+ * if it is full.
+ */
+static int refill(linereader* R)
+{
+	if (R->start > 0) {
+		memmove(R->buf, R->buf + R->start, R->end - R->start);
+		R->end -= R->start;
+		R->scan -= R->start;
+		R->start = 0;
+	}
+	if (R->end == R->cap) {
+		int err = 0;
+		mem_Realloc(2 * R->cap, R->buf, err);
+		if (err)
+			return err;
+		R->cap *= 2;
+	}
+
+	if (R->fp) {
+		const size_t n = fread(R->buf + R->end, 1,
+					R->cap - R->end, R->fp);
+		if (n == 0) {
+			if (ferror(R->fp))
+				return csnip_err_ERRNO;
+			R->eof = true;
+		}
+		R->end += n;
+	} else {
+		csnip_x_ssize_t n;
+		do {
+			n = read(R->fd, R->buf + R->end, R->cap - R->end);
+		} while (n < 0 && errno == EINTR);
+		if (n < 0)
+			return csnip_err_ERRNO;
+		if (n == 0)
+			R->eof = true;
+		R->end += (size_t)n;
+	}
+	return 0;
+}
+
+int csnip_linereader_next(linereader* R,
+			int delim,
+			const char** line,
+			size_t* len)
+{
+	while (1) {
+		const char* p = memchr(R->buf + R->scan, delim,
+					R->end - R->scan);
+		if (p) {
+			const size_t e = (size_t)(p - R->buf) + 1;
+			*line = R->buf + R->start;
+			*len = e - R->start;
+			R->start = R->scan = e;
+			return 1;
+		}
+		R->scan = R->end;
+
+		if (R->eof) {
+			if (R->start == R->end)
+				return 0;
+
+			/* Last line without delimiter */
+			*line = R->buf + R->start;
+			*len = R->end - R->start;
+			R->start = R->end;
+			return 1;
+		}
+
+		const int err = refill(R);
+		if (err)
+			return err;
+	}
+}
+
+int csnip_linereader_next_line(linereader* R,
+			const char** line,
+			size_t* len)
+{
+	return csnip_linereader_next(R, '\n', line, len);
+}
+
+csnip_x_ssize_t csnip_linereader_getdelim(char** lineptr,
+			size_t* n,
+			int delim,
+			linereader* R)
+{
+	if (lineptr == NULL || n == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (*lineptr == NULL)
+		*n = 0;
+
+	const char* line;
+	size_t len;
+	const int r = csnip_linereader_next(R, delim, &line, &len);
+	if (r <= 0) {
+		if (r == csnip_err_NOMEM)
+			errno = ENOMEM;
+		return -1;
+	}
+	if (len + 1 > *n) {
+		int err = 0;
+		mem_Realloc(len + 1, *lineptr, err);
+		if (err) {
+			errno = ENOMEM;
+			return -1;
+		}
+		*n = len + 1;
+	}
+	memcpy(*lineptr, line, len);
+	(*lineptr)[len] = '\0';
+	return (csnip_x_ssize_t)len;
+}
@@ -0,0 +1,123 @@
+#ifndef CSNIP_LINEREADER_H
+#define CSNIP_LINEREADER_H
+
+/**	@file linereader.h
+ *	@brief			Buffered line reader
+ *	@defgroup linereader	Buffered line reader
+ *	@{
+ *
+ *	Reads delimited lines from a file descriptor or a FILE*.
+ *
+ *	The reader keeps a large internal buffer, fills it with bulk
+ *	read() or fread() calls, and finds delimiters with memchr(),
+ *	which libc implements with vector instructions.  Lines are
+ *	returned as zero-copy slices into the buffer; a line spanning a
+ *	buffer refill is moved to the front of the buffer, and the buffer
+ *	grows as needed for lines longer than the buffer.
+ *
+ *	Since the reader reads ahead, the underlying descriptor or FILE*
+ *	should not be read from by other means while the reader is in
+ *	use.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include <csnip/x.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default buffer size. */
+#define CSNIP_LINEREADER_BUFSIZE	(256 * 1024)
+
+/** Line reader (opaque). */
+typedef struct csnip_linereader csnip_linereader;
+
+/**	Create a line reader for a file descriptor.
+ *
+ *	@param	bufsize
+ *		the initial buffer size, or 0 for
+ *		CSNIP_LINEREADER_BUFSIZE.
+ *
+ *	@param	err
+ *		error return; csnip_err_NOMEM.
+ */
+csnip_linereader* csnip_linereader_from_fd(int fd,
+					size_t bufsize,
+					int* err);
+
+/**	Create a line reader for a stdio stream. */
+csnip_linereader* csnip_linereader_from_file(FILE* fp,
+					size_t bufsize,
+					int* err);
+
+/**	Free a line reader.
+ *
+ *	The underlying descriptor or stream is not closed.
+ */
+void csnip_linereader_free(csnip_linereader* R);
+
+/**	Read the next line.
+ *
+ *	@param	delim
+ *		the delimiter character.
+ *
+ *	@param	line
+ *		receives a pointer to the line.  The line is not
+ *		terminated with '\0', and remains valid until the next
+ *		call on the reader.
+ *
+ *	@param	len
+ *		receives the length of the line, including the
+ *		delimiter.  The last line of the input lacks the
+ *		delimiter if the input does not end with one.
+ *
+ *	@return	1 if a line was read, 0 at the end of the input, or a
+ *		negative error code (csnip_err_ERRNO, csnip_err_NOMEM).
+ */
+int csnip_linereader_next(csnip_linereader* R,
+			int delim,
+			const char** line,
+			size_t* len);
+
+/**	Read the next newline-delimited line. */
+int csnip_linereader_next_line(csnip_linereader* R,
+			const char** line,
+			size_t* len);
+
+/**	getdelim() compatible interface.
+ *
+ *	Copies the next line, including the delimiter, into *lineptr,
+ *	reallocating it as necessary, and terminates it with '\0'.
+ *
+ *	@return	the number of characters read, including the delimiter
+ *		but excluding the terminating '\0', or -1 at the end of
+ *		the input and on error, with errno set in the latter
+ *		case.
+ */
+csnip_x_ssize_t csnip_linereader_getdelim(char** lineptr,
+			size_t* n,
+			int delim,
+			csnip_linereader* R);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* CSNIP_LINEREADER_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_LINEREADER_HAVE_SHORT_NAMES)
+#define LINEREADER_BUFSIZE		CSNIP_LINEREADER_BUFSIZE
+#define linereader			csnip_linereader
+#define linereader_from_fd		csnip_linereader_from_fd
+#define linereader_from_file		csnip_linereader_from_file
+#define linereader_free			csnip_linereader_free
+#define linereader_next			csnip_linereader_next
+#define linereader_next_line		csnip_linereader_next_line
+#define linereader_getdelim		csnip_linereader_getdelim
+#define CSNIP_LINEREADER_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_LINEREADER_HAVE_SHORT_NAMES */
@@ -23,6 +23,7 @@
 #include <csnip/log.h>
 #include <csnip/lphash_table.h>
 #include <csnip/mem.h>
+#include <csnip/numfmt.h>
 #include <csnip/time.h>
 #include <csnip/x.h>
 
@@ -93,6 +94,9 @@ typedef struct {
 	/** Logger output file */
 	FILE* fp;
 
+	/** Whether to use the coarse clock */
+	int coarse_time;
+
 } csnip_log_processor;
 
 static csnip_log_processor* proc = NULL;
@@ -121,6 +125,7 @@ static void proc_init(csnip_log_processor* P)
 	for (int i = 0; i < Static_len(P->logfmt); ++i)
 		P->logfmt[i] = NULL;
 	P->fp = NULL;
+	P->coarse_time = 0;
 }
 
 static void proc_free(csnip_log_processor* P)
@@ -255,6 +260,7 @@ int csnip_log_config(const csnip_log_configuration* cfg)
 
 	/* Set the log file target */
 	proc->fp = (cfg->out_fp ? cfg->out_fp : stderr);
+	proc->coarse_time = cfg->coarse_time;
 
 	return 0;
 }
@@ -281,10 +287,21 @@ typedef enum {
 	TS_MONO,
 } TsType;
 
-static const char* put_timestamp(char* buf, size_t bufSz, TsType tsType)
+/* Get the current time, possibly from the coarse clock. */
+static struct timespec get_time(bool mono)
 {
+	if (proc->coarse_time) {
+		return time_coarse_now(mono ? TIME_COARSE_MONOTONIC
+					: TIME_COARSE_REALTIME);
+	}
 	struct timespec ts;
-	csnip_x_clock_gettime(CLOCK_REALTIME, &ts);
+	csnip_x_clock_gettime(mono ? CLOCK_MONOTONIC : CLOCK_REALTIME, &ts);
+	return ts;
+}
+
+static const char* put_timestamp(char* buf, size_t bufSz, TsType tsType)
+{
+	const struct timespec ts = get_time(false);
 	struct tm broken_down;
 	if (tsType == TS_LOCAL) {
 #ifdef WIN32
@@ -302,23 +319,39 @@ static const char* put_timestamp(char* buf, size_t bufSz, TsType tsType)
 	strftime(buf, bufSz, "%Y/%m/%d %H:%M:%S",
 		&broken_down);
 	const size_t l = strlen(buf);
-	if (l < bufSz) {
-		snprintf(buf + l, bufSz - l,
-			".%06ld",
-			ts.tv_nsec/1000);
+	if (l + 8 <= bufSz) {
+		buf[l] = '.';
+		numfmt_u64_pad(buf + l + 1, (uint64_t)ts.tv_nsec / 1000, 6);
+		buf[l + 7] = '\0';
 	}
 	return buf;
 }
 
+/* Shortest round trip representation of a double */
+static const char* put_double(char* buf, size_t bufSz, double v)
+{
+	if (bufSz > NUMFMT_DOUBLE_MAX)
+		buf[numfmt_double(buf, v)] = '\0';
+	else
+		snprintf(buf, bufSz, "%.17g", v);
+	return buf;
+}
+
+static const char* put_int(char* buf, size_t bufSz, int v)
+{
+	if (bufSz > NUMFMT_I64_MAX)
+		buf[numfmt_i64(buf, v)] = '\0';
+	else
+		snprintf(buf, bufSz, "%d", v);
+	return buf;
+}
+
 static const char* put_timestampnum(char* buf, size_t bufSz, TsType tsType)
 {
-	struct timespec ts;
-	csnip_x_clock_gettime(tsType == TS_MONO ? CLOCK_MONOTONIC : CLOCK_REALTIME,
-		&ts);
+	const struct timespec ts = get_time(tsType == TS_MONO);
 	double ts_sec;
 	time_Convert(ts, ts_sec);
-	snprintf(buf, bufSz, "%.17g", ts_sec);
-	return buf;
+	return put_double(buf, bufSz, ts_sec);
 }
 
 static const char* value_for_key(const char* keyStart,
@@ -349,22 +382,18 @@ static const char* value_for_key(const char* keyStart,
 		} if (strncmp(keyStart, "file", 4) == 0) {
 			return src_file;
 		} else if (strncmp(keyStart, "line", 4) == 0) {
-			snprintf(buf, bufSz, "%d", src_line);
-			return buf;
+			return put_int(buf, bufSz, src_line);
 		} else if (strncmp(keyStart, "func", 4) == 0) {
 			return src_func;
 		} else if (strncmp(keyStart, "prio", 4) == 0) {
-			snprintf(buf, bufSz, "%d", prio);
-			return buf;
+			return put_int(buf, bufSz, prio);
 		}
 		break;
 	case 7:
 		if (strncmp(keyStart, "timesec", 7) == 0) {
-			struct timespec ts;
-			csnip_x_clock_gettime(CLOCK_MONOTONIC, &ts);
-			snprintf(buf, bufSz, "%.16g",
+			const struct timespec ts = get_time(true);
+			return put_double(buf, bufSz,
 			  ts.tv_sec + ts.tv_nsec/1e9);
-			return buf;
 		} else if (strncmp(keyStart, "utctime", 7) == 0) {
 			return put_timestamp(buf, bufSz, 0);
 		}
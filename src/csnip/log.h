@@ -154,8 +154,22 @@ typedef struct {
 	 */
 	const char* logfmt[2];
 
-	/** Output destination */
+	/** Output destination.
+	 *
+	 *  Defaults to stderr.  To capture log output in memory, use
+	 *  a stream from memstream.h.
+	 */
 	FILE* out_fp;
+
+	/** Use the coarse clock for timestamps.
+	 *
+	 *  If nonzero, the time keywords in the format strings are
+	 *  rendered from csnip_time_coarse_now(), which is much
+	 *  cheaper than clock_gettime(), but only has a resolution of
+	 *  a few milliseconds.  See time.h on how to start the coarse
+	 *  clock's refresh thread.
+	 */
+	int coarse_time;
 } csnip_log_configuration;
 
 int csnip_log_config(const csnip_log_configuration* cfg);
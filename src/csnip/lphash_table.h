@@ -79,6 +79,7 @@
 	/* Size and capacity */ \
 	scope size_t prefix##size(const tbltype* tbl); \
 	scope size_t prefix##capacity(const tbltype* tbl); \
+	scope void prefix##reserve(tbltype* tbl, int* err, size_t n); \
 	\
 	/* Slot functions */ \
 	scope size_t prefix##findslot( \
@@ -190,6 +191,13 @@
  *		* `capacity`: `size_t capacity(tbltype* tbl);`  Retrieve
  *		  the capacity of the hash table, i.e., the size of the
  *		  underlying backing array.
+ *		* `reserve`: `void reserve(tbltype* tbl, int* err,
+ *		  size_t n);`  Grow the table so that it can hold `n`
+ *		  entries without further growth.  The table is kept at
+ *		  most 2/3 full, and the capacity is a power of 2, so
+ *		  reserving `2 * c / 3` entries for a power of 2 `c`
+ *		  results in a capacity of `c`; this can be used to
+ *		  obtain specific load factors.
  *
  *	Slot and entry access:
  *		* findslot
@@ -458,6 +466,12 @@
 		return T->cap; \
 	} \
 	\
+	scope void prefix##reserve(tbltype* T, int* err, size_t n) \
+	{ \
+		if (err) *err = 0; \
+		prefix##_internal_grow(T, err, n); \
+	} \
+	\
 	/* Slot functions */ \
 	scope size_t prefix##findslot(const tbltype* T, keytype key) \
 	{ \
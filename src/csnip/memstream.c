@@ -0,0 +1,369 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <csnip/csnip_conf.h>
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+#include <pthread.h>
+#endif
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/arr.h>
+#include <csnip/err.h>
+#include <csnip/mem.h>
+#include <csnip/memstream.h>
+#include <csnip/ringbuf2.h>
+#include <csnip/util.h>
+#include <csnip/x.h>
+
+#if defined(CSNIP_CONF__HAVE_FOPENCOOKIE) \
+  || defined(CSNIP_CONF__HAVE_FUNOPEN) || defined(_WIN32)
+#define HAVE_COOKIE
+#endif
+
+#ifdef HAVE_COOKIE
+typedef x_cookie_write_function_t cookie_write_fn;
+#else
+typedef x_ssize_t cookie_write_fn(void* cookie, const char* buf,
+				size_t size);
+#endif
+
+/* Open a write-only cookie stream with a buffer of the given size;
+ * the buffer is allocated and returned in *vbuf.
+ */
+static FILE* open_cookie(void* cookie, cookie_write_fn* wr,
+			size_t bufsize, char** vbuf, int* err)
+{
+	if (bufsize == 0)
+		bufsize = MEMSTREAM_BUFSIZE;
+	mem_Alloc(bufsize, *vbuf, *err);
+	if (*vbuf == NULL)
+		return NULL;
+
+#ifdef HAVE_COOKIE
+	x_cookie_io_functions_t funcs = {
+		.read = NULL,
+		.write = wr,
+		.seek = NULL,
+		.close = NULL,
+	};
+	FILE* fp = x_fopencookie(cookie, "w", funcs);
+#else
+	(void)cookie;
+	(void)wr;
+	FILE* fp = NULL;
+	errno = ENOSYS;
+#endif
+	if (fp == NULL) {
+		const int errno_save = errno;
+		mem_Free(*vbuf);
+		errno = errno_save;
+		csnip_err_Raise(csnip_err_ERRNO, *err);
+		return NULL;
+	}
+	setvbuf(fp, *vbuf, _IOFBF, bufsize);
+	return fp;
+}
+
+/* Close a cookie stream; the cookie stays intact. */
+static int close_cookie(FILE* fp, char* vbuf)
+{
+	const int r = fclose(fp);
+	const int errno_save = errno;
+	free(vbuf);
+	errno = errno_save;
+	return (r == 0 ? 0 : csnip_err_ERRNO);
+}
+
+/* Memstream */
+
+struct csnip_memstream {
+	FILE* fp;
+	char* vbuf;
+
+	/* Data, with room for the '\0' terminator */
+	char* a;
+	size_t n;
+	size_t cap;
+};
+
+static x_ssize_t mem_write(void* cookie, const char* buf, size_t size)
+{
+	memstream* M = cookie;
+	if (M->n + size + 1 > M->cap) {
+		int err = 0;
+		arr_Reserve(M->a, M->n, M->cap, M->n + size + 1, err);
+		if (err) {
+			errno = ENOMEM;
+			return 0;
+		}
+	}
+	memcpy(M->a + M->n, buf, size);
+	M->n += size;
+	M->a[M->n] = '\0';
+	return (x_ssize_t)size;
+}
+
+memstream* csnip_memstream_open(size_t bufsize, int* err)
+{
+	if (err)
+		*err = 0;
+	memstream* M;
+	mem_Alloc(1, M, *err);
+	if (M == NULL)
+		return NULL;
+	M->a = NULL;
+	M->n = 0;
+	M->cap = 0;
+	M->fp = open_cookie(M, mem_write, bufsize, &M->vbuf, err);
+	if (M->fp == NULL) {
+		mem_Free(M);
+		return NULL;
+	}
+	return M;
+}
+
+FILE* csnip_memstream_fp(const memstream* M)
+{
+	return M->fp;
+}
+
+const char* csnip_memstream_data(memstream* M, size_t* size)
+{
+	fflush(M->fp);
+	if (size)
+		*size = M->n;
+	return (M->a ? M->a : "");
+}
+
+void csnip_memstream_clear(memstream* M)
+{
+	fflush(M->fp);
+	M->n = 0;
+	if (M->a)
+		M->a[0] = '\0';
+}
+
+int csnip_memstream_close(memstream* M)
+{
+	if (M == NULL)
+		return 0;
+	const int r = close_cookie(M->fp, M->vbuf);
+	mem_Free(M->a);
+	mem_Free(M);
+	return r;
+}
+
+/* Ringstream */
+
+struct csnip_ringstream {
+	FILE* fp;
+	char* vbuf;
+
+	int mode;
+	char* buf;
+	ringbuf2 rb;
+	uint64_t dropped;
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_mutex_t mtx;
+	pthread_cond_t space_cv;	/* Signalled when bytes are read */
+#endif
+};
+
+static void ring_lock(ringstream* R)
+{
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_mutex_lock(&R->mtx);
+#else
+	(void)R;
+#endif
+}
+
+static void ring_unlock(ringstream* R)
+{
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_mutex_unlock(&R->mtx);
+#else
+	(void)R;
+#endif
+}
+
+/* Copy n bytes into the ring; there must be room for them. */
+static void ring_put(ringstream* R, const char* src, size_t n)
+{
+	size_t i0, l0, i1, l1;
+	const int na = ringbuf2_get_write_areas(&R->rb, &i0, &l0, &i1, &l1);
+	const size_t k = (na > 0 ? csnip_Min(n, l0) : 0);
+	memcpy(R->buf + i0, src, k);
+	if (k < n)
+		memcpy(R->buf + i1, src + k, n - k);
+	ringbuf2_add_written(&R->rb, n);
+}
+
+/* Copy n bytes out of the ring, without consuming them. */
+static void ring_get(ringstream* R, char* dst, size_t n)
+{
+	size_t i0, l0, i1, l1;
+	const int na = ringbuf2_get_read_areas(&R->rb, &i0, &l0, &i1, &l1);
+	const size_t k = (na > 0 ? csnip_Min(n, l0) : 0);
+	memcpy(dst, R->buf + i0, k);
+	if (k < n)
+		memcpy(dst + k, R->buf + i1, n - k);
+}
+
+static x_ssize_t ring_write(void* cookie, const char* buf, size_t size)
+{
+	ringstream* R = cookie;
+	const size_t cap = R->rb.cap;
+	ring_lock(R);
+
+	if (R->mode == RINGSTREAM_OVERWRITE) {
+		/* Drop the oldest bytes to make room */
+		const char* src = buf;
+		size_t n = size;
+		if (n > cap) {
+			R->dropped += n - cap;
+			src += n - cap;
+			n = cap;
+		}
+		const size_t free_sz = ringbuf2_free_size(&R->rb);
+		if (free_sz < n) {
+			ringbuf2_add_read(&R->rb, n - free_sz);
+			R->dropped += n - free_sz;
+		}
+		ring_put(R, src, n);
+		ring_unlock(R);
+		return (x_ssize_t)size;
+	}
+
+	/* Blocking mode */
+	size_t done = 0;
+	while (done < size) {
+		size_t free_sz = ringbuf2_free_size(&R->rb);
+		if (free_sz == 0) {
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+			pthread_cond_wait(&R->space_cv, &R->mtx);
+			continue;
+#else
+			break;
+#endif
+		}
+		const size_t k = csnip_Min(free_sz, size - done);
+		ring_put(R, buf + done, k);
+		done += k;
+	}
+	ring_unlock(R);
+	if (done == 0)
+		errno = ENOSPC;
+	return (x_ssize_t)done;
+}
+
+ringstream* csnip_ringstream_open(size_t capacity,
+				int mode,
+				size_t bufsize,
+				int* err)
+{
+	if (err)
+		*err = 0;
+	if (capacity == 0 || capacity > SIZE_MAX / 4
+	  || (mode != RINGSTREAM_OVERWRITE && mode != RINGSTREAM_BLOCK))
+	{
+		csnip_err_Raise(csnip_err_INVAL, *err);
+		return NULL;
+	}
+
+	ringstream* R;
+	mem_Alloc(1, R, *err);
+	if (R == NULL)
+		return NULL;
+	R->mode = mode;
+	R->dropped = 0;
+	mem_Alloc(ringbuf2_init(&R->rb, capacity), R->buf, *err);
+	if (R->buf == NULL) {
+		mem_Free(R);
+		return NULL;
+	}
+	R->fp = open_cookie(R, ring_write, bufsize, &R->vbuf, err);
+	if (R->fp == NULL) {
+		mem_Free(R->buf);
+		mem_Free(R);
+		return NULL;
+	}
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_mutex_init(&R->mtx, NULL);
+	pthread_cond_init(&R->space_cv, NULL);
+#endif
+	return R;
+}
+
+FILE* csnip_ringstream_fp(const ringstream* R)
+{
+	return R->fp;
+}
+
+int csnip_ringstream_peek(ringstream* R, struct x_iovec* areas)
+{
+	size_t i0, l0, i1, l1;
+	ring_lock(R);
+	const int na = ringbuf2_get_read_areas(&R->rb, &i0, &l0, &i1, &l1);
+	ring_unlock(R);
+	if (na > 0) {
+		areas[0].iov_base = R->buf + i0;
+		areas[0].iov_len = l0;
+	}
+	if (na > 1) {
+		areas[1].iov_base = R->buf + i1;
+		areas[1].iov_len = l1;
+	}
+	return na;
+}
+
+void csnip_ringstream_consume(ringstream* R, size_t n)
+{
+	ring_lock(R);
+	n = csnip_Min(n, ringbuf2_used_size(&R->rb));
+	ringbuf2_add_read(&R->rb, n);
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	if (n > 0)
+		pthread_cond_signal(&R->space_cv);
+#endif
+	ring_unlock(R);
+}
+
+size_t csnip_ringstream_read(ringstream* R, void* buf, size_t n)
+{
+	ring_lock(R);
+	n = csnip_Min(n, ringbuf2_used_size(&R->rb));
+	ring_get(R, buf, n);
+	ringbuf2_add_read(&R->rb, n);
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	if (n > 0)
+		pthread_cond_signal(&R->space_cv);
+#endif
+	ring_unlock(R);
+	return n;
+}
+
+uint64_t csnip_ringstream_dropped(ringstream* R)
+{
+	ring_lock(R);
+	const uint64_t d = R->dropped;
+	ring_unlock(R);
+	return d;
+}
+
+int csnip_ringstream_close(ringstream* R)
+{
+	if (R == NULL)
+		return 0;
+	const int r = close_cookie(R->fp, R->vbuf);
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_cond_destroy(&R->space_cv);
+	pthread_mutex_destroy(&R->mtx);
+#endif
+	mem_Free(R->buf);
+	mem_Free(R);
+	return r;
+}
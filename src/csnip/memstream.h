@@ -0,0 +1,201 @@
+#ifndef CSNIP_MEMSTREAM_H
+#define CSNIP_MEMSTREAM_H
+
+/**	@file memstream.h
+ *	@brief			In-memory stdio streams
+ *	@defgroup memstream	In-memory stdio streams
+ *	@{
+ *
+ *	FILE* streams that write to memory instead of to a file
+ *	descriptor, e.g. to capture log output (see the out_fp member
+ *	of csnip_log_configuration), or to test formatting code without
+ *	system calls.  Both stream types are built on
+ *	csnip_x_fopencookie(), and are therefore unavailable where that
+ *	is.
+ *
+ *	* A memstream appends everything written to a growing array.
+ *
+ *	* A ringstream keeps the written bytes in a ring buffer of
+ *	  bounded capacity.  When the ring is full, it either
+ *	  overwrites the oldest bytes, or blocks the writer until a
+ *	  reader has consumed data.
+ *
+ *	The streams are fully buffered with a large stdio buffer, so
+ *	that the cookie functions are called rarely.  Bytes still in the
+ *	stdio buffer are not visible in memory before the stream is
+ *	flushed.
+ *
+ *	The accumulated bytes are accessed in place, without copying.
+ *	The streams must be closed with csnip_memstream_close() and
+ *	csnip_ringstream_close() rather than with fclose().
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <csnip/x.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Default stdio buffer size. */
+#define CSNIP_MEMSTREAM_BUFSIZE		(64 * 1024)
+
+/** @name Memstream */
+/**@{*/
+
+/** Memory stream (opaque). */
+typedef struct csnip_memstream csnip_memstream;
+
+/**	Open a memory stream.
+ *
+ *	@param	bufsize
+ *		the stdio buffer size, or 0 for CSNIP_MEMSTREAM_BUFSIZE.
+ *
+ *	@param	err
+ *		error return; csnip_err_NOMEM or csnip_err_ERRNO.
+ */
+csnip_memstream* csnip_memstream_open(size_t bufsize, int* err);
+
+/**	The stream to write to. */
+FILE* csnip_memstream_fp(const csnip_memstream* M);
+
+/**	Access the bytes written.
+ *
+ *	Flushes the stream, and returns a pointer to the bytes written
+ *	so far.  The data is followed by a '\\0' byte, which is not
+ *	counted in @a size.  The pointer is valid until the next write
+ *	or flush.
+ *
+ *	@param	size
+ *		if not NULL, the number of bytes is returned here.
+ */
+const char* csnip_memstream_data(csnip_memstream* M, size_t* size);
+
+/**	Discard the bytes written.
+ *
+ *	Flushes the stream first, so that buffered bytes are discarded
+ *	as well.  The capacity is kept.
+ */
+void csnip_memstream_clear(csnip_memstream* M);
+
+/**	Close the stream and free the memory.
+ *
+ *	@return	0 on success, or csnip_err_ERRNO if the stream could not
+ *		be flushed.
+ */
+int csnip_memstream_close(csnip_memstream* M);
+/**@}*/
+
+/** @name Ringstream */
+/**@{*/
+
+/** Overwrite the oldest bytes when full. */
+#define CSNIP_RINGSTREAM_OVERWRITE	0
+
+/** Block the writer when full. */
+#define CSNIP_RINGSTREAM_BLOCK		1
+
+/** Ring buffer stream (opaque). */
+typedef struct csnip_ringstream csnip_ringstream;
+
+/**	Open a ring buffer stream.
+ *
+ *	Reading functions (peek, consume, read) may be called from a
+ *	different thread than the one writing to the stream, which is
+ *	required for CSNIP_RINGSTREAM_BLOCK streams to make progress
+ *	once full.  Without threading support, writes to a full
+ *	blocking stream fail instead.
+ *
+ *	@param	capacity
+ *		the minimum ring capacity in bytes; it is rounded up to
+ *		a power of 2.
+ *
+ *	@param	mode
+ *		CSNIP_RINGSTREAM_OVERWRITE or CSNIP_RINGSTREAM_BLOCK.
+ *
+ *	@param	bufsize
+ *		the stdio buffer size, or 0 for CSNIP_MEMSTREAM_BUFSIZE.
+ *
+ *	@param	err
+ *		error return; csnip_err_INVAL, csnip_err_NOMEM or
+ *		csnip_err_ERRNO.
+ */
+csnip_ringstream* csnip_ringstream_open(size_t capacity,
+					int mode,
+					size_t bufsize,
+					int* err);
+
+/**	The stream to write to. */
+FILE* csnip_ringstream_fp(const csnip_ringstream* R);
+
+/**	Access the bytes in the ring.
+ *
+ *	Stores the (at most 2) contiguous areas holding the unread
+ *	bytes, oldest first, in @a areas.  The stream is not flushed,
+ *	since the writer could be blocked; call fflush() from the
+ *	writing thread as needed.
+ *
+ *	In CSNIP_RINGSTREAM_BLOCK mode, the areas stay valid until they
+ *	are consumed.  In CSNIP_RINGSTREAM_OVERWRITE mode, they are only
+ *	valid until the next write.
+ *
+ *	@return	the number of areas.
+ */
+int csnip_ringstream_peek(csnip_ringstream* R,
+			struct csnip_x_iovec* areas);
+
+/**	Mark the oldest @a n bytes as read. */
+void csnip_ringstream_consume(csnip_ringstream* R, size_t n);
+
+/**	Copy out and consume up to @a n bytes.
+ *
+ *	@return	the number of bytes copied, which is 0 if the ring is
+ *		empty.
+ */
+size_t csnip_ringstream_read(csnip_ringstream* R, void* buf, size_t n);
+
+/**	Number of bytes overwritten before they were read. */
+uint64_t csnip_ringstream_dropped(csnip_ringstream* R);
+
+/**	Close the stream and free the memory.
+ *
+ *	Flushes the stream, which may block in
+ *	CSNIP_RINGSTREAM_BLOCK mode.
+ *
+ *	@return	0 on success, or csnip_err_ERRNO if the stream could not
+ *		be flushed.
+ */
+int csnip_ringstream_close(csnip_ringstream* R);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* CSNIP_MEMSTREAM_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_MEMSTREAM_HAVE_SHORT_NAMES)
+#define MEMSTREAM_BUFSIZE		CSNIP_MEMSTREAM_BUFSIZE
+#define memstream			csnip_memstream
+#define memstream_open			csnip_memstream_open
+#define memstream_fp			csnip_memstream_fp
+#define memstream_data			csnip_memstream_data
+#define memstream_clear			csnip_memstream_clear
+#define memstream_close			csnip_memstream_close
+#define RINGSTREAM_OVERWRITE		CSNIP_RINGSTREAM_OVERWRITE
+#define RINGSTREAM_BLOCK		CSNIP_RINGSTREAM_BLOCK
+#define ringstream			csnip_ringstream
+#define ringstream_open			csnip_ringstream_open
+#define ringstream_fp			csnip_ringstream_fp
+#define ringstream_peek			csnip_ringstream_peek
+#define ringstream_consume		csnip_ringstream_consume
+#define ringstream_read			csnip_ringstream_read
+#define ringstream_dropped		csnip_ringstream_dropped
+#define ringstream_close		csnip_ringstream_close
+#define CSNIP_MEMSTREAM_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_MEMSTREAM_HAVE_SHORT_NAMES */
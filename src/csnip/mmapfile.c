@@ -0,0 +1,218 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <csnip/csnip_conf.h>
+#ifdef CSNIP_CONF__HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/err.h>
+#include <csnip/mem.h>
+#include <csnip/mmapfile.h>
+#include <csnip/x.h>
+#include <csnip/x_unistd.h>
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC	0
+#endif
+
+/* Read the input until the end into a malloc()ed buffer. */
+static int read_all(mmapfile* M, int fd, size_t size_hint)
+{
+	size_t cap = (size_hint > 0 ? size_hint + 1 : 65536);
+	size_t n = 0;
+	char* buf;
+	int err = 0;
+	mem_Alloc(cap, buf, err);
+	if (err)
+		return err;
+
+	while (1) {
+		if (n == cap) {
+			mem_Realloc(2 * cap, buf, err);
+			if (err) {
+				mem_Free(buf);
+				return err;
+			}
+			cap *= 2;
+		}
+		const csnip_x_ssize_t r = read(fd, buf + n, cap - n);
+		if (r < 0) {
+			if (errno == EINTR)
+				continue;
+			const int errno_save = errno;
+			mem_Free(buf);
+			errno = errno_save;
+			return csnip_err_ERRNO;
+		}
+		if (r == 0)
+			break;
+		n += (size_t)r;
+	}
+
+	M->data = buf;
+	M->size = n;
+	M->mapped = 0;
+	M->map_len = 0;
+	return 0;
+}
+
+#ifdef CSNIP_CONF__HAVE_SYS_MMAN_H
+/* Map the file; returns nonzero if that fails. */
+static int map(mmapfile* M, int fd, size_t size, unsigned flags)
+{
+	int mflags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+	if (flags & MMAPFILE_POPULATE)
+		mflags |= MAP_POPULATE;
+#endif
+	void* p = mmap(NULL, size, PROT_READ, mflags, fd, 0);
+	if (p == MAP_FAILED)
+		return -1;
+
+#ifdef MADV_SEQUENTIAL
+	if (flags & MMAPFILE_SEQUENTIAL)
+		madvise(p, size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_WILLNEED
+	if (flags & MMAPFILE_WILLNEED)
+		madvise(p, size, MADV_WILLNEED);
+#endif
+
+	M->data = p;
+	M->size = size;
+	M->mapped = 1;
+	M->map_len = size;
+	return 0;
+}
+#endif
+
+int csnip_mmapfile_open_fd(mmapfile* M, int fd, unsigned flags)
+{
+	M->data = NULL;
+	M->size = 0;
+	M->mapped = 0;
+	M->map_len = 0;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+		return csnip_err_ERRNO;
+	const int regular = S_ISREG(st.st_mode);
+
+	/* Empty files can't be mapped; but files reported as empty can
+	 * have contents, e.g. in /proc and sysfs, so read those.
+	 */
+#ifdef CSNIP_CONF__HAVE_SYS_MMAN_H
+	if (regular && st.st_size > 0 && !(flags & MMAPFILE_NOMAP)
+	  && (unsigned long long)st.st_size <= SIZE_MAX
+	  && map(M, fd, (size_t)st.st_size, flags) == 0)
+	{
+		return 0;
+	}
+#else
+	(void)flags;
+#endif
+	return read_all(M, fd, regular ? (size_t)st.st_size : 0);
+}
+
+int csnip_mmapfile_open(mmapfile* M, const char* path, unsigned flags)
+{
+	const int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return csnip_err_ERRNO;
+	const int err = csnip_mmapfile_open_fd(M, fd, flags);
+	const int errno_save = errno;
+	close(fd);
+	errno = errno_save;
+	return err;
+}
+
+void csnip_mmapfile_close(mmapfile* M)
+{
+#ifdef CSNIP_CONF__HAVE_SYS_MMAN_H
+	if (M->mapped) {
+		munmap((void*)M->data, M->map_len);
+	} else
+#endif
+	{
+		free((void*)M->data);
+	}
+	M->data = NULL;
+	M->size = 0;
+	M->mapped = 0;
+	M->map_len = 0;
+}
+
+int csnip_mmapfile_is_mapped(const mmapfile* M)
+{
+	return M->mapped;
+}
+
+mmapfile_span csnip_mmapfile_contents(const mmapfile* M)
+{
+	mmapfile_span s = { M->data, M->size };
+	return s;
+}
+
+int csnip_mmapfile_next_line(mmapfile_span* rest,
+				int delim,
+				mmapfile_span* line)
+{
+	if (rest->len == 0)
+		return 0;
+	const char* p = memchr(rest->ptr, delim, rest->len);
+	const size_t n = (p ? (size_t)(p - rest->ptr) + 1 : rest->len);
+	line->ptr = rest->ptr;
+	line->len = n;
+	rest->ptr += n;
+	rest->len -= n;
+	return 1;
+}
+
+int csnip_mmapfile_next_record(mmapfile_span* rest,
+				size_t recsize,
+				mmapfile_span* rec)
+{
+	if (recsize == 0 || rest->len < recsize)
+		return 0;
+	rec->ptr = rest->ptr;
+	rec->len = recsize;
+	rest->ptr += recsize;
+	rest->len -= recsize;
+	return 1;
+}
+
+size_t csnip_mmapfile_chunks(const mmapfile* M,
+				size_t n,
+				int delim,
+				mmapfile_span* chunks)
+{
+	const char* const data = M->data;
+	const size_t size = M->size;
+	size_t nchunk = 0;
+	size_t start = 0;
+	for (size_t i = 1; i <= n && start < size; ++i) {
+		size_t end = size;
+		if (i < n) {
+			/* Extend the nominal boundary to the end of the
+			 * line it falls into.
+			 */
+			const size_t b = size / n * i + size % n * i / n;
+			if (b <= start)
+				continue;
+			const char* p = memchr(data + b - 1, delim,
+						size - b + 1);
+			end = (p ? (size_t)(p - data) + 1 : size);
+		}
+		chunks[nchunk].ptr = data + start;
+		chunks[nchunk].len = end - start;
+		++nchunk;
+		start = end;
+	}
+	return nchunk;
+}
@@ -0,0 +1,166 @@
+#ifndef CSNIP_MMAPFILE_H
+#define CSNIP_MMAPFILE_H
+
+/**	@file mmapfile.h
+ *	@brief			Memory-mapped input files
+ *	@defgroup mmapfile	Memory-mapped input files
+ *	@{
+ *
+ *	Maps an input file read-only into memory, so that it can be
+ *	processed without copying it through read() buffers.
+ *
+ *	The contents are processed as spans (pointer and length) that
+ *	point directly into the mapping:  the file can be iterated line
+ *	by line or record by record, and split into line-aligned chunks
+ *	for processing in parallel.
+ *
+ *	Inputs that can't be mapped, such as pipes and terminals, are
+ *	read into a memory buffer instead, so that callers need not
+ *	distinguish between the two cases.
+ *
+ *	Example:  Count the lines in each of four chunks.
+ *
+ *	```
+ *	csnip_mmapfile M;
+ *	if (csnip_mmapfile_open(&M, path, CSNIP_MMAPFILE_WILLNEED) != 0)
+ *		...;
+ *	csnip_mmapfile_span chunk[4], line;
+ *	size_t nchunk = csnip_mmapfile_chunks(&M, 4, '\n', chunk);
+ *	for (size_t i = 0; i < nchunk; ++i) {	// in parallel
+ *		size_t n = 0;
+ *		while (csnip_mmapfile_next_line(&chunk[i], '\n', &line))
+ *			++n;
+ *	}
+ *	csnip_mmapfile_close(&M);
+ *	```
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @name Open flags */
+/**@{*/
+/** Hint that the file will be read sequentially (MADV_SEQUENTIAL). */
+#define CSNIP_MMAPFILE_SEQUENTIAL	1
+/** Start reading the file ahead (MADV_WILLNEED). */
+#define CSNIP_MMAPFILE_WILLNEED		2
+/** Prefault the whole mapping (MAP_POPULATE, where available). */
+#define CSNIP_MMAPFILE_POPULATE		4
+/** Don't map the file, read it into memory. */
+#define CSNIP_MMAPFILE_NOMAP		8
+/**@}*/
+
+/** A span of the file's contents. */
+typedef struct {
+	const char* ptr;
+	size_t len;
+} csnip_mmapfile_span;
+
+/** A mapped file. */
+typedef struct {
+	const char* data;	/**< The contents */
+	size_t size;		/**< The size in bytes */
+
+	/** @cond */
+	int mapped;		/* 1 if mapped, 0 if read into memory */
+	size_t map_len;
+	/** @endcond */
+} csnip_mmapfile;
+
+/**	Open and map a file.
+ *
+ *	@param	flags
+ *		combination of the CSNIP_MMAPFILE_* open flags.
+ *
+ *	@return	0 on success, csnip_err_ERRNO, or csnip_err_NOMEM.
+ */
+int csnip_mmapfile_open(csnip_mmapfile* M, const char* path,
+			unsigned flags);
+
+/**	Map an open file descriptor.
+ *
+ *	If the descriptor does not refer to a regular file, or mapping
+ *	fails, the input is read until the end into a memory buffer.
+ *	So are files that report a size of 0, such as the files in
+ *	/proc and sysfs on Linux.
+ *	The descriptor is not closed, and can be closed right after
+ *	this call.
+ */
+int csnip_mmapfile_open_fd(csnip_mmapfile* M, int fd, unsigned flags);
+
+/**	Unmap the file, or free the buffer. */
+void csnip_mmapfile_close(csnip_mmapfile* M);
+
+/**	Whether the contents are mapped (rather than read). */
+int csnip_mmapfile_is_mapped(const csnip_mmapfile* M);
+
+/**	The whole contents as a span. */
+csnip_mmapfile_span csnip_mmapfile_contents(const csnip_mmapfile* M);
+
+/**	Take the next line from a span.
+ *
+ *	Removes the first line, including the delimiter, from @a rest,
+ *	and returns it in @a line.  The last line lacks the delimiter if
+ *	the span does not end with one.
+ *
+ *	@return	1 if a line was taken, 0 if @a rest was empty.
+ */
+int csnip_mmapfile_next_line(csnip_mmapfile_span* rest,
+				int delim,
+				csnip_mmapfile_span* line);
+
+/**	Take the next fixed-size record from a span.
+ *
+ *	@return	1 if a record was taken, 0 if fewer than @a recsize
+ *		bytes remain.  Trailing bytes that do not make up a
+ *		whole record are left in @a rest.
+ */
+int csnip_mmapfile_next_record(csnip_mmapfile_span* rest,
+				size_t recsize,
+				csnip_mmapfile_span* rec);
+
+/**	Split the contents into line-aligned chunks.
+ *
+ *	Divides the contents into at most @a n chunks of approximately
+ *	equal size, such that every chunk except the last ends with the
+ *	delimiter; no line is split between chunks.  Fewer chunks result
+ *	if the lines are long compared to the chunk size.
+ *
+ *	@param	chunks
+ *		array of @a n spans receiving the chunks.
+ *
+ *	@return	the number of (non-empty) chunks.
+ */
+size_t csnip_mmapfile_chunks(const csnip_mmapfile* M,
+				size_t n,
+				int delim,
+				csnip_mmapfile_span* chunks);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* CSNIP_MMAPFILE_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_MMAPFILE_HAVE_SHORT_NAMES)
+#define MMAPFILE_SEQUENTIAL		CSNIP_MMAPFILE_SEQUENTIAL
+#define MMAPFILE_WILLNEED		CSNIP_MMAPFILE_WILLNEED
+#define MMAPFILE_POPULATE		CSNIP_MMAPFILE_POPULATE
+#define MMAPFILE_NOMAP			CSNIP_MMAPFILE_NOMAP
+#define mmapfile_span			csnip_mmapfile_span
+#define mmapfile			csnip_mmapfile
+#define mmapfile_open			csnip_mmapfile_open
+#define mmapfile_open_fd		csnip_mmapfile_open_fd
+#define mmapfile_close			csnip_mmapfile_close
+#define mmapfile_is_mapped		csnip_mmapfile_is_mapped
+#define mmapfile_contents		csnip_mmapfile_contents
+#define mmapfile_next_line		csnip_mmapfile_next_line
+#define mmapfile_next_record		csnip_mmapfile_next_record
+#define mmapfile_chunks			csnip_mmapfile_chunks
+#define CSNIP_MMAPFILE_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_MMAPFILE_HAVE_SHORT_NAMES */
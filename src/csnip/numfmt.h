@@ -0,0 +1,95 @@
+#ifndef CSNIP_NUMFMT_H
+#define CSNIP_NUMFMT_H
+
+/**	@file numfmt.h
+ *	@brief			Number to text conversion
+ *	@defgroup numfmt	Number to text conversion
+ *	@{
+ *
+ *	Fast replacements for the numeric conversions of snprintf().
+ *
+ *	The functions write the text representation of a number
+ *	straight into a caller supplied buffer and return the number of
+ *	bytes written.  They don't append a '\\0' byte, don't parse a
+ *	format string, and don't depend on the locale.  The buffer must
+ *	have room for the maximum length given by the corresponding
+ *	CSNIP_NUMFMT_*_MAX constant.
+ *
+ *	Decimal integers are produced two digits at a time from a
+ *	lookup table.  Doubles are converted to the shortest decimal
+ *	representation that reads back as the same value (with
+ *	strtod() or csnip_numparse_double()), using the Schubfach
+ *	algorithm; where there are several shortest ones, the closest to
+ *	the exact binary value is chosen.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @name Maximum output lengths */
+/**@{*/
+#define CSNIP_NUMFMT_U64_MAX		20
+#define CSNIP_NUMFMT_I64_MAX		20
+#define CSNIP_NUMFMT_HEX_MAX		16
+#define CSNIP_NUMFMT_DOUBLE_MAX		24
+/**@}*/
+
+/**	Format an unsigned integer in decimal. */
+size_t csnip_numfmt_u64(char* buf, uint64_t v);
+
+/**	Format a signed integer in decimal. */
+size_t csnip_numfmt_i64(char* buf, int64_t v);
+
+/**	Format an unsigned integer in decimal, zero padded.
+ *
+ *	Writes at least @a width digits, padding with leading zeros;
+ *	the buffer must have room for max(width, CSNIP_NUMFMT_U64_MAX)
+ *	bytes.
+ */
+size_t csnip_numfmt_u64_pad(char* buf, uint64_t v, int width);
+
+/**	Format an unsigned integer in hexadecimal.
+ *
+ *	Writes at least @a width digits, padding with leading zeros,
+ *	and no "0x" prefix; @a width must not exceed 16.
+ *
+ *	@param	upper
+ *		if nonzero, use upper case digits.
+ */
+size_t csnip_numfmt_hex(char* buf, uint64_t v, int width, int upper);
+
+/**	Format a double.
+ *
+ *	Writes the shortest round trip representation.  Like the "%g"
+ *	conversion with precision 17, fixed notation is used for
+ *	decimal exponents from -4 to 16, and otherwise scientific
+ *	notation with a two or three digit exponent, as in "1e+100" or
+ *	"2.5e-07".  There are no trailing zeros in the fraction.
+ *	Infinities are written as "inf" or "-inf", and NaNs as "nan".
+ */
+size_t csnip_numfmt_double(char* buf, double v);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* CSNIP_NUMFMT_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_NUMFMT_HAVE_SHORT_NAMES)
+#define NUMFMT_U64_MAX			CSNIP_NUMFMT_U64_MAX
+#define NUMFMT_I64_MAX			CSNIP_NUMFMT_I64_MAX
+#define NUMFMT_HEX_MAX			CSNIP_NUMFMT_HEX_MAX
+#define NUMFMT_DOUBLE_MAX		CSNIP_NUMFMT_DOUBLE_MAX
+#define numfmt_u64			csnip_numfmt_u64
+#define numfmt_i64			csnip_numfmt_i64
+#define numfmt_u64_pad			csnip_numfmt_u64_pad
+#define numfmt_hex			csnip_numfmt_hex
+#define numfmt_double			csnip_numfmt_double
+#define CSNIP_NUMFMT_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_NUMFMT_HAVE_SHORT_NAMES */
@@ -0,0 +1,101 @@
+#ifndef CSNIP_NUMPARSE_H
+#define CSNIP_NUMPARSE_H
+
+/**	@file numparse.h
+ *	@brief			Text to number conversion
+ *	@defgroup numparse	Text to number conversion
+ *	@{
+ *
+ *	Fast replacements for strtoull(), strtoll() and strtod() for
+ *	parsing numeric text.
+ *
+ *	The functions work on (pointer, length) spans that need not be
+ *	'\\0' terminated, don't skip leading white space, and don't
+ *	depend on the locale; the decimal point is always '.'.  Like
+ *	C++'s std::from_chars(), they parse the longest prefix of the
+ *	span forming a number and report its length, so that trailing
+ *	text can be checked for by comparing it to the span length.
+ *
+ *	Decimal integers are converted 8 digits at a time with SWAR
+ *	(SIMD within a register) arithmetic.  Doubles are converted with
+ *	the Eisel-Lemire algorithm, which handles almost all inputs with
+ *	one or two 64 x 64 bit multiplications; the rare ambiguous
+ *	cases, as well as hexadecimal floating point input, are passed
+ *	to strtod().  Results are correctly rounded, so that they are
+ *	bit identical to those of strtod() in the "C" locale.
+ *
+ *	All functions return 0 on success, csnip_err_FORMAT if the span
+ *	doesn't begin with a number (*used is 0 then), or
+ *	csnip_err_RANGE if the value is out of range.  Out of range
+ *	values are saturated, as by strtoull() and strtod().
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**	Parse an unsigned integer.
+ *
+ *	Accepts an optional '+' sign, followed by digits.
+ *
+ *	@param	base
+ *		the base, 2 to 36, or 0 to detect it from the C prefix
+ *		("0x" for 16, "0" for 8, otherwise 10); other values
+ *		give csnip_err_INVAL.
+ *
+ *	@param	v
+ *		the value is returned here.
+ *
+ *	@param	used
+ *		the number of characters forming the number is returned
+ *		here.
+ */
+int csnip_numparse_u64(const char* p,
+			size_t len,
+			int base,
+			uint64_t* v,
+			size_t* used);
+
+/**	Parse a signed integer.
+ *
+ *	Like csnip_numparse_u64(), but also accepts a '-' sign.
+ */
+int csnip_numparse_i64(const char* p,
+			size_t len,
+			int base,
+			int64_t* v,
+			size_t* used);
+
+/**	Parse a double.
+ *
+ *	Accepts the syntax of strtod(): an optional sign, followed by a
+ *	decimal number with optional fraction and exponent, a
+ *	hexadecimal floating point number, "inf", "infinity" or "nan",
+ *	optionally followed by a parenthesized character sequence; the
+ *	latter are case insensitive.
+ *
+ *	Overflow to infinity and underflow to zero are reported as
+ *	csnip_err_RANGE.
+ */
+int csnip_numparse_double(const char* p,
+			size_t len,
+			double* v,
+			size_t* used);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* CSNIP_NUMPARSE_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_NUMPARSE_HAVE_SHORT_NAMES)
+#define numparse_u64			csnip_numparse_u64
+#define numparse_i64			csnip_numparse_i64
+#define numparse_double			csnip_numparse_double
+#define CSNIP_NUMPARSE_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_NUMPARSE_HAVE_SHORT_NAMES */
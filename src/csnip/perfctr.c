@@ -0,0 +1,246 @@
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/csnip_conf.h>
+#include <csnip/err.h>
+#include <csnip/perfctr.h>
+
+#if defined(CSNIP_CONF__HAVE_LINUX_PERF_EVENT_H)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char* const names[CSNIP_PERFCTR_N] = {
+	"cycles",
+	"instructions",
+	"cache-misses",
+	"branch-misses",
+	"dTLB-misses",
+	"page-faults",
+};
+
+const char* csnip_perfctr_name(int i)
+{
+	if (i < 0 || i >= CSNIP_PERFCTR_N)
+		return NULL;
+	return names[i];
+}
+
+int csnip_perfctr_parse(const char* s, unsigned* events)
+{
+	if (strcmp(s, "all") == 0) {
+		*events = CSNIP_PERFCTR_ALL;
+		return 0;
+	}
+	if (strcmp(s, "hw") == 0) {
+		*events = CSNIP_PERFCTR_HW;
+		return 0;
+	}
+	if (strcmp(s, "none") == 0) {
+		*events = 0;
+		return 0;
+	}
+
+	unsigned ev = 0;
+	while (*s) {
+		const size_t len = strcspn(s, ",");
+		int i;
+		for (i = 0; i < CSNIP_PERFCTR_N; ++i) {
+			if (strlen(names[i]) == len
+			  && strncmp(names[i], s, len) == 0)
+			{
+				break;
+			}
+		}
+		if (i == CSNIP_PERFCTR_N)
+			return csnip_err_INVAL;
+		ev |= 1u << i;
+		s += len;
+		if (*s == ',')
+			++s;
+	}
+	*events = ev;
+	return 0;
+}
+
+unsigned csnip_perfctr_events(const csnip_perfctr* P)
+{
+	return P->events;
+}
+
+#if defined(CSNIP_CONF__HAVE_LINUX_PERF_EVENT_H)
+
+static void init_attr(struct perf_event_attr* a, int i)
+{
+	static const struct { uint32_t type; uint64_t config; } ev[] = {
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+		{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+		{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB
+		    | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+		    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+		{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+	};
+
+	memset(a, 0, sizeof *a);
+	a->size = sizeof *a;
+	a->type = ev[i].type;
+	a->config = ev[i].config;
+	a->read_format = PERF_FORMAT_GROUP
+		| PERF_FORMAT_TOTAL_TIME_ENABLED
+		| PERF_FORMAT_TOTAL_TIME_RUNNING;
+	a->exclude_kernel = 1;
+	a->exclude_hv = 1;
+}
+
+int csnip_perfctr_open(csnip_perfctr* P, unsigned events)
+{
+	P->leader = -1;
+	P->events = 0;
+	for (int i = 0; i < CSNIP_PERFCTR_N; ++i) {
+		P->fd[i] = -1;
+		if (!(events & (1u << i)))
+			continue;
+
+		/* The first event opened leads the group; it starts out
+		 * disabled, and the others follow it.
+		 */
+		struct perf_event_attr a;
+		init_attr(&a, i);
+		a.disabled = (P->leader < 0);
+		const long fd = syscall(SYS_perf_event_open, &a, 0, -1,
+					P->leader, 0);
+		if (fd < 0)
+			continue;
+		P->fd[i] = (int)fd;
+		P->events |= 1u << i;
+		if (P->leader < 0)
+			P->leader = (int)fd;
+	}
+
+	return P->events ? 0 : csnip_err_UNSUPPORTED;
+}
+
+void csnip_perfctr_close(csnip_perfctr* P)
+{
+	for (int i = 0; i < CSNIP_PERFCTR_N; ++i) {
+		if (P->fd[i] >= 0)
+			close(P->fd[i]);
+		P->fd[i] = -1;
+	}
+	P->leader = -1;
+	P->events = 0;
+}
+
+static void group_ioctl(csnip_perfctr* P, unsigned long req)
+{
+	if (P->leader >= 0)
+		ioctl(P->leader, req, PERF_IOC_FLAG_GROUP);
+}
+
+void csnip_perfctr_start(csnip_perfctr* P)
+{
+	group_ioctl(P, PERF_EVENT_IOC_RESET);
+	group_ioctl(P, PERF_EVENT_IOC_ENABLE);
+}
+
+void csnip_perfctr_pause(csnip_perfctr* P)
+{
+	group_ioctl(P, PERF_EVENT_IOC_DISABLE);
+}
+
+void csnip_perfctr_resume(csnip_perfctr* P)
+{
+	group_ioctl(P, PERF_EVENT_IOC_ENABLE);
+}
+
+void csnip_perfctr_read(csnip_perfctr* P, csnip_perfctr_counts* C)
+{
+	C->valid = 0;
+	C->multiplexed = 0;
+	memset(C->value, 0, sizeof C->value);
+	if (P->leader < 0)
+		return;
+
+	/* Group read format:  nr, time_enabled, time_running, and the
+	 * values in the order the events were added to the group.
+	 */
+	uint64_t buf[3 + CSNIP_PERFCTR_N];
+	const ssize_t n = read(P->leader, buf, sizeof buf);
+	if (n < (ssize_t)(3 * sizeof buf[0]))
+		return;
+	const uint64_t nr = buf[0], enabled = buf[1], running = buf[2];
+	if (running == 0 || (size_t)n < (3 + nr) * sizeof buf[0])
+		return;
+
+	C->multiplexed = (running < enabled);
+	uint64_t k = 0;
+	for (int i = 0; i < CSNIP_PERFCTR_N && k < nr; ++i) {
+		if (P->fd[i] < 0)
+			continue;
+		uint64_t v = buf[3 + k++];
+		if (C->multiplexed)
+			v = (uint64_t)((double)v * enabled / running);
+		C->value[i] = v;
+		C->valid |= 1u << i;
+	}
+}
+
+void csnip_perfctr_stop(csnip_perfctr* P, csnip_perfctr_counts* C)
+{
+	group_ioctl(P, PERF_EVENT_IOC_DISABLE);
+	csnip_perfctr_read(P, C);
+}
+
+#else /* CSNIP_CONF__HAVE_LINUX_PERF_EVENT_H */
+
+int csnip_perfctr_open(csnip_perfctr* P, unsigned events)
+{
+	(void)events;
+	for (int i = 0; i < CSNIP_PERFCTR_N; ++i)
+		P->fd[i] = -1;
+	P->leader = -1;
+	P->events = 0;
+	return csnip_err_UNSUPPORTED;
+}
+
+void csnip_perfctr_close(csnip_perfctr* P)
+{
+	P->events = 0;
+}
+
+void csnip_perfctr_start(csnip_perfctr* P)
+{
+	(void)P;
+}
+
+void csnip_perfctr_pause(csnip_perfctr* P)
+{
+	(void)P;
+}
+
+void csnip_perfctr_resume(csnip_perfctr* P)
+{
+	(void)P;
+}
+
+void csnip_perfctr_read(csnip_perfctr* P, csnip_perfctr_counts* C)
+{
+	(void)P;
+	C->valid = 0;
+	C->multiplexed = 0;
+	memset(C->value, 0, sizeof C->value);
+}
+
+void csnip_perfctr_stop(csnip_perfctr* P, csnip_perfctr_counts* C)
+{
+	csnip_perfctr_read(P, C);
+}
+
+#endif /* CSNIP_CONF__HAVE_LINUX_PERF_EVENT_H */
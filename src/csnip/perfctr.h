@@ -0,0 +1,198 @@
+#ifndef CSNIP_PERFCTR_H
+#define CSNIP_PERFCTR_H
+
+/**	@file perfctr.h
+ *	@brief			Hardware performance counters
+ *	@defgroup perfctr	Hardware performance counters
+ *	@{
+ *
+ *	Counts hardware events, such as cache misses, for a block of code
+ *	in the calling thread, through Linux's perf_event_open(2).
+ *
+ *	The events are opened as one group, so that they are counted
+ *	over exactly the same interval, and read with a single system
+ *	call.  If the CPU can't count all of them at once, the kernel
+ *	multiplexes the group, and the counts are scaled up from the
+ *	fraction of the time they were counted.
+ *
+ *	Performance counters are often unavailable:  on other operating
+ *	systems, in virtual machines without a virtual PMU, and in
+ *	containers or with kernel.perf_event_paranoid settings that
+ *	restrict them.  The API degrades gracefully:  events that can't
+ *	be opened are left out, and the counts tell which events were
+ *	counted, so that callers can report the others as unavailable.
+ *	Only user space events are counted, which is permitted at the
+ *	default perf_event_paranoid level of 2.
+ *
+ *	@code{.c}
+ *	csnip_perfctr P;
+ *	csnip_perfctr_open(&P, CSNIP_PERFCTR_ALL);
+ *	csnip_perfctr_counts C;
+ *	csnip_perfctr_Scoped(&P, &C,
+ *		work();
+ *	);
+ *	if (C.valid & CSNIP_PERFCTR_CACHE_MISSES) {
+ *		const uint64_t m = C.value[CSNIP_PERFCTR_I_CACHE_MISSES];
+ *		printf("%llu cache misses\n", (unsigned long long)m);
+ *	}
+ *	csnip_perfctr_close(&P);
+ *	@endcode
+ */
+
+#include <stdint.h>
+
+/** @name Events
+ *
+ *  Flags for sets of events; the corresponding CSNIP_PERFCTR_I_*
+ *  constants are their indices in csnip_perfctr_counts::value.
+ */
+/**@{*/
+#define CSNIP_PERFCTR_CYCLES		(1u << 0)	/**< CPU cycles */
+#define CSNIP_PERFCTR_INSTRUCTIONS	(1u << 1)	/**< Retired instr. */
+#define CSNIP_PERFCTR_CACHE_MISSES	(1u << 2)	/**< LLC misses */
+#define CSNIP_PERFCTR_BRANCH_MISSES	(1u << 3)	/**< Mispredicts */
+#define CSNIP_PERFCTR_DTLB_MISSES	(1u << 4)	/**< dTLB load misses */
+#define CSNIP_PERFCTR_PAGE_FAULTS	(1u << 5)	/**< Page faults (sw) */
+
+/** The hardware events */
+#define CSNIP_PERFCTR_HW		0x1fu
+/** All events */
+#define CSNIP_PERFCTR_ALL		0x3fu
+
+#define CSNIP_PERFCTR_I_CYCLES		0
+#define CSNIP_PERFCTR_I_INSTRUCTIONS	1
+#define CSNIP_PERFCTR_I_CACHE_MISSES	2
+#define CSNIP_PERFCTR_I_BRANCH_MISSES	3
+#define CSNIP_PERFCTR_I_DTLB_MISSES	4
+#define CSNIP_PERFCTR_I_PAGE_FAULTS	5
+
+/** Number of events */
+#define CSNIP_PERFCTR_N			6
+/**@}*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Counter group.
+ *
+ *  The members are internal.
+ */
+typedef struct {
+	/** @cond */
+	int fd[CSNIP_PERFCTR_N];	/* Descriptors, or -1 */
+	int leader;			/* Group leader descriptor, or -1 */
+	unsigned events;		/* Events opened */
+	/** @endcond */
+} csnip_perfctr;
+
+/** Event counts. */
+typedef struct {
+	unsigned valid;			/**< Events counted */
+	int multiplexed;		/**< Whether counts are estimates */
+	uint64_t value[CSNIP_PERFCTR_N];/**< Counts, by event index */
+} csnip_perfctr_counts;
+
+/**	Open counters.
+ *
+ *	@param	events
+ *		the events to count, as CSNIP_PERFCTR_* flags.
+ *
+ *	@return	0 if at least one of the events could be opened;
+ *		csnip_perfctr_events() tells which.  Otherwise
+ *		csnip_err_UNSUPPORTED; the counter group can still be
+ *		used and closed, but counts nothing.
+ */
+int csnip_perfctr_open(csnip_perfctr* P, unsigned events);
+
+/**	Close counters. */
+void csnip_perfctr_close(csnip_perfctr* P);
+
+/**	The events that are being counted. */
+unsigned csnip_perfctr_events(const csnip_perfctr* P);
+
+/**	Reset the counts to zero and start counting. */
+void csnip_perfctr_start(csnip_perfctr* P);
+
+/**	Stop counting and read the counts.
+ *
+ *	Events that couldn't be opened, or that the kernel never got to
+ *	count (e.g., if other users occupied the hardware counters), are
+ *	left out of C->valid.
+ */
+void csnip_perfctr_stop(csnip_perfctr* P, csnip_perfctr_counts* C);
+
+/**	Read the counts without stopping. */
+void csnip_perfctr_read(csnip_perfctr* P, csnip_perfctr_counts* C);
+
+/**	Suspend counting.
+ *
+ *	Unlike csnip_perfctr_stop(), doesn't read the counts.  Each of
+ *	csnip_perfctr_pause() and csnip_perfctr_resume() is a system
+ *	call, costing on the order of a microsecond.
+ */
+void csnip_perfctr_pause(csnip_perfctr* P);
+
+/**	Resume counting after csnip_perfctr_pause(). */
+void csnip_perfctr_resume(csnip_perfctr* P);
+
+/**	Name of an event.
+ *
+ *	@param	i
+ *		the event index, a CSNIP_PERFCTR_I_* constant.
+ *
+ *	@return	the name as used by the perf tool, e.g.,
+ *		"cache-misses", or NULL if the index is out of range.
+ */
+const char* csnip_perfctr_name(int i);
+
+/**	Parse a list of events.
+ *
+ *	@param	s
+ *		comma separated event names, or "all", "hw" or "none".
+ *
+ *	@return	0 on success, or csnip_err_INVAL if a name is not known.
+ */
+int csnip_perfctr_parse(const char* s, unsigned* events);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @name Scoped counting */
+/**@{*/
+
+/**	Count events in a block.
+ *
+ *	Statement macro.  Starts the counters, executes the statements,
+ *	and stops the counters, storing the counts in *C.  The block
+ *	must not leave the macro with break, continue, return or goto.
+ */
+#define csnip_perfctr_Scoped(P, C, ...) \
+	do { \
+		csnip_perfctr_start(P); \
+		__VA_ARGS__ \
+		csnip_perfctr_stop((P), (C)); \
+	} while (0)
+/**@}*/
+
+/** @} */
+
+#endif /* CSNIP_PERFCTR_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_PERFCTR_HAVE_SHORT_NAMES)
+#define perfctr				csnip_perfctr
+#define perfctr_counts			csnip_perfctr_counts
+#define perfctr_open			csnip_perfctr_open
+#define perfctr_close			csnip_perfctr_close
+#define perfctr_events			csnip_perfctr_events
+#define perfctr_start			csnip_perfctr_start
+#define perfctr_stop			csnip_perfctr_stop
+#define perfctr_read			csnip_perfctr_read
+#define perfctr_pause			csnip_perfctr_pause
+#define perfctr_resume			csnip_perfctr_resume
+#define perfctr_name			csnip_perfctr_name
+#define perfctr_parse			csnip_perfctr_parse
+#define perfctr_Scoped			csnip_perfctr_Scoped
+#define CSNIP_PERFCTR_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_PERFCTR_HAVE_SHORT_NAMES */
@@ -0,0 +1,528 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <csnip/csnip_conf.h>
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+#include <pthread.h>
+#endif
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/rdist.h>
+#include <csnip/rng.h>
+#include <csnip/runif.h>
+
+/* Uniform random sources */
+
+static uint64_t get64(const rng* R)
+{
+	return (uint64_t)runif_getull(R, (unsigned long long)UINT64_MAX);
+}
+
+/* Uniform in [0, 1) */
+static double get01(const rng* R)
+{
+	return runif_getd(R, 1.0);
+}
+
+/* Ziggurat tables.
+ *
+ * The layout follows Marsaglia & Tsang, "The Ziggurat Method for
+ * Generating Random Variables", J. Stat. Softw. 5(8), 2000, with 256
+ * layers of equal area v.  Layer 0 is the base strip including the
+ * tail beyond r.  For a random integer j in [0, 2^b) and layer i, the
+ * candidate is x = j * w[i]; it is accepted right away if j < k[i],
+ * i.e., if x lies in the part of the layer that is fully below the
+ * density.  f[i] is the density at the right edge of layer i.
+ */
+
+#define ZIG_N		256
+
+/* Normal, 52 bit magnitudes */
+#define NOR_R		3.6541528853610088
+#define NOR_V		0.00492867323399
+#define NOR_M		4503599627370496.0	/* 2^52 */
+
+/* Exponential, 53 bit magnitudes */
+#define EXP_R		7.69711747013104972
+#define EXP_V		0.0039496598225815571993
+#define EXP_M		9007199254740992.0	/* 2^53 */
+
+static uint64_t nor_k[ZIG_N];
+static double nor_w[ZIG_N];
+static double nor_f[ZIG_N];
+
+static uint64_t exp_k[ZIG_N];
+static double exp_w[ZIG_N];
+static double exp_f[ZIG_N];
+
+static void zig_init(void)
+{
+	/* Normal */
+	double dn = NOR_R, tn = dn;
+	double q = NOR_V / exp(-0.5 * dn * dn);
+	nor_k[0] = (uint64_t)((dn / q) * NOR_M);
+	nor_k[1] = 0;
+	nor_w[0] = q / NOR_M;
+	nor_w[ZIG_N - 1] = dn / NOR_M;
+	nor_f[0] = 1.0;
+	nor_f[ZIG_N - 1] = exp(-0.5 * dn * dn);
+	for (int i = ZIG_N - 2; i >= 1; --i) {
+		dn = sqrt(-2.0 * log(NOR_V / dn + exp(-0.5 * dn * dn)));
+		nor_k[i + 1] = (uint64_t)((dn / tn) * NOR_M);
+		tn = dn;
+		nor_f[i] = exp(-0.5 * dn * dn);
+		nor_w[i] = dn / NOR_M;
+	}
+
+	/* Exponential */
+	double de = EXP_R, te = de;
+	q = EXP_V / exp(-de);
+	exp_k[0] = (uint64_t)((de / q) * EXP_M);
+	exp_k[1] = 0;
+	exp_w[0] = q / EXP_M;
+	exp_w[ZIG_N - 1] = de / EXP_M;
+	exp_f[0] = 1.0;
+	exp_f[ZIG_N - 1] = exp(-de);
+	for (int i = ZIG_N - 2; i >= 1; --i) {
+		de = -log(EXP_V / de + exp(-de));
+		exp_k[i + 1] = (uint64_t)((de / te) * EXP_M);
+		te = de;
+		exp_f[i] = exp(-de);
+		exp_w[i] = de / EXP_M;
+	}
+}
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+static pthread_once_t zig_once = PTHREAD_ONCE_INIT;
+#define zig_ensure_init()	pthread_once(&zig_once, zig_init)
+#else
+static bool zig_ready = false;
+#define zig_ensure_init() \
+	do { \
+		if (!zig_ready) { \
+			zig_init(); \
+			zig_ready = true; \
+		} \
+	} while (0)
+#endif
+
+/* Normal and exponential variates */
+
+static double normal_imp(const rng* R)
+{
+	while (1) {
+		uint64_t r = get64(R);
+		const int idx = r & 0xff;
+		r >>= 8;
+		const int sign = r & 1;
+		const uint64_t rabs = (r >> 1) & 0x000fffffffffffffull;
+		double x = rabs * nor_w[idx];
+		if (sign)
+			x = -x;
+		if (rabs < nor_k[idx])
+			return x;
+
+		if (idx == 0) {
+			/* Sample from the tail beyond NOR_R */
+			while (1) {
+				const double xx =
+				  -log1p(-get01(R)) / NOR_R;
+				const double yy = -log1p(-get01(R));
+				if (yy + yy > xx * xx)
+					return sign ? -(NOR_R + xx)
+						    : NOR_R + xx;
+			}
+		}
+
+		/* Wedge */
+		const double u = get01(R);
+		if ((nor_f[idx - 1] - nor_f[idx]) * u + nor_f[idx]
+		  < exp(-0.5 * x * x))
+		{
+			return x;
+		}
+	}
+}
+
+static double exp_imp(const rng* R)
+{
+	while (1) {
+		uint64_t r = get64(R) >> 3;
+		const int idx = r & 0xff;
+		r >>= 8;
+		const double x = r * exp_w[idx];
+		if (r < exp_k[idx])
+			return x;
+
+		if (idx == 0) {
+			/* Tail: memoryless */
+			return EXP_R - log1p(-get01(R));
+		}
+
+		/* Wedge */
+		const double u = get01(R);
+		if ((exp_f[idx - 1] - exp_f[idx]) * u + exp_f[idx]
+		  < exp(-x))
+		{
+			return x;
+		}
+	}
+}
+
+double csnip_rdist_normal(const rng* R)
+{
+	zig_ensure_init();
+	return normal_imp(R);
+}
+
+double csnip_rdist_exp(const rng* R)
+{
+	zig_ensure_init();
+	return exp_imp(R);
+}
+
+void csnip_rdist_normal_fill(const rng* R, size_t n, double* out)
+{
+	zig_ensure_init();
+	for (size_t i = 0; i < n; ++i)
+		out[i] = normal_imp(R);
+}
+
+void csnip_rdist_exp_fill(const rng* R, size_t n, double* out)
+{
+	zig_ensure_init();
+	for (size_t i = 0; i < n; ++i)
+		out[i] = exp_imp(R);
+}
+
+/* Gamma variates (Marsaglia & Tsang, "A Simple Method for Generating
+ * Gamma Variables", ACM TOMS 26(3), 2000).
+ */
+
+typedef struct {
+	double d, c;
+	double inv_shape;	/* 1/shape if shape < 1, else 0 */
+} gamma_param;
+
+static gamma_param gamma_setup(double shape)
+{
+	gamma_param G;
+	G.inv_shape = 0;
+	if (shape < 1) {
+		/* Gamma(shape) = Gamma(shape + 1) * U^(1/shape) */
+		G.inv_shape = 1.0 / shape;
+		shape += 1.0;
+	}
+	G.d = shape - 1.0 / 3.0;
+	G.c = 1.0 / sqrt(9.0 * G.d);
+	return G;
+}
+
+static double gamma_imp(const rng* R, const gamma_param* G)
+{
+	double ret;
+	while (1) {
+		double x, v;
+		do {
+			x = normal_imp(R);
+			v = 1.0 + G->c * x;
+		} while (v <= 0);
+		v = v * v * v;
+		const double u = 1.0 - get01(R);	/* (0, 1] */
+		const double x2 = x * x;
+		if (u < 1.0 - 0.0331 * x2 * x2
+		  || log(u) < 0.5 * x2 + G->d * (1.0 - v + log(v)))
+		{
+			ret = G->d * v;
+			break;
+		}
+	}
+	if (G->inv_shape != 0)
+		ret *= pow(1.0 - get01(R), G->inv_shape);
+	return ret;
+}
+
+double csnip_rdist_gamma(const rng* R, double shape)
+{
+	zig_ensure_init();
+	const gamma_param G = gamma_setup(shape);
+	return gamma_imp(R, &G);
+}
+
+void csnip_rdist_gamma_fill(const rng* R,
+				double shape,
+				size_t n,
+				double* out)
+{
+	zig_ensure_init();
+	const gamma_param G = gamma_setup(shape);
+	for (size_t i = 0; i < n; ++i)
+		out[i] = gamma_imp(R, &G);
+}
+
+/* Poisson variates.
+ *
+ * For mu >= 10, PTRS from W. Hörmann, "The transformed rejection
+ * method for generating Poisson random variables", Insurance:
+ * Mathematics and Economics 12, 1993.  For smaller mu, multiplication
+ * of uniforms.
+ */
+
+typedef struct {
+	double mu;
+	double enmu;		/* exp(-mu), small mu */
+	double slam, loglam;	/* PTRS parameters */
+	double a, b, invalpha, vr;
+} poisson_param;
+
+static poisson_param poisson_setup(double mu)
+{
+	poisson_param P = { .mu = mu };
+	if (mu >= 10) {
+		P.slam = sqrt(mu);
+		P.loglam = log(mu);
+		P.b = 0.931 + 2.53 * P.slam;
+		P.a = -0.059 + 0.02483 * P.b;
+		P.invalpha = 1.1239 + 1.1328 / (P.b - 3.4);
+		P.vr = 0.9277 - 3.6224 / (P.b - 2);
+	} else {
+		P.enmu = exp(-mu);
+	}
+	return P;
+}
+
+static unsigned long poisson_imp(const rng* R, const poisson_param* P)
+{
+	if (P->mu >= 10) {
+		while (1) {
+			const double U = get01(R) - 0.5;
+			const double V = get01(R);
+			const double us = 0.5 - fabs(U);
+			const double k = floor((2 * P->a / us + P->b) * U
+						+ P->mu + 0.43);
+			if (us >= 0.07 && V <= P->vr)
+				return (unsigned long)k;
+			if (k < 0 || (us < 0.013 && V > us))
+				continue;
+			if (log(V) + log(P->invalpha)
+			      - log(P->a / (us * us) + P->b)
+			    <= -P->mu + k * P->loglam - lgamma(k + 1))
+			{
+				return (unsigned long)k;
+			}
+		}
+	}
+
+	if (P->mu <= 0)
+		return 0;
+	unsigned long k = 0;
+	double prod = get01(R);
+	while (prod > P->enmu) {
+		++k;
+		prod *= get01(R);
+	}
+	return k;
+}
+
+unsigned long csnip_rdist_poisson(const rng* R, double mu)
+{
+	const poisson_param P = poisson_setup(mu);
+	return poisson_imp(R, &P);
+}
+
+void csnip_rdist_poisson_fill(const rng* R,
+				double mu,
+				size_t n,
+				unsigned long* out)
+{
+	const poisson_param P = poisson_setup(mu);
+	for (size_t i = 0; i < n; ++i)
+		out[i] = poisson_imp(R, &P);
+}
+
+/* Binomial variates.
+ *
+ * For (n + 1) p >= 11, BTRD from W. Hörmann, "The generation of
+ * binomial random variates", J. Stat. Comput. Simul. 46, 1993.
+ * Otherwise, sequential inversion.  In both cases, p > 1/2 is handled
+ * by sampling failures instead of successes.
+ */
+
+#define BINOM_INVERSION_THRESHOLD	11
+
+typedef struct {
+	unsigned long n;
+	double p;		/* min(p, 1 - p) */
+	bool flip;		/* whether p was replaced by 1 - p */
+	bool btrd;
+
+	/* Inversion */
+	double q_n;
+
+	/* BTRD */
+	double m, r, nr, npq, b, a, c, alpha, v_r, u_rv_r;
+} binom_param;
+
+/* Stirling formula correction term fc(k) = log(k!) - (k + 1/2) log(k + 1)
+ * + (k + 1) - log(sqrt(2 pi)).
+ */
+static double fc(double k)
+{
+	static const double tbl[10] = {
+		0.08106146679532726,
+		0.04134069595540929,
+		0.02767792568499834,
+		0.02079067210376509,
+		0.01664469118982119,
+		0.01387612882307075,
+		0.01189670994589177,
+		0.01041126526197209,
+		0.009255462182712733,
+		0.008330563433362871,
+	};
+	if (k < 10)
+		return tbl[(int)k];
+	const double ikp1 = 1.0 / (k + 1);
+	return (1.0 / 12
+		- (1.0 / 360 - 1.0 / 1260 * (ikp1 * ikp1)) * (ikp1 * ikp1))
+		* ikp1;
+}
+
+static binom_param binom_setup(unsigned long n, double p)
+{
+	binom_param B = { .n = n, .p = p, .flip = false };
+	if (p > 0.5) {
+		B.p = 1.0 - p;
+		B.flip = true;
+	}
+	p = B.p;
+	B.m = floor((n + 1.0) * p);
+	B.btrd = (B.m >= BINOM_INVERSION_THRESHOLD);
+	if (B.btrd) {
+		B.r = p / (1 - p);
+		B.nr = (n + 1.0) * B.r;
+		B.npq = n * p * (1 - p);
+		const double sqrt_npq = sqrt(B.npq);
+		B.b = 1.15 + 2.53 * sqrt_npq;
+		B.a = -0.0873 + 0.0248 * B.b + 0.01 * p;
+		B.c = n * p + 0.5;
+		B.alpha = (2.83 + 5.1 / B.b) * sqrt_npq;
+		B.v_r = 0.92 - 4.2 / B.b;
+		B.u_rv_r = 0.86 * B.v_r;
+	} else {
+		B.q_n = pow(1 - p, (double)n);
+	}
+	return B;
+}
+
+static unsigned long binom_invert(const rng* R, const binom_param* B)
+{
+	const double q = 1 - B->p;
+	const double s = B->p / q;
+	const double a = (B->n + 1.0) * s;
+	double r = B->q_n;
+	double u = get01(R);
+	unsigned long x = 0;
+	while (u > r && x < B->n) {
+		u -= r;
+		++x;
+		const double r1 = (a / x - s) * r;
+		/* Once the pmf is that small, we are in the far tail,
+		 * and rounding errors dominate.
+		 */
+		if (r1 < 2.220446049250313e-16 && r1 < r)
+			break;
+		r = r1;
+	}
+	return x;
+}
+
+static unsigned long binom_btrd(const rng* R, const binom_param* B)
+{
+	const double n = (double)B->n;
+	while (1) {
+		double u;
+		double v = get01(R);
+		if (v <= B->u_rv_r) {
+			u = v / B->v_r - 0.43;
+			return (unsigned long)floor(
+			  (2 * B->a / (0.5 - fabs(u)) + B->b) * u + B->c);
+		}
+
+		if (v >= B->v_r) {
+			u = get01(R) - 0.5;
+		} else {
+			u = v / B->v_r - 0.93;
+			u = (u < 0 ? -0.5 : 0.5) - u;
+			v = get01(R) * B->v_r;
+		}
+
+		const double us = 0.5 - fabs(u);
+		const double k = floor((2 * B->a / us + B->b) * u + B->c);
+		if (k < 0 || k > n)
+			continue;
+		v = v * B->alpha / (B->a / (us * us) + B->b);
+		const double km = fabs(k - B->m);
+		if (km <= 15) {
+			/* Recursive evaluation of f(k) / f(m) */
+			double f = 1;
+			if (B->m < k) {
+				for (double i = B->m + 1; i <= k; ++i)
+					f *= B->nr / i - B->r;
+			} else if (B->m > k) {
+				for (double i = k + 1; i <= B->m; ++i)
+					v *= B->nr / i - B->r;
+			}
+			if (v <= f)
+				return (unsigned long)k;
+			continue;
+		}
+
+		/* Squeeze, then final acceptance test */
+		v = log(v);
+		const double rho = (km / B->npq)
+		  * (((km / 3.0 + 0.625) * km + 1.0 / 6) * km + 0.5);
+		const double t = -km * km / (2 * B->npq);
+		if (v < t - rho)
+			return (unsigned long)k;
+		if (v > t + rho)
+			continue;
+		const double nm = n - B->m + 1;
+		const double h = (B->m + 0.5) * log((B->m + 1) / (B->r * nm))
+				+ fc(B->m) + fc(n - B->m);
+		const double nk = n - k + 1;
+		if (v <= h + (n + 1) * log(nm / nk)
+			+ (k + 0.5) * log(nk * B->r / (k + 1))
+			- fc(k) - fc(n - k))
+		{
+			return (unsigned long)k;
+		}
+	}
+}
+
+static unsigned long binom_imp(const rng* R, const binom_param* B)
+{
+	const unsigned long k = B->btrd ? binom_btrd(R, B)
+					: binom_invert(R, B);
+	return B->flip ? B->n - k : k;
+}
+
+unsigned long csnip_rdist_binomial(const rng* R,
+				unsigned long n,
+				double p)
+{
+	const binom_param B = binom_setup(n, p);
+	return binom_imp(R, &B);
+}
+
+void csnip_rdist_binomial_fill(const rng* R,
+				unsigned long nTrial,
+				double p,
+				size_t n,
+				unsigned long* out)
+{
+	const binom_param B = binom_setup(nTrial, p);
+	for (size_t i = 0; i < n; ++i)
+		out[i] = binom_imp(R, &B);
+}
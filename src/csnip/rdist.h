@@ -0,0 +1,124 @@
+#ifndef CSNIP_RDIST_H
+#define CSNIP_RDIST_H
+
+/**	@file rdist.h
+ *	@defgroup rdist		Non-uniform random variates
+ *	@{
+ *
+ *	Generation of non-uniform random variates.
+ *
+ *	This module builds on the uniform variates of runif.h to sample
+ *	from a number of common continuous and discrete distributions.
+ *	The algorithms are chosen for speed:
+ *
+ *	* Normal and exponential variates use the ziggurat method
+ *	  (Marsaglia & Tsang, 2000) with 256 layers.  In about 99% of
+ *	  the cases, a sample costs one 64 bit random word, a table
+ *	  lookup, a multiplication and one comparison.
+ *
+ *	* Gamma variates use the Marsaglia & Tsang (2000) squeeze
+ *	  method on top of the normal ziggurat.
+ *
+ *	* Poisson variates use the PTRS transformed rejection method
+ *	  (Hörmann, 1993) for mu >= 10, and multiplication of uniforms
+ *	  otherwise.
+ *
+ *	* Binomial variates use the BTRD transformed rejection method
+ *	  (Hörmann, 1993) for (n + 1) p >= 11, and inversion otherwise.
+ *
+ *	Each sampler has a _fill variant generating many variates into
+ *	an array.
+ *
+ *	The ziggurat tables are computed on first use.
+ */
+
+#include <stddef.h>
+
+#include <csnip/rng.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**	Standard normal variate (mean 0, variance 1). */
+double csnip_rdist_normal(const csnip_rng* R);
+
+/**	Standard exponential variate (rate 1). */
+double csnip_rdist_exp(const csnip_rng* R);
+
+/**	Gamma variate.
+ *
+ *	@param	shape
+ *		the shape parameter; must be positive.  The scale is 1;
+ *		multiply the result for other scales.
+ */
+double csnip_rdist_gamma(const csnip_rng* R, double shape);
+
+/**	Poisson variate.
+ *
+ *	@param	mu
+ *		the mean; must be non-negative.
+ */
+unsigned long csnip_rdist_poisson(const csnip_rng* R, double mu);
+
+/**	Binomial variate.
+ *
+ *	The number of successes in n independent trials with success
+ *	probability p each.
+ *
+ *	@param	n
+ *		the number of trials.
+ *
+ *	@param	p
+ *		the success probability, 0 <= p <= 1.
+ */
+unsigned long csnip_rdist_binomial(const csnip_rng* R,
+				unsigned long n,
+				double p);
+
+/** @name Bulk generation
+ *
+ *  These fill out[0], ..., out[n - 1] with independent variates; the
+ *  results are the same as n calls of the corresponding single-variate
+ *  function, but setup costs (e.g. of the Poisson and binomial
+ *  samplers) are paid only once.
+ */
+/**@{*/
+void csnip_rdist_normal_fill(const csnip_rng* R, size_t n, double* out);
+void csnip_rdist_exp_fill(const csnip_rng* R, size_t n, double* out);
+void csnip_rdist_gamma_fill(const csnip_rng* R,
+				double shape,
+				size_t n,
+				double* out);
+void csnip_rdist_poisson_fill(const csnip_rng* R,
+				double mu,
+				size_t n,
+				unsigned long* out);
+void csnip_rdist_binomial_fill(const csnip_rng* R,
+				unsigned long nTrial,
+				double p,
+				size_t n,
+				unsigned long* out);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* CSNIP_RDIST_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_RDIST_HAVE_SHORT_NAMES)
+#define rdist_normal		csnip_rdist_normal
+#define rdist_exp		csnip_rdist_exp
+#define rdist_gamma		csnip_rdist_gamma
+#define rdist_poisson		csnip_rdist_poisson
+#define rdist_binomial		csnip_rdist_binomial
+#define rdist_normal_fill	csnip_rdist_normal_fill
+#define rdist_exp_fill		csnip_rdist_exp_fill
+#define rdist_gamma_fill	csnip_rdist_gamma_fill
+#define rdist_poisson_fill	csnip_rdist_poisson_fill
+#define rdist_binomial_fill	csnip_rdist_binomial_fill
+#define CSNIP_RDIST_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_RDIST_HAVE_SHORT_NAMES */
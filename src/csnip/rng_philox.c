@@ -0,0 +1,222 @@
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/rng.h>
+#include <csnip/rng_philox.h>
+
+/* Philox4x32 constants */
+#define PHILOX_M0	0xD2511F53u
+#define PHILOX_M1	0xCD9E8D57u
+#define PHILOX_W0	0x9E3779B9u
+#define PHILOX_W1	0xBB67AE85u
+#define PHILOX_ROUNDS	10
+
+/* Number of blocks processed side by side in the batch kernel */
+#define LANES		8
+
+static void ctr_add(uint32_t ctr[4], uint32_t inc)
+{
+	uint32_t carry = inc;
+	for (int i = 0; i < 4 && carry; ++i) {
+		const uint32_t old = ctr[i];
+		ctr[i] += carry;
+		carry = (ctr[i] < old);
+	}
+}
+
+void csnip_rng_philox4x32(const uint32_t ctr[4],
+			const uint32_t key[2],
+			uint32_t out[4])
+{
+	uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	for (int r = 0; r < PHILOX_ROUNDS; ++r) {
+		if (r > 0) {
+			k0 += PHILOX_W0;
+			k1 += PHILOX_W1;
+		}
+		const uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+		const uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+		c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+		c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+		c1 = (uint32_t)p1;
+		c3 = (uint32_t)p0;
+	}
+	out[0] = c0;
+	out[1] = c1;
+	out[2] = c2;
+	out[3] = c3;
+}
+
+/* Compute LANES blocks at once.
+ *
+ * The words of the blocks are kept in structure-of-arrays form, so that
+ * each round is a sequence of element-wise operations over arrays of
+ * LANES values, which compilers turn into SIMD code (e.g., pmuludq on
+ * SSE2/AVX2, umull on NEON).
+ */
+static void philox_lanes(const uint32_t ctr[4],
+			const uint32_t key[2],
+			uint32_t* out)
+{
+	uint32_t c0[LANES], c1[LANES], c2[LANES], c3[LANES];
+	uint32_t cc[4] = { ctr[0], ctr[1], ctr[2], ctr[3] };
+	for (int j = 0; j < LANES; ++j) {
+		c0[j] = cc[0];
+		c1[j] = cc[1];
+		c2[j] = cc[2];
+		c3[j] = cc[3];
+		ctr_add(cc, 1);
+	}
+
+	uint32_t k0 = key[0], k1 = key[1];
+	for (int r = 0; r < PHILOX_ROUNDS; ++r) {
+		if (r > 0) {
+			k0 += PHILOX_W0;
+			k1 += PHILOX_W1;
+		}
+		for (int j = 0; j < LANES; ++j) {
+			const uint64_t p0 = (uint64_t)PHILOX_M0 * c0[j];
+			const uint64_t p1 = (uint64_t)PHILOX_M1 * c2[j];
+			c0[j] = (uint32_t)(p1 >> 32) ^ c1[j] ^ k0;
+			c2[j] = (uint32_t)(p0 >> 32) ^ c3[j] ^ k1;
+			c1[j] = (uint32_t)p1;
+			c3[j] = (uint32_t)p0;
+		}
+	}
+
+	for (int j = 0; j < LANES; ++j) {
+		out[4*j + 0] = c0[j];
+		out[4*j + 1] = c1[j];
+		out[4*j + 2] = c2[j];
+		out[4*j + 3] = c3[j];
+	}
+}
+
+void csnip_rng_philox4x32_batch(const uint32_t ctr[4],
+			const uint32_t key[2],
+			size_t nblock,
+			uint32_t* out)
+{
+	uint32_t c[4] = { ctr[0], ctr[1], ctr[2], ctr[3] };
+	while (nblock >= LANES) {
+		philox_lanes(c, key, out);
+		ctr_add(c, LANES);
+		out += 4 * LANES;
+		nblock -= LANES;
+	}
+	while (nblock > 0) {
+		csnip_rng_philox4x32(c, key, out);
+		ctr_add(c, 1);
+		out += 4;
+		--nblock;
+	}
+}
+
+/* Threefry2x64 */
+
+#define THREEFRY_PARITY	0x1BD11BDAA9FC1A22ull
+#define THREEFRY_ROUNDS	20
+
+static uint64_t rotl64(uint64_t x, int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+void csnip_rng_threefry2x64(const uint64_t ctr[2],
+			const uint64_t key[2],
+			uint64_t out[2])
+{
+	static const int rot[8] = { 16, 42, 12, 31, 16, 32, 24, 21 };
+	const uint64_t ks[3] = {
+		key[0],
+		key[1],
+		THREEFRY_PARITY ^ key[0] ^ key[1]
+	};
+
+	uint64_t x0 = ctr[0] + ks[0];
+	uint64_t x1 = ctr[1] + ks[1];
+	for (int r = 0; r < THREEFRY_ROUNDS; ++r) {
+		x0 += x1;
+		x1 = rotl64(x1, rot[r % 8]);
+		x1 ^= x0;
+
+		/* Key injection every 4 rounds */
+		if (r % 4 == 3) {
+			const int i = (r + 1) / 4;
+			x0 += ks[i % 3];
+			x1 += ks[(i + 1) % 3] + (uint64_t)i;
+		}
+	}
+	out[0] = x0;
+	out[1] = x1;
+}
+
+/* Streaming interface */
+
+void csnip_rng_philox_init(rng_philox_state* S,
+			const uint32_t key[2],
+			const uint32_t ctr[4])
+{
+	S->key[0] = key[0];
+	S->key[1] = key[1];
+	if (ctr) {
+		memcpy(S->ctr, ctr, sizeof(S->ctr));
+	} else {
+		memset(S->ctr, 0, sizeof(S->ctr));
+	}
+	S->pos = 4 * CSNIP_RNG_PHILOX_NBUF;
+}
+
+void csnip_rng_philox_seed(rng_philox_state* S,
+			int nseed,
+			const uint32_t* seed)
+{
+	const uint32_t key[2] = {
+		nseed > 0 ? seed[0] : 0,
+		nseed > 1 ? seed[1] : 0
+	};
+	rng_philox_init(S, key, NULL);
+}
+
+uint32_t csnip_rng_philox_getnum(rng_philox_state* S)
+{
+	if (S->pos == 4 * CSNIP_RNG_PHILOX_NBUF) {
+		rng_philox4x32_batch(S->ctr, S->key,
+			CSNIP_RNG_PHILOX_NBUF, S->buf);
+		ctr_add(S->ctr, CSNIP_RNG_PHILOX_NBUF);
+		S->pos = 0;
+	}
+	return S->buf[S->pos++];
+}
+
+static void gen_seed(const rng* R,
+			int nseed,
+			const unsigned long int* seed)
+{
+	/* Use the low 32 bits of each seed value;  the key has 64
+	 * bits, so the first two seed values suffice.
+	 */
+	uint32_t s[2] = { 0, 0 };
+	for (int i = 0; i < nseed && i < 2; ++i)
+		s[i] = (uint32_t)seed[i];
+	rng_philox_seed(R->state, 2, s);
+}
+
+static unsigned long int gen_getnum(const rng* R)
+{
+	return rng_philox_getnum(R->state);
+}
+
+rng csnip_rng_philox_makerng(rng_philox_state* state)
+{
+	rng R = {
+		.minval = 0,
+		.maxval = 0xFFFFFFFFul,
+		.state = state,
+		.seed = gen_seed,
+		.getnum = gen_getnum,
+	};
+
+	return R;
+}
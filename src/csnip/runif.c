@@ -5,13 +5,100 @@
 #include <stdlib.h>
 #include <tgmath.h>
 
+#include <stdint.h>
+
 #define CSNIP_SHORT_NAMES
 #include <csnip/rng.h>
 #include <csnip/runif.h>
+#include <csnip/util.h>
+
+/* Fast path for RNGs with full 32 or 64 bit output range.
+ *
+ * Most generators (e.g. the Mersenne twister) produce uniformly
+ * distributed words of exactly 32 or 64 bits, i.e. minval == 0 and
+ * maxval == 2^32 - 1 or 2^64 - 1.  For those, we avoid the divisions
+ * of the generic algorithm:  Bounded integers are generated with
+ * Lemire's multiply-shift method, which needs a division only in the
+ * rare case where a rejection threshold must be computed, and
+ * floating point numbers are built directly from the high bits of a
+ * random word with a multiplication by a constant power of 2.  Both
+ * methods produce exactly uniform results.
+ *
+ * Reference:  D. Lemire, "Fast Random Integer Generation in an
+ * Interval", ACM Transactions on Modeling and Computer Simulation
+ * 29(1), 2019.
+ */
+
+/* Number of random bits per rng_getnum() call on the fast path, or 0
+ * if the RNG does not qualify.
+ */
+static int fast_nbits(const rng* R)
+{
+	if (R->minval != 0)
+		return 0;
+	if (R->maxval == 0xFFFFFFFFul)
+		return 32;
+#if ULONG_MAX == UINT64_MAX
+	if (R->maxval == ULONG_MAX)
+		return 64;
+#endif
+	return 0;
+}
+
+/* Get a uniform random 64 bit word. */
+static uint64_t fast_get64(const rng* R, int nbits)
+{
+	if (nbits == 64)
+		return rng_getnum(R);
+	const uint64_t hi = rng_getnum(R);
+	return (hi << 32) | rng_getnum(R);
+}
+
+/* Uniform value in { 0, ..., max }, using full-range random words. */
+static uint64_t fast_getu64(const rng* R, int nbits, uint64_t max)
+{
+	if (max <= 0xFFFFFFFFu && nbits == 32) {
+		if (max == 0xFFFFFFFFu)
+			return rng_getnum(R);
+
+		/* Lemire's method with 32 bit words */
+		const uint32_t s = (uint32_t)max + 1;
+		uint64_t m = (uint64_t)rng_getnum(R) * s;
+		uint32_t l = (uint32_t)m;
+		if (l < s) {
+			const uint32_t t = (uint32_t)-s % s;
+			while (l < t) {
+				m = (uint64_t)rng_getnum(R) * s;
+				l = (uint32_t)m;
+			}
+		}
+		return m >> 32;
+	}
+
+	if (max == UINT64_MAX)
+		return fast_get64(R, nbits);
+
+	/* Lemire's method with 64 bit words */
+	const uint64_t s = max + 1;
+	uint64_t l;
+	uint64_t h = mul64x64(fast_get64(R, nbits), s, &l);
+	if (l < s) {
+		const uint64_t t = -s % s;
+		while (l < t)
+			h = mul64x64(fast_get64(R, nbits), s, &l);
+	}
+	return h;
+}
 
 #define DEF_runif_get(type, type_max, func_name) \
 type func_name(const rng* R, type max) \
 { \
+	if (sizeof(type) <= sizeof(uint64_t)) { \
+		const int nbits = fast_nbits(R); \
+		if (nbits) \
+			return (type)fast_getu64(R, nbits, max); \
+	} \
+ \
 	const type delta = R->maxval - R->minval; \
 	if (max <= delta) { \
 		if (max == type_max) { \
@@ -82,6 +169,30 @@ DEF_runif_get(unsigned long long int, ULLONG_MAX, runif_getull)
 #define DEF_runif_getf(type, mant_dig, func_name) \
 type func_name(const rng* R, type lim) \
 { \
+	/* Fast path:  Take the mant_dig high bits of a random word and
+	 * scale by 2^-mant_dig; the scale factor is a compile time
+	 * constant, and the result is exactly uniform on the grid
+	 * { k / 2^mant_dig }, as for the generic path below.
+	 */ \
+	if (FLT_RADIX == 2 && mant_dig <= 64) { \
+		const int nbits = fast_nbits(R); \
+		if (nbits) { \
+			/* Clamp; silences shift warnings for types
+			 * not taking this path. */ \
+			const int md = (mant_dig <= 64 ? mant_dig : 64); \
+			const int sh = 64 - md; \
+			const type scale = (type)1 \
+			  / ((type)((uint64_t)1 << (md - 1)) * 2); \
+			uint64_t w; \
+			if (md <= 32 && nbits == 32) { \
+				w = (uint64_t)rng_getnum(R) << 32; \
+			} else { \
+				w = fast_get64(R, nbits); \
+			} \
+			return (type)(w >> sh) * scale * lim; \
+		} \
+	} \
+ \
 	const type m = pow((type)FLT_RADIX, mant_dig); \
 	type ret; \
 	\
@@ -15,6 +15,10 @@
  *
  * The generated random variables are uniform, provided that the
  * underlying random number generator produces uniform numbers.
+ *
+ * RNGs whose output covers exactly 32 or 64 bits (minval == 0 and
+ * maxval == 2^32 - 1 or 2^64 - 1) take a division-free fast path;
+ * other ranges use a slower generic algorithm.
  */
 unsigned long long int csnip_runif_getull(const csnip_rng* R,
 				unsigned long long int max);
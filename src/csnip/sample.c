@@ -0,0 +1,302 @@
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/err.h>
+#include <csnip/mem.h>
+#include <csnip/rng.h>
+#include <csnip/runif.h>
+#include <csnip/sample.h>
+#include <csnip/util.h>
+
+static uint64_t get64(const rng* R)
+{
+	return runif_getull(R, UINT64_MAX);
+}
+
+/* Uniform double in the open interval (0, 1). */
+static double get_open01(const rng* R)
+{
+	return ((double)(get64(R) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+/* Batched bounded integers
+ *
+ * Multiplying a random 64 bit word w by b1 yields a number in [0, b1)
+ * in the high word; the low word is again (nearly) uniform and can be
+ * multiplied by b2, and so on.  The result is exactly uniform once the
+ * final low word is subjected to Lemire's rejection test with the
+ * product of the bounds.
+ */
+void csnip_sample_bounded_batch(const rng* R,
+				int k,
+				const uint64_t* bound,
+				uint64_t* out)
+{
+	uint64_t prod = 1;
+	for (int i = 0; i < k; ++i)
+		prod *= bound[i];
+
+	while (1) {
+		uint64_t lo = get64(R);
+		for (int i = 0; i < k; ++i)
+			out[i] = mul64x64(lo, bound[i], &lo);
+		if (lo >= prod)
+			return;
+		const uint64_t t = -prod % prod;
+		if (lo >= t)
+			return;
+	}
+}
+
+int csnip_sample_shuffle_indices(const rng* R, size_t n, size_t* j)
+{
+	/* Choose the batch size such that the product of the bounds
+	 * stays below 2^48, keeping the rejection probability below
+	 * 2^-16.
+	 */
+	int k;
+	if (n <= (1u << 12))
+		k = 4;
+	else if (n <= (1u << 16))
+		k = 3;
+	else if ((uint64_t)n <= (1u << 24))
+		k = 2;
+	else
+		k = 1;
+	if ((size_t)k > n - 1)
+		k = (int)(n - 1);
+
+	if (k == 1) {
+		j[0] = (size_t)runif_getull(R, n - 1);
+		return 1;
+	}
+
+	uint64_t bound[4] = { 0 }, res[4];
+	for (int i = 0; i < k; ++i)
+		bound[i] = n - i;
+	sample_bounded_batch(R, k, bound, res);
+	for (int i = 0; i < k; ++i)
+		j[i] = (size_t)res[i];
+	return k;
+}
+
+/* Reservoir sampling, Algorithm L */
+
+/* Compute the index of the next item to store, given that item i has
+ * just been processed.
+ */
+static void reservoir_advance(sample_reservoir* S,
+				const rng* R,
+				unsigned long long i)
+{
+	const double s = floor(log(get_open01(R)) / log1p(-S->w));
+	if (s < (double)(ULLONG_MAX - i - 1))
+		S->next = i + 1 + (unsigned long long)s;
+	else
+		S->next = ULLONG_MAX;
+}
+
+void csnip_sample_reservoir_init(sample_reservoir* S,
+				const rng* R,
+				size_t k)
+{
+	S->k = k;
+	S->n = 0;
+	if (k == 0) {
+		S->w = 1.0;
+		S->next = ULLONG_MAX;
+		return;
+	}
+	S->w = exp(log(get_open01(R)) / k);
+	reservoir_advance(S, R, k - 1);
+}
+
+size_t csnip_sample_reservoir_offer(sample_reservoir* S, const rng* R)
+{
+	const unsigned long long i = S->n++;
+	if (i < S->k)
+		return (size_t)i;
+	if (i != S->next)
+		return CSNIP_SAMPLE_SKIP;
+
+	const size_t slot = (size_t)runif_getull(R, S->k - 1);
+	S->w *= exp(log(get_open01(R)) / S->k);
+	reservoir_advance(S, R, i);
+	return slot;
+}
+
+unsigned long long csnip_sample_reservoir_skip(sample_reservoir* S)
+{
+	if (S->n < S->k || S->next <= S->n)
+		return 0;
+	const unsigned long long nskip = S->next - S->n;
+	S->n = S->next;
+	return nskip;
+}
+
+/* Alias tables, Vose's construction */
+
+int csnip_sample_alias_init(sample_alias* A, size_t n, const double* weight)
+{
+	A->n = 0;
+	A->thresh = NULL;
+	A->alias = NULL;
+	if (n == 0)
+		return csnip_err_INVAL;
+
+	double sum = 0;
+	for (size_t i = 0; i < n; ++i) {
+		if (!(weight[i] >= 0) || isinf(weight[i]))
+			return csnip_err_INVAL;
+		sum += weight[i];
+	}
+	if (!(sum > 0) || isinf(sum))
+		return csnip_err_INVAL;
+
+	double* p;
+	size_t* work;
+	if (mem_Allocx(n, p) != 0)
+		return csnip_err_NOMEM;
+	if (mem_Allocx(n, work) != 0
+	  || mem_Allocx(n, A->thresh) != 0
+	  || mem_Allocx(n, A->alias) != 0)
+	{
+		mem_Free(p);
+		mem_Free(work);
+		mem_Free(A->thresh);
+		mem_Free(A->alias);
+		A->thresh = NULL;
+		A->alias = NULL;
+		return csnip_err_NOMEM;
+	}
+
+	/* Scaled probabilities; mean 1.  The work array holds the
+	 * "small" stack growing upward from 0 and the "large" stack
+	 * growing downward from n.
+	 */
+	size_t nsmall = 0, ilarge = n;
+	for (size_t i = 0; i < n; ++i) {
+		p[i] = weight[i] * n / sum;
+		if (p[i] < 1.0)
+			work[nsmall++] = i;
+		else
+			work[--ilarge] = i;
+	}
+
+	while (nsmall > 0 && ilarge < n) {
+		const size_t l = work[--nsmall];
+		const size_t g = work[ilarge++];
+		A->thresh[l] = (uint64_t)(p[l] * 18446744073709551616.0);
+		A->alias[l] = g;
+		p[g] = (p[g] + p[l]) - 1.0;
+		if (p[g] < 1.0)
+			work[nsmall++] = g;
+		else
+			work[--ilarge] = g;
+	}
+
+	/* The remaining entries have probability 1, up to rounding. */
+	while (ilarge < n) {
+		const size_t g = work[ilarge++];
+		A->thresh[g] = UINT64_MAX;
+		A->alias[g] = g;
+	}
+	while (nsmall > 0) {
+		const size_t l = work[--nsmall];
+		A->thresh[l] = UINT64_MAX;
+		A->alias[l] = l;
+	}
+
+	mem_Free(p);
+	mem_Free(work);
+	A->n = n;
+	return 0;
+}
+
+void csnip_sample_alias_free(sample_alias* A)
+{
+	mem_Free(A->thresh);
+	mem_Free(A->alias);
+	A->n = 0;
+	A->thresh = NULL;
+	A->alias = NULL;
+}
+
+size_t csnip_sample_alias_draw(const sample_alias* A, const rng* R)
+{
+	const size_t i = (size_t)runif_getull(R, A->n - 1);
+	if (get64(R) < A->thresh[i])
+		return i;
+	return A->alias[i];
+}
+
+/* Sampling without replacement */
+
+/* Open addressing hash set of indices for Floyd's algorithm;
+ * (size_t)-1 marks empty slots.
+ */
+static int set_insert(size_t* set, int shift, size_t x)
+{
+	const size_t mask = ((size_t)1 << (64 - shift)) - 1;
+	size_t h = (size_t)(((uint64_t)x * 0x9E3779B97F4A7C15ull) >> shift);
+	while (set[h] != (size_t)-1) {
+		if (set[h] == x)
+			return 0;
+		h = (h + 1) & mask;
+	}
+	set[h] = x;
+	return 1;
+}
+
+int csnip_sample_noreplace(const rng* R, size_t n, size_t k, size_t* out)
+{
+	if (k > n)
+		return csnip_err_INVAL;
+	if (k == 0)
+		return 0;
+
+	if (k >= n / 4) {
+		/* Dense: partial Fisher-Yates shuffle */
+		size_t* idx;
+		if (mem_Allocx(n, idx) != 0)
+			return csnip_err_NOMEM;
+		for (size_t i = 0; i < n; ++i)
+			idx[i] = i;
+		for (size_t i = 0; i < k; ++i) {
+			const size_t j = i + (size_t)runif_getull(R, n - 1 - i);
+			const size_t t = idx[i];
+			idx[i] = idx[j];
+			idx[j] = t;
+			out[i] = idx[i];
+		}
+		mem_Free(idx);
+		return 0;
+	}
+
+	/* Sparse: Floyd's algorithm.  The hash set has at least 2k
+	 * slots.
+	 */
+	int lg = 1;
+	while (((size_t)1 << lg) < 2 * k)
+		++lg;
+	size_t* set;
+	if (mem_Allocx((size_t)1 << lg, set) != 0)
+		return csnip_err_NOMEM;
+	for (size_t i = 0; i < ((size_t)1 << lg); ++i)
+		set[i] = (size_t)-1;
+
+	size_t m = 0;
+	for (size_t j = n - k; j < n; ++j) {
+		const size_t t = (size_t)runif_getull(R, j);
+		if (set_insert(set, 64 - lg, t)) {
+			out[m++] = t;
+		} else {
+			set_insert(set, 64 - lg, j);
+			out[m++] = j;
+		}
+	}
+	mem_Free(set);
+	return 0;
+}
@@ -0,0 +1,235 @@
+#ifndef CSNIP_SAMPLE_H
+#define CSNIP_SAMPLE_H
+
+/**	@file sample.h
+ *	@brief			Random sampling
+ *	@defgroup sample	Random sampling
+ *	@{
+ *
+ *	Shuffling, reservoir sampling, weighted choice and sampling
+ *	without replacement.
+ *
+ *	All functions take their randomness from a csnip_rng.  Bounded
+ *	integers are generated with Lemire's multiply-and-shift method;
+ *	where the bounds permit, several bounded integers are extracted
+ *	from a single 64 bit random word (batched generation, after
+ *	Brackett-Rozinsky & Lemire).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <csnip/rng.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**	Generate a batch of bounded random integers.
+ *
+ *	Fills out[i] with a uniformly distributed integer in
+ *	[0, bound[i]) for i = 0, ..., k - 1, consuming a single 64 bit
+ *	random word in most cases.
+ *
+ *	The product of all bounds must be representable in a uint64_t;
+ *	all bounds must be positive.
+ */
+void csnip_sample_bounded_batch(const csnip_rng* R,
+				int k,
+				const uint64_t* bound,
+				uint64_t* out);
+
+/**	Indices for the next Fisher-Yates steps.
+ *
+ *	Generates j[0] in [0, n), j[1] in [0, n - 1), ..., and returns
+ *	the number of indices generated (between 1 and 4, but never more
+ *	than n - 1).  This is the building block of csnip_Shuffle().
+ *
+ *	@param	n
+ *		number of elements not yet placed; must be >= 2.
+ */
+int csnip_sample_shuffle_indices(const csnip_rng* R, size_t n, size_t* j);
+
+/**	Shuffle an array.
+ *
+ *	Permutes the first N entries of an array uniformly at random,
+ *	using the Fisher-Yates algorithm.  Like the sorting macros in
+ *	sort.h, the array is accessed through a swap statement only.
+ *
+ *	@param	R
+ *		pointer to the csnip_rng to use.
+ *
+ *	@param	u, v
+ *		dummy variables, representing array indices.
+ *
+ *	@param	swap_au_av
+ *		Statement to swap a[u] and a[v].  u and v are always
+ *		different.
+ *
+ *	@param	N
+ *		array size.
+ */
+#define csnip_Shuffle(R, u, v, swap_au_av, N) \
+	do { \
+		size_t csnip__sh_n = (N); \
+		size_t csnip__sh_j[4]; \
+		while (csnip__sh_n > 1) { \
+			const int csnip__sh_k = \
+			  csnip_sample_shuffle_indices((R), \
+			    csnip__sh_n, csnip__sh_j); \
+			for (int csnip__sh_m = 0; \
+			  csnip__sh_m < csnip__sh_k; ++csnip__sh_m) \
+			{ \
+				size_t u = csnip__sh_n - 1; \
+				size_t v = csnip__sh_j[csnip__sh_m]; \
+				if (u != v) { \
+					swap_au_av; \
+				} \
+				--csnip__sh_n; \
+			} \
+		} \
+	} while (0)
+
+/** @name Reservoir sampling
+ *
+ *  Uniform sampling of k items from a stream of unknown length, using
+ *  Vitter/Li's Algorithm L.  Instead of drawing a random number for
+ *  each item, the algorithm computes how many items to skip until the
+ *  next replacement, so that only O(k (1 + log(n / k))) random numbers
+ *  are needed for a stream of n items.
+ *
+ *  Typical use:
+ *
+ *  ~~~{.c}
+ *  csnip_sample_reservoir S;
+ *  csnip_sample_reservoir_init(&S, R, k);
+ *  for (each item x) {
+ *      size_t slot = csnip_sample_reservoir_offer(&S, R);
+ *      if (slot != CSNIP_SAMPLE_SKIP)
+ *          res[slot] = x;
+ *  }
+ *  ~~~
+ *
+ *  Streams that can skip ahead cheaply (e.g. seekable records) can
+ *  use csnip_sample_reservoir_skip() to jump directly to the next
+ *  item to be stored.
+ */
+/**@{*/
+
+/** Return value of csnip_sample_reservoir_offer() for skipped items. */
+#define CSNIP_SAMPLE_SKIP	((size_t)-1)
+
+/** Reservoir sampler state. */
+typedef struct {
+	size_t k;			/**< Reservoir size */
+	unsigned long long n;		/**< Number of items seen */
+	unsigned long long next;	/**< Index of next stored item */
+	double w;			/**< Algorithm L's W variable */
+} csnip_sample_reservoir;
+
+/** Initialize a reservoir sampler for k items. */
+void csnip_sample_reservoir_init(csnip_sample_reservoir* S,
+				const csnip_rng* R,
+				size_t k);
+
+/** Offer the next stream item.
+ *
+ *  Returns the reservoir slot the item is to be stored in, or
+ *  CSNIP_SAMPLE_SKIP if it is not part of the sample.
+ */
+size_t csnip_sample_reservoir_offer(csnip_sample_reservoir* S,
+				const csnip_rng* R);
+
+/** Number of items that can be skipped.
+ *
+ *  Returns the number of upcoming stream items that will not be
+ *  stored, and marks them as seen.  The item after them is to be
+ *  offered with csnip_sample_reservoir_offer().
+ */
+unsigned long long csnip_sample_reservoir_skip(csnip_sample_reservoir* S);
+
+/**@}*/
+
+/** @name Alias tables
+ *
+ *  Weighted random choice among n alternatives in O(1) per draw,
+ *  using Walker's alias method with Vose's O(n) table construction.
+ */
+/**@{*/
+
+/** Alias table. */
+typedef struct {
+	size_t n;		/**< Number of alternatives */
+	uint64_t* thresh;	/**< Acceptance thresholds, scaled to 2^64 */
+	size_t* alias;		/**< Alias indices */
+} csnip_sample_alias;
+
+/** Build an alias table.
+ *
+ *  @param	A
+ *		the table to initialize.
+ *
+ *  @param	n
+ *		number of alternatives; must be positive.
+ *
+ *  @param	weight
+ *		the non-negative weights; they need not be normalized,
+ *		but their sum must be positive.
+ *
+ *  @return	0 on success, or csnip_err_INVAL for invalid weights,
+ *		csnip_err_NOMEM if out of memory.
+ */
+int csnip_sample_alias_init(csnip_sample_alias* A,
+				size_t n,
+				const double* weight);
+
+/** Free the memory held by an alias table. */
+void csnip_sample_alias_free(csnip_sample_alias* A);
+
+/** Draw an index in [0, n) with probability proportional to its
+ *  weight.
+ */
+size_t csnip_sample_alias_draw(const csnip_sample_alias* A,
+				const csnip_rng* R);
+
+/**@}*/
+
+/** Sample without replacement.
+ *
+ *  Chooses k distinct indices from [0, n) uniformly at random, and
+ *  writes them to out[0], ..., out[k - 1] in no particular order.
+ *  Sparse samples use Floyd's algorithm with a small hash set (O(k)
+ *  time and memory); dense samples use a partial Fisher-Yates shuffle
+ *  of an index array.
+ *
+ *  @return	0 on success, csnip_err_INVAL if k > n, or
+ *		csnip_err_NOMEM if out of memory.
+ */
+int csnip_sample_noreplace(const csnip_rng* R,
+				size_t n,
+				size_t k,
+				size_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* CSNIP_SAMPLE_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_SAMPLE_HAVE_SHORT_NAMES)
+#define Shuffle				csnip_Shuffle
+#define sample_bounded_batch		csnip_sample_bounded_batch
+#define sample_shuffle_indices		csnip_sample_shuffle_indices
+#define sample_reservoir		csnip_sample_reservoir
+#define sample_reservoir_init		csnip_sample_reservoir_init
+#define sample_reservoir_offer		csnip_sample_reservoir_offer
+#define sample_reservoir_skip		csnip_sample_reservoir_skip
+#define sample_alias			csnip_sample_alias
+#define sample_alias_init		csnip_sample_alias_init
+#define sample_alias_free		csnip_sample_alias_free
+#define sample_alias_draw		csnip_sample_alias_draw
+#define sample_noreplace		csnip_sample_noreplace
+#define CSNIP_SAMPLE_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_SAMPLE_HAVE_SHORT_NAMES */
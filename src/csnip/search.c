@@ -0,0 +1,130 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/cpu.h>
+#include <csnip/search.h>
+#include <csnip/simd.h>
+
+/* Number of searches interleaved */
+#define GROUP		8
+
+/* Lower bound search, instantiated for each simd.h backend.
+ *
+ * The lower bound of each key is known to be in [base, base + len];
+ * the range is halved by comparing base[half - 1] with the key, until
+ * len is at most the number of vector lanes.  Then the elements less
+ * than the key among the L elements from base are counted.  Where the
+ * vector would extend beyond the array, it is taken from the end
+ * instead; that is still correct, as the lower bound is then in the
+ * vector as well.
+ *
+ * len depends only on n, so a group of searches can be run in lock
+ * step, and the loads of one step are independent.
+ */
+#define V(be, name)	csnip_simd_ ## be ## _ ## name
+
+#define DEFINE_LOWER_BOUND(be, W, target) \
+	target static void lower_bound_ ## be(const int32_t* a, \
+						size_t n, \
+						const int32_t* keys, \
+						size_t nkeys, \
+						size_t* out) \
+	{ \
+		enum { L = W / 4 }; \
+		if (n < L) { \
+			for (size_t k = 0; k < nkeys; ++k) { \
+				size_t i = 0; \
+				while (i < n && a[i] < keys[k]) \
+					++i; \
+				out[k] = i; \
+			} \
+			return; \
+		} \
+	\
+		for (size_t k = 0; k < nkeys; k += GROUP) { \
+			const size_t ng = (nkeys - k < GROUP ? \
+						nkeys - k : GROUP); \
+			const int32_t* key = keys + k; \
+			size_t base[GROUP] = { 0 }; \
+			size_t len = n; \
+			while (len > L) { \
+				const size_t half = len / 2; \
+				for (size_t g = 0; g < ng; ++g) { \
+					base[g] += (a[base[g] + half - 1] \
+						< key[g] ? half : 0); \
+				} \
+				len -= half; \
+			} \
+			for (size_t g = 0; g < ng; ++g) { \
+				const size_t s = (base[g] + L <= n ? \
+						base[g] : n - L); \
+				const V(be, i32) v = \
+					V(be, i32_load)(a + s); \
+				const V(be, i32) kv = \
+					V(be, i32_splat)(key[g]); \
+				const uint64_t m = V(be, i32_movemask)( \
+						V(be, i32_gt)(kv, v)); \
+				out[k + g] = s \
+					+ (size_t)simd_mask_popcount(m); \
+			} \
+		} \
+	}
+
+DEFINE_LOWER_BOUND(scalar, 16, )
+#if defined(CSNIP_SIMD_HAVE_SSE2)
+DEFINE_LOWER_BOUND(sse2, 16, CSNIP_SIMD_TARGET_SSE2)
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX2)
+DEFINE_LOWER_BOUND(avx2, 32, CSNIP_SIMD_TARGET_AVX2)
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX512)
+DEFINE_LOWER_BOUND(avx512, 64, CSNIP_SIMD_TARGET_AVX512)
+#endif
+#if defined(CSNIP_SIMD_HAVE_NEON)
+DEFINE_LOWER_BOUND(neon, 16, )
+#endif
+
+typedef void lower_bound_fn(const int32_t* a,
+			size_t n,
+			const int32_t* keys,
+			size_t nkeys,
+			size_t* out);
+
+static lower_bound_fn* resolve_lower_bound(void)
+{
+	const int level = csnip_cpu__level();
+	(void)level;
+#if defined(CSNIP_SIMD_HAVE_AVX512)
+	if (level >= CSNIP_CPU_LEVEL_AVX512)
+		return lower_bound_avx512;
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX2)
+	if (level >= CSNIP_CPU_LEVEL_AVX2)
+		return lower_bound_avx2;
+#endif
+#if defined(CSNIP_SIMD_HAVE_SSE2)
+	if (level >= CSNIP_CPU_LEVEL_SSE2)
+		return lower_bound_sse2;
+#endif
+#if defined(CSNIP_SIMD_HAVE_NEON)
+	if (level >= CSNIP_CPU_LEVEL_NEON)
+		return lower_bound_neon;
+#endif
+	return lower_bound_scalar;
+}
+
+csnip_cpu_DispatchVoid(csnip_search_lower_bound_i32_batch,
+	(const int32_t* a, size_t n, const int32_t* keys, size_t nkeys,
+	 size_t* out),
+	(a, n, keys, nkeys, out),
+	resolve_lower_bound)
+
+size_t csnip_search_lower_bound_i32(const int32_t* a,
+			size_t n,
+			int32_t key)
+{
+	size_t r;
+	csnip_search_lower_bound_i32_batch(a, n, &key, 1, &r);
+	return r;
+}
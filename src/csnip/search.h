@@ -23,8 +23,15 @@
  *
  *  3.	Has the potential to be faster than bsearch() because it's not
  *      necessary to dereference a function pointer for each comparison.
+ *
+ *  For arrays of int32_t, csnip_search_lower_bound_i32() and
+ *  csnip_search_lower_bound_i32_batch() are faster still, using
+ *  branch free halving and vector comparisons.
  */
 
+#include <stddef.h>
+#include <stdint.h>
+
 /** Binary search.
  *
  *  Statement macro. Find the smallest index i in an ascending sorted
@@ -99,11 +106,50 @@
 	} while(0)
 /** @endcond */
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Lower bound in a sorted int32_t array.
+ *
+ *  Finds the smallest index i such that a[i] >= key in the ascending
+ *  sorted array a of size n, or returns n if there is none; i.e., the
+ *  same result as csnip_Bsearch() with the comparison a[u] < key.
+ *
+ *  The range is halved without branches until it fits into a vector,
+ *  whose elements are then compared with the key at once.
+ */
+size_t csnip_search_lower_bound_i32(const int32_t* a,
+			size_t n,
+			int32_t key);
+
+/** Lower bounds of many keys in a sorted int32_t array.
+ *
+ *  Stores the lower bound of keys[k] in a, as found by
+ *  csnip_search_lower_bound_i32(), in out[k] for k < nkeys.
+ *
+ *  The searches for groups of keys are interleaved, so that their
+ *  cache misses overlap; for large arrays, this is considerably
+ *  faster than searching one key at a time.  The widest vector
+ *  instruction set the CPU supports is used (see cpu.h).
+ */
+void csnip_search_lower_bound_i32_batch(const int32_t* a,
+			size_t n,
+			const int32_t* keys,
+			size_t nkeys,
+			size_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
 /** @} */
 
 #endif /* CSNIP_SEARCH_H */
 
 #if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_SEARCH_HAVE_SHORT_NAMES)
 #define Bsearch		csnip_Bsearch
+#define search_lower_bound_i32	csnip_search_lower_bound_i32
+#define search_lower_bound_i32_batch	csnip_search_lower_bound_i32_batch
 #define CSNIP_SEARCH_HAVE_SHORT_NAMES
 #endif /* CSNIP_SHORT_NAMES && ! CSNIP_SEARCH_HAVE_SHORT_NAMES */
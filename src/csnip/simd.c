@@ -0,0 +1,194 @@
+#define CSNIP_SHORT_NAMES
+#include <csnip/simd.h>
+
+extern inline int csnip_simd_mask_popcount(uint64_t m);
+extern inline int csnip_simd_mask_ctz(uint64_t m);
+extern inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_load(const void* p);
+extern inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_load16(const void* p);
+extern inline void csnip_simd_scalar_u8_store(void* p, csnip_simd_scalar_u8 a);
+extern inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_splat(uint8_t c);
+extern inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_eq(
+				csnip_simd_scalar_u8 a,
+				csnip_simd_scalar_u8 b);
+extern inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_gt(
+				csnip_simd_scalar_u8 a,
+				csnip_simd_scalar_u8 b);
+extern inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_min(
+				csnip_simd_scalar_u8 a,
+				csnip_simd_scalar_u8 b);
+extern inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_max(
+				csnip_simd_scalar_u8 a,
+				csnip_simd_scalar_u8 b);
+extern inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_and(
+				csnip_simd_scalar_u8 a,
+				csnip_simd_scalar_u8 b);
+extern inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_or(
+				csnip_simd_scalar_u8 a,
+				csnip_simd_scalar_u8 b);
+extern inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_shr(
+				csnip_simd_scalar_u8 a,
+				int n);
+extern inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_shuffle(
+				csnip_simd_scalar_u8 t,
+				csnip_simd_scalar_u8 idx);
+extern inline uint64_t csnip_simd_scalar_u8_movemask(csnip_simd_scalar_u8 a);
+extern inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_load(const void* p);
+extern inline void csnip_simd_scalar_i32_store(void* p,
+				csnip_simd_scalar_i32 a);
+extern inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_splat(int32_t c);
+extern inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_eq(
+				csnip_simd_scalar_i32 a,
+				csnip_simd_scalar_i32 b);
+extern inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_gt(
+				csnip_simd_scalar_i32 a,
+				csnip_simd_scalar_i32 b);
+extern inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_min(
+				csnip_simd_scalar_i32 a,
+				csnip_simd_scalar_i32 b);
+extern inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_max(
+				csnip_simd_scalar_i32 a,
+				csnip_simd_scalar_i32 b);
+extern inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_add(
+				csnip_simd_scalar_i32 a,
+				csnip_simd_scalar_i32 b);
+extern inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_mullo(
+				csnip_simd_scalar_i32 a,
+				csnip_simd_scalar_i32 b);
+extern inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_and(
+				csnip_simd_scalar_i32 a,
+				csnip_simd_scalar_i32 b);
+extern inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_xor(
+				csnip_simd_scalar_i32 a,
+				csnip_simd_scalar_i32 b);
+extern inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_shr(
+				csnip_simd_scalar_i32 a,
+				int n);
+extern inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_gather(
+				const void* base,
+				csnip_simd_scalar_i32 off);
+extern inline uint64_t csnip_simd_scalar_i32_movemask(csnip_simd_scalar_i32 a);
+
+#if defined(CSNIP_SIMD_HAVE_SSE2)
+extern inline __m128i csnip_simd_sse2_u8_load(const void* p);
+extern inline __m128i csnip_simd_sse2_u8_load16(const void* p);
+extern inline void csnip_simd_sse2_u8_store(void* p, __m128i a);
+extern inline __m128i csnip_simd_sse2_u8_splat(uint8_t c);
+extern inline __m128i csnip_simd_sse2_u8_eq(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_u8_gt(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_u8_min(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_u8_max(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_u8_and(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_u8_or(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_u8_shr(__m128i a, int n);
+extern inline __m128i csnip_simd_sse2_u8_shuffle(__m128i t, __m128i idx);
+extern inline uint64_t csnip_simd_sse2_u8_movemask(__m128i a);
+extern inline __m128i csnip_simd_sse2_i32_load(const void* p);
+extern inline void csnip_simd_sse2_i32_store(void* p, __m128i a);
+extern inline __m128i csnip_simd_sse2_i32_splat(int32_t c);
+extern inline __m128i csnip_simd_sse2_i32_eq(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_i32_gt(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_i32_min(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_i32_max(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_i32_add(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_i32_mullo(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_i32_and(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_i32_xor(__m128i a, __m128i b);
+extern inline __m128i csnip_simd_sse2_i32_shr(__m128i a, int n);
+extern inline __m128i csnip_simd_sse2_i32_gather(const void* base,
+				__m128i off);
+extern inline uint64_t csnip_simd_sse2_i32_movemask(__m128i a);
+#endif
+
+#if defined(CSNIP_SIMD_HAVE_AVX2)
+extern inline __m256i csnip_simd_avx2_u8_load(const void* p);
+extern inline __m256i csnip_simd_avx2_u8_load16(const void* p);
+extern inline void csnip_simd_avx2_u8_store(void* p, __m256i a);
+extern inline __m256i csnip_simd_avx2_u8_splat(uint8_t c);
+extern inline __m256i csnip_simd_avx2_u8_eq(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_u8_gt(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_u8_min(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_u8_max(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_u8_and(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_u8_or(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_u8_shr(__m256i a, int n);
+extern inline __m256i csnip_simd_avx2_u8_shuffle(__m256i t, __m256i idx);
+extern inline uint64_t csnip_simd_avx2_u8_movemask(__m256i a);
+extern inline __m256i csnip_simd_avx2_i32_load(const void* p);
+extern inline void csnip_simd_avx2_i32_store(void* p, __m256i a);
+extern inline __m256i csnip_simd_avx2_i32_splat(int32_t c);
+extern inline __m256i csnip_simd_avx2_i32_eq(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_i32_gt(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_i32_min(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_i32_max(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_i32_add(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_i32_mullo(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_i32_and(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_i32_xor(__m256i a, __m256i b);
+extern inline __m256i csnip_simd_avx2_i32_shr(__m256i a, int n);
+extern inline __m256i csnip_simd_avx2_i32_gather(const void* base,
+				__m256i off);
+extern inline uint64_t csnip_simd_avx2_i32_movemask(__m256i a);
+#endif
+
+#if defined(CSNIP_SIMD_HAVE_AVX512)
+extern inline __m512i csnip_simd_avx512_u8_load(const void* p);
+extern inline __m512i csnip_simd_avx512_u8_load16(const void* p);
+extern inline void csnip_simd_avx512_u8_store(void* p, __m512i a);
+extern inline __m512i csnip_simd_avx512_u8_splat(uint8_t c);
+extern inline __m512i csnip_simd_avx512_u8_eq(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_u8_gt(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_u8_min(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_u8_max(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_u8_and(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_u8_or(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_u8_shr(__m512i a, int n);
+extern inline __m512i csnip_simd_avx512_u8_shuffle(__m512i t, __m512i idx);
+extern inline uint64_t csnip_simd_avx512_u8_movemask(__m512i a);
+extern inline __m512i csnip_simd_avx512_i32_load(const void* p);
+extern inline void csnip_simd_avx512_i32_store(void* p, __m512i a);
+extern inline __m512i csnip_simd_avx512_i32_splat(int32_t c);
+extern inline __m512i csnip_simd_avx512_i32_eq(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_i32_gt(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_i32_min(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_i32_max(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_i32_add(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_i32_mullo(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_i32_and(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_i32_xor(__m512i a, __m512i b);
+extern inline __m512i csnip_simd_avx512_i32_shr(__m512i a, int n);
+extern inline __m512i csnip_simd_avx512_i32_gather(const void* base,
+				__m512i off);
+extern inline uint64_t csnip_simd_avx512_i32_movemask(__m512i a);
+#endif
+
+#if defined(CSNIP_SIMD_HAVE_NEON)
+extern inline uint8x16_t csnip_simd_neon_u8_load(const void* p);
+extern inline uint8x16_t csnip_simd_neon_u8_load16(const void* p);
+extern inline void csnip_simd_neon_u8_store(void* p, uint8x16_t a);
+extern inline uint8x16_t csnip_simd_neon_u8_splat(uint8_t c);
+extern inline uint8x16_t csnip_simd_neon_u8_eq(uint8x16_t a, uint8x16_t b);
+extern inline uint8x16_t csnip_simd_neon_u8_gt(uint8x16_t a, uint8x16_t b);
+extern inline uint8x16_t csnip_simd_neon_u8_min(uint8x16_t a, uint8x16_t b);
+extern inline uint8x16_t csnip_simd_neon_u8_max(uint8x16_t a, uint8x16_t b);
+extern inline uint8x16_t csnip_simd_neon_u8_and(uint8x16_t a, uint8x16_t b);
+extern inline uint8x16_t csnip_simd_neon_u8_or(uint8x16_t a, uint8x16_t b);
+extern inline uint8x16_t csnip_simd_neon_u8_shr(uint8x16_t a, int n);
+extern inline uint8x16_t csnip_simd_neon_u8_shuffle(uint8x16_t t,
+				uint8x16_t idx);
+extern inline uint64_t csnip_simd_neon_u8_movemask(uint8x16_t a);
+extern inline int32x4_t csnip_simd_neon_i32_load(const void* p);
+extern inline void csnip_simd_neon_i32_store(void* p, int32x4_t a);
+extern inline int32x4_t csnip_simd_neon_i32_splat(int32_t c);
+extern inline int32x4_t csnip_simd_neon_i32_eq(int32x4_t a, int32x4_t b);
+extern inline int32x4_t csnip_simd_neon_i32_gt(int32x4_t a, int32x4_t b);
+extern inline int32x4_t csnip_simd_neon_i32_min(int32x4_t a, int32x4_t b);
+extern inline int32x4_t csnip_simd_neon_i32_max(int32x4_t a, int32x4_t b);
+extern inline int32x4_t csnip_simd_neon_i32_add(int32x4_t a, int32x4_t b);
+extern inline int32x4_t csnip_simd_neon_i32_mullo(int32x4_t a, int32x4_t b);
+extern inline int32x4_t csnip_simd_neon_i32_and(int32x4_t a, int32x4_t b);
+extern inline int32x4_t csnip_simd_neon_i32_xor(int32x4_t a, int32x4_t b);
+extern inline int32x4_t csnip_simd_neon_i32_shr(int32x4_t a, int n);
+extern inline int32x4_t csnip_simd_neon_i32_gather(const void* base,
+				int32x4_t off);
+extern inline uint64_t csnip_simd_neon_i32_movemask(int32x4_t a);
+#endif
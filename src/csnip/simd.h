@@ -0,0 +1,1247 @@
+#ifndef CSNIP_SIMD_H
+#define CSNIP_SIMD_H
+
+/**	@file simd.h
+ *	@brief			Portable SIMD vectors
+ *	@defgroup simd		Portable SIMD vectors
+ *	@{
+ *
+ *	A thin layer over vector instruction sets, providing the
+ *	operations needed by scanning, searching and hashing kernels.
+ *	Its users in csnip are the delimiter scan of tokenize.h, the
+ *	lower bound search of search.h and the batched FNV hash of
+ *	hash.h.  The linear probing tables (lphash.h, lphash_table.h)
+ *	and the sorting macros do not use it:  they operate on entries
+ *	of arbitrary type through caller supplied expressions (is_empty,
+ *	is_match, the comparison), so there is no fixed memory layout
+ *	for a vector kernel to work on.
+ *
+ *	Each instruction set is a backend with its own prefix and vector
+ *	width:
+ *
+ *	Backend		| Prefix		| Width
+ *	----------------|-----------------------|------
+ *	scalar		| csnip_simd_scalar_	| 16
+ *	SSE2		| csnip_simd_sse2_	| 16
+ *	AVX2		| csnip_simd_avx2_	| 32
+ *	AVX-512 (BW, DQ)| csnip_simd_avx512_	| 64
+ *	NEON (AArch64)	| csnip_simd_neon_	| 16
+ *
+ *	The scalar backend emulates the others in plain C and is always
+ *	available.  A backend is available, as indicated by the macro
+ *	CSNIP_SIMD_HAVE_<BACKEND>, if the compiler can generate its
+ *	instructions.  With GCC and clang on x86, all x86 backends are
+ *	available irrespective of the compiler flags, as their functions
+ *	are compiled for the target instruction set with the target
+ *	attribute; the functions may then only be called after checking
+ *	that the CPU supports the instruction set (see cpu.h), and are
+ *	best called from functions with the same target attribute
+ *	(CSNIP_SIMD_TARGET_<BACKEND>), so that they are inlined.
+ *
+ *	The native backend is the widest one the compiler flags enable,
+ *	e.g. SSE2 on x86-64 by default, or AVX2 with -mavx2.  It can be
+ *	used without the backend prefix (csnip_simd_u8_eq(), etc.)
+ *	without any precautions.
+ *
+ *	There are two vector types per backend:  u8 with unsigned 8 bit
+ *	lanes, and i32 with signed 32 bit lanes.  Comparisons return
+ *	vectors with lanes all ones (true) or all zeros (false).
+ *	Movemask operations return a bitmask of type uint64_t with bit
+ *	i set if the most significant bit of lane i is; they are
+ *	typically applied to comparison results and followed by
+ *	csnip_simd_mask_ctz() or csnip_simd_mask_popcount().
+ *
+ *	The operations on u8 vectors (e.g., csnip_simd_sse2_u8_eq())
+ *	are:
+ *
+ *	Operation	| Result
+ *	----------------|-----------------------------------------------
+ *	load(p)		| load from unaligned memory
+ *	load16(p)	| load 16 bytes, repeated to the vector width
+ *	store(p, a)	| store to unaligned memory
+ *	splat(c)	| all lanes c
+ *	eq(a, b)	| a == b
+ *	gt(a, b)	| a > b, unsigned
+ *	min(a, b)	| lanewise minimum, unsigned
+ *	max(a, b)	| lanewise maximum, unsigned
+ *	and(a, b)	| bitwise and
+ *	or(a, b)	| bitwise or
+ *	shr(a, n)	| lanewise logical right shift by n < 8
+ *	shuffle(t, i)	| t[i & 15] within each 16 byte block, or 0 if
+ *			| i & 0x80 (PSHUFB semantics)
+ *	movemask(a)	| most significant bits
+ *
+ *	The shuffle is emulated on the scalar backend and on the SSE2
+ *	backend unless SSSE3 is enabled; CSNIP_SIMD_<BACKEND>_FAST_SHUFFLE
+ *	is 1 if it is a single instruction.
+ *
+ *	The operations on i32 vectors are load, store, splat, eq, gt,
+ *	min, max (all signed), movemask, and the following:
+ *
+ *	Operation	| Result
+ *	----------------|-----------------------------------------------
+ *	add(a, b)	| a + b, wrapping around
+ *	mullo(a, b)	| low 32 bits of a * b
+ *	and(a, b)	| bitwise and
+ *	xor(a, b)	| bitwise exclusive or
+ *	shr(a, n)	| lanewise logical right shift by n < 32
+ *	gather(p, off)	| 4 bytes loaded from (const char*)p + off[i] in
+ *			| lane i
+ *
+ *	The gather is emulated on backends without a gather instruction
+ *	(all except AVX2 and AVX-512).
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+/** @name Backend availability */
+/**@{*/
+#if (defined(__GNUC__) || defined(__clang__)) \
+  && (defined(__x86_64__) || defined(__i386__))
+#  define CSNIP_SIMD_HAVE_SSE2		1
+#  define CSNIP_SIMD_HAVE_AVX2		1
+#  define CSNIP_SIMD_HAVE_AVX512	1
+#  define CSNIP_SIMD_TARGET_SSE2	__attribute__((target("sse2")))
+#  define CSNIP_SIMD_TARGET_AVX2	__attribute__((target("avx2")))
+#  define CSNIP_SIMD_TARGET_AVX512 \
+	__attribute__((target("avx512f,avx512bw,avx512dq")))
+#else
+#  if defined(__SSE2__) || defined(_M_X64) \
+     || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define CSNIP_SIMD_HAVE_SSE2	1
+#  endif
+#  if defined(__AVX2__)
+#    define CSNIP_SIMD_HAVE_AVX2	1
+#  endif
+#  if defined(__AVX512BW__) && defined(__AVX512DQ__)
+#    define CSNIP_SIMD_HAVE_AVX512	1
+#  endif
+#  define CSNIP_SIMD_TARGET_SSE2
+#  define CSNIP_SIMD_TARGET_AVX2
+#  define CSNIP_SIMD_TARGET_AVX512
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#  define CSNIP_SIMD_HAVE_NEON		1
+#endif
+/**@}*/
+
+#if defined(CSNIP_SIMD_HAVE_SSE2) || defined(CSNIP_SIMD_HAVE_AVX2) \
+  || defined(CSNIP_SIMD_HAVE_AVX512)
+#include <immintrin.h>
+#endif
+#if defined(CSNIP_SIMD_HAVE_NEON)
+#include <arm_neon.h>
+#endif
+
+/** @name Native backend */
+/**@{*/
+#if defined(CSNIP_SIMD_HAVE_AVX512) \
+  && defined(__AVX512BW__) && defined(__AVX512DQ__)
+#  define CSNIP_SIMD_NATIVE		avx512
+#  define CSNIP_SIMD_WIDTH		64
+#elif defined(CSNIP_SIMD_HAVE_AVX2) && defined(__AVX2__)
+#  define CSNIP_SIMD_NATIVE		avx2
+#  define CSNIP_SIMD_WIDTH		32
+#elif defined(CSNIP_SIMD_HAVE_SSE2) \
+  && (defined(__SSE2__) || !defined(__GNUC__))
+#  define CSNIP_SIMD_NATIVE		sse2
+#  define CSNIP_SIMD_WIDTH		16
+#elif defined(CSNIP_SIMD_HAVE_NEON)
+#  define CSNIP_SIMD_NATIVE		neon
+#  define CSNIP_SIMD_WIDTH		16
+#else
+#  define CSNIP_SIMD_NATIVE		scalar
+#  define CSNIP_SIMD_WIDTH		16
+#  define CSNIP_SIMD_NATIVE_IS_SCALAR	1
+#endif
+/**@}*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @name Bitmasks */
+/**@{*/
+
+/**	Number of set bits in a mask. */
+inline int csnip_simd_mask_popcount(uint64_t m)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(m);
+#else
+	m = m - ((m >> 1) & 0x5555555555555555U);
+	m = (m & 0x3333333333333333U) + ((m >> 2) & 0x3333333333333333U);
+	m = (m + (m >> 4)) & 0x0f0f0f0f0f0f0f0fU;
+	return (int)((m * 0x0101010101010101U) >> 56);
+#endif
+}
+
+/**	Index of the lowest set bit in a nonzero mask. */
+inline int csnip_simd_mask_ctz(uint64_t m)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(m);
+#else
+	int n = 0;
+	while (!(m & 1)) {
+		m >>= 1;
+		++n;
+	}
+	return n;
+#endif
+}
+/**@}*/
+
+/* Scalar backend */
+
+#define CSNIP_SIMD_SCALAR_WIDTH		16
+#define CSNIP_SIMD_SCALAR_FAST_SHUFFLE	0
+
+typedef struct { uint8_t v[16]; } csnip_simd_scalar_u8;
+typedef struct { int32_t v[4]; } csnip_simd_scalar_i32;
+
+inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_load(const void* p)
+{
+	csnip_simd_scalar_u8 r;
+	memcpy(r.v, p, sizeof r.v);
+	return r;
+}
+
+inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_load16(const void* p)
+{
+	return csnip_simd_scalar_u8_load(p);
+}
+
+inline void csnip_simd_scalar_u8_store(void* p, csnip_simd_scalar_u8 a)
+{
+	memcpy(p, a.v, sizeof a.v);
+}
+
+inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_splat(uint8_t c)
+{
+	csnip_simd_scalar_u8 r;
+	memset(r.v, c, sizeof r.v);
+	return r;
+}
+
+inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_eq(csnip_simd_scalar_u8 a,
+						csnip_simd_scalar_u8 b)
+{
+	csnip_simd_scalar_u8 r;
+	for (int i = 0; i < 16; ++i)
+		r.v[i] = (a.v[i] == b.v[i] ? 0xff : 0);
+	return r;
+}
+
+inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_gt(csnip_simd_scalar_u8 a,
+						csnip_simd_scalar_u8 b)
+{
+	csnip_simd_scalar_u8 r;
+	for (int i = 0; i < 16; ++i)
+		r.v[i] = (a.v[i] > b.v[i] ? 0xff : 0);
+	return r;
+}
+
+inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_min(csnip_simd_scalar_u8 a,
+						csnip_simd_scalar_u8 b)
+{
+	csnip_simd_scalar_u8 r;
+	for (int i = 0; i < 16; ++i)
+		r.v[i] = (a.v[i] < b.v[i] ? a.v[i] : b.v[i]);
+	return r;
+}
+
+inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_max(csnip_simd_scalar_u8 a,
+						csnip_simd_scalar_u8 b)
+{
+	csnip_simd_scalar_u8 r;
+	for (int i = 0; i < 16; ++i)
+		r.v[i] = (a.v[i] > b.v[i] ? a.v[i] : b.v[i]);
+	return r;
+}
+
+inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_and(csnip_simd_scalar_u8 a,
+						csnip_simd_scalar_u8 b)
+{
+	csnip_simd_scalar_u8 r;
+	for (int i = 0; i < 16; ++i)
+		r.v[i] = a.v[i] & b.v[i];
+	return r;
+}
+
+inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_or(csnip_simd_scalar_u8 a,
+						csnip_simd_scalar_u8 b)
+{
+	csnip_simd_scalar_u8 r;
+	for (int i = 0; i < 16; ++i)
+		r.v[i] = a.v[i] | b.v[i];
+	return r;
+}
+
+inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_shr(csnip_simd_scalar_u8 a,
+						int n)
+{
+	csnip_simd_scalar_u8 r;
+	for (int i = 0; i < 16; ++i)
+		r.v[i] = (uint8_t)(a.v[i] >> n);
+	return r;
+}
+
+inline csnip_simd_scalar_u8 csnip_simd_scalar_u8_shuffle(
+						csnip_simd_scalar_u8 t,
+						csnip_simd_scalar_u8 idx)
+{
+	csnip_simd_scalar_u8 r;
+	for (int i = 0; i < 16; ++i)
+		r.v[i] = (idx.v[i] & 0x80 ? 0 : t.v[idx.v[i] & 15]);
+	return r;
+}
+
+inline uint64_t csnip_simd_scalar_u8_movemask(csnip_simd_scalar_u8 a)
+{
+	uint64_t m = 0;
+	for (int i = 0; i < 16; ++i)
+		m |= (uint64_t)(a.v[i] >> 7) << i;
+	return m;
+}
+
+inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_load(const void* p)
+{
+	csnip_simd_scalar_i32 r;
+	memcpy(r.v, p, sizeof r.v);
+	return r;
+}
+
+inline void csnip_simd_scalar_i32_store(void* p, csnip_simd_scalar_i32 a)
+{
+	memcpy(p, a.v, sizeof a.v);
+}
+
+inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_splat(int32_t c)
+{
+	csnip_simd_scalar_i32 r;
+	for (int i = 0; i < 4; ++i)
+		r.v[i] = c;
+	return r;
+}
+
+inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_eq(
+						csnip_simd_scalar_i32 a,
+						csnip_simd_scalar_i32 b)
+{
+	csnip_simd_scalar_i32 r;
+	for (int i = 0; i < 4; ++i)
+		r.v[i] = (a.v[i] == b.v[i] ? -1 : 0);
+	return r;
+}
+
+inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_gt(
+						csnip_simd_scalar_i32 a,
+						csnip_simd_scalar_i32 b)
+{
+	csnip_simd_scalar_i32 r;
+	for (int i = 0; i < 4; ++i)
+		r.v[i] = (a.v[i] > b.v[i] ? -1 : 0);
+	return r;
+}
+
+inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_min(
+						csnip_simd_scalar_i32 a,
+						csnip_simd_scalar_i32 b)
+{
+	csnip_simd_scalar_i32 r;
+	for (int i = 0; i < 4; ++i)
+		r.v[i] = (a.v[i] < b.v[i] ? a.v[i] : b.v[i]);
+	return r;
+}
+
+inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_max(
+						csnip_simd_scalar_i32 a,
+						csnip_simd_scalar_i32 b)
+{
+	csnip_simd_scalar_i32 r;
+	for (int i = 0; i < 4; ++i)
+		r.v[i] = (a.v[i] > b.v[i] ? a.v[i] : b.v[i]);
+	return r;
+}
+
+inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_add(
+						csnip_simd_scalar_i32 a,
+						csnip_simd_scalar_i32 b)
+{
+	csnip_simd_scalar_i32 r;
+	for (int i = 0; i < 4; ++i)
+		r.v[i] = (int32_t)((uint32_t)a.v[i] + (uint32_t)b.v[i]);
+	return r;
+}
+
+inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_mullo(
+						csnip_simd_scalar_i32 a,
+						csnip_simd_scalar_i32 b)
+{
+	csnip_simd_scalar_i32 r;
+	for (int i = 0; i < 4; ++i)
+		r.v[i] = (int32_t)((uint32_t)a.v[i] * (uint32_t)b.v[i]);
+	return r;
+}
+
+inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_and(
+						csnip_simd_scalar_i32 a,
+						csnip_simd_scalar_i32 b)
+{
+	csnip_simd_scalar_i32 r;
+	for (int i = 0; i < 4; ++i)
+		r.v[i] = a.v[i] & b.v[i];
+	return r;
+}
+
+inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_xor(
+						csnip_simd_scalar_i32 a,
+						csnip_simd_scalar_i32 b)
+{
+	csnip_simd_scalar_i32 r;
+	for (int i = 0; i < 4; ++i)
+		r.v[i] = a.v[i] ^ b.v[i];
+	return r;
+}
+
+inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_shr(
+						csnip_simd_scalar_i32 a,
+						int n)
+{
+	csnip_simd_scalar_i32 r;
+	for (int i = 0; i < 4; ++i)
+		r.v[i] = (int32_t)((uint32_t)a.v[i] >> n);
+	return r;
+}
+
+inline csnip_simd_scalar_i32 csnip_simd_scalar_i32_gather(
+						const void* base,
+						csnip_simd_scalar_i32 off)
+{
+	csnip_simd_scalar_i32 r;
+	for (int i = 0; i < 4; ++i)
+		memcpy(&r.v[i], (const char*)base + off.v[i], 4);
+	return r;
+}
+
+inline uint64_t csnip_simd_scalar_i32_movemask(csnip_simd_scalar_i32 a)
+{
+	uint64_t m = 0;
+	for (int i = 0; i < 4; ++i)
+		m |= (uint64_t)((uint32_t)a.v[i] >> 31) << i;
+	return m;
+}
+
+/* SSE2 backend */
+
+#if defined(CSNIP_SIMD_HAVE_SSE2)
+#define CSNIP_SIMD_SSE2_WIDTH		16
+#if defined(__SSSE3__)
+#  define CSNIP_SIMD_SSE2_FAST_SHUFFLE	1
+#else
+#  define CSNIP_SIMD_SSE2_FAST_SHUFFLE	0
+#endif
+
+typedef __m128i csnip_simd_sse2_u8;
+typedef __m128i csnip_simd_sse2_i32;
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_u8_load(const void* p)
+{
+	return _mm_loadu_si128((const __m128i*)p);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_u8_load16(const void* p)
+{
+	return _mm_loadu_si128((const __m128i*)p);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline void csnip_simd_sse2_u8_store(void* p, __m128i a)
+{
+	_mm_storeu_si128((__m128i*)p, a);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_u8_splat(uint8_t c)
+{
+	return _mm_set1_epi8((char)c);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_u8_eq(__m128i a, __m128i b)
+{
+	return _mm_cmpeq_epi8(a, b);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_u8_gt(__m128i a, __m128i b)
+{
+	/* a > b iff min(a, b) != a */
+	return _mm_xor_si128(_mm_cmpeq_epi8(_mm_min_epu8(a, b), a),
+				_mm_set1_epi8(-1));
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_u8_min(__m128i a, __m128i b)
+{
+	return _mm_min_epu8(a, b);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_u8_max(__m128i a, __m128i b)
+{
+	return _mm_max_epu8(a, b);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_u8_and(__m128i a, __m128i b)
+{
+	return _mm_and_si128(a, b);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_u8_or(__m128i a, __m128i b)
+{
+	return _mm_or_si128(a, b);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_u8_shr(__m128i a, int n)
+{
+	return _mm_and_si128(_mm_srl_epi16(a, _mm_cvtsi32_si128(n)),
+				_mm_set1_epi8((char)(0xff >> n)));
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_u8_shuffle(__m128i t, __m128i idx)
+{
+#if defined(__SSSE3__)
+	return _mm_shuffle_epi8(t, idx);
+#else
+	uint8_t tv[16], iv[16], rv[16];
+	_mm_storeu_si128((__m128i*)tv, t);
+	_mm_storeu_si128((__m128i*)iv, idx);
+	for (int i = 0; i < 16; ++i)
+		rv[i] = (iv[i] & 0x80 ? 0 : tv[iv[i] & 15]);
+	return _mm_loadu_si128((const __m128i*)rv);
+#endif
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline uint64_t csnip_simd_sse2_u8_movemask(__m128i a)
+{
+	return (uint64_t)(unsigned)_mm_movemask_epi8(a);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_i32_load(const void* p)
+{
+	return _mm_loadu_si128((const __m128i*)p);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline void csnip_simd_sse2_i32_store(void* p, __m128i a)
+{
+	_mm_storeu_si128((__m128i*)p, a);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_i32_splat(int32_t c)
+{
+	return _mm_set1_epi32(c);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_i32_eq(__m128i a, __m128i b)
+{
+	return _mm_cmpeq_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_i32_gt(__m128i a, __m128i b)
+{
+	return _mm_cmpgt_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_i32_min(__m128i a, __m128i b)
+{
+	const __m128i m = _mm_cmpgt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(m, b), _mm_andnot_si128(m, a));
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_i32_max(__m128i a, __m128i b)
+{
+	const __m128i m = _mm_cmpgt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_i32_add(__m128i a, __m128i b)
+{
+	return _mm_add_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_i32_mullo(__m128i a, __m128i b)
+{
+#if defined(__SSE4_1__)
+	return _mm_mullo_epi32(a, b);
+#else
+	/* Even and odd lanes separately with 32 x 32 -> 64 bit products */
+	const __m128i p02 = _mm_mul_epu32(a, b);
+	const __m128i p13 = _mm_mul_epu32(_mm_srli_epi64(a, 32),
+						_mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(
+			_mm_shuffle_epi32(p02, _MM_SHUFFLE(0, 0, 2, 0)),
+			_mm_shuffle_epi32(p13, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_i32_and(__m128i a, __m128i b)
+{
+	return _mm_and_si128(a, b);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_i32_xor(__m128i a, __m128i b)
+{
+	return _mm_xor_si128(a, b);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_i32_shr(__m128i a, int n)
+{
+	return _mm_srl_epi32(a, _mm_cvtsi32_si128(n));
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline __m128i csnip_simd_sse2_i32_gather(const void* base, __m128i off)
+{
+	int32_t o[4], r[4];
+	_mm_storeu_si128((__m128i*)o, off);
+	for (int i = 0; i < 4; ++i)
+		memcpy(&r[i], (const char*)base + o[i], 4);
+	return _mm_loadu_si128((const __m128i*)r);
+}
+
+CSNIP_SIMD_TARGET_SSE2
+inline uint64_t csnip_simd_sse2_i32_movemask(__m128i a)
+{
+	return (uint64_t)(unsigned)_mm_movemask_ps(_mm_castsi128_ps(a));
+}
+#endif /* CSNIP_SIMD_HAVE_SSE2 */
+
+/* AVX2 backend */
+
+#if defined(CSNIP_SIMD_HAVE_AVX2)
+#define CSNIP_SIMD_AVX2_WIDTH		32
+#define CSNIP_SIMD_AVX2_FAST_SHUFFLE	1
+
+typedef __m256i csnip_simd_avx2_u8;
+typedef __m256i csnip_simd_avx2_i32;
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_u8_load(const void* p)
+{
+	return _mm256_loadu_si256((const __m256i*)p);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_u8_load16(const void* p)
+{
+	return _mm256_broadcastsi128_si256(
+			_mm_loadu_si128((const __m128i*)p));
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline void csnip_simd_avx2_u8_store(void* p, __m256i a)
+{
+	_mm256_storeu_si256((__m256i*)p, a);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_u8_splat(uint8_t c)
+{
+	return _mm256_set1_epi8((char)c);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_u8_eq(__m256i a, __m256i b)
+{
+	return _mm256_cmpeq_epi8(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_u8_gt(__m256i a, __m256i b)
+{
+	return _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(a, b), a),
+				_mm256_set1_epi8(-1));
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_u8_min(__m256i a, __m256i b)
+{
+	return _mm256_min_epu8(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_u8_max(__m256i a, __m256i b)
+{
+	return _mm256_max_epu8(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_u8_and(__m256i a, __m256i b)
+{
+	return _mm256_and_si256(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_u8_or(__m256i a, __m256i b)
+{
+	return _mm256_or_si256(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_u8_shr(__m256i a, int n)
+{
+	return _mm256_and_si256(_mm256_srl_epi16(a, _mm_cvtsi32_si128(n)),
+				_mm256_set1_epi8((char)(0xff >> n)));
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_u8_shuffle(__m256i t, __m256i idx)
+{
+	return _mm256_shuffle_epi8(t, idx);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline uint64_t csnip_simd_avx2_u8_movemask(__m256i a)
+{
+	return (uint64_t)(uint32_t)_mm256_movemask_epi8(a);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_i32_load(const void* p)
+{
+	return _mm256_loadu_si256((const __m256i*)p);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline void csnip_simd_avx2_i32_store(void* p, __m256i a)
+{
+	_mm256_storeu_si256((__m256i*)p, a);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_i32_splat(int32_t c)
+{
+	return _mm256_set1_epi32(c);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_i32_eq(__m256i a, __m256i b)
+{
+	return _mm256_cmpeq_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_i32_gt(__m256i a, __m256i b)
+{
+	return _mm256_cmpgt_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_i32_min(__m256i a, __m256i b)
+{
+	return _mm256_min_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_i32_max(__m256i a, __m256i b)
+{
+	return _mm256_max_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_i32_add(__m256i a, __m256i b)
+{
+	return _mm256_add_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_i32_mullo(__m256i a, __m256i b)
+{
+	return _mm256_mullo_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_i32_and(__m256i a, __m256i b)
+{
+	return _mm256_and_si256(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_i32_xor(__m256i a, __m256i b)
+{
+	return _mm256_xor_si256(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_i32_shr(__m256i a, int n)
+{
+	return _mm256_srl_epi32(a, _mm_cvtsi32_si128(n));
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline __m256i csnip_simd_avx2_i32_gather(const void* base, __m256i off)
+{
+	return _mm256_i32gather_epi32((const int*)base, off, 1);
+}
+
+CSNIP_SIMD_TARGET_AVX2
+inline uint64_t csnip_simd_avx2_i32_movemask(__m256i a)
+{
+	return (uint64_t)(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(a));
+}
+#endif /* CSNIP_SIMD_HAVE_AVX2 */
+
+/* AVX-512 backend */
+
+#if defined(CSNIP_SIMD_HAVE_AVX512)
+#define CSNIP_SIMD_AVX512_WIDTH		64
+#define CSNIP_SIMD_AVX512_FAST_SHUFFLE	1
+
+typedef __m512i csnip_simd_avx512_u8;
+typedef __m512i csnip_simd_avx512_i32;
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_u8_load(const void* p)
+{
+	return _mm512_loadu_si512(p);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_u8_load16(const void* p)
+{
+	return _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i*)p));
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline void csnip_simd_avx512_u8_store(void* p, __m512i a)
+{
+	_mm512_storeu_si512(p, a);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_u8_splat(uint8_t c)
+{
+	return _mm512_set1_epi8((char)c);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_u8_eq(__m512i a, __m512i b)
+{
+	return _mm512_movm_epi8(_mm512_cmpeq_epi8_mask(a, b));
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_u8_gt(__m512i a, __m512i b)
+{
+	return _mm512_movm_epi8(_mm512_cmpgt_epu8_mask(a, b));
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_u8_min(__m512i a, __m512i b)
+{
+	return _mm512_min_epu8(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_u8_max(__m512i a, __m512i b)
+{
+	return _mm512_max_epu8(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_u8_and(__m512i a, __m512i b)
+{
+	return _mm512_and_si512(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_u8_or(__m512i a, __m512i b)
+{
+	return _mm512_or_si512(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_u8_shr(__m512i a, int n)
+{
+	return _mm512_and_si512(_mm512_srl_epi16(a, _mm_cvtsi32_si128(n)),
+				_mm512_set1_epi8((char)(0xff >> n)));
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_u8_shuffle(__m512i t, __m512i idx)
+{
+	return _mm512_shuffle_epi8(t, idx);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline uint64_t csnip_simd_avx512_u8_movemask(__m512i a)
+{
+	return (uint64_t)_mm512_movepi8_mask(a);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_i32_load(const void* p)
+{
+	return _mm512_loadu_si512(p);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline void csnip_simd_avx512_i32_store(void* p, __m512i a)
+{
+	_mm512_storeu_si512(p, a);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_i32_splat(int32_t c)
+{
+	return _mm512_set1_epi32(c);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_i32_eq(__m512i a, __m512i b)
+{
+	return _mm512_movm_epi32(_mm512_cmpeq_epi32_mask(a, b));
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_i32_gt(__m512i a, __m512i b)
+{
+	return _mm512_movm_epi32(_mm512_cmpgt_epi32_mask(a, b));
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_i32_min(__m512i a, __m512i b)
+{
+	return _mm512_min_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_i32_max(__m512i a, __m512i b)
+{
+	return _mm512_max_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_i32_add(__m512i a, __m512i b)
+{
+	return _mm512_add_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_i32_mullo(__m512i a, __m512i b)
+{
+	return _mm512_mullo_epi32(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_i32_and(__m512i a, __m512i b)
+{
+	return _mm512_and_si512(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_i32_xor(__m512i a, __m512i b)
+{
+	return _mm512_xor_si512(a, b);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_i32_shr(__m512i a, int n)
+{
+	return _mm512_srl_epi32(a, _mm_cvtsi32_si128(n));
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline __m512i csnip_simd_avx512_i32_gather(const void* base, __m512i off)
+{
+	return _mm512_i32gather_epi32(off, base, 1);
+}
+
+CSNIP_SIMD_TARGET_AVX512
+inline uint64_t csnip_simd_avx512_i32_movemask(__m512i a)
+{
+	return (uint64_t)_mm512_movepi32_mask(a);
+}
+#endif /* CSNIP_SIMD_HAVE_AVX512 */
+
+/* NEON backend */
+
+#if defined(CSNIP_SIMD_HAVE_NEON)
+#define CSNIP_SIMD_NEON_WIDTH		16
+#define CSNIP_SIMD_NEON_FAST_SHUFFLE	1
+
+typedef uint8x16_t csnip_simd_neon_u8;
+typedef int32x4_t csnip_simd_neon_i32;
+
+inline uint8x16_t csnip_simd_neon_u8_load(const void* p)
+{
+	return vld1q_u8((const uint8_t*)p);
+}
+
+inline uint8x16_t csnip_simd_neon_u8_load16(const void* p)
+{
+	return vld1q_u8((const uint8_t*)p);
+}
+
+inline void csnip_simd_neon_u8_store(void* p, uint8x16_t a)
+{
+	vst1q_u8((uint8_t*)p, a);
+}
+
+inline uint8x16_t csnip_simd_neon_u8_splat(uint8_t c)
+{
+	return vdupq_n_u8(c);
+}
+
+inline uint8x16_t csnip_simd_neon_u8_eq(uint8x16_t a, uint8x16_t b)
+{
+	return vceqq_u8(a, b);
+}
+
+inline uint8x16_t csnip_simd_neon_u8_gt(uint8x16_t a, uint8x16_t b)
+{
+	return vcgtq_u8(a, b);
+}
+
+inline uint8x16_t csnip_simd_neon_u8_min(uint8x16_t a, uint8x16_t b)
+{
+	return vminq_u8(a, b);
+}
+
+inline uint8x16_t csnip_simd_neon_u8_max(uint8x16_t a, uint8x16_t b)
+{
+	return vmaxq_u8(a, b);
+}
+
+inline uint8x16_t csnip_simd_neon_u8_and(uint8x16_t a, uint8x16_t b)
+{
+	return vandq_u8(a, b);
+}
+
+inline uint8x16_t csnip_simd_neon_u8_or(uint8x16_t a, uint8x16_t b)
+{
+	return vorrq_u8(a, b);
+}
+
+inline uint8x16_t csnip_simd_neon_u8_shr(uint8x16_t a, int n)
+{
+	return vshlq_u8(a, vdupq_n_s8((int8_t)-n));
+}
+
+inline uint8x16_t csnip_simd_neon_u8_shuffle(uint8x16_t t, uint8x16_t idx)
+{
+	/* TBL gives 0 for indices >= 16 */
+	return vqtbl1q_u8(t, vandq_u8(idx, vdupq_n_u8(0x8f)));
+}
+
+inline uint64_t csnip_simd_neon_u8_movemask(uint8x16_t a)
+{
+	static const int8_t shifts[16] = {
+		0, 1, 2, 3, 4, 5, 6, 7, 0, 1, 2, 3, 4, 5, 6, 7
+	};
+	const uint8x16_t b = vshlq_u8(vshrq_n_u8(a, 7), vld1q_s8(shifts));
+	return (uint64_t)vaddv_u8(vget_low_u8(b))
+		| ((uint64_t)vaddv_u8(vget_high_u8(b)) << 8);
+}
+
+inline int32x4_t csnip_simd_neon_i32_load(const void* p)
+{
+	return vld1q_s32((const int32_t*)p);
+}
+
+inline void csnip_simd_neon_i32_store(void* p, int32x4_t a)
+{
+	vst1q_s32((int32_t*)p, a);
+}
+
+inline int32x4_t csnip_simd_neon_i32_splat(int32_t c)
+{
+	return vdupq_n_s32(c);
+}
+
+inline int32x4_t csnip_simd_neon_i32_eq(int32x4_t a, int32x4_t b)
+{
+	return vreinterpretq_s32_u32(vceqq_s32(a, b));
+}
+
+inline int32x4_t csnip_simd_neon_i32_gt(int32x4_t a, int32x4_t b)
+{
+	return vreinterpretq_s32_u32(vcgtq_s32(a, b));
+}
+
+inline int32x4_t csnip_simd_neon_i32_min(int32x4_t a, int32x4_t b)
+{
+	return vminq_s32(a, b);
+}
+
+inline int32x4_t csnip_simd_neon_i32_max(int32x4_t a, int32x4_t b)
+{
+	return vmaxq_s32(a, b);
+}
+
+inline int32x4_t csnip_simd_neon_i32_add(int32x4_t a, int32x4_t b)
+{
+	return vaddq_s32(a, b);
+}
+
+inline int32x4_t csnip_simd_neon_i32_mullo(int32x4_t a, int32x4_t b)
+{
+	return vmulq_s32(a, b);
+}
+
+inline int32x4_t csnip_simd_neon_i32_and(int32x4_t a, int32x4_t b)
+{
+	return vandq_s32(a, b);
+}
+
+inline int32x4_t csnip_simd_neon_i32_xor(int32x4_t a, int32x4_t b)
+{
+	return veorq_s32(a, b);
+}
+
+inline int32x4_t csnip_simd_neon_i32_shr(int32x4_t a, int n)
+{
+	return vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_s32(a),
+						vdupq_n_s32(-n)));
+}
+
+inline int32x4_t csnip_simd_neon_i32_gather(const void* base, int32x4_t off)
+{
+	int32_t o[4], r[4];
+	vst1q_s32(o, off);
+	for (int i = 0; i < 4; ++i)
+		memcpy(&r[i], (const char*)base + o[i], 4);
+	return vld1q_s32(r);
+}
+
+inline uint64_t csnip_simd_neon_i32_movemask(int32x4_t a)
+{
+	static const int32_t shifts[4] = { 0, 1, 2, 3 };
+	const uint32x4_t b = vshlq_u32(
+			vshrq_n_u32(vreinterpretq_u32_s32(a), 31),
+			vld1q_s32(shifts));
+	return (uint64_t)vaddvq_u32(b);
+}
+#endif /* CSNIP_SIMD_HAVE_NEON */
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @cond */
+#define csnip_simd__native(name) \
+	csnip_simd__native2(CSNIP_SIMD_NATIVE, name)
+#define csnip_simd__native2(be, name)	csnip_simd__native3(be, name)
+#define csnip_simd__native3(be, name)	csnip_simd_ ## be ## _ ## name
+/** @endcond */
+
+/** @name Native backend operations */
+/**@{*/
+
+#define csnip_simd_u8			csnip_simd__native(u8)
+#define csnip_simd_u8_load		csnip_simd__native(u8_load)
+#define csnip_simd_u8_load16		csnip_simd__native(u8_load16)
+#define csnip_simd_u8_store		csnip_simd__native(u8_store)
+#define csnip_simd_u8_splat		csnip_simd__native(u8_splat)
+#define csnip_simd_u8_eq		csnip_simd__native(u8_eq)
+#define csnip_simd_u8_gt		csnip_simd__native(u8_gt)
+#define csnip_simd_u8_min		csnip_simd__native(u8_min)
+#define csnip_simd_u8_max		csnip_simd__native(u8_max)
+#define csnip_simd_u8_and		csnip_simd__native(u8_and)
+#define csnip_simd_u8_or		csnip_simd__native(u8_or)
+#define csnip_simd_u8_shr		csnip_simd__native(u8_shr)
+#define csnip_simd_u8_shuffle		csnip_simd__native(u8_shuffle)
+#define csnip_simd_u8_movemask		csnip_simd__native(u8_movemask)
+#define csnip_simd_i32			csnip_simd__native(i32)
+#define csnip_simd_i32_load		csnip_simd__native(i32_load)
+#define csnip_simd_i32_store		csnip_simd__native(i32_store)
+#define csnip_simd_i32_splat		csnip_simd__native(i32_splat)
+#define csnip_simd_i32_eq		csnip_simd__native(i32_eq)
+#define csnip_simd_i32_gt		csnip_simd__native(i32_gt)
+#define csnip_simd_i32_min		csnip_simd__native(i32_min)
+#define csnip_simd_i32_max		csnip_simd__native(i32_max)
+#define csnip_simd_i32_add		csnip_simd__native(i32_add)
+#define csnip_simd_i32_mullo		csnip_simd__native(i32_mullo)
+#define csnip_simd_i32_and		csnip_simd__native(i32_and)
+#define csnip_simd_i32_xor		csnip_simd__native(i32_xor)
+#define csnip_simd_i32_shr		csnip_simd__native(i32_shr)
+#define csnip_simd_i32_gather		csnip_simd__native(i32_gather)
+#define csnip_simd_i32_movemask		csnip_simd__native(i32_movemask)
+#define CSNIP_SIMD_FAST_SHUFFLE		csnip_simd__NATIVE_FAST_SHUFFLE
+/**@}*/
+
+/** @cond */
+#if CSNIP_SIMD_WIDTH == 64
+#  define csnip_simd__NATIVE_FAST_SHUFFLE	CSNIP_SIMD_AVX512_FAST_SHUFFLE
+#elif CSNIP_SIMD_WIDTH == 32
+#  define csnip_simd__NATIVE_FAST_SHUFFLE	CSNIP_SIMD_AVX2_FAST_SHUFFLE
+#elif defined(CSNIP_SIMD_NATIVE_IS_SCALAR)
+#  define csnip_simd__NATIVE_FAST_SHUFFLE	CSNIP_SIMD_SCALAR_FAST_SHUFFLE
+#elif defined(CSNIP_SIMD_HAVE_NEON)
+#  define csnip_simd__NATIVE_FAST_SHUFFLE	CSNIP_SIMD_NEON_FAST_SHUFFLE
+#else
+#  define csnip_simd__NATIVE_FAST_SHUFFLE	CSNIP_SIMD_SSE2_FAST_SHUFFLE
+#endif
+/** @endcond */
+
+/** @} */
+
+#endif /* CSNIP_SIMD_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_SIMD_HAVE_SHORT_NAMES)
+#define simd_mask_popcount		csnip_simd_mask_popcount
+#define simd_mask_ctz			csnip_simd_mask_ctz
+#define simd_u8				csnip_simd_u8
+#define simd_u8_load			csnip_simd_u8_load
+#define simd_u8_load16			csnip_simd_u8_load16
+#define simd_u8_store			csnip_simd_u8_store
+#define simd_u8_splat			csnip_simd_u8_splat
+#define simd_u8_eq			csnip_simd_u8_eq
+#define simd_u8_gt			csnip_simd_u8_gt
+#define simd_u8_min			csnip_simd_u8_min
+#define simd_u8_max			csnip_simd_u8_max
+#define simd_u8_and			csnip_simd_u8_and
+#define simd_u8_or			csnip_simd_u8_or
+#define simd_u8_shr			csnip_simd_u8_shr
+#define simd_u8_shuffle			csnip_simd_u8_shuffle
+#define simd_u8_movemask		csnip_simd_u8_movemask
+#define simd_i32			csnip_simd_i32
+#define simd_i32_load			csnip_simd_i32_load
+#define simd_i32_store			csnip_simd_i32_store
+#define simd_i32_splat			csnip_simd_i32_splat
+#define simd_i32_eq			csnip_simd_i32_eq
+#define simd_i32_gt			csnip_simd_i32_gt
+#define simd_i32_min			csnip_simd_i32_min
+#define simd_i32_max			csnip_simd_i32_max
+#define simd_i32_add			csnip_simd_i32_add
+#define simd_i32_mullo			csnip_simd_i32_mullo
+#define simd_i32_and			csnip_simd_i32_and
+#define simd_i32_xor			csnip_simd_i32_xor
+#define simd_i32_shr			csnip_simd_i32_shr
+#define simd_i32_gather			csnip_simd_i32_gather
+#define simd_i32_movemask		csnip_simd_i32_movemask
+#define CSNIP_SIMD_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_SIMD_HAVE_SHORT_NAMES */
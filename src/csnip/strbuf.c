@@ -0,0 +1,162 @@
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/err.h>
+#include <csnip/numfmt.h>
+#include <csnip/strbuf.h>
+
+extern inline int csnip_strbuf_reserve(csnip_strbuf* S, size_t n);
+extern inline void csnip_strbuf_clear(csnip_strbuf* S);
+extern inline void csnip_strbuf_truncate(csnip_strbuf* S, size_t len);
+extern inline int csnip_strbuf_append(csnip_strbuf* S,
+					const char* p,
+					size_t n);
+extern inline int csnip_strbuf_appends(csnip_strbuf* S, const char* str);
+extern inline int csnip_strbuf_appendc(csnip_strbuf* S, char c);
+
+void csnip_strbuf_init(strbuf* S)
+{
+	S->ptr = S->small;
+	S->len = 0;
+	S->cap = sizeof S->small;
+	S->small[0] = '\0';
+}
+
+void csnip_strbuf_free(strbuf* S)
+{
+	if (S->ptr != S->small)
+		free(S->ptr);
+	strbuf_init(S);
+}
+
+char* csnip_strbuf_release(strbuf* S, size_t* len)
+{
+	char* r = S->ptr;
+	if (r == S->small) {
+		r = malloc(S->len + 1);
+		if (r == NULL)
+			return NULL;
+		memcpy(r, S->small, S->len + 1);
+	}
+	if (len)
+		*len = S->len;
+	strbuf_init(S);
+	return r;
+}
+
+int csnip_strbuf__grow(strbuf* S, size_t need)
+{
+	/* Room for need more bytes and the '\0' */
+	if (need > SIZE_MAX - 1 - S->len)
+		return csnip_err_NOMEM;
+	const size_t least = S->len + need + 1;
+	size_t cap = S->cap;
+	while (cap < least) {
+		if (cap > SIZE_MAX / 2) {
+			cap = least;
+			break;
+		}
+		cap *= 2;
+	}
+
+	char* p;
+	if (S->ptr == S->small) {
+		p = malloc(cap);
+		if (p == NULL)
+			return csnip_err_NOMEM;
+		memcpy(p, S->small, S->len + 1);
+	} else {
+		p = realloc(S->ptr, cap);
+		if (p == NULL)
+			return csnip_err_NOMEM;
+	}
+	S->ptr = p;
+	S->cap = cap;
+	return 0;
+}
+
+int csnip_strbuf_appendvf(strbuf* S, const char* format, va_list ap)
+{
+	va_list ap2;
+	va_copy(ap2, ap);
+	size_t avail = S->cap - S->len;
+	int n = vsnprintf(S->ptr + S->len, avail, format, ap2);
+	va_end(ap2);
+	if (n < 0) {
+		S->ptr[S->len] = '\0';
+		return csnip_err_ERRNO;
+	}
+
+	if ((size_t)n >= avail) {
+		/* Didn't fit; retry with the exact size */
+		const int err = csnip_strbuf__grow(S, (size_t)n);
+		if (err) {
+			S->ptr[S->len] = '\0';
+			return err;
+		}
+		avail = S->cap - S->len;
+		n = vsnprintf(S->ptr + S->len, avail, format, ap);
+		if (n < 0 || (size_t)n >= avail) {
+			S->ptr[S->len] = '\0';
+			return csnip_err_ERRNO;
+		}
+	}
+	S->len += (size_t)n;
+	return 0;
+}
+
+int csnip_strbuf_appendf(strbuf* S, const char* format, ...)
+{
+	va_list ap;
+	va_start(ap, format);
+	const int err = strbuf_appendvf(S, format, ap);
+	va_end(ap);
+	return err;
+}
+
+/* Numbers */
+
+int csnip_strbuf_append_u64(strbuf* S, uint64_t v)
+{
+	const int err = strbuf_reserve(S, NUMFMT_U64_MAX);
+	if (err)
+		return err;
+	S->len += numfmt_u64(S->ptr + S->len, v);
+	S->ptr[S->len] = '\0';
+	return 0;
+}
+
+int csnip_strbuf_append_i64(strbuf* S, int64_t v)
+{
+	const int err = strbuf_reserve(S, NUMFMT_I64_MAX);
+	if (err)
+		return err;
+	S->len += numfmt_i64(S->ptr + S->len, v);
+	S->ptr[S->len] = '\0';
+	return 0;
+}
+
+int csnip_strbuf_append_hex(strbuf* S, uint64_t v, int width)
+{
+	const int err = strbuf_reserve(S, NUMFMT_HEX_MAX);
+	if (err)
+		return err;
+	S->len += numfmt_hex(S->ptr + S->len, v, width, 0);
+	S->ptr[S->len] = '\0';
+	return 0;
+}
+
+int csnip_strbuf_append_double(strbuf* S, double v)
+{
+	const int err = strbuf_reserve(S, NUMFMT_DOUBLE_MAX);
+	if (err)
+		return err;
+	S->len += numfmt_double(S->ptr + S->len, v);
+	S->ptr[S->len] = '\0';
+	return 0;
+}
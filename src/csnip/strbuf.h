@@ -0,0 +1,190 @@
+#ifndef CSNIP_STRBUF_H
+#define CSNIP_STRBUF_H
+
+/**	@file strbuf.h
+ *	@brief			String builder
+ *	@defgroup strbuf	String builder
+ *	@{
+ *
+ *	Growable, always '\\0' terminated string buffer.
+ *
+ *	A string buffer starts out with a small inline buffer, so that
+ *	short strings are built without any allocation, and grows
+ *	geometrically (by doubling) on the heap beyond that.  Appending
+ *	is amortized O(1) per byte, with the common case of enough
+ *	spare capacity inlined.  Formatted output is written by
+ *	vsnprintf() straight into the spare capacity, and numbers are
+ *	appended with the numfmt conversions.
+ *
+ *	The built string can be passed on with csnip_strbuf_release()
+ *	without copying when it lives on the heap.
+ *
+ *	The members @a ptr and @a len can be read directly.  Since @a
+ *	ptr can point into the struct itself, a strbuf must not be
+ *	copied or moved by value.
+ *
+ *	Functions returning int return 0 on success, or csnip_err_NOMEM
+ *	if out of memory; the buffer is unchanged in that case.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Size of the inline buffer, including the '\\0' byte */
+#define CSNIP_STRBUF_INLINE_SIZE	64
+
+/** String buffer. */
+typedef struct {
+	char* ptr;		/**< The string, '\\0' terminated */
+	size_t len;		/**< The string length */
+	/** @cond */
+	size_t cap;		/* Capacity, including the '\0' byte */
+	char small[CSNIP_STRBUF_INLINE_SIZE];
+	/** @endcond */
+} csnip_strbuf;
+
+/**	Initialize an empty string buffer. */
+void csnip_strbuf_init(csnip_strbuf* S);
+
+/**	Release the memory of a string buffer.
+ *
+ *	The buffer is left empty and can be reused.
+ */
+void csnip_strbuf_free(csnip_strbuf* S);
+
+/**	Pass the string to the caller.
+ *
+ *	@param[out]	len
+ *			If not NULL, the string length is returned here.
+ *
+ *	@return	the string, which must be released with free(), or NULL
+ *		if out of memory.  The buffer is left empty.
+ */
+char* csnip_strbuf_release(csnip_strbuf* S, size_t* len);
+
+/** @cond */
+int csnip_strbuf__grow(csnip_strbuf* S, size_t need);
+/** @endcond */
+
+/**	Reserve capacity.
+ *
+ *	Makes sure that @a n more bytes can be appended without
+ *	reallocation.
+ */
+inline int csnip_strbuf_reserve(csnip_strbuf* S, size_t n)
+{
+	if (S->cap - S->len > n)
+		return 0;
+	return csnip_strbuf__grow(S, n);
+}
+
+/**	Empty the string, keeping the capacity. */
+inline void csnip_strbuf_clear(csnip_strbuf* S)
+{
+	S->len = 0;
+	S->ptr[0] = '\0';
+}
+
+/**	Truncate the string to at most @a len bytes. */
+inline void csnip_strbuf_truncate(csnip_strbuf* S, size_t len)
+{
+	if (len < S->len) {
+		S->len = len;
+		S->ptr[len] = '\0';
+	}
+}
+
+/**	Append bytes. */
+inline int csnip_strbuf_append(csnip_strbuf* S, const char* p, size_t n)
+{
+	const int err = csnip_strbuf_reserve(S, n);
+	if (err)
+		return err;
+	memcpy(S->ptr + S->len, p, n);
+	S->len += n;
+	S->ptr[S->len] = '\0';
+	return 0;
+}
+
+/**	Append a '\\0' terminated string. */
+inline int csnip_strbuf_appends(csnip_strbuf* S, const char* str)
+{
+	return csnip_strbuf_append(S, str, strlen(str));
+}
+
+/**	Append a character. */
+inline int csnip_strbuf_appendc(csnip_strbuf* S, char c)
+{
+	const int err = csnip_strbuf_reserve(S, 1);
+	if (err)
+		return err;
+	S->ptr[S->len++] = c;
+	S->ptr[S->len] = '\0';
+	return 0;
+}
+
+/**	Append formatted output.
+ *
+ *	The output is formatted directly into the spare capacity; if it
+ *	doesn't fit, the buffer is grown to the size reported by
+ *	vsnprintf(), and formatting is repeated once.
+ *
+ *	@return	0 on success, csnip_err_NOMEM if out of memory, or
+ *		csnip_err_ERRNO if vsnprintf() fails.
+ */
+int csnip_strbuf_appendf(csnip_strbuf* S, const char* format, ...)
+#if defined(__GNUC__)
+		__attribute__((format (printf, 2, 3)))
+#endif
+		;
+
+/**	Append formatted output, va_list version. */
+int csnip_strbuf_appendvf(csnip_strbuf* S, const char* format, va_list ap);
+
+/** @name Numbers
+ *
+ *  Conversions as by numfmt.h; hexadecimal numbers are written in
+ *  lower case, zero padded to @a width digits, which must not exceed
+ *  16.
+ */
+/**@{*/
+int csnip_strbuf_append_u64(csnip_strbuf* S, uint64_t v);
+int csnip_strbuf_append_i64(csnip_strbuf* S, int64_t v);
+int csnip_strbuf_append_hex(csnip_strbuf* S, uint64_t v, int width);
+int csnip_strbuf_append_double(csnip_strbuf* S, double v);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* CSNIP_STRBUF_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_STRBUF_HAVE_SHORT_NAMES)
+#define STRBUF_INLINE_SIZE		CSNIP_STRBUF_INLINE_SIZE
+#define strbuf				csnip_strbuf
+#define strbuf_init			csnip_strbuf_init
+#define strbuf_free			csnip_strbuf_free
+#define strbuf_release			csnip_strbuf_release
+#define strbuf_reserve			csnip_strbuf_reserve
+#define strbuf_clear			csnip_strbuf_clear
+#define strbuf_truncate			csnip_strbuf_truncate
+#define strbuf_append			csnip_strbuf_append
+#define strbuf_appends			csnip_strbuf_appends
+#define strbuf_appendc			csnip_strbuf_appendc
+#define strbuf_appendf			csnip_strbuf_appendf
+#define strbuf_appendvf			csnip_strbuf_appendvf
+#define strbuf_append_u64		csnip_strbuf_append_u64
+#define strbuf_append_i64		csnip_strbuf_append_i64
+#define strbuf_append_hex		csnip_strbuf_append_hex
+#define strbuf_append_double		csnip_strbuf_append_double
+#define CSNIP_STRBUF_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_STRBUF_HAVE_SHORT_NAMES */
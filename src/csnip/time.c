@@ -1,3 +1,6 @@
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
 #include <time.h>
 
 #include <csnip/csnip_conf.h>
@@ -17,7 +20,18 @@
 #  endif
 #endif
 
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+#include <pthread.h>
+#endif
+#ifdef CSNIP_CONF__HAVE_SYS_PRCTL_H
+#include <sys/prctl.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
 #include "time.h"
+#include "x.h"
 
 typedef long double ldouble;
 
@@ -132,3 +146,562 @@ struct timespec csnip_time_sub(struct timespec a, struct timespec b)
 	}
 	return a;
 }
+
+/* Cycle counter */
+
+extern inline uint64_t csnip_time_cycles(void);
+extern inline uint64_t csnip_time_cycles_fenced(void);
+extern inline double csnip_time__stopwatch_lap(csnip_time_stopwatch* sw,
+					uint64_t now);
+extern inline double csnip_time__stopwatch_stop(csnip_time_stopwatch* sw,
+					uint64_t now);
+
+static int64_t ts_as_ns(struct timespec ts)
+{
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int64_t mono_ns(void)
+{
+	struct timespec ts;
+	csnip_x_clock_gettime(CSNIP_X_CLOCK_MAYBE_MONOTONIC, &ts);
+	return ts_as_ns(ts);
+}
+
+uint64_t csnip_time__cycles_fallback(void)
+{
+	return (uint64_t)mono_ns();
+}
+
+/* Calibration state: the counter rate, and the reference point
+ * (counter and monotonic clock) of the calibration.
+ */
+static double cal_per_ns = 1.0;
+static uint64_t cal_cycles0;
+static int64_t cal_ns0;
+
+/* Read the counter and the clock at (nearly) the same time.  Of a few
+ * attempts, take the one with the shortest clock bracket around the
+ * counter read.
+ */
+static void read_pair(uint64_t* cycles, int64_t* ns)
+{
+	int64_t best = INT64_MAX;
+	*cycles = 0;
+	*ns = 0;
+	for (int i = 0; i < 5; ++i) {
+		const int64_t a = mono_ns();
+		const uint64_t c = csnip_time_cycles_fenced();
+		const int64_t b = mono_ns();
+		if (b - a < best) {
+			best = b - a;
+			*cycles = c;
+			*ns = a + (b - a) / 2;
+		}
+	}
+}
+
+static void calibrate(double seconds)
+{
+	uint64_t c0, c1;
+	int64_t n0, n1;
+	read_pair(&c0, &n0);
+#if defined(CSNIP_TIME__CYCLES_TSC) || defined(CSNIP_TIME__CYCLES_CNTVCT)
+	const int64_t dur = (int64_t)(seconds * 1e9);
+	do {
+		read_pair(&c1, &n1);
+	} while (n1 - n0 < dur);
+	cal_per_ns = (double)(c1 - c0) / (double)(n1 - n0);
+#else
+	/* The fallback counter is in nanoseconds already. */
+	(void)seconds;
+	(void)c1;
+	(void)n1;
+	cal_per_ns = 1.0;
+#endif
+	cal_cycles0 = c0;
+	cal_ns0 = n0;
+}
+
+static void cal_init(void)
+{
+	calibrate(0.005);
+}
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+static pthread_once_t cal_once = PTHREAD_ONCE_INIT;
+#define cal_ensure_init()	pthread_once(&cal_once, cal_init)
+#else
+static int cal_done = 0;
+#define cal_ensure_init() \
+	do { \
+		if (!cal_done) { \
+			cal_init(); \
+			cal_done = 1; \
+		} \
+	} while (0)
+#endif
+
+void csnip_time_cycles_calibrate(double seconds)
+{
+	/* The initial calibration must not overwrite this one later */
+	cal_ensure_init();
+	calibrate(seconds);
+}
+
+double csnip_time_cycles_per_ns(void)
+{
+	cal_ensure_init();
+	return cal_per_ns;
+}
+
+double csnip_time_cycles_to_ns(uint64_t cycles)
+{
+	cal_ensure_init();
+	return (double)cycles / cal_per_ns;
+}
+
+const char* csnip_time_cycles_source(void)
+{
+#if defined(CSNIP_TIME__CYCLES_TSC)
+	return "tsc";
+#elif defined(CSNIP_TIME__CYCLES_CNTVCT)
+	return "cntvct";
+#else
+	return "clock_gettime";
+#endif
+}
+
+int csnip_time_cycles_invariant(void)
+{
+#if defined(CSNIP_TIME__CYCLES_TSC)
+	unsigned int eax, ebx, ecx, edx;
+	if (__get_cpuid_max(0x80000000u, NULL) < 0x80000007u
+	  || !__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx))
+	{
+		return 0;
+	}
+	return (edx >> 8) & 1;
+#else
+	return 1;
+#endif
+}
+
+double csnip_time_cycles_drift_ppm(void)
+{
+	cal_ensure_init();
+	uint64_t c;
+	int64_t n;
+	read_pair(&c, &n);
+	if (n <= cal_ns0)
+		return 0.0;
+	const double rate = (double)(c - cal_cycles0) / (double)(n - cal_ns0);
+	return (rate / cal_per_ns - 1.0) * 1e6;
+}
+
+/* Duration histograms */
+
+void csnip_time_histogram_add(csnip_time_histogram* H, double ns)
+{
+	int b = 0;
+	if (ns >= 1.0) {
+		int e;
+		frexp(ns, &e);
+		b = (e < CSNIP_TIME_HISTOGRAM_NBIN ? e
+			: CSNIP_TIME_HISTOGRAM_NBIN - 1);
+	}
+	++H->count[b];
+	++H->n;
+}
+
+double csnip_time_histogram_quantile(const csnip_time_histogram* H,
+					double q)
+{
+	if (H->n == 0)
+		return 0.0;
+	const double target = q * H->n;
+	unsigned long long cum = 0;
+	for (int b = 0; b < CSNIP_TIME_HISTOGRAM_NBIN; ++b) {
+		cum += H->count[b];
+		if (cum > 0 && cum >= target)
+			return ldexp(1.0, b);
+	}
+	return ldexp(1.0, CSNIP_TIME_HISTOGRAM_NBIN - 1);
+}
+
+/* Coarse clock */
+
+extern inline int64_t csnip_time_coarse_now_ns(int clk);
+extern inline struct timespec csnip_time_coarse_now(int clk);
+
+/* Published times; 0 if the refresh thread is not running. */
+int64_t csnip_time__coarse_ns[2];
+
+int64_t csnip_time__coarse_slow(int clk)
+{
+	struct timespec ts;
+#if defined(CLOCK_REALTIME_COARSE) && defined(CLOCK_MONOTONIC_COARSE)
+	clock_gettime(clk == CSNIP_TIME_COARSE_MONOTONIC
+		? CLOCK_MONOTONIC_COARSE : CLOCK_REALTIME_COARSE, &ts);
+#else
+	csnip_x_clock_gettime(clk == CSNIP_TIME_COARSE_MONOTONIC
+		? CSNIP_X_CLOCK_MAYBE_MONOTONIC : CSNIP_X_CLOCK_REALTIME, &ts);
+#endif
+	return ts_as_ns(ts);
+}
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+
+static pthread_mutex_t coarse_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t coarse_cv;	/* Signals coarse_quit */
+static pthread_t coarse_thread;
+static int coarse_running = 0;
+static long coarse_period_us;
+static int coarse_quit;
+
+static void coarse_store(int64_t* p, int64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	__atomic_store_n(p, v, __ATOMIC_RELAXED);
+#else
+	*(volatile int64_t*)p = v;
+#endif
+}
+
+static void coarse_publish(void)
+{
+	struct timespec rt, mt;
+	csnip_x_clock_gettime(CSNIP_X_CLOCK_REALTIME, &rt);
+	csnip_x_clock_gettime(CSNIP_X_CLOCK_MAYBE_MONOTONIC, &mt);
+	coarse_store(&csnip_time__coarse_ns[CSNIP_TIME_COARSE_REALTIME],
+		ts_as_ns(rt));
+	coarse_store(&csnip_time__coarse_ns[CSNIP_TIME_COARSE_MONOTONIC],
+		ts_as_ns(mt));
+}
+
+/* The refresh thread waits on coarse_cv, preferably with the
+ * monotonic clock, so that wall clock steps don't affect the period.
+ */
+static void coarse_cv_init(void)
+{
+#ifdef CSNIP_CONF__HAVE_PTHREAD_CONDATTR_SETCLOCK
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&coarse_cv, &attr);
+	pthread_condattr_destroy(&attr);
+#else
+	pthread_cond_init(&coarse_cv, NULL);
+#endif
+}
+
+static struct timespec coarse_deadline(long period_us)
+{
+	struct timespec ts;
+#ifdef CSNIP_CONF__HAVE_PTHREAD_CONDATTR_SETCLOCK
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+	csnip_x_clock_gettime(CSNIP_X_CLOCK_REALTIME, &ts);
+#endif
+	ts.tv_sec += period_us / 1000000;
+	ts.tv_nsec += (period_us % 1000000) * 1000;
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_nsec -= 1000000000;
+		++ts.tv_sec;
+	}
+	return ts;
+}
+
+static void* coarse_main(void* arg)
+{
+	(void)arg;
+	pthread_mutex_lock(&coarse_mutex);
+	while (!coarse_quit) {
+		coarse_publish();
+
+		/* Sleep for a period, or until stopped */
+		const struct timespec deadline =
+			coarse_deadline(coarse_period_us);
+		int r = 0;
+		while (!coarse_quit && r != ETIMEDOUT) {
+			r = pthread_cond_timedwait(&coarse_cv, &coarse_mutex,
+						&deadline);
+		}
+	}
+	pthread_mutex_unlock(&coarse_mutex);
+	return NULL;
+}
+
+int csnip_time_coarse_start(long period_us)
+{
+	if (period_us <= 0)
+		return csnip_err_INVAL;
+
+	pthread_mutex_lock(&coarse_mutex);
+	coarse_period_us = period_us;
+	if (coarse_running) {
+		pthread_mutex_unlock(&coarse_mutex);
+		return 0;
+	}
+
+	/* Publish before returning, so the caller sees fresh values */
+	coarse_publish();
+	coarse_quit = 0;
+	coarse_cv_init();
+	const int r = pthread_create(&coarse_thread, NULL, coarse_main, NULL);
+	if (r != 0) {
+		pthread_cond_destroy(&coarse_cv);
+		coarse_store(&csnip_time__coarse_ns[0], 0);
+		coarse_store(&csnip_time__coarse_ns[1], 0);
+		pthread_mutex_unlock(&coarse_mutex);
+		errno = r;
+		return csnip_err_ERRNO;
+	}
+	coarse_running = 1;
+	pthread_mutex_unlock(&coarse_mutex);
+	return 0;
+}
+
+void csnip_time_coarse_stop(void)
+{
+	pthread_mutex_lock(&coarse_mutex);
+	if (!coarse_running) {
+		pthread_mutex_unlock(&coarse_mutex);
+		return;
+	}
+	coarse_quit = 1;
+	pthread_cond_signal(&coarse_cv);
+	pthread_mutex_unlock(&coarse_mutex);
+
+	pthread_join(coarse_thread, NULL);
+
+	pthread_mutex_lock(&coarse_mutex);
+	pthread_cond_destroy(&coarse_cv);
+	coarse_store(&csnip_time__coarse_ns[0], 0);
+	coarse_store(&csnip_time__coarse_ns[1], 0);
+	coarse_running = 0;
+	pthread_mutex_unlock(&coarse_mutex);
+}
+
+#else /* CSNIP_CONF__SUPPORT_THREADING */
+
+int csnip_time_coarse_start(long period_us)
+{
+	(void)period_us;
+	return csnip_err_UNSUPPORTED;
+}
+
+void csnip_time_coarse_stop(void)
+{
+}
+
+#endif /* CSNIP_CONF__SUPPORT_THREADING */
+
+/* Precise sleeping */
+
+/* Busy-wait window, negative until calibrated */
+static long spin_ns = -1;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define spin_get()	__atomic_load_n(&spin_ns, __ATOMIC_RELAXED)
+#define spin_set(v)	__atomic_store_n(&spin_ns, (v), __ATOMIC_RELAXED)
+#else
+#define spin_get()	(*(volatile long*)&spin_ns)
+#define spin_set(v)	((void)(*(volatile long*)&spin_ns = (v)))
+#endif
+
+static void cpu_relax(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_ia32_pause();
+#elif defined(__GNUC__) && defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+int64_t csnip_time_mono_ns(void)
+{
+	return mono_ns();
+}
+
+/* Sleep until the deadline, without busy-waiting. */
+static int sleep_abs(int64_t deadline)
+{
+#if defined(CSNIP_CONF__HAVE_CLOCK_NANOSLEEP) \
+  && defined(CSNIP_X_CLOCK_MONOTONIC)
+	struct timespec ts;
+	ts.tv_sec = (time_t)(deadline / 1000000000);
+	ts.tv_nsec = (long)(deadline % 1000000000);
+	int r;
+	while ((r = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+			&ts, NULL)) == EINTR)
+	{
+		/* Restart; the deadline is absolute */
+	}
+	if (r != 0) {
+		errno = r;
+		return csnip_err_ERRNO;
+	}
+	return 0;
+#else
+	int64_t now;
+	while ((now = mono_ns()) < deadline) {
+		const int64_t d = deadline - now;
+		struct timespec ts;
+		ts.tv_sec = (time_t)(d / 1000000000);
+		ts.tv_nsec = (long)(d % 1000000000);
+		if (csnip_time_sleep(ts) != 0 && errno != EINTR)
+			return csnip_err_ERRNO;
+	}
+	return 0;
+#endif
+}
+
+/* Measure the worst oversleep of a few short sleeps, and derive the
+ * busy-wait window from it.
+ */
+static long spin_calibrate(void)
+{
+	int64_t worst = 0;
+	for (int i = 0; i < 5; ++i) {
+		const int64_t t = mono_ns() + 200000;
+		if (sleep_abs(t) != 0)
+			break;
+		const int64_t over = mono_ns() - t;
+		if (over > worst)
+			worst = over;
+	}
+
+	/* Add some margin, and bound the time spent spinning */
+	int64_t w = worst + worst / 2 + 2000;
+	if (w > 2000000)
+		w = 2000000;
+	spin_set((long)w);
+	return (long)w;
+}
+
+static void spin_init(void)
+{
+	if (spin_get() < 0)
+		spin_calibrate();
+}
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+static pthread_once_t spin_once = PTHREAD_ONCE_INIT;
+#define spin_ensure_init()	pthread_once(&spin_once, spin_init)
+#else
+#define spin_ensure_init()	spin_init()
+#endif
+
+long csnip_time_sleep_spin(long spin)
+{
+	if (spin < 0)
+		return spin_calibrate();
+	spin_set(spin);
+	return spin;
+}
+
+int csnip_time_sleep_until_ns(int64_t deadline)
+{
+	spin_ensure_init();
+	const int64_t wake = deadline - spin_get();
+	if (wake > mono_ns()) {
+		const int err = sleep_abs(wake);
+		if (err)
+			return err;
+	}
+	while (mono_ns() < deadline)
+		cpu_relax();
+	return 0;
+}
+
+int csnip_time_sleep_until(struct timespec deadline)
+{
+	return csnip_time_sleep_until_ns(ts_as_ns(deadline));
+}
+
+int csnip_time_set_timer_slack(unsigned long slack_ns)
+{
+#if defined(CSNIP_CONF__HAVE_SYS_PRCTL_H) && defined(PR_SET_TIMERSLACK)
+	if (prctl(PR_SET_TIMERSLACK, slack_ns, 0, 0, 0) != 0)
+		return csnip_err_ERRNO;
+	return 0;
+#else
+	(void)slack_ns;
+	return csnip_err_UNSUPPORTED;
+#endif
+}
+
+/* Pacing */
+
+/* Offset of the deadline n periods after the next one:  whole
+ * nanoseconds, and the fraction in *frac.
+ *
+ * n * period_frac can exceed 64 bits after a long stall; the high
+ * half of n contributes whole nanoseconds only.
+ */
+static int64_t pacer_offset(const csnip_time_pacer* P,
+			uint64_t n,
+			uint32_t* frac)
+{
+	const uint64_t f = (uint64_t)P->frac
+				+ (n & 0xFFFFFFFFu) * P->period_frac;
+	*frac = (uint32_t)f;
+	return (int64_t)n * P->period
+		+ (int64_t)((n >> 32) * P->period_frac)
+		+ (int64_t)(f >> 32);
+}
+
+/* Advance the deadline by n periods. */
+static void pacer_advance(csnip_time_pacer* P, uint64_t n)
+{
+	uint32_t frac;
+	P->next += pacer_offset(P, n, &frac);
+	P->frac = frac;
+}
+
+int csnip_time_pacer_init(csnip_time_pacer* P, double period_s)
+{
+	if (!(period_s > 0.0) || period_s > 9e9)
+		return csnip_err_INVAL;
+	const double ns = period_s * 1e9;
+	const double whole = floor(ns);
+	P->period = (int64_t)whole;
+	P->period_frac = (uint32_t)((ns - whole) * 4294967296.0);
+	if (P->period == 0)
+		return csnip_err_INVAL;
+	P->frac = 0;
+	P->ticks = 0;
+	P->missed = 0;
+	P->next = mono_ns();
+	pacer_advance(P, 1);
+	return 0;
+}
+
+int csnip_time_pacer_wait(csnip_time_pacer* P)
+{
+	const int64_t now = mono_ns();
+	if (now < P->next) {
+		const int err = csnip_time_sleep_until_ns(P->next);
+		if (err)
+			return err;
+	} else if (now - P->next >= P->period) {
+		/* Skip the deadlines missed entirely, i.e., the largest k
+		 * with next + k * period <= now.  The estimate in double
+		 * is off by a few periods at most.
+		 */
+		const int64_t late = now - P->next;
+		uint64_t k = (uint64_t)((double)late / ((double)P->period
+					+ P->period_frac / 4294967296.0));
+		uint32_t frac;
+		while (k > 0 && pacer_offset(P, k, &frac) > late)
+			--k;
+		while (pacer_offset(P, k + 1, &frac) <= late)
+			++k;
+		pacer_advance(P, k);
+		P->missed += k;
+	}
+	++P->ticks;
+	pacer_advance(P, 1);
+	return 0;
+}
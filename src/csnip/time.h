@@ -14,9 +14,17 @@
  *	to represent times.  This module provides a number of functions
  *	and macros to conveniently convert between the different time
  *	representations, as well as functions for sleeping, comparison
- *	of times, addition and subtraction of times.  The module does
- *	not, however, get times; e.g., we do not duplicate functionality
- *	for clock_gettime().
+ *	of times, addition and subtraction of times.  It does provide a
+ *	cycle counter with stopwatch and scoped timing facilities, for
+ *	measuring short durations cheaply.
+ *
+ *	Clock reads are provided where they add something to plain
+ *	clock_gettime():  the coarse clock (csnip_time_coarse_now())
+ *	gives the wall clock time (CSNIP_TIME_COARSE_REALTIME) or the
+ *	monotonic time at millisecond-scale resolution, read with a
+ *	single load while its refresh thread runs; and
+ *	csnip_time_mono_ns() reads the monotonic clock as a nanosecond
+ *	count, the unit of the deadline sleeps and the pacer.
  *
  *	The macro implementation is generic and can transparently handle
  *	the correct representation of time.
@@ -50,6 +58,7 @@
 
 #include <csnip/csnip_conf.h>
 
+#include <stdint.h>
 #include <time.h>
 
 #ifdef CSNIP_CONF__HAVE_SYS_TIME_H
@@ -252,6 +261,499 @@ struct timespec csnip_time_sub(struct timespec a, struct timespec b);
 	  csnip_time_AsTimespec(time_a), \
 	  csnip_time_AsTimespec(time_b))
 
+/** @name Cycle counter
+ *
+ *  csnip_time_cycles() reads the cheapest available high resolution
+ *  counter:  the time stamp counter (rdtsc) on x86, the virtual
+ *  counter (cntvct_el0) on AArch64, and clock_gettime() with a
+ *  monotonic clock, in nanoseconds, elsewhere.  Reading the hardware
+ *  counters costs a few nanoseconds, much less than a clock_gettime()
+ *  call.
+ *
+ *  The counter rate is calibrated against the monotonic clock once,
+ *  on first use of one of the conversion functions.  The calibration
+ *  takes a few milliseconds.
+ */
+/**@{*/
+
+/** @cond */
+#if (defined(__GNUC__) || defined(__clang__)) \
+  && (defined(__x86_64__) || defined(__i386__))
+#  define CSNIP_TIME__CYCLES_TSC
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+#  define CSNIP_TIME__CYCLES_CNTVCT
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+uint64_t csnip_time__cycles_fallback(void);
+#ifdef __cplusplus
+}
+#endif
+/** @endcond */
+
+/**	Read the cycle counter.
+ *
+ *	The read is not ordered with respect to surrounding
+ *	instructions; use it to mark the start of a timed region, and
+ *	csnip_time_cycles_fenced() to mark its end.
+ */
+inline uint64_t csnip_time_cycles(void)
+{
+#if defined(CSNIP_TIME__CYCLES_TSC)
+	uint32_t lo, hi;
+	__asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+#elif defined(CSNIP_TIME__CYCLES_CNTVCT)
+	uint64_t v;
+	__asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+	return v;
+#else
+	return csnip_time__cycles_fallback();
+#endif
+}
+
+/**	Read the cycle counter after preceding instructions completed.
+ *
+ *	On x86-64 this is lfence; rdtsc, which orders like rdtscp but is
+ *	available on all CPUs; on AArch64, isb; mrs.
+ */
+inline uint64_t csnip_time_cycles_fenced(void)
+{
+#if defined(CSNIP_TIME__CYCLES_TSC) \
+  && (defined(__x86_64__) || defined(__SSE2__))
+	uint32_t lo, hi;
+	__asm__ __volatile__("lfence\n\trdtsc"
+		: "=a"(lo), "=d"(hi) : : "memory");
+	return ((uint64_t)hi << 32) | lo;
+#elif defined(CSNIP_TIME__CYCLES_TSC)
+	uint32_t lo, hi;
+	__asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi) : : "memory");
+	return ((uint64_t)hi << 32) | lo;
+#elif defined(CSNIP_TIME__CYCLES_CNTVCT)
+	uint64_t v;
+	__asm__ __volatile__("isb\n\tmrs %0, cntvct_el0"
+		: "=r"(v) : : "memory");
+	return v;
+#else
+	return csnip_time__cycles_fallback();
+#endif
+}
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**	(Re-)calibrate the cycle counter.
+ *
+ *	Measures the counter rate against the monotonic clock over the
+ *	given number of seconds.  The calibration is done automatically
+ *	on first use (over 5 ms); calling this explicitly allows for a
+ *	more precise, longer calibration, which replaces the automatic
+ *	one, also if called before first use.  Not safe to call
+ *	concurrently with the conversion functions.
+ */
+void csnip_time_cycles_calibrate(double seconds);
+
+/**	Counter ticks per nanosecond. */
+double csnip_time_cycles_per_ns(void);
+
+/**	Convert a counter difference to nanoseconds. */
+double csnip_time_cycles_to_ns(uint64_t cycles);
+
+/**	Name of the counter source.
+ *
+ *	One of "tsc", "cntvct" or "clock_gettime".
+ */
+const char* csnip_time_cycles_source(void);
+
+/**	Check whether the counter runs at a constant rate.
+ *
+ *	For the TSC, this checks the invariant TSC CPUID flag; without
+ *	it, the TSC rate may change with frequency scaling and the TSC
+ *	may stop in deep sleep states.  The other sources always run at
+ *	a constant rate.
+ *
+ *	@return	1 if the rate is constant, 0 if not.
+ */
+int csnip_time_cycles_invariant(void);
+
+/**	Measure the counter drift since calibration.
+ *
+ *	Compares the counter rate observed since the calibration with
+ *	the calibrated rate.  A large drift indicates a non-invariant
+ *	counter, or that the thread was migrated between CPUs with
+ *	unsynchronized counters.
+ *
+ *	@return	the relative drift in parts per million.
+ */
+double csnip_time_cycles_drift_ppm(void);
+
+#ifdef __cplusplus
+}
+#endif
+/**@}*/
+
+/** @name Stopwatch
+ *
+ *  A stopwatch based on the cycle counter.  Times are reported in
+ *  nanoseconds.
+ *
+ *  ~~~{.c}
+ *  csnip_time_stopwatch sw;
+ *  csnip_time_StopwatchStart(&sw);
+ *  step1();
+ *  double t1 = csnip_time_StopwatchLap(&sw);
+ *  step2();
+ *  double t2 = csnip_time_StopwatchLap(&sw);
+ *  double total = csnip_time_StopwatchStop(&sw);
+ *  ~~~
+ */
+/**@{*/
+
+/** Stopwatch state. */
+typedef struct {
+	uint64_t start;		/**< Counter at start */
+	uint64_t lap;		/**< Counter at the last lap */
+} csnip_time_stopwatch;
+
+/** @cond */
+inline double csnip_time__stopwatch_lap(csnip_time_stopwatch* sw,
+					uint64_t now)
+{
+	const uint64_t d = now - sw->lap;
+	sw->lap = now;
+	return csnip_time_cycles_to_ns(d);
+}
+
+inline double csnip_time__stopwatch_stop(csnip_time_stopwatch* sw,
+					uint64_t now)
+{
+	sw->lap = now;
+	return csnip_time_cycles_to_ns(now - sw->start);
+}
+/** @endcond */
+
+/**	Start the stopwatch. */
+#define csnip_time_StopwatchStart(sw) \
+	((void)((sw)->start = (sw)->lap = csnip_time_cycles()))
+
+/**	Time since the last lap (or start) in nanoseconds.
+ *
+ *	Expression macro; also starts the next lap.
+ */
+#define csnip_time_StopwatchLap(sw) \
+	csnip_time__stopwatch_lap((sw), csnip_time_cycles_fenced())
+
+/**	Time since the start in nanoseconds.
+ *
+ *	Expression macro.  The stopwatch can be stopped several times;
+ *	each call reports the time since the start.
+ */
+#define csnip_time_StopwatchStop(sw) \
+	csnip_time__stopwatch_stop((sw), csnip_time_cycles_fenced())
+/**@}*/
+
+/** @name Scoped timing
+ *
+ *  Statement macros to time a block of code and feed the duration to
+ *  an accumulator.  The block must not leave the macro with break,
+ *  continue, return or goto, since then no time is recorded.
+ */
+/**@{*/
+
+/**	Time a block.
+ *
+ *	@param	ns
+ *		dummy variable; holds the elapsed time in nanoseconds
+ *		(a double) when @a sink is executed.
+ *
+ *	@param	sink
+ *		statement consuming the time ns.
+ *
+ *	@param	...
+ *		the statements to time.
+ */
+#define csnip_time_Scoped(ns, sink, ...) \
+	do { \
+		const uint64_t csnip__scoped_t0 = csnip_time_cycles(); \
+		__VA_ARGS__ \
+		const double ns = csnip_time_cycles_to_ns( \
+			csnip_time_cycles_fenced() - csnip__scoped_t0); \
+		sink; \
+	} while (0)
+
+/**	Time a block and add the duration to a meanvar accumulator.
+ *
+ *	@param	accumptr
+ *		pointer to a csnip_meanvar (or other meanvar accumulator,
+ *		see meanvar.h, which needs to be included).
+ */
+#define csnip_time_ScopedMeanvar(accumptr, ...) \
+	csnip_time_Scoped(csnip__scoped_ns, \
+		csnip_meanvar_Add((accumptr), csnip__scoped_ns), \
+		__VA_ARGS__)
+
+/**	Time a block and add the duration to a histogram. */
+#define csnip_time_ScopedHistogram(histptr, ...) \
+	csnip_time_Scoped(csnip__scoped_ns, \
+		csnip_time_histogram_add((histptr), csnip__scoped_ns), \
+		__VA_ARGS__)
+/**@}*/
+
+/** @name Duration histograms
+ *
+ *  Logarithmic histograms of durations, with bins of powers of 2
+ *  nanoseconds; these allow to estimate latency quantiles with little
+ *  overhead.
+ */
+/**@{*/
+
+/** Number of histogram bins. */
+#define CSNIP_TIME_HISTOGRAM_NBIN	64
+
+/** Duration histogram.
+ *
+ *  Bin 0 counts durations below 1 ns, bin i > 0 counts durations
+ *  in [2^(i-1), 2^i) ns.  Zero-initialize before use.
+ */
+typedef struct {
+	unsigned long long count[CSNIP_TIME_HISTOGRAM_NBIN];
+	unsigned long long n;	/**< Total number of samples */
+} csnip_time_histogram;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Add a duration (in ns) to the histogram. */
+void csnip_time_histogram_add(csnip_time_histogram* H, double ns);
+
+/** Estimate a quantile.
+ *
+ *  Returns the upper edge of the bin containing the q-quantile, i.e.
+ *  an upper bound that is within a factor of 2 of the actual
+ *  quantile; 0 if the histogram is empty.
+ */
+double csnip_time_histogram_quantile(const csnip_time_histogram* H,
+					double q);
+
+#ifdef __cplusplus
+}
+#endif
+/**@}*/
+
+/** @name Coarse clock
+ *
+ *  Cheap timestamps with millisecond-scale resolution, for callers
+ *  that read the clock at high rates but do not need precise times,
+ *  such as loggers.
+ *
+ *  While the refresh thread started by csnip_time_coarse_start() is
+ *  running, the current times are published as atomic 64 bit
+ *  nanosecond counts, and reading the clock is a single load.
+ *  Otherwise, the CLOCK_REALTIME_COARSE and CLOCK_MONOTONIC_COARSE
+ *  clocks are used where available (Linux), and the regular clocks
+ *  elsewhere.
+ */
+/**@{*/
+
+/** Coarse real time clock (time since the epoch). */
+#define CSNIP_TIME_COARSE_REALTIME	0
+/** Coarse monotonic clock. */
+#define CSNIP_TIME_COARSE_MONOTONIC	1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @cond */
+extern int64_t csnip_time__coarse_ns[2];
+int64_t csnip_time__coarse_slow(int clk);
+/** @endcond */
+
+/**	Start the coarse clock refresh thread.
+ *
+ *	@param	period_us
+ *		refresh period in microseconds; this is the resolution
+ *		of the coarse clock.  If the thread is already running,
+ *		only the period is changed.
+ *
+ *	@return	0 on success, csnip_err_INVAL for a non-positive
+ *		period, csnip_err_ERRNO if the thread could not be
+ *		created, or csnip_err_UNSUPPORTED if csnip was built
+ *		without threading support.
+ */
+int csnip_time_coarse_start(long period_us);
+
+/**	Stop the coarse clock refresh thread.
+ *
+ *	Subsequent reads fall back to the system's coarse clocks.
+ */
+void csnip_time_coarse_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**	Read the coarse clock in nanoseconds.
+ *
+ *	@param	clk
+ *		CSNIP_TIME_COARSE_REALTIME or
+ *		CSNIP_TIME_COARSE_MONOTONIC.
+ */
+inline int64_t csnip_time_coarse_now_ns(int clk)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	const int64_t v = __atomic_load_n(&csnip_time__coarse_ns[clk],
+				__ATOMIC_RELAXED);
+#else
+	const int64_t v = ((volatile int64_t*)csnip_time__coarse_ns)[clk];
+#endif
+	if (v != 0)
+		return v;
+	return csnip_time__coarse_slow(clk);
+}
+
+/**	Read the coarse clock as a struct timespec. */
+inline struct timespec csnip_time_coarse_now(int clk)
+{
+	const int64_t v = csnip_time_coarse_now_ns(clk);
+	struct timespec ts;
+	ts.tv_sec = (time_t)(v / 1000000000);
+	ts.tv_nsec = (long)(v % 1000000000);
+	return ts;
+}
+/**@}*/
+
+/** @name Precise sleeping
+ *
+ *  Sleeping with csnip_time_sleep() typically overshoots by 50 to
+ *  100 µs because of the kernel's timer slack and wakeup latency.
+ *  csnip_time_sleep_until() sleeps until shortly before an absolute
+ *  deadline, and busy-waits for the remainder.  The busy-wait window
+ *  is calibrated at first use by measuring the oversleep of a few
+ *  short sleeps.
+ *
+ *  Deadlines are given on the monotonic clock, i.e. the clock read by
+ *  csnip_x_clock_gettime(CSNIP_X_CLOCK_MAYBE_MONOTONIC, ...).
+ */
+/**@{*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**	Sleep until an absolute time on the monotonic clock.
+ *
+ *	Uses clock_nanosleep() with TIMER_ABSTIME where available, so
+ *	that the deadline does not drift when the sleep is interrupted
+ *	by signals; the last few microseconds before the deadline are
+ *	spent busy-waiting.
+ *
+ *	@return	0 on success, or csnip_err_ERRNO.
+ */
+int csnip_time_sleep_until(struct timespec deadline);
+
+/**	Sleep until an absolute monotonic time in nanoseconds. */
+int csnip_time_sleep_until_ns(int64_t deadline_ns);
+
+/**	Current monotonic time in nanoseconds. */
+int64_t csnip_time_mono_ns(void);
+
+/**	Set the busy-wait window of csnip_time_sleep_until().
+ *
+ *	@param	spin_ns
+ *		the window in nanoseconds; 0 disables busy-waiting, and
+ *		a negative value recalibrates the window.
+ *
+ *	@return	the window in effect.
+ */
+long csnip_time_sleep_spin(long spin_ns);
+
+/**	Set the calling thread's timer slack.
+ *
+ *	Linux by default lets sleeps of normal threads expire up to 50
+ *	µs late, so that wakeups can be coalesced.  Lower values make
+ *	sleeps more precise at a slight cost in power consumption.  The
+ *	setting is per thread; call csnip_time_sleep_spin(-1) afterwards
+ *	to recalibrate the busy-wait window for the new slack.
+ *
+ *	@param	slack_ns
+ *		the slack in nanoseconds; 0 resets to the default.
+ *
+ *	@return	0 on success, csnip_err_ERRNO, or
+ *		csnip_err_UNSUPPORTED on systems other than Linux.
+ */
+int csnip_time_set_timer_slack(unsigned long slack_ns);
+
+#ifdef __cplusplus
+}
+#endif
+/**@}*/
+
+/** @name Pacing
+ *
+ *  A pacer runs a loop at a fixed rate.  The deadlines are computed
+ *  from the start time and the tick count, rather than from the time
+ *  at which the previous iteration finished, so that the rate does
+ *  not drift:
+ *
+ *  ```
+ *  csnip_time_pacer P;
+ *  csnip_time_pacer_init(&P, 1e-3);	// 1 kHz
+ *  while (running) {
+ *  	csnip_time_pacer_wait(&P);
+ *  	send_packet();
+ *  }
+ *  ```
+ */
+/**@{*/
+
+/** Fixed rate pacer. */
+typedef struct {
+	int64_t next;		/**< Next deadline (monotonic ns) */
+	int64_t period;		/**< Period, whole nanoseconds */
+	uint32_t period_frac;	/**< Period, fraction in 2^-32 ns */
+	uint32_t frac;		/**< Accumulated deadline fraction */
+	uint64_t ticks;		/**< Number of completed waits */
+	uint64_t missed;	/**< Number of deadlines skipped */
+} csnip_time_pacer;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**	Initialize a pacer.
+ *
+ *	The first deadline is one period from now.
+ *
+ *	@param	period_s
+ *		the period in seconds, at least 1 ns.
+ *
+ *	@return	0 on success, or csnip_err_INVAL for a period shorter
+ *		than 1 ns.
+ */
+int csnip_time_pacer_init(csnip_time_pacer* P, double period_s);
+
+/**	Wait for the next deadline.
+ *
+ *	If the caller is late by less than a period, returns
+ *	immediately, so that the loop catches up.  If it is late by one
+ *	or more whole periods, the missed deadlines are skipped (and
+ *	counted in P->missed) rather than run in a burst; the phase of
+ *	the deadlines is kept.
+ *
+ *	@return	0 on success, or csnip_err_ERRNO.
+ */
+int csnip_time_pacer_wait(csnip_time_pacer* P);
+
+#ifdef __cplusplus
+}
+#endif
+/**@}*/
+
 /** @} */
 
 #endif /* CSNIP_TIME_H */
@@ -279,5 +781,37 @@ struct timespec csnip_time_sub(struct timespec a, struct timespec b);
 #define time_IsLessEqual		csnip_time_IsLessEqual
 #define time_Add			csnip_time_Add
 #define time_Sub			csnip_time_Sub
+#define time_cycles			csnip_time_cycles
+#define time_cycles_fenced		csnip_time_cycles_fenced
+#define time_cycles_calibrate		csnip_time_cycles_calibrate
+#define time_cycles_per_ns		csnip_time_cycles_per_ns
+#define time_cycles_to_ns		csnip_time_cycles_to_ns
+#define time_cycles_source		csnip_time_cycles_source
+#define time_cycles_invariant		csnip_time_cycles_invariant
+#define time_cycles_drift_ppm		csnip_time_cycles_drift_ppm
+#define time_stopwatch			csnip_time_stopwatch
+#define time_StopwatchStart		csnip_time_StopwatchStart
+#define time_StopwatchLap		csnip_time_StopwatchLap
+#define time_StopwatchStop		csnip_time_StopwatchStop
+#define time_Scoped			csnip_time_Scoped
+#define time_ScopedMeanvar		csnip_time_ScopedMeanvar
+#define time_ScopedHistogram		csnip_time_ScopedHistogram
+#define time_histogram			csnip_time_histogram
+#define time_histogram_add		csnip_time_histogram_add
+#define time_histogram_quantile		csnip_time_histogram_quantile
+#define TIME_COARSE_REALTIME		CSNIP_TIME_COARSE_REALTIME
+#define TIME_COARSE_MONOTONIC		CSNIP_TIME_COARSE_MONOTONIC
+#define time_coarse_start		csnip_time_coarse_start
+#define time_coarse_stop		csnip_time_coarse_stop
+#define time_coarse_now_ns		csnip_time_coarse_now_ns
+#define time_coarse_now			csnip_time_coarse_now
+#define time_sleep_until		csnip_time_sleep_until
+#define time_sleep_until_ns		csnip_time_sleep_until_ns
+#define time_mono_ns			csnip_time_mono_ns
+#define time_sleep_spin			csnip_time_sleep_spin
+#define time_set_timer_slack		csnip_time_set_timer_slack
+#define time_pacer			csnip_time_pacer
+#define time_pacer_init			csnip_time_pacer_init
+#define time_pacer_wait			csnip_time_pacer_wait
 #define CSNIP_TIME_HAVE_SHORT_NAMES
 #endif /* CSNIP_SHORT_NAMES && !CSNIP_TIME_HAVE_SHORT_NAMES */
@@ -0,0 +1,336 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/cpu.h>
+#include <csnip/err.h>
+#include <csnip/simd.h>
+#include <csnip/tokenize.h>
+
+extern inline int csnip_tokenize_set_has(const csnip_tokenize_set* S,
+					unsigned char c);
+
+void csnip_tokenize_set_init(tokenize_set* S, const char* chars)
+{
+	memset(S, 0, sizeof *S);
+	for (const char* p = chars; *p; ++p)
+		tokenize_set_add(S, (unsigned char)*p);
+}
+
+void csnip_tokenize_set_add(tokenize_set* S, unsigned char c)
+{
+	if (tokenize_set_has(S, c))
+		return;
+	S->bits[c >> 6] |= (uint64_t)1 << (c & 63);
+	if (S->nchars < 4)
+		S->chars[S->nchars] = c;
+	++S->nchars;
+
+	/* Each distinct high nibble gets a bucket bit; a byte is in the
+	 * set iff the bucket bits for its nibbles intersect.
+	 */
+	const int h = c >> 4;
+	if (S->hi[h] == 0) {
+		if (S->nbuckets >= 8) {
+			S->nbuckets = 9;
+			return;
+		}
+		S->hi[h] = (uint8_t)(1u << S->nbuckets++);
+	}
+	S->lo[c & 15] |= S->hi[h];
+}
+
+/* Scanning */
+
+static size_t find_scalar(const tokenize_set* S,
+			const char* p,
+			size_t i,
+			size_t len)
+{
+	const unsigned char* u = (const unsigned char*)p;
+	for (; i < len; ++i) {
+		if (tokenize_set_has(S, u[i]))
+			return i;
+	}
+	return len;
+}
+
+/* Vector scanning, instantiated for each simd.h backend.  The nibble
+ * method needs a fast shuffle; without one, sets of up to 4 bytes
+ * are matched by comparison.
+ */
+#define V(be, name)	csnip_simd_ ## be ## _ ## name
+
+#define DEFINE_FIND(be, W, target, fast_shuffle) \
+	target static size_t find_nibble_ ## be(const tokenize_set* S, \
+						const char* p, \
+						size_t len) \
+	{ \
+		const V(be, u8) lo_t = V(be, u8_load16)(S->lo); \
+		const V(be, u8) hi_t = V(be, u8_load16)(S->hi); \
+		const V(be, u8) m0f = V(be, u8_splat)(0x0f); \
+		const V(be, u8) zero = V(be, u8_splat)(0); \
+		size_t i = 0; \
+		for (; i + W <= len; i += W) { \
+			const V(be, u8) v = V(be, u8_load)(p + i); \
+			const V(be, u8) lo = V(be, u8_and)(v, m0f); \
+			const V(be, u8) hi = V(be, u8_shr)(v, 4); \
+			const V(be, u8) m = V(be, u8_and)( \
+				V(be, u8_shuffle)(lo_t, lo), \
+				V(be, u8_shuffle)(hi_t, hi)); \
+			const uint64_t bits = V(be, u8_movemask)( \
+						V(be, u8_gt)(m, zero)); \
+			if (bits) \
+				return i + (size_t)simd_mask_ctz(bits); \
+		} \
+		return find_scalar(S, p, i, len); \
+	} \
+	\
+	target static size_t find_cmp_ ## be(const tokenize_set* S, \
+						const char* p, \
+						size_t len) \
+	{ \
+		/* Pad to 4 characters by repeating the first one */ \
+		V(be, u8) c[4]; \
+		for (int k = 0; k < 4; ++k) { \
+			const int j = (k < S->nchars ? k : 0); \
+			c[k] = V(be, u8_splat)(S->chars[j]); \
+		} \
+		size_t i = 0; \
+		for (; i + W <= len; i += W) { \
+			const V(be, u8) v = V(be, u8_load)(p + i); \
+			const V(be, u8) m = V(be, u8_or)( \
+				V(be, u8_or)(V(be, u8_eq)(v, c[0]), \
+						V(be, u8_eq)(v, c[1])), \
+				V(be, u8_or)(V(be, u8_eq)(v, c[2]), \
+						V(be, u8_eq)(v, c[3]))); \
+			const uint64_t bits = V(be, u8_movemask)(m); \
+			if (bits) \
+				return i + (size_t)simd_mask_ctz(bits); \
+		} \
+		return find_scalar(S, p, i, len); \
+	} \
+	\
+	static size_t find_ ## be(const tokenize_set* S, \
+				const char* p, \
+				size_t len) \
+	{ \
+		if (S->nchars == 0) \
+			return len; \
+		if (fast_shuffle && S->nbuckets <= 8) \
+			return find_nibble_ ## be(S, p, len); \
+		if (S->nchars <= 4) \
+			return find_cmp_ ## be(S, p, len); \
+		return find_scalar(S, p, 0, len); \
+	}
+
+static size_t find_portable(const tokenize_set* S,
+				const char* p,
+				size_t len)
+{
+	return find_scalar(S, p, 0, len);
+}
+
+#if defined(CSNIP_SIMD_HAVE_SSE2)
+DEFINE_FIND(sse2, 16, CSNIP_SIMD_TARGET_SSE2, CSNIP_SIMD_SSE2_FAST_SHUFFLE)
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX2)
+DEFINE_FIND(avx2, 32, CSNIP_SIMD_TARGET_AVX2, 1)
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX512)
+DEFINE_FIND(avx512, 64, CSNIP_SIMD_TARGET_AVX512, 1)
+#endif
+#if defined(CSNIP_SIMD_HAVE_NEON)
+DEFINE_FIND(neon, 16, , 1)
+#endif
+
+typedef size_t find_fn(const tokenize_set* S, const char* p, size_t len);
+
+static find_fn* resolve_find(void)
+{
+	const int level = csnip_cpu__level();
+	(void)level;
+#if defined(CSNIP_SIMD_HAVE_AVX512)
+	if (level >= CSNIP_CPU_LEVEL_AVX512)
+		return find_avx512;
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX2)
+	if (level >= CSNIP_CPU_LEVEL_AVX2)
+		return find_avx2;
+#endif
+#if defined(CSNIP_SIMD_HAVE_SSE2)
+	if (level >= CSNIP_CPU_LEVEL_SSE2)
+		return find_sse2;
+#endif
+#if defined(CSNIP_SIMD_HAVE_NEON)
+	if (level >= CSNIP_CPU_LEVEL_NEON)
+		return find_neon;
+#endif
+	return find_portable;
+}
+
+csnip_cpu_Dispatch(size_t, csnip_tokenize_find,
+	(const tokenize_set* S, const char* p, size_t len), (S, p, len),
+	resolve_find)
+
+/* Tokenizing */
+
+char* csnip_tokenize_strtok(char* str,
+			const tokenize_set* delim,
+			char** saveptr)
+{
+	char* p = (str ? str : *saveptr);
+	if (p == NULL)
+		return NULL;
+
+	/* Skip initial delimiters */
+	while (*p && tokenize_set_has(delim, (unsigned char)*p))
+		++p;
+	if (*p == '\0') {
+		*saveptr = NULL;
+		return NULL;
+	}
+
+	/* Find the next delimiter */
+	char* q = p + 1;
+	while (*q && !tokenize_set_has(delim, (unsigned char)*q))
+		++q;
+
+	if (*q == '\0') {
+		*saveptr = NULL;
+	} else {
+		*q = '\0';
+		*saveptr = q + 1;
+	}
+	return p;
+}
+
+size_t csnip_tokenize_split(const tokenize_set* delim,
+			const char* line,
+			size_t len,
+			tokenize_span* fields,
+			size_t max)
+{
+	size_t n = 0;
+	size_t i = 0;
+	while (1) {
+		const size_t k = tokenize_find(delim, line + i, len - i);
+		if (n < max) {
+			fields[n].ptr = line + i;
+			fields[n].len = k;
+		}
+		++n;
+		i += k;
+		if (i >= len)
+			break;
+		++i;	/* Skip the delimiter */
+	}
+	return n;
+}
+
+/* CSV */
+
+void csnip_tokenize_csv_init(tokenize_csv* C, char sep, char quote)
+{
+	const char special[] = { sep, quote, '\r', '\n', '\0' };
+	tokenize_set_init(&C->special, special);
+	C->sep = sep;
+	C->quote = quote;
+}
+
+/* Find the end of unquoted text: a separator, a line break, or the
+ * end of the buffer.  Quote characters and lone '\r's are literal
+ * here.
+ */
+static size_t scan_plain(const tokenize_csv* C,
+			const char* buf,
+			size_t i,
+			size_t len)
+{
+	while (i < len) {
+		i += tokenize_find(&C->special, buf + i, len - i);
+		if (i == len)
+			break;
+		const char c = buf[i];
+		if (c == C->sep || c == '\n'
+		  || (c == '\r' && (i + 1 == len || buf[i + 1] == '\n')))
+		{
+			break;
+		}
+		++i;
+	}
+	return i;
+}
+
+int csnip_tokenize_csv_record(const tokenize_csv* C,
+			char* buf,
+			size_t len,
+			tokenize_span* fields,
+			size_t max,
+			size_t* nfields,
+			size_t* used)
+{
+	size_t n = 0;
+	size_t i = 0;
+	while (1) {
+		char* const start = buf + i;
+		size_t flen;
+		if (i < len && buf[i] == C->quote) {
+			/* Quoted field: unquote in place */
+			char* out = start;
+			size_t r = i + 1;
+			while (1) {
+				const char* q = memchr(buf + r, C->quote,
+							len - r);
+				if (q == NULL)
+					return csnip_err_FORMAT;
+				const size_t k = (size_t)(q - (buf + r));
+				memmove(out, buf + r, k);
+				out += k;
+				r += k + 1;
+				if (r < len && buf[r] == C->quote) {
+					*out++ = C->quote;
+					++r;
+					continue;
+				}
+				break;
+			}
+
+			/* Keep any text after the closing quote */
+			const size_t e = scan_plain(C, buf, r, len);
+			memmove(out, buf + r, e - r);
+			out += e - r;
+			flen = (size_t)(out - start);
+			i = e;
+		} else {
+			const size_t e = scan_plain(C, buf, i, len);
+			flen = e - i;
+			i = e;
+		}
+
+		if (n < max) {
+			fields[n].ptr = start;
+			fields[n].len = flen;
+		}
+		++n;
+
+		if (i == len)
+			break;
+		if (buf[i] == C->sep) {
+			++i;
+			continue;
+		}
+
+		/* Line break */
+		if (buf[i] == '\r')
+			++i;
+		if (i < len && buf[i] == '\n')
+			++i;
+		break;
+	}
+
+	*nfields = n;
+	*used = i;
+	return 0;
+}
@@ -0,0 +1,198 @@
+#ifndef CSNIP_TOKENIZE_H
+#define CSNIP_TOKENIZE_H
+
+/**	@file tokenize.h
+ *	@brief			Delimited text tokenizer
+ *	@defgroup tokenize	Delimited text tokenizer
+ *	@{
+ *
+ *	Splits delimited text (TSV, CSV, whitespace separated records)
+ *	into fields.
+ *
+ *	The delimiters are kept in a character set with a 256 bit
+ *	membership table, built once and reused across calls, so that
+ *	classifying a byte costs a single table lookup regardless of
+ *	the number of delimiters.  Scanning for the next delimiter uses
+ *	the widest backend of simd.h that the CPU supports, selected at
+ *	load time (see cpu.h):
+ *
+ *	* Where the backend has a fast byte shuffle (SSSE3, AVX2,
+ *	  AVX-512, NEON), bytes are classified a vector at a time with a
+ *	  pair of nibble table lookups.  This works for sets whose bytes
+ *	  have at most 8 distinct high nibbles, which includes all sets
+ *	  of up to 8 bytes.
+ *
+ *	* Otherwise (e.g., SSE2 only), sets of up to 4 bytes are
+ *	  matched by comparison.
+ *
+ *	* Otherwise, the scalar table lookup is used.
+ *
+ *	Fields are returned as (pointer, length) spans into the input
+ *	buffer, without copying.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Character set.
+ *
+ *  Initialize with csnip_tokenize_set_init(); the members are
+ *  internal.
+ */
+typedef struct {
+	/** @cond */
+	uint64_t bits[4];	/* Membership bitmap */
+	uint8_t lo[16];		/* Bucket masks by low nibble */
+	uint8_t hi[16];		/* Bucket bit by high nibble */
+	uint8_t chars[4];	/* Members, for the compare method */
+	int nbuckets;		/* Distinct high nibbles; > 8: no PSHUFB */
+	int nchars;		/* Number of members; > 4: no compare */
+	/** @endcond */
+} csnip_tokenize_set;
+
+/** Field span. */
+typedef struct {
+	const char* ptr;	/**< Start of the field */
+	size_t len;		/**< Length of the field */
+} csnip_tokenize_span;
+
+/** @name Character sets */
+/**@{*/
+
+/**	Initialize a set with the characters in a string. */
+void csnip_tokenize_set_init(csnip_tokenize_set* S, const char* chars);
+
+/**	Add a byte to a set. */
+void csnip_tokenize_set_add(csnip_tokenize_set* S, unsigned char c);
+
+/**	Test whether a byte is in a set. */
+inline int csnip_tokenize_set_has(const csnip_tokenize_set* S,
+					unsigned char c)
+{
+	return (int)((S->bits[c >> 6] >> (c & 63)) & 1);
+}
+/**@}*/
+
+/** @name Tokenizing */
+/**@{*/
+
+/**	Find the first byte in a set.
+ *
+ *	@return	the offset of the first byte of p[0 .. len) that is in
+ *		@a S, or @a len if there is none.
+ */
+size_t csnip_tokenize_find(const csnip_tokenize_set* S,
+			const char* p,
+			size_t len);
+
+/**	Reentrant strtok().
+ *
+ *	Same semantics as strtok_r(), but with the delimiters given as
+ *	a set.  Leading delimiters are skipped, and the delimiter
+ *	following the token is overwritten with '\\0'.
+ */
+char* csnip_tokenize_strtok(char* str,
+			const csnip_tokenize_set* delim,
+			char** saveptr);
+
+/**	Split a line into fields.
+ *
+ *	Every byte in @a delim separates two fields, so that adjacent
+ *	delimiters delimit an empty field (as in TSV), and a line of
+ *	length 0 consists of one empty field.
+ *
+ *	@param	fields
+ *		array for the fields; at most @a max are stored.
+ *
+ *	@return	the number of fields in the line, which may exceed
+ *		@a max.
+ */
+size_t csnip_tokenize_split(const csnip_tokenize_set* delim,
+			const char* line,
+			size_t len,
+			csnip_tokenize_span* fields,
+			size_t max);
+/**@}*/
+
+/** @name CSV */
+/**@{*/
+
+/** CSV dialect. */
+typedef struct {
+	/** @cond */
+	csnip_tokenize_set special;	/* sep, quote, '\r', '\n' */
+	char sep;
+	char quote;
+	/** @endcond */
+} csnip_tokenize_csv;
+
+/**	Initialize a CSV dialect.
+ *
+ *	@param	sep
+ *		the field separator, typically ','.
+ *
+ *	@param	quote
+ *		the quote character, typically '"'.
+ */
+void csnip_tokenize_csv_init(csnip_tokenize_csv* C, char sep, char quote);
+
+/**	Parse a CSV record.
+ *
+ *	Parses the record at the beginning of buf[0 .. len), which ends
+ *	with an unquoted line break ("\n" or "\r\n") or with the end of
+ *	the buffer.  Quoted fields may contain separators and line
+ *	breaks, and doubled quote characters stand for a single one;
+ *	they are unquoted in place, so that the buffer is modified, and
+ *	the spans point to the unquoted contents.
+ *
+ *	@param	fields
+ *		array for the fields; at most @a max are stored.
+ *
+ *	@param	nfields
+ *		the number of fields in the record is returned here; it
+ *		may exceed @a max.
+ *
+ *	@param	used
+ *		the length of the record, including the line break, is
+ *		returned here.  The next record begins at buf + *used.
+ *
+ *	@return	0 on success, or csnip_err_FORMAT if the buffer ends
+ *		within a quoted field.  The fields before it may have
+ *		been unquoted already in that case, so the record must
+ *		be read again before retrying with more data.
+ */
+int csnip_tokenize_csv_record(const csnip_tokenize_csv* C,
+			char* buf,
+			size_t len,
+			csnip_tokenize_span* fields,
+			size_t max,
+			size_t* nfields,
+			size_t* used);
+/**@}*/
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* CSNIP_TOKENIZE_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_TOKENIZE_HAVE_SHORT_NAMES)
+#define tokenize_set			csnip_tokenize_set
+#define tokenize_span			csnip_tokenize_span
+#define tokenize_set_init		csnip_tokenize_set_init
+#define tokenize_set_add		csnip_tokenize_set_add
+#define tokenize_set_has		csnip_tokenize_set_has
+#define tokenize_find			csnip_tokenize_find
+#define tokenize_strtok			csnip_tokenize_strtok
+#define tokenize_split			csnip_tokenize_split
+#define tokenize_csv			csnip_tokenize_csv
+#define tokenize_csv_init		csnip_tokenize_csv_init
+#define tokenize_csv_record		csnip_tokenize_csv_record
+#define CSNIP_TOKENIZE_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_TOKENIZE_HAVE_SHORT_NAMES */
@@ -0,0 +1,408 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/csnip_conf.h>
+#include <csnip/err.h>
+#include <csnip/mem.h>
+#include <csnip/ringbuf2.h>
+#include <csnip/time.h>
+#include <csnip/trace.h>
+#include <csnip/util.h>
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+#include <pthread.h>
+#endif
+#ifdef CSNIP_CONF__HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+/* Event record */
+typedef struct {
+	uint64_t ts;		/* Cycle counter */
+	const char* name;
+	union {
+		uint64_t dur;	/* 'X':  duration in cycles */
+		double value;	/* 'C':  counter value */
+	} arg;
+	uint32_t ph;		/* Phase:  'B', 'E', 'X', 'i' or 'C' */
+	uint32_t seq;		/* Index + 1, or 0 while being written */
+} event;
+
+/* Per thread buffer.
+ *
+ * The recording thread writes the events and advances rb.n_written;
+ * the dumping thread reads them and advances rb.n_read.  Unlike with
+ * csnip_ringbuf2_add_written(), the writer leaves n_read alone when
+ * overwriting; the dump skips the overwritten events instead.  Each
+ * event's seq works as a seqlock, so that the dump can tell events
+ * that were overwritten while it copied them.
+ */
+typedef struct buffer_s buffer;
+struct buffer_s {
+	ringbuf2 rb;
+	event* ev;
+	unsigned tid;
+	int dead;		/* Thread exited */
+	char name[32];
+	buffer* next;
+};
+
+static int enabled;
+static size_t buf_cap;
+static uint64_t t_base;
+
+/* Registry of all buffers, and the calling thread's buffer */
+static buffer* buffers;
+static unsigned n_threads;
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+static pthread_mutex_t reg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t key;
+#if defined(__GNUC__) || defined(__clang__)
+/* Initial exec avoids a __tls_get_addr() call per event in the shared
+ * library; a pointer fits the static TLS space reserved for dlopen().
+ */
+static _Thread_local buffer* tls __attribute__((tls_model("initial-exec")));
+#else
+static _Thread_local buffer* tls;
+#endif
+#define reg_lock()	pthread_mutex_lock(&reg_mutex)
+#define reg_unlock()	pthread_mutex_unlock(&reg_mutex)
+#else
+static buffer* tls;
+#define reg_lock()	((void)0)
+#define reg_unlock()	((void)0)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define load_relaxed(p)		__atomic_load_n((p), __ATOMIC_RELAXED)
+#define load_acquire(p)		__atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define store_relaxed(p, v)	__atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define store_release(p, v)	__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define fence_acquire()		__atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define fence_release()		__atomic_thread_fence(__ATOMIC_RELEASE)
+#else
+#define load_relaxed(p)		(*(p))
+#define load_acquire(p)		(*(p))
+#define store_relaxed(p, v)	((void)(*(p) = (v)))
+#define store_release(p, v)	((void)(*(p) = (v)))
+#define fence_acquire()		((void)0)
+#define fence_release()		((void)0)
+#endif
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+/* Thread exit:  keep the buffer until its events are dumped */
+static void thread_exit(void* p)
+{
+	buffer* b = p;
+	reg_lock();
+	b->dead = 1;
+	reg_unlock();
+	tls = NULL;
+}
+
+static void make_key(void)
+{
+	pthread_key_create(&key, thread_exit);
+}
+#endif
+
+static buffer* register_thread(void)
+{
+	int err = 0;
+	buffer* b;
+	mem_Alloc(1, b, err);
+	if (err)
+		return NULL;
+	const size_t cap = ringbuf2_init(&b->rb, load_relaxed(&buf_cap));
+	mem_Alloc(cap, b->ev, err);
+	if (err) {
+		mem_Free(b);
+		return NULL;
+	}
+	b->dead = 0;
+	b->name[0] = '\0';
+
+	reg_lock();
+	b->tid = ++n_threads;
+	b->next = buffers;
+	buffers = b;
+	reg_unlock();
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_setspecific(key, b);
+#endif
+	tls = b;
+	return b;
+}
+
+/* Append an event to the thread's buffer */
+static void record(uint32_t ph, const char* name, uint64_t ts, uint64_t arg)
+{
+	buffer* b = tls;
+	if (b == NULL) {
+		b = register_thread();
+		if (b == NULL)
+			return;
+	}
+
+	const size_t n = b->rb.n_written;
+	event* e = &b->ev[n & (b->rb.cap - 1)];
+	store_relaxed(&e->seq, 0);
+	fence_release();
+	e->ts = ts;
+	e->name = name;
+	e->arg.dur = arg;
+	e->ph = ph;
+	store_release(&e->seq, (uint32_t)(n + 1));
+	store_release(&b->rb.n_written, n + 1);
+}
+
+int csnip_trace_enable(size_t cap)
+{
+	if (cap == 0)
+		return csnip_err_INVAL;
+
+	/* Calibrate now rather than in the first dump */
+	csnip_time_cycles_per_ns();
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	pthread_once(&key_once, make_key);
+#endif
+
+	reg_lock();
+	if (t_base == 0)
+		t_base = csnip_time_cycles();
+	reg_unlock();
+	store_relaxed(&buf_cap, cap);
+	store_relaxed(&enabled, 1);
+	return 0;
+}
+
+void csnip_trace_disable(void)
+{
+	store_relaxed(&enabled, 0);
+}
+
+void csnip_trace_thread_name(const char* name)
+{
+	if (!load_relaxed(&enabled))
+		return;
+	buffer* b = tls;
+	if (b == NULL) {
+		b = register_thread();
+		if (b == NULL)
+			return;
+	}
+	reg_lock();
+	strncpy(b->name, name, sizeof(b->name) - 1);
+	b->name[sizeof(b->name) - 1] = '\0';
+	reg_unlock();
+}
+
+void csnip_trace_begin(const char* name)
+{
+	if (load_relaxed(&enabled))
+		record('B', name, csnip_time_cycles(), 0);
+}
+
+void csnip_trace_end(const char* name)
+{
+	if (load_relaxed(&enabled))
+		record('E', name, csnip_time_cycles(), 0);
+}
+
+void csnip_trace_instant(const char* name)
+{
+	if (load_relaxed(&enabled))
+		record('i', name, csnip_time_cycles(), 0);
+}
+
+void csnip_trace_counter(const char* name, double value)
+{
+	if (load_relaxed(&enabled)) {
+		uint64_t v;
+		memcpy(&v, &value, sizeof v);
+		record('C', name, csnip_time_cycles(), v);
+	}
+}
+
+uint64_t csnip_trace__scope_begin(void)
+{
+	return load_relaxed(&enabled) ? csnip_time_cycles() : 0;
+}
+
+void csnip_trace__scope_end(csnip_trace__scope* S)
+{
+	if (S->t0 != 0 && load_relaxed(&enabled)) {
+		const uint64_t t1 = csnip_time_cycles();
+		record('X', S->name, S->t0, t1 - S->t0);
+	}
+}
+
+/* Dump */
+
+static void put_str(FILE* fp, const char* s)
+{
+	putc('"', fp);
+	for (; *s; ++s) {
+		const unsigned char c = (unsigned char)*s;
+		if (c == '"' || c == '\\')
+			fprintf(fp, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(fp, "\\u%04x", c);
+		else
+			putc(c, fp);
+	}
+	putc('"', fp);
+}
+
+/* Start a record of the trace events array */
+static void put_sep(FILE* fp, int* nrec)
+{
+	fputs(*nrec > 0 ? ",\n" : "\n", fp);
+	++*nrec;
+}
+
+static void put_event(FILE* fp,
+		int* nrec,
+		const event* e,
+		long pid,
+		unsigned tid,
+		double cycles_per_us)
+{
+	const double ts = (double)(int64_t)(e->ts - t_base) / cycles_per_us;
+	put_sep(fp, nrec);
+	fputs("{\"name\": ", fp);
+	put_str(fp, e->name);
+	fprintf(fp, ", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": %ld, "
+		"\"tid\": %u", (char)e->ph, ts, pid, tid);
+	switch (e->ph) {
+	case 'X':
+		fprintf(fp, ", \"dur\": %.3f",
+			(double)e->arg.dur / cycles_per_us);
+		break;
+	case 'i':
+		fputs(", \"s\": \"t\"", fp);
+		break;
+	case 'C':
+		fprintf(fp, ", \"args\": {\"value\": %.17g}", e->arg.value);
+		break;
+	}
+	putc('}', fp);
+}
+
+/* A thread's part of the dump snapshot */
+typedef struct {
+	unsigned tid;
+	char name[32];
+	size_t first;		/* Index of the first event in the copy */
+	size_t n;		/* Number of events */
+} thread_snap;
+
+int csnip_trace_dump(FILE* fp)
+{
+	const double cycles_per_us = csnip_time_cycles_per_ns() * 1000.0;
+#ifdef CSNIP_CONF__HAVE_UNISTD_H
+	const long pid = (long)getpid();
+#else
+	const long pid = 1;
+#endif
+	int err = 0;
+	thread_snap* thr = NULL;
+	size_t nthr = 0, thr_cap = 0;
+	event* copy = NULL;
+	size_t ncopy = 0, copy_cap = 0;
+
+	/* Snapshot the buffers; the output is written without the lock,
+	 * so that new threads need not wait for it.
+	 */
+	reg_lock();
+	buffer** p = &buffers;
+	while (*p) {
+		buffer* b = *p;
+		const size_t cap = b->rb.cap;
+
+		const size_t n_written = load_acquire(&b->rb.n_written);
+		size_t first = b->rb.n_read;
+		if (n_written - first > cap)
+			first = n_written - cap;
+		const size_t n = n_written - first;
+		if (nthr == thr_cap) {
+			const size_t new_cap = (thr_cap ? 2 * thr_cap : 16);
+			mem_Realloc(new_cap, thr, err);
+			if (err)
+				break;
+			thr_cap = new_cap;
+		}
+		if (n > copy_cap - ncopy) {
+			const size_t new_cap = csnip_Max(2 * copy_cap,
+							ncopy + n);
+			mem_Realloc(new_cap, copy, err);
+			if (err)
+				break;
+			copy_cap = new_cap;
+		}
+
+		/* Copy the events that were not overwritten */
+		thread_snap* t = &thr[nthr++];
+		t->tid = b->tid;
+		memcpy(t->name, b->name, sizeof t->name);
+		t->first = ncopy;
+		for (size_t i = first; i != n_written; ++i) {
+			const event* e = &b->ev[i & (cap - 1)];
+			const uint32_t seq = load_acquire(&e->seq);
+			copy[ncopy] = *e;
+			fence_acquire();
+			if (seq == (uint32_t)(i + 1)
+			  && load_relaxed(&e->seq) == seq)
+			{
+				++ncopy;
+			}
+		}
+		t->n = ncopy - t->first;
+		b->rb.n_read = n_written;
+
+		if (b->dead) {
+			*p = b->next;
+			mem_Free(b->ev);
+			mem_Free(b);
+		} else {
+			p = &b->next;
+		}
+	}
+	reg_unlock();
+
+	int nrec = 0;
+	fputs("{\"traceEvents\": [", fp);
+	for (size_t k = 0; k < nthr; ++k) {
+		const thread_snap* t = &thr[k];
+		put_sep(fp, &nrec);
+		fprintf(fp, "{\"name\": \"thread_name\", \"ph\": \"M\", "
+			"\"pid\": %ld, \"tid\": %u, \"args\": {\"name\": ",
+			pid, t->tid);
+		if (t->name[0]) {
+			put_str(fp, t->name);
+		} else {
+			fprintf(fp, "\"thread %u\"", t->tid);
+		}
+		fputs("}}", fp);
+
+		for (size_t i = t->first; i < t->first + t->n; ++i) {
+			put_event(fp, &nrec, &copy[i], pid, t->tid,
+				cycles_per_us);
+		}
+	}
+	fputs("\n],\n\"displayTimeUnit\": \"ns\"\n}\n", fp);
+	mem_Free(copy);
+	mem_Free(thr);
+
+	if (err)
+		return err;
+	if (ferror(fp) || fflush(fp) != 0)
+		return csnip_err_ERRNO;
+	return 0;
+}
@@ -0,0 +1,228 @@
+#ifndef CSNIP_TRACE_H
+#define CSNIP_TRACE_H
+
+/**	@file trace.h
+ *	@brief			Tracing
+ *	@defgroup trace		Tracing
+ *	@{
+ *
+ *	Records where time goes in a program, as a timeline of named
+ *	spans, instants and counter values per thread, which can be
+ *	viewed in chrome://tracing or Perfetto (ui.perfetto.dev).
+ *
+ *	Events are fixed size binary records, time stamped with the
+ *	cycle counter (csnip_time_cycles()), and appended to a ring
+ *	buffer of the recording thread without taking locks.  Only a
+ *	thread's first event, which registers its buffer, briefly takes
+ *	the lock of the buffer registry.  The ring buffers have the
+ *	overwrite semantics of csnip_ringbuf2_add_written():  when a
+ *	buffer is full, the oldest events are overwritten, so that a
+ *	trace shows the most recent history.  Recording an event costs
+ *	a few nanoseconds on top of reading the cycle counter; a span
+ *	recorded with CSNIP_TRACE_SCOPE() reads the counter twice.
+ *
+ *	Event names must be strings with static lifetime, ideally string
+ *	literals; only the pointers are recorded.
+ *
+ *	@code{.c}
+ *	csnip_trace_enable(1 << 16);
+ *	...
+ *	void process(batch* b)
+ *	{
+ *		CSNIP_TRACE_SCOPE("process");
+ *		CSNIP_TRACE_COUNTER("batch size", b->n);
+ *		...
+ *	}
+ *	...
+ *	FILE* fp = fopen("trace.json", "w");
+ *	csnip_trace_dump(fp);
+ *	fclose(fp);
+ *	@endcode
+ *
+ *	The tracing macros can be compiled out by defining
+ *	CSNIP_TRACE_LEVEL to 0; then they expand to nothing, and their
+ *	arguments are not evaluated.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef CSNIP_TRACE_LEVEL
+/**	Compiled-in tracing.
+ *
+ *	This macro is only defined if not already predefined.  If 0,
+ *	the CSNIP_TRACE_* macros compile to nothing; if 1, they record
+ *	events while tracing is enabled with csnip_trace_enable().
+ */
+#define CSNIP_TRACE_LEVEL	1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @name Control */
+/**@{*/
+
+/**	Enable recording.
+ *
+ *	@param	cap
+ *		the number of events each thread's ring buffer holds,
+ *		rounded up to a power of 2.  Each event takes 32 bytes.
+ *		Buffers are allocated on the first event of each thread;
+ *		threads that already have a buffer keep it.
+ *
+ *	@return	0 on success, or csnip_err_INVAL if cap is 0.
+ */
+int csnip_trace_enable(size_t cap);
+
+/**	Disable recording.
+ *
+ *	The recorded events are kept, and can still be dumped.
+ */
+void csnip_trace_disable(void);
+
+/**	Set the calling thread's name in the trace.
+ *
+ *	The name is copied, and truncated to 31 characters.  Has no
+ *	effect if tracing is not enabled.
+ */
+void csnip_trace_thread_name(const char* name);
+
+/**	Write the recorded events as a Chrome trace.
+ *
+ *	Writes the events of all threads in the Chrome JSON trace event
+ *	format, and removes them from the buffers.  Can be called while
+ *	other threads are recording; events being overwritten during the
+ *	dump are left out.  The buffers of threads that exited are freed
+ *	once dumped.  The registry lock is held while the events are
+ *	copied, but not while they are written to @a fp.
+ *
+ *	@return	0 on success, csnip_err_NOMEM if memory could not be
+ *		allocated, or csnip_err_ERRNO if writing failed.
+ */
+int csnip_trace_dump(FILE* fp);
+/**@}*/
+
+/** @name Events
+ *
+ *  Record events, if tracing is enabled.  These are the functions
+ *  behind the CSNIP_TRACE_* macros; the macros should be preferred,
+ *  since they can be compiled out.
+ */
+/**@{*/
+
+/**	Begin a span. */
+void csnip_trace_begin(const char* name);
+
+/**	End the span most recently begun in this thread. */
+void csnip_trace_end(const char* name);
+
+/**	Record an instant. */
+void csnip_trace_instant(const char* name);
+
+/**	Record a counter value. */
+void csnip_trace_counter(const char* name, double value);
+/**@}*/
+
+/** @cond */
+typedef struct {
+	const char* name;
+	uint64_t t0;		/* 0 if not recording */
+} csnip_trace__scope;
+
+uint64_t csnip_trace__scope_begin(void);
+void csnip_trace__scope_end(csnip_trace__scope* S);
+/** @endcond */
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @name Tracing macros */
+/**@{*/
+
+/** @cond */
+#define CSNIP_TRACE__CAT(a, b)		CSNIP_TRACE__CAT2(a, b)
+#define CSNIP_TRACE__CAT2(a, b)		a##b
+#ifdef __COUNTER__
+#define CSNIP_TRACE__VAR	CSNIP_TRACE__CAT(csnip__trace_, __COUNTER__)
+#else
+#define CSNIP_TRACE__VAR	CSNIP_TRACE__CAT(csnip__trace_, __LINE__)
+#endif
+
+#if defined(__cplusplus)
+struct csnip_trace__guard {
+	csnip_trace__scope S;
+	explicit csnip_trace__guard(const char* name)
+	{
+		S.name = name;
+		S.t0 = csnip_trace__scope_begin();
+	}
+	~csnip_trace__guard() { csnip_trace__scope_end(&S); }
+};
+#endif
+/** @endcond */
+
+#if CSNIP_TRACE_LEVEL > 0
+
+/**	Trace the enclosing block.
+ *
+ *	Declaration macro:  records a span from this point to the end of
+ *	the enclosing block, as a single event written at the end.  The
+ *	span ends however the block is left, including by return or
+ *	break.  This requires C++, or the cleanup attribute of GCC and
+ *	Clang; with other C compilers, only an instant is recorded.
+ */
+#if defined(__cplusplus)
+#define CSNIP_TRACE_SCOPE(name) \
+	csnip_trace__guard CSNIP_TRACE__VAR(name)
+#elif defined(__GNUC__) || defined(__clang__)
+#define CSNIP_TRACE_SCOPE(name) \
+	csnip_trace__scope CSNIP_TRACE__VAR \
+		__attribute__((cleanup(csnip_trace__scope_end))) \
+		= { (name), csnip_trace__scope_begin() }
+#else
+#define CSNIP_TRACE_SCOPE(name)		CSNIP_TRACE_INSTANT(name)
+#endif
+
+/**	Begin a span; @sa csnip_trace_begin() */
+#define CSNIP_TRACE_BEGIN(name)		csnip_trace_begin(name)
+
+/**	End a span; @sa csnip_trace_end() */
+#define CSNIP_TRACE_END(name)		csnip_trace_end(name)
+
+/**	Record an instant; @sa csnip_trace_instant() */
+#define CSNIP_TRACE_INSTANT(name)	csnip_trace_instant(name)
+
+/**	Record a counter value; @sa csnip_trace_counter() */
+#define CSNIP_TRACE_COUNTER(name, value) \
+	csnip_trace_counter((name), (value))
+
+#else
+
+#define CSNIP_TRACE_SCOPE(name)		((void)0)
+#define CSNIP_TRACE_BEGIN(name)		((void)0)
+#define CSNIP_TRACE_END(name)		((void)0)
+#define CSNIP_TRACE_INSTANT(name)	((void)0)
+#define CSNIP_TRACE_COUNTER(name, value) ((void)0)
+
+#endif
+/**@}*/
+
+/** @} */
+
+#endif /* CSNIP_TRACE_H */
+
+#if defined(CSNIP_SHORT_NAMES) && !defined(CSNIP_TRACE_HAVE_SHORT_NAMES)
+#define trace_enable			csnip_trace_enable
+#define trace_disable			csnip_trace_disable
+#define trace_thread_name		csnip_trace_thread_name
+#define trace_dump			csnip_trace_dump
+#define trace_begin			csnip_trace_begin
+#define trace_end			csnip_trace_end
+#define trace_instant			csnip_trace_instant
+#define trace_counter			csnip_trace_counter
+#define CSNIP_TRACE_HAVE_SHORT_NAMES
+#endif /* CSNIP_SHORT_NAMES && !CSNIP_TRACE_HAVE_SHORT_NAMES */
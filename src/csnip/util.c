@@ -1,3 +1,4 @@
 #include <csnip/util.h>
 
 extern inline size_t csnip_next_pow_of_2(size_t a);
+extern inline uint64_t csnip_mul64x64(uint64_t a, uint64_t b, uint64_t* lo);
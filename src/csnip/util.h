@@ -102,6 +102,31 @@ inline size_t csnip_next_pow_of_2(size_t a)
 	return a;
 }
 
+/** Full 64 x 64 -> 128 bit multiplication.
+ *
+ *  Returns the high 64 bits of the product a * b, and stores the low
+ *  64 bits in *lo.
+ */
+inline uint64_t csnip_mul64x64(uint64_t a, uint64_t b, uint64_t* lo)
+{
+#if defined(__SIZEOF_INT128__)
+	const unsigned __int128 p = (unsigned __int128)a * b;
+	*lo = (uint64_t)p;
+	return (uint64_t)(p >> 64);
+#else
+	const uint64_t a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32;
+	const uint64_t b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+	const uint64_t ll = a_lo * b_lo;
+	const uint64_t lh = a_lo * b_hi;
+	const uint64_t hl = a_hi * b_lo;
+	const uint64_t hh = a_hi * b_hi;
+	const uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFu)
+				+ (hl & 0xFFFFFFFFu);
+	*lo = (mid << 32) | (ll & 0xFFFFFFFFu);
+	return hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
 /**	Fill a range with values.
  *
  *	Set dest[0], ..., dest[len - 1] to the value val.
@@ -166,6 +191,7 @@ inline size_t csnip_next_pow_of_2(size_t a)
 #define Static_len		csnip_Static_len
 #define Container_of		csnip_Container_of
 #define next_pow_of_2		csnip_next_pow_of_2
+#define mul64x64		csnip_mul64x64
 #define Fill_n			csnip_Fill_n
 #define Fill			csnip_Fill
 #define Copy_n			csnip_Copy_n
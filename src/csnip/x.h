@@ -206,8 +206,10 @@ CSNIP_SYMBOL extern int csnip_x_optopt_imp;
 
 /**	Csnip's own readv().
  *
- *	Reads into a temporary buffer using read(), then copies into the
- *	scattered blocks.
+ *	Reads directly into the first block if it is large, or otherwise
+ *	reads up to 4 KiB into a stack buffer with a single read() and
+ *	copies into the scattered blocks.  Like readv(), it may return
+ *	fewer bytes than requested; csnip_x_readv_all() handles that.
  */
 csnip_x_ssize_t csnip_x_readv_imp(int fd,
 			const struct csnip_x_iovec* iov,
@@ -266,15 +268,57 @@ int csnip_x_vasprintf_imp(char** strp, const char* format, va_list ap);
  *
  *	Behaves like writev(), though isn't as efficient.
  *
- *	This implementation first copies the scattered blocks into a
- *	temporary buffer and then calls write().  If the write() system
- *	call respects POSIX' atomicity guarantees, then so will this
- *	implementation of readv().
+ *	If the first block is large, it is written directly.  Otherwise
+ *	up to 4 KiB of the scattered blocks are copied into a stack
+ *	buffer and written with a single write().  Writes of up to 4 KiB
+ *	in total are therefore atomic if write() respects POSIX'
+ *	atomicity guarantees for them; larger writes may be short, as
+ *	with writev().
  */
 csnip_x_ssize_t csnip_x_writev_imp(int fd,
 			const struct csnip_x_iovec* iov,
 			int iovcnt);
 
+/**	Read until all blocks are filled.
+ *
+ *	Calls csnip_x_readv() repeatedly until all the blocks are
+ *	filled or the end of the input is reached.  After partial
+ *	transfers, the iovec array is advanced in place, so that on
+ *	return it describes the part not yet transferred.  Arrays longer
+ *	than IOV_MAX are transferred in several calls.
+ *
+ *	Interrupted calls (EINTR) are restarted.  If the descriptor is
+ *	non-blocking and not ready (EAGAIN), the function waits for it
+ *	with poll(), depending on @a timeout_ms.
+ *
+ *	@param	timeout_ms
+ *		maximum time to wait for the descriptor to become ready
+ *		each time it is not, in milliseconds.  -1 waits
+ *		indefinitely, 0 fails with EAGAIN right away.  On
+ *		timeout, the function fails with ETIMEDOUT.
+ *
+ *	@return	the number of bytes read, which is less than requested
+ *		only at the end of the input, or -1 on error with errno
+ *		set.  The bytes transferred before an error are
+ *		reflected in the advanced iovec array.
+ */
+csnip_x_ssize_t csnip_x_readv_all(int fd,
+			struct csnip_x_iovec* iov,
+			int iovcnt,
+			int timeout_ms);
+
+/**	Write all blocks.
+ *
+ *	The counterpart of csnip_x_readv_all(); see there.
+ *
+ *	@return	the number of bytes written, i.e. the total size of
+ *		the blocks, or -1 on error with errno set.
+ */
+csnip_x_ssize_t csnip_x_writev_all(int fd,
+			struct csnip_x_iovec* iov,
+			int iovcnt,
+			int timeout_ms);
+
 /** @} */
 
 /**	Wrapper for clock_gettime() or csnip_x_clock_gettime() */
@@ -374,6 +418,7 @@ int x_csnip_clock_gettime_imp(csnip_x_clockid_t clk_id,
 #define x_optopt			csnip_x_optopt
 #define x_optopt_imp			csnip_x_optopt_imp
 #define x_readv				csnip_x_readv
+#define x_readv_all			csnip_x_readv_all
 #define x_readv_imp			csnip_x_readv_imp
 #define x_strdup			csnip_x_strdup
 #define x_strerror_r			csnip_x_strerror_r
@@ -383,6 +428,7 @@ int x_csnip_clock_gettime_imp(csnip_x_clockid_t clk_id,
 #define x_vasprintf			csnip_x_vasprintf
 #define x_vasprintf_imp			csnip_x_vasprintf_imp
 #define x_writev			csnip_x_writev
+#define x_writev_all			csnip_x_writev_all
 #define x_writev_imp			csnip_x_writev_imp
 #define CSNIP_X_HAVE_SHORT_NAMES
 #endif /* CSNIP_SHORT_NAMES && !CSNIP_X_HAVE_SHORT_NAMES */
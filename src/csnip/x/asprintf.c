@@ -2,6 +2,7 @@
 #include <stdarg.h>
 #include <stdlib.h>
 
+#include <csnip/strbuf.h>
 #include <csnip/x.h>
 
 int csnip_x_asprintf_imp(char** strp, const char* format, ...)
@@ -15,18 +16,20 @@ int csnip_x_asprintf_imp(char** strp, const char* format, ...)
 
 int csnip_x_vasprintf_imp(char** strp, const char* format, va_list ap)
 {
-	va_list aq;
-	va_copy(aq, ap);
+	/* Format into the builder's inline buffer first, so that short
+	 * strings are formatted only once.
+	 */
+	csnip_strbuf S;
+	csnip_strbuf_init(&S);
+	if (csnip_strbuf_appendvf(&S, format, ap) != 0) {
+		csnip_strbuf_free(&S);
+		*strp = NULL;
+		return -1;
+	}
 
-	/* Determine the size, get buffer */
-	const int sz = vsnprintf(NULL, 0, format, ap);
-	*strp = malloc(sz + 1);
+	size_t len;
+	*strp = csnip_strbuf_release(&S, &len);
 	if (*strp == NULL)
 		return -1;
-
-	/* Write */
-	vsnprintf(*strp, sz + 1, format, aq);
-	va_end(aq);
-
-	return sz;
+	return (int)len;
 }
@@ -0,0 +1,136 @@
+#include <errno.h>
+#include <limits.h>
+
+#include <csnip/csnip_conf.h>
+#ifdef CSNIP_CONF__HAVE_POLL_H
+#include <poll.h>
+#endif
+
+#include <csnip/x.h>
+#include <csnip/x_unistd.h>
+
+/* Maximum number of blocks passed to a single readv() / writev() */
+#if defined(IOV_MAX)
+#define MAX_IOV		IOV_MAX
+#elif defined(UIO_MAXIOV)
+#define MAX_IOV		UIO_MAXIOV
+#else
+#define MAX_IOV		1024
+#endif
+
+#ifndef EWOULDBLOCK
+#define EWOULDBLOCK	EAGAIN
+#endif
+
+/* Skip the empty blocks at the start of the array. */
+static void skip_empty(struct csnip_x_iovec** iov, int* iovcnt)
+{
+	while (*iovcnt > 0 && (*iov)->iov_len == 0) {
+		++*iov;
+		--*iovcnt;
+	}
+}
+
+/* Advance the array past n transferred bytes. */
+static void advance(struct csnip_x_iovec** iov, int* iovcnt, size_t n)
+{
+	while (n > 0) {
+		struct csnip_x_iovec* v = *iov;
+		if (n < v->iov_len) {
+			v->iov_base = (char*)v->iov_base + n;
+			v->iov_len -= n;
+			return;
+		}
+		n -= v->iov_len;
+		v->iov_base = (char*)v->iov_base + v->iov_len;
+		v->iov_len = 0;
+		++*iov;
+		--*iovcnt;
+	}
+}
+
+/* Handle a failed transfer.  Returns 0 if the transfer should be
+ * retried, -1 if it failed.
+ */
+static int handle_error(int fd, int writing, int timeout_ms)
+{
+	if (errno == EINTR)
+		return 0;
+	if ((errno != EAGAIN && errno != EWOULDBLOCK) || timeout_ms == 0)
+		return -1;
+
+#ifdef CSNIP_CONF__HAVE_POLL_H
+	struct pollfd pfd;
+	pfd.fd = fd;
+	pfd.events = (writing ? POLLOUT : POLLIN);
+	pfd.revents = 0;
+	int r;
+	do {
+		r = poll(&pfd, 1, timeout_ms);
+	} while (r < 0 && errno == EINTR);
+	if (r < 0)
+		return -1;
+	if (r == 0) {
+		errno = ETIMEDOUT;
+		return -1;
+	}
+	return 0;
+#else
+	(void)fd;
+	(void)writing;
+	return -1;
+#endif
+}
+
+csnip_x_ssize_t csnip_x_readv_all(int fd,
+			struct csnip_x_iovec* iov,
+			int iovcnt,
+			int timeout_ms)
+{
+	size_t total = 0;
+	while (1) {
+		skip_empty(&iov, &iovcnt);
+		if (iovcnt == 0)
+			break;
+		const int n = (iovcnt < MAX_IOV ? iovcnt : MAX_IOV);
+		const csnip_x_ssize_t r = csnip_x_readv(fd, iov, n);
+		if (r < 0) {
+			if (handle_error(fd, 0, timeout_ms) != 0)
+				return -1;
+			continue;
+		}
+		if (r == 0)
+			break;	/* End of file */
+		total += (size_t)r;
+		advance(&iov, &iovcnt, (size_t)r);
+	}
+	return (csnip_x_ssize_t)total;
+}
+
+csnip_x_ssize_t csnip_x_writev_all(int fd,
+			struct csnip_x_iovec* iov,
+			int iovcnt,
+			int timeout_ms)
+{
+	size_t total = 0;
+	while (1) {
+		skip_empty(&iov, &iovcnt);
+		if (iovcnt == 0)
+			break;
+		const int n = (iovcnt < MAX_IOV ? iovcnt : MAX_IOV);
+		const csnip_x_ssize_t r = csnip_x_writev(fd, iov, n);
+		if (r < 0) {
+			if (handle_error(fd, 1, timeout_ms) != 0)
+				return -1;
+			continue;
+		}
+		if (r == 0) {
+			/* No progress on a non-empty write */
+			errno = EIO;
+			return -1;
+		}
+		total += (size_t)r;
+		advance(&iov, &iovcnt, (size_t)r);
+	}
+	return (csnip_x_ssize_t)total;
+}
@@ -1,5 +1,5 @@
-#include <stdlib.h>
 #include <errno.h>
+#include <string.h>
 
 #include <csnip/csnip_conf.h>
 #ifdef CSNIP_CONF__HAVE_IO_H
@@ -10,37 +10,45 @@
 #include <csnip/x.h>
 #include <csnip/x_unistd.h>
 
+/* Size of the bounce buffer for small scattered reads */
+#define BOUNCE_SIZE	4096
+
 csnip_x_ssize_t csnip_x_readv_imp(int fd,
 			const struct csnip_x_iovec* iov,
 			int iovcnt)
 {
-	/* Compute the total block size */
-	size_t bsz = 0;
-	for (int i = 0; i < iovcnt; ++i)
-		bsz += iov[i].iov_len;
-
-	/* Read into a temp buffer */
-	char* p = malloc(bsz);
-	if (p == NULL) {
-		errno = ENOMEM;
-		return -1;
+	/* Skip leading empty blocks */
+	while (iovcnt > 0 && iov->iov_len == 0) {
+		++iov;
+		--iovcnt;
 	}
-	csnip_x_ssize_t r = read(fd, p, bsz);
-	if (r < 0) {
-		free(p);
+	if (iovcnt == 0)
+		return 0;
+
+	/* Large first block: read into it directly.  Like readv(),
+	 * this is allowed to return fewer bytes than requested.
+	 */
+	if (iov[0].iov_len >= BOUNCE_SIZE || iovcnt == 1)
+		return read(fd, iov[0].iov_base, iov[0].iov_len);
+
+	/* Small blocks: read up to BOUNCE_SIZE bytes with a single
+	 * read(), then scatter.
+	 */
+	char buf[BOUNCE_SIZE];
+	size_t bsz = 0;
+	for (int i = 0; i < iovcnt && bsz < BOUNCE_SIZE; ++i)
+		bsz += csnip_Min(iov[i].iov_len, BOUNCE_SIZE - bsz);
+	const csnip_x_ssize_t r = read(fd, buf, bsz);
+	if (r <= 0)
 		return r;
-	}
 
-	/* Scatter received data */
-	char* q = p;
-	const char* end = p + r;
+	const char* q = buf;
+	const char* end = buf + r;
 	for (int i = 0; i < iovcnt && q < end; ++i) {
-		size_t ncp = csnip_Min(iov[i].iov_len, (size_t)(end - q));
+		const size_t ncp = csnip_Min(iov[i].iov_len,
+					(size_t)(end - q));
 		memcpy(iov[i].iov_base, q, ncp);
 		q += ncp;
 	}
-
-	/* Free temp memory */
-	free(p);
 	return r;
 }
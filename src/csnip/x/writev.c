@@ -1,35 +1,41 @@
 #include <errno.h>
-#include <stdlib.h>
 #include <string.h>
 
+#include <csnip/util.h>
 #include <csnip/x.h>
 #include <csnip/x_unistd.h>
 
+/* Size of the bounce buffer for small gathered writes */
+#define BOUNCE_SIZE	4096
+
 csnip_x_ssize_t csnip_x_writev_imp(int fd,
 			const struct csnip_x_iovec* iov,
 			int iovcnt)
 {
-	/* Compute the total block size */
-	size_t bsz = 0;
-	for (int i = 0; i < iovcnt; ++i)
-		bsz += iov[i].iov_len;
-
-	/* Copy all the blocks into an temp buffer */
-	char* p = malloc(bsz);
-	if (p == NULL) {
-		errno = ENOMEM;
-		return -1;
-	}
-	char* q = p;
-	for (int i = 0; i < iovcnt; ++i) {
-		memcpy(q, iov[i].iov_base, iov[i].iov_len);
-		q += iov[i].iov_len;
+	/* Skip leading empty blocks */
+	while (iovcnt > 0 && iov->iov_len == 0) {
+		++iov;
+		--iovcnt;
 	}
+	if (iovcnt == 0)
+		return 0;
 
-	/* Write */
-	csnip_x_ssize_t r = write(fd, p, bsz);
+	/* Large first block: write it directly.  Like writev(), this
+	 * is allowed to write fewer bytes than requested.
+	 */
+	if (iov[0].iov_len >= BOUNCE_SIZE || iovcnt == 1)
+		return write(fd, iov[0].iov_base, iov[0].iov_len);
 
-	/* Free, return */
-	free(p);
-	return r;
+	/* Small blocks: gather up to BOUNCE_SIZE bytes and write them
+	 * with a single write().
+	 */
+	char buf[BOUNCE_SIZE];
+	size_t bsz = 0;
+	for (int i = 0; i < iovcnt && bsz < BOUNCE_SIZE; ++i) {
+		const size_t ncp = csnip_Min(iov[i].iov_len,
+					BOUNCE_SIZE - bsz);
+		memcpy(buf + bsz, iov[i].iov_base, ncp);
+		bsz += ncp;
+	}
+	return write(fd, buf, bsz);
 }
@@ -0,0 +1,149 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/aio.h>
+#include <csnip/err.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+enum { BLK = 4096, NBLK = 64, DEPTH = 16 };
+
+static char src[NBLK * BLK];
+static char dst[NBLK * BLK];
+
+/* Wait for all requests in flight; check that each transferred a full
+ * block, and mark the tags seen.
+ */
+static void drain(aio* A, unsigned char* seen)
+{
+	aio_completion c[DEPTH];
+	while (aio_inflight(A) > 0) {
+		const int n = aio_poll(A, c, DEPTH, 1);
+		CHECK(n > 0);
+		for (int i = 0; i < n; ++i) {
+			CHECK(c[i].tag < NBLK);
+			CHECK(c[i].res == BLK);
+			CHECK(!seen[c[i].tag]);
+			seen[c[i].tag] = 1;
+		}
+	}
+}
+
+static void test_backend(int backend, const char* name)
+{
+	printf("Backend %s:", name);
+	int err;
+	aio* A = aio_make(DEPTH, backend, &err);
+	if (A == NULL && err == csnip_err_UNSUPPORTED) {
+		puts(" skipped (unsupported)");
+		return;
+	}
+	CHECK(A != NULL && err == 0);
+	printf(" [%s]", aio_backend(A) == AIO_URING ? "io_uring"
+						: "threads");
+
+	char path[] = "aio_test_XXXXXX";
+	const int fd = mkstemp(path);
+	CHECK(fd >= 0);
+
+	/* Write the blocks in batches, in scrambled order */
+	for (size_t i = 0; i < sizeof src; ++i)
+		src[i] = (char)(i * 13 + i / 4093 + backend);
+	unsigned char seen[NBLK] = { 0 };
+	for (int i = 0; i < NBLK; ++i) {
+		const int b = (i * 23) % NBLK;
+		int r = aio_submit_write(A, fd, src + b * BLK, BLK,
+					(uint64_t)b * BLK, (uint64_t)b);
+		if (r == csnip_err_RANGE) {
+			CHECK(aio_inflight(A) == DEPTH);
+			drain(A, seen);
+			r = aio_submit_write(A, fd, src + b * BLK, BLK,
+					(uint64_t)b * BLK, (uint64_t)b);
+		}
+		CHECK(r == 0);
+		if (i % 5 == 4)
+			CHECK(aio_flush(A) == 0);
+	}
+	drain(A, seen);
+	for (int i = 0; i < NBLK; ++i)
+		CHECK(seen[i]);
+
+	aio_completion c;
+	CHECK(aio_submit_fsync(A, fd, 99) == 0);
+	CHECK(aio_poll(A, &c, 1, 1) == 1);
+	CHECK(c.tag == 99 && c.res == 0);
+
+	/* Read back into registered buffers */
+	struct x_iovec bufs[2] = {
+		{ dst, sizeof dst / 2 },
+		{ dst + sizeof dst / 2, sizeof dst / 2 },
+	};
+	CHECK(aio_register_buffers(A, bufs, 2) == 0);
+	memset(seen, 0, sizeof seen);
+	for (int i = 0; i < NBLK; ++i) {
+		if (aio_inflight(A) == DEPTH)
+			drain(A, seen);
+		CHECK(aio_submit_read(A, fd, dst + i * BLK, BLK,
+				(uint64_t)i * BLK, (uint64_t)i) == 0);
+	}
+	drain(A, seen);
+	CHECK(memcmp(src, dst, sizeof src) == 0);
+
+	/* Registration is refused with requests in flight */
+	CHECK(aio_submit_read(A, fd, dst, BLK, 0, 0) == 0);
+	CHECK(aio_register_buffers(A, NULL, 0) == csnip_err_CALLFLOW);
+	memset(seen, 0, sizeof seen);
+	drain(A, seen);
+	CHECK(aio_register_buffers(A, NULL, 0) == 0);
+
+	/* Short read at the end of file */
+	CHECK(aio_submit_read(A, fd, dst, BLK, sizeof src - 100, 7) == 0);
+	CHECK(aio_poll(A, &c, 1, 1) == 1);
+	CHECK(c.tag == 7 && c.res == 100);
+
+#if SIZE_MAX > 0xffffffff
+	/* Overlong requests are clamped, not truncated modulo 2^32 */
+	CHECK(aio_submit_read(A, fd, dst, ((size_t)1 << 32) + BLK, 0, 9)
+		== 0);
+	CHECK(aio_poll(A, &c, 1, 1) == 1);
+	CHECK(c.tag == 9 && c.res == (int64_t)sizeof src);
+#endif
+
+	/* Errors show in the completion */
+	CHECK(aio_submit_read(A, -1, dst, BLK, 0, 8) == 0);
+	CHECK(aio_poll(A, &c, 1, 1) == 1);
+	CHECK(c.tag == 8 && c.res == -EBADF);
+
+	/* Leave requests in flight for aio_free() */
+	CHECK(aio_submit_read(A, fd, dst, BLK, 0, 0) == 0);
+	CHECK(aio_submit_fsync(A, fd, 1) == 0);
+	aio_free(A);
+
+	close(fd);
+	unlink(path);
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_backend(AIO_AUTO, "auto");
+	test_backend(AIO_URING, "io_uring");
+	test_backend(AIO_THREADS, "threads");
+
+	int err;
+	CHECK(aio_make(0, AIO_AUTO, &err) == NULL);
+	CHECK(err == csnip_err_INVAL);
+	return 0;
+}
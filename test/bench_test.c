@@ -0,0 +1,206 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/bench.h>
+#include <csnip/err.h>
+#include <csnip/time.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+/* Busy loop of roughly 100 ns per iteration */
+static void spin(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; ++i) {
+		const uint64_t t0 = time_cycles();
+		while (time_cycles_to_ns(time_cycles() - t0) < 100)
+			;
+	}
+}
+
+static void bm_spin(bench* B, void* arg, uint64_t iters)
+{
+	int* calls = arg;
+	++*calls;
+	spin(iters);
+}
+
+/* Spins as long while paused as while timed */
+static void bm_paused(bench* B, void* arg, uint64_t iters)
+{
+	(void)arg;
+	for (uint64_t i = 0; i < iters; ++i) {
+		bench_pause(B);
+		spin(1);
+		bench_resume(B);
+		spin(1);
+	}
+}
+
+static void bm_sum(bench* B, void* arg, uint64_t iters)
+{
+	const int* a = arg;
+	for (uint64_t i = 0; i < iters; ++i) {
+		int s = 0;
+		for (int j = 0; j < 100; ++j)
+			s += a[j];
+		bench_DoNotOptimize(s);
+	}
+	bench_ClobberMemory();
+}
+
+static char* read_all(FILE* fp)
+{
+	static char buf[4096];
+	rewind(fp);
+	const size_t n = fread(buf, 1, sizeof buf - 1, fp);
+	buf[n] = '\0';
+	return buf;
+}
+
+int main(void)
+{
+	printf("Options:");
+	bench_opts O;
+	bench_opts_init(&O);
+	CHECK(O.samples > 0 && O.cpu == -1 && O.out == stdout);
+	int f = -1;
+	CHECK(bench_parse_format("csv", &f) == 0 && f == CSNIP_BENCH_CSV);
+	CHECK(bench_parse_format("json", &f) == 0 && f == CSNIP_BENCH_JSON);
+	CHECK(bench_parse_format("text", &f) == 0 && f == CSNIP_BENCH_TEXT);
+	CHECK(bench_parse_format("xml", &f) == csnip_err_INVAL);
+	CHECK(bench_pin_cpu(-1) == csnip_err_INVAL);
+	puts(" OK");
+
+	FILE* fp = tmpfile();
+	CHECK(fp != NULL);
+	O.warmup = 0.002;
+	O.min_time = 0.001;
+	O.samples = 5;
+	O.out = fp;
+
+	printf("Calibration:");
+	bench B;
+	CHECK(bench_init(&B, &O) == 0);
+	int calls = 0;
+	bench_result R;
+	CHECK(bench_run(&B, "spin", bm_spin, &calls, 1, &R) == 0);
+	CHECK(strcmp(R.name, "spin") == 0);
+	CHECK(R.samples == 5);
+	CHECK(calls > 5);
+	/* About 100 ns per iteration, so about 10000 iterations per ms;
+	 * allow for a noisy machine.
+	 */
+	CHECK(R.iters >= 1000);
+	CHECK(R.min >= 100);
+	CHECK(R.min <= R.median && R.median <= R.max);
+	CHECK(R.min <= R.mean && R.mean <= R.max);
+	CHECK(R.stddev >= 0);
+	puts(" OK");
+
+	printf("Ops per iteration:");
+	bench_result R2;
+	CHECK(bench_run(&B, "spin/10", bm_spin, &calls, 10, &R2) == 0);
+	CHECK(R2.min >= 10 && R2.min < R.median);
+	puts(" OK");
+
+	printf("Pause:");
+	CHECK(bench_run(&B, "paused", bm_paused, NULL, 1, &R2) == 0);
+	CHECK(R2.min >= 100 && R2.min < 1.5 * R.median);
+	puts(" OK");
+
+	printf("DoNotOptimize:");
+	int a[100];
+	for (int i = 0; i < 100; ++i)
+		a[i] = i;
+	CHECK(bench_run(&B, "sum", bm_sum, a, 100, NULL) == 0);
+	bench_finish(&B);
+	puts(" OK");
+
+	printf("Text:");
+	const char* s = read_all(fp);
+	CHECK(strncmp(s, "benchmark ", 10) == 0);
+	CHECK(strstr(s, "\nspin/10 ") != NULL);
+	CHECK(strstr(s, "\nsum ") != NULL);
+	puts(" OK");
+
+	printf("CSV:");
+	fp = freopen(NULL, "w+", fp);
+	CHECK(fp != NULL);
+	O.out = fp;
+	O.format = CSNIP_BENCH_CSV;
+	O.samples = 1;
+	CHECK(bench_init(&B, &O) == 0);
+	CHECK(bench_metric(&B, "bytes", 3.5) == 0);
+	CHECK(bench_run(&B, "a,\"b\"", bm_sum, a, 100, &R) == 0);
+	CHECK(R.stddev == 0 && R.min == R.max && R.min == R.median);
+	CHECK(R.counters_valid == 0);
+	CHECK(R.nmetrics == 1 && R.metric[0] == 3.5);
+	CHECK(bench_run(&B, "c", bm_sum, a, 100, &R) == 0);
+	CHECK(R.nmetrics == 0);
+	bench_finish(&B);
+	s = read_all(fp);
+	CHECK(strncmp(s, "name,iterations,samples,mean_ns,", 32) == 0);
+	CHECK(strstr(s, ",max_ns,bytes\n") != NULL);
+	CHECK(strstr(s, "\n\"a,\"\"b\"\"\",") != NULL);
+	CHECK(strstr(s, ",3.5\nc,") != NULL);
+	CHECK(s[strlen(s) - 2] == ',');
+	puts(" OK");
+
+	/* Whether the counters are available depends on the system */
+	printf("Counters:");
+	fp = freopen(NULL, "w+", fp);
+	CHECK(fp != NULL);
+	O.out = fp;
+	O.counters = CSNIP_PERFCTR_CYCLES | CSNIP_PERFCTR_PAGE_FAULTS;
+	CHECK(bench_init(&B, &O) == 0);
+	CHECK(bench_run(&B, "paused", bm_paused, NULL, 1, &R) == 0);
+	CHECK((R.counters_valid & ~O.counters) == 0);
+	if (R.counters_valid & CSNIP_PERFCTR_CYCLES)
+		CHECK(R.counters[CSNIP_PERFCTR_I_CYCLES] > 0);
+	bench_finish(&B);
+	s = read_all(fp);
+	CHECK(strstr(s, ",max_ns,cycles,page-faults\n") != NULL);
+	O.counters = 0;
+	puts(" OK");
+
+	printf("JSON:");
+	fp = freopen(NULL, "w+", fp);
+	CHECK(fp != NULL);
+	O.out = fp;
+	O.format = CSNIP_BENCH_JSON;
+	CHECK(bench_init(&B, &O) == 0);
+	bench_finish(&B);
+	s = read_all(fp);
+	CHECK(strstr(s, "\"benchmarks\": [\n  ]\n}\n") != NULL);
+
+	fp = freopen(NULL, "w+", fp);
+	CHECK(fp != NULL);
+	O.out = fp;
+	CHECK(bench_init(&B, &O) == 0);
+	CHECK(bench_run(&B, "q\"\\", bm_sum, a, 100, NULL) == 0);
+	for (int i = 0; i < CSNIP_BENCH_MAX_METRICS; ++i)
+		CHECK(bench_metric(&B, "m", i) == 0);
+	CHECK(bench_metric(&B, "m", 0) == csnip_err_RANGE);
+	CHECK(bench_run(&B, "r", bm_sum, a, 100, NULL) == 0);
+	bench_finish(&B);
+	s = read_all(fp);
+	CHECK(strncmp(s, "{\n  \"context\": {", 16) == 0);
+	CHECK(strstr(s, "{\"name\": \"q\\\"\\\\\", \"iterations\": ") != NULL);
+	CHECK(strstr(s, "},\n    {\"name\": \"r\"") != NULL);
+	CHECK(strstr(s, ", \"metrics\": {\"m\": 0, \"m\": 1,") != NULL);
+	CHECK(strcmp(s + strlen(s) - 8, "}\n  ]\n}\n") == 0);
+	puts(" OK");
+	fclose(fp);
+
+	return 0;
+}
@@ -0,0 +1,159 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/cpu.h>
+#include <csnip/hash.h>
+#include <csnip/search.h>
+#include <csnip/tokenize.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+static uint64_t rnd_state = 0x9e3779b97f4a7c15u;
+
+static uint64_t rnd(void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 7;
+	rnd_state ^= rnd_state << 17;
+	return rnd_state;
+}
+
+static int cmp_i32(const void* a, const void* b)
+{
+	const int32_t x = *(const int32_t*)a, y = *(const int32_t*)b;
+	return (x > y) - (x < y);
+}
+
+/* Check the dispatched kernels against naive implementations */
+
+static void test_tokenize(void)
+{
+	static const char* sets[] = { ",", " ,;:|\t\n", "\x01\x12\x23\x34\x45"
+		"\x56\x67\x78\x89\x9a", "" };
+	char buf[300];
+	for (int rep = 0; rep < 2000; ++rep) {
+		tokenize_set S;
+		tokenize_set_init(&S, sets[rep % 4]);
+		const size_t len = rnd() % sizeof buf;
+		for (size_t i = 0; i < len; ++i)
+			buf[i] = (char)(rnd() % 8 == 0 ? sets[rep % 4][0]
+							: 'a' + rnd() % 26);
+		for (size_t start = 0; start < len; start += 1 + rnd() % 40) {
+			size_t ref = start;
+			while (ref < len
+			  && !tokenize_set_has(&S, (unsigned char)buf[ref]))
+			{
+				++ref;
+			}
+			CHECK(start + tokenize_find(&S, buf + start,
+						len - start) == ref);
+		}
+	}
+}
+
+static void test_search(void)
+{
+	int32_t a[1000], keys[50];
+	size_t out[50];
+	for (int rep = 0; rep < 500; ++rep) {
+		const size_t n = (rep < 100 ? (size_t)rep : rnd() % 1000);
+		const int32_t range = (rep % 2 ? 100 : INT32_MAX);
+		for (size_t i = 0; i < n; ++i)
+			a[i] = (int32_t)(rnd() % (uint64_t)range) - range / 2;
+		qsort(a, n, sizeof a[0], cmp_i32);
+		const size_t nkeys = rnd() % 50;
+		for (size_t k = 0; k < nkeys; ++k) {
+			const int32_t r = (int32_t)(rnd() % (uint64_t)range);
+			keys[k] = (n > 0 && rnd() % 2 ? a[rnd() % n]
+						: r - range / 2);
+		}
+		search_lower_bound_i32_batch(a, n, keys, nkeys, out);
+		for (size_t k = 0; k < nkeys; ++k) {
+			size_t ref;
+			Bsearch(size_t, u, a[u] < keys[k], n, ref);
+			CHECK(out[k] == ref);
+			CHECK(search_lower_bound_i32(a, n, keys[k]) == ref);
+		}
+	}
+}
+
+static void test_hash(void)
+{
+	static unsigned char keys[4000];
+	uint32_t out[200];
+	for (size_t i = 0; i < sizeof keys; ++i)
+		keys[i] = (unsigned char)rnd();
+	for (size_t key_size = 0; key_size <= 20; ++key_size) {
+		const size_t n = 200 - key_size;
+		hash_fnv32_batch(keys, key_size, n, FNV32_INIT, out);
+		for (size_t k = 0; k < n; ++k) {
+			CHECK(out[k] == hash_fnv32_b(keys + k * key_size,
+						key_size, FNV32_INIT));
+		}
+	}
+}
+
+static void run_kernels(void)
+{
+	test_tokenize();
+	test_search();
+	test_hash();
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1) {
+		/* Child:  check that the level is capped as requested */
+		const int level = cpu_level();
+		printf("  level %s:", cpu_level_name(level));
+		CHECK(level <= atoi(argv[1]));
+		run_kernels();
+		puts(" OK");
+		return 0;
+	}
+
+	printf("Features:");
+	const unsigned f = cpu_features();
+	CHECK(cpu_has(f));
+	CHECK(cpu_has(0));
+	if (cpu_has(CSNIP_CPU_AVX2))
+		CHECK(cpu_has(CSNIP_CPU_AVX | CSNIP_CPU_SSE2));
+	const int level = cpu_level();
+	CHECK(level >= CSNIP_CPU_LEVEL_SCALAR
+		&& level <= CSNIP_CPU_LEVEL_AVX512);
+	CHECK(strcmp(cpu_level_name(level), "unknown") != 0);
+	printf(" level %s", cpu_level_name(level));
+	puts(" OK");
+
+	printf("Kernels:");
+	run_kernels();
+	puts(" OK");
+
+	/* The level is fixed at load time, so run the kernels at lower
+	 * levels in child processes; also with immediate binding, where
+	 * the environment is looked up differently.
+	 */
+	puts("Capped levels:");
+	fflush(stdout);
+	for (int l = 0; l <= level; ++l) {
+		for (int bind_now = 0; bind_now < 2; ++bind_now) {
+			char cmd[4096];
+			snprintf(cmd, sizeof cmd, "%sCSNIP_CPU_LEVEL=%s %s %d",
+				bind_now ? "LD_BIND_NOW=1 " : "",
+				cpu_level_name(l), argv[0], l);
+			CHECK(system(cmd) == 0);
+		}
+	}
+
+	return 0;
+}
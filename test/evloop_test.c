@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/csnip_conf.h>
+#include <csnip/err.h>
+#include <csnip/evloop.h>
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+#include <pthread.h>
+#endif
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+struct fdrec {
+	int ncalls;
+	unsigned revents;
+	int del_fd;	/* fd to remove when called, or -1 */
+};
+
+static void fd_cb(evloop* L, int fd, unsigned revents, void* arg)
+{
+	(void)fd;
+	struct fdrec* r = arg;
+	++r->ncalls;
+	r->revents |= revents;
+	if (r->del_fd >= 0) {
+		CHECK(evloop_del_fd(L, r->del_fd) == 0);
+		r->del_fd = -1;
+	}
+}
+
+static void test_level(evloop* L)
+{
+	printf("Level-triggered pipe:");
+	int p[2];
+	CHECK(pipe(p) == 0);
+	struct fdrec r = { 0, 0, -1 };
+	CHECK(evloop_add_fd(L, p[0], EVLOOP_READ, fd_cb, &r) == 0);
+	CHECK(evloop_add_fd(L, p[0], EVLOOP_READ, fd_cb, &r)
+		== csnip_err_INVAL);
+	CHECK(evloop_run_once(L, 0) == 0);
+	CHECK(write(p[1], "x", 1) == 1);
+
+	/* Unread data keeps firing */
+	for (int i = 0; i < 3; ++i)
+		CHECK(evloop_run_once(L, 100) == 1);
+	CHECK(r.ncalls == 3 && (r.revents & EVLOOP_READ));
+
+	CHECK(evloop_del_fd(L, p[0]) == 0);
+	CHECK(evloop_run_once(L, 0) == 0);
+	CHECK(evloop_del_fd(L, p[0]) == csnip_err_INVAL);
+	close(p[0]);
+	close(p[1]);
+	puts(" OK");
+}
+
+static void test_edge(evloop* L)
+{
+	printf("Edge-triggered pipe:");
+	int p[2];
+	CHECK(pipe(p) == 0);
+	struct fdrec r = { 0, 0, -1 };
+	CHECK(evloop_add_fd(L, p[0], EVLOOP_READ | EVLOOP_EDGE,
+		fd_cb, &r) == 0);
+	CHECK(write(p[1], "x", 1) == 1);
+	CHECK(evloop_run_once(L, 100) == 1);
+	CHECK(evloop_run_once(L, 0) == 0);
+
+	/* More data is a new edge */
+	CHECK(write(p[1], "y", 1) == 1);
+	CHECK(evloop_run_once(L, 100) == 1);
+	CHECK(r.ncalls == 2);
+
+	/* Switch to level-triggered */
+	CHECK(evloop_mod_fd(L, p[0], EVLOOP_READ) == 0);
+	CHECK(evloop_run_once(L, 0) == 1);
+	CHECK(evloop_run_once(L, 0) == 1);
+	CHECK(evloop_del_fd(L, p[0]) == 0);
+	close(p[0]);
+	close(p[1]);
+	puts(" OK");
+}
+
+static void test_socketpair(evloop* L)
+{
+	printf("Socket pair, write readiness and hangup:");
+	int s[2];
+	CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, s) == 0);
+	struct fdrec rw = { 0, 0, -1 }, rr = { 0, 0, -1 };
+	CHECK(evloop_add_fd(L, s[0], EVLOOP_WRITE, fd_cb, &rw) == 0);
+	CHECK(evloop_add_fd(L, s[1], EVLOOP_READ, fd_cb, &rr) == 0);
+	CHECK(evloop_run_once(L, 100) == 1);
+	CHECK(rw.revents == EVLOOP_WRITE && rr.ncalls == 0);
+
+	CHECK(evloop_del_fd(L, s[0]) == 0);
+	close(s[0]);
+	CHECK(evloop_run_once(L, 100) == 1);
+	CHECK(rr.revents & EVLOOP_HUP);
+	CHECK(evloop_del_fd(L, s[1]) == 0);
+	close(s[1]);
+	puts(" OK");
+}
+
+/* A callback removing another watcher whose event is in the same
+ * batch must suppress the second callback.
+ */
+static void test_del_in_batch(evloop* L)
+{
+	printf("Removal within a batch:");
+	int p[2], q[2];
+	CHECK(pipe(p) == 0 && pipe(q) == 0);
+	struct fdrec rp = { 0, 0, q[0] }, rq = { 0, 0, p[0] };
+	CHECK(evloop_add_fd(L, p[0], EVLOOP_READ, fd_cb, &rp) == 0);
+	CHECK(evloop_add_fd(L, q[0], EVLOOP_READ, fd_cb, &rq) == 0);
+	CHECK(write(p[1], "x", 1) == 1);
+	CHECK(write(q[1], "x", 1) == 1);
+	CHECK(evloop_run_once(L, 100) == 1);
+	CHECK(rp.ncalls + rq.ncalls == 1);
+
+	/* Whichever callback ran removed the other watcher */
+	const int rem = (rp.ncalls ? p[0] : q[0]);
+	CHECK(evloop_del_fd(L, rem) == 0);
+	close(p[0]); close(p[1]);
+	close(q[0]); close(q[1]);
+	puts(" OK");
+}
+
+struct timerlog {
+	int order[8];
+	int n;
+	evloop_timer cancel;	/* Timer to cancel when called */
+};
+
+static struct timerlog tlog;
+
+static void order_cb(evloop* L, evloop_timer id, void* arg)
+{
+	(void)id;
+	tlog.order[tlog.n++] = (int)(intptr_t)arg;
+	if (tlog.cancel) {
+		CHECK(evloop_cancel_timer(L, tlog.cancel) == 0);
+		tlog.cancel = 0;
+	}
+}
+
+static void run_for(evloop* L, int64_t ns)
+{
+	const int64_t end = evloop_now() + ns;
+	while (evloop_now() < end)
+		CHECK(evloop_run_once(L, 5) >= 0);
+}
+
+static void test_timers(evloop* L)
+{
+	printf("Timer ordering and cancellation:");
+	memset(&tlog, 0, sizeof tlog);
+	evloop_timer t1, t2, t3, t4;
+	CHECK(evloop_add_timer(L, 30000000, 0, order_cb, (void*)3, &t3) == 0);
+	CHECK(evloop_add_timer(L, 10000000, 0, order_cb, (void*)1, &t1) == 0);
+	CHECK(evloop_add_timer(L, 20000000, 0, order_cb, (void*)2, &t2) == 0);
+	CHECK(evloop_add_timer(L, 25000000, 0, order_cb, (void*)4, &t4) == 0);
+	CHECK(t1 != 0 && t1 != t2 && t2 != t3);
+	CHECK(evloop_cancel_timer(L, t4) == 0);
+	CHECK(evloop_cancel_timer(L, t4) == csnip_err_INVAL);
+
+	const int64_t t0 = evloop_now();
+	while (tlog.n < 3)
+		CHECK(evloop_run_once(L, -1) >= 0);
+	const int64_t dt = evloop_now() - t0;
+	printf(" [%.1f ms]", dt * 1e-6);
+	CHECK(dt >= 29000000);
+	CHECK(tlog.order[0] == 1 && tlog.order[1] == 2 && tlog.order[2] == 3);
+	CHECK(evloop_cancel_timer(L, t1) == csnip_err_INVAL);
+
+	/* Cancel a timer from within another timer's callback */
+	memset(&tlog, 0, sizeof tlog);
+	CHECK(evloop_add_timer(L, 0, 0, order_cb, (void*)1, &t1) == 0);
+	CHECK(evloop_add_timer(L, 0, 0, order_cb, (void*)2, &t2) == 0);
+	tlog.cancel = t2;
+	run_for(L, 10000000);
+	CHECK(tlog.n == 1 && tlog.order[0] == 1);
+	puts(" OK");
+}
+
+static int nperiodic;
+
+static void periodic_cb(evloop* L, evloop_timer id, void* arg)
+{
+	(void)arg;
+	if (++nperiodic == 5)
+		CHECK(evloop_cancel_timer(L, id) == 0);
+}
+
+static void test_periodic(evloop* L)
+{
+	printf("Periodic timer:");
+	nperiodic = 0;
+	CHECK(evloop_add_timer(L, 2000000, 2000000, periodic_cb,
+		NULL, NULL) == 0);
+	run_for(L, 50000000);
+	CHECK(nperiodic == 5);
+	puts(" OK");
+}
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+static int nwake;
+
+static void wake_cb(evloop* L, void* arg)
+{
+	(void)L;
+	(void)arg;
+	++nwake;
+}
+
+static void* waker(void* arg)
+{
+	evloop* L = arg;
+	usleep(10000);
+	CHECK(evloop_wakeup(L) == 0);
+	usleep(10000);
+	evloop_stop(L);
+	return NULL;
+}
+#endif
+
+static void test_wakeup(evloop* L)
+{
+	printf("Cross-thread wakeup and stop:");
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	evloop_set_wake_cb(L, wake_cb, NULL);
+	pthread_t th;
+	CHECK(pthread_create(&th, NULL, waker, L) == 0);
+	CHECK(evloop_run(L) == 0);
+	pthread_join(th, NULL);
+	CHECK(nwake >= 1);
+	puts(" OK");
+#else
+	(void)L;
+	puts(" skipped");
+#endif
+}
+
+int main(void)
+{
+	int err = 0;
+	evloop* L = evloop_make(&err);
+	if (L == NULL) {
+		CHECK(err == csnip_err_UNSUPPORTED);
+		puts("Event loop unsupported, skipping tests");
+		return 0;
+	}
+	test_level(L);
+	test_edge(L);
+	test_socketpair(L);
+	test_del_in_batch(L);
+	test_timers(L);
+	test_periodic(L);
+	test_wakeup(L);
+	evloop_free(L);
+	return 0;
+}
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/err.h>
+#include <csnip/fmt.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+/* Render fmtstr both with fmt_Str() and compiled, and compare. */
+static void check_same(const char* fmtstr,
+			const char* const* keys,
+			const char* const* vals)
+{
+	/* Key/value pairs for fmt_ListMatch */
+	const char* kv[32];
+	int n = 0;
+	for (int i = 0; keys[i]; ++i) {
+		kv[n++] = keys[i];
+		kv[n++] = vals[i];
+	}
+	kv[n] = NULL;
+
+	char* r1 = NULL;
+	int err1 = 0;
+	fmt_Str(fmtstr, '$', s, e, val, next,
+		fmt_ScanShStyle(s, e, next),
+		fmt_ListMatch(s, e, val, kv),
+		/* Nop */,
+		r1,
+		err1);
+	CHECK(err1 == 0);
+
+	fmt_template T;
+	int err2 = 0;
+	fmt_Compile(fmtstr, '$', s, e, next,
+		fmt_ScanShStyle(s, e, next),
+		keys,
+		&T,
+		err2);
+	CHECK(err2 == 0);
+	char* r2 = NULL;
+	fmt_Render(&T, vals, r2, err2);
+	CHECK(err2 == 0);
+	if (strcmp(r1, r2) != 0) {
+		fprintf(stderr, "\"%s\" vs. \"%s\"\n", r1, r2);
+		CHECK(0);
+	}
+
+	/* Into a buffer, with given lengths */
+	size_t vlens[16];
+	for (int i = 0; keys[i]; ++i)
+		vlens[i] = strlen(vals[i]);
+	const size_t sz = fmt_template_size(&T, vals, vlens);
+	CHECK(sz == strlen(r1));
+	char buf[256];
+	CHECK(fmt_template_render_to(&T, vals, vlens, buf) == sz);
+	CHECK(strcmp(buf, r1) == 0);
+
+	fmt_template_free(&T);
+	free(r1);
+	free(r2);
+}
+
+static void test_equivalence(void)
+{
+	printf("Compiled vs. fmt_Str:");
+	const char* keys[] = { "a", "bb", "name", "x_1", NULL };
+	const char* vals[] = { "A", "", "world", "value one" };
+	const char* fmts[] = {
+		"",
+		"plain text",
+		"$a",
+		"${a}",
+		"Hello, ${name}!",
+		"$a$bb$name$x_1",
+		"[$name] [${bb}] [$a]",
+		"cost: $$5, $$$a",
+		"$a$$",
+		"trailing $",
+		"$name-$name-$name",
+	};
+	for (size_t i = 0; i < sizeof fmts / sizeof *fmts; ++i)
+		check_same(fmts[i], keys, vals);
+	puts(" OK");
+}
+
+static void test_ops(void)
+{
+	printf("Template structure:");
+	const char* keys[] = { "x", "y", NULL };
+	fmt_template T;
+	fmt_Compile("a$$b${x}c$y", '$', s, e, next,
+		fmt_ScanShStyle(s, e, next), keys, &T, _);
+
+	/* "a$b" is merged into one literal span */
+	CHECK(T.n_ops == 4);
+	CHECK(T.ops[0].key == -1 && T.ops[0].len == 3);
+	CHECK(T.ops[1].key == 0);
+	CHECK(T.ops[2].key == -1 && T.ops[2].len == 1);
+	CHECK(T.ops[3].key == 1);
+	CHECK(T.lit_len == 4 && memcmp(T.lit, "a$bc", 4) == 0);
+
+	/* Reuse with different values */
+	const char* v1[] = { "1", "2" };
+	const char* v2[] = { "long value", "" };
+	char* r = NULL;
+	fmt_Render(&T, v1, r, _);
+	CHECK(strcmp(r, "a$b1c2") == 0);
+	free(r);
+	fmt_Render(&T, v2, r, _);
+	CHECK(strcmp(r, "a$blong valuec") == 0);
+	free(r);
+	fmt_template_free(&T);
+	puts(" OK");
+}
+
+static void test_errors(void)
+{
+	printf("Errors:");
+	const char* keys[] = { "x", NULL };
+	fmt_template T;
+	int err = 0;
+
+	/* Unknown key */
+	fmt_Compile("$x and $z", '$', s, e, next,
+		fmt_ScanShStyle(s, e, next), keys, &T, err);
+	CHECK(err == csnip_err_FORMAT);
+	fmt_template_free(&T);
+
+	/* Unterminated brace */
+	err = 0;
+	fmt_Compile("${x", '$', s, e, next,
+		fmt_ScanShStyle(s, e, next), keys, &T, err);
+	CHECK(err == csnip_err_FORMAT);
+	fmt_template_free(&T);
+
+	/* @-style keys */
+	const char* keys2[] = { "name", "response", NULL };
+	const char* vals2[] = { "Moritz", "Great!" };
+	err = 0;
+	fmt_Compile("Hi, @name@, how are you? @response@", '@', s, e, next,
+		fmt_ScanToChar(s, e, next, '@'), keys2, &T, err);
+	CHECK(err == 0);
+	char* r = NULL;
+	fmt_Render(&T, vals2, r, err);
+	CHECK(err == 0 && strcmp(r, "Hi, Moritz, how are you? Great!") == 0);
+	free(r);
+	fmt_template_free(&T);
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_equivalence();
+	test_ops();
+	test_errors();
+	return 0;
+}
@@ -89,6 +89,30 @@ int main(int argc, char** argv)
 		return 1;
 	}
 
+	/* Check reserving capacity */
+	puts("Testing capacity reservation.");
+
+	{
+		int2str_map* R = int2str_make(NULL);
+		int2str_reserve(R, NULL, 2 * 64 / 3);
+		if (int2str_capacity(R) != 64) {
+			fprintf(stderr, "Error:  Unexpected capacity after "
+			  "reserve: %zu\n", int2str_capacity(R));
+			return 1;
+		}
+		for (int i = 0; i < 2 * 64 / 3; ++i) {
+			int2str_entry E = { i, "x" };
+			int2str_insert(R, NULL, E);
+		}
+		if (int2str_capacity(R) != 64 || int2str_size(R) != 42) {
+			fprintf(stderr, "Error:  Table grew after reserve: "
+			  "capacity %zu\n", int2str_capacity(R));
+			return 1;
+		}
+		int2str_free(R);
+	}
+	int2str_free(M);
+
 	puts("-> tests passed.\n");
 	return 0;
 }
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/linereader.h>
+#include <csnip/x.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+/* Input with empty lines, a line much longer than the small buffers
+ * used below, and no trailing delimiter.
+ */
+static char input[4096];
+static size_t input_len;
+
+static void make_input(void)
+{
+	char* p = input;
+	p += sprintf(p, "first\n\nthird line\n");
+	for (int i = 0; i < 1000; ++i)
+		*p++ = 'a' + i % 26;
+	*p++ = '\n';
+	p += sprintf(p, "\nlast");
+	input_len = (size_t)(p - input);
+}
+
+/* Check that the lines reassemble to the input, and that each line
+ * ends with the delimiter, except possibly the last.
+ */
+static int check_lines(linereader* R, int delim)
+{
+	size_t pos = 0;
+	int nlines = 0;
+	const char* line;
+	size_t len;
+	int r;
+	while ((r = linereader_next(R, delim, &line, &len)) == 1) {
+		CHECK(len > 0 && pos + len <= input_len);
+		CHECK(memcmp(line, input + pos, len) == 0);
+		pos += len;
+		CHECK(line[len - 1] == delim || pos == input_len);
+		const char* q = memchr(line, delim, len);
+		CHECK(q == NULL || q == line + len - 1);
+		++nlines;
+	}
+	CHECK(r == 0);
+	CHECK(pos == input_len);
+	CHECK(linereader_next(R, delim, &line, &len) == 0);
+	return nlines;
+}
+
+static FILE* input_file(void)
+{
+	FILE* fp = tmpfile();
+	CHECK(fp != NULL);
+	CHECK(fwrite(input, 1, input_len, fp) == input_len);
+	rewind(fp);
+	return fp;
+}
+
+static void test_file(void)
+{
+	printf("Line reader on FILE*:");
+	const size_t bufsizes[] = { 1, 7, 64, 0 };
+	for (int b = 0; b < 4; ++b) {
+		FILE* fp = input_file();
+		int err = 0;
+		linereader* R = linereader_from_file(fp, bufsizes[b], &err);
+		CHECK(R != NULL && err == 0);
+		CHECK(check_lines(R, '\n') == 6);
+		linereader_free(R);
+		fclose(fp);
+	}
+
+	/* Other delimiter */
+	FILE* fp = input_file();
+	linereader* R = linereader_from_file(fp, 16, NULL);
+	CHECK(check_lines(R, 'a') == 41);
+	linereader_free(R);
+	fclose(fp);
+	puts(" OK");
+}
+
+static void test_pipe(void)
+{
+	printf("Line reader on a pipe:");
+	int p[2];
+	CHECK(pipe(p) == 0);
+	CHECK(write(p[1], input, input_len) == (ssize_t)input_len);
+	close(p[1]);
+	int err = 0;
+	linereader* R = linereader_from_fd(p[0], 32, &err);
+	CHECK(R != NULL);
+	CHECK(check_lines(R, '\n') == 6);
+	linereader_free(R);
+	close(p[0]);
+
+	/* Empty input */
+	CHECK(pipe(p) == 0);
+	close(p[1]);
+	R = linereader_from_fd(p[0], 0, &err);
+	const char* line;
+	size_t len;
+	CHECK(linereader_next_line(R, &line, &len) == 0);
+	linereader_free(R);
+	close(p[0]);
+	puts(" OK");
+}
+
+/* The getdelim() wrapper agrees with csnip_x_getdelim_imp(). */
+static void test_getdelim(void)
+{
+	printf("getdelim wrapper:");
+	FILE* fp1 = input_file();
+	FILE* fp2 = input_file();
+	linereader* R = linereader_from_file(fp2, 8, NULL);
+	char *l1 = NULL, *l2 = NULL;
+	size_t n1 = 0, n2 = 0;
+	int nlines = 0;
+	while (1) {
+		const csnip_x_ssize_t r1 = x_getdelim_imp(&l1, &n1, '\n', fp1);
+		const csnip_x_ssize_t r2 = linereader_getdelim(&l2, &n2,
+						'\n', R);
+		CHECK(r1 == r2);
+		if (r1 < 0)
+			break;
+		CHECK(strcmp(l1, l2) == 0);
+		CHECK(n2 > (size_t)r2);
+		++nlines;
+	}
+	CHECK(nlines == 6);
+	free(l1);
+	free(l2);
+	linereader_free(R);
+	fclose(fp1);
+	fclose(fp2);
+	puts(" OK");
+}
+
+int main(void)
+{
+	make_input();
+	test_file();
+	test_pipe();
+	test_getdelim();
+	return 0;
+}
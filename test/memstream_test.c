@@ -0,0 +1,179 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/err.h>
+#include <csnip/log.h>
+#include <csnip/memstream.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+static void test_memstream(void)
+{
+	printf("Memstream:");
+	int err;
+	memstream* M = memstream_open(0, &err);
+	CHECK(M != NULL && err == 0);
+	FILE* fp = memstream_fp(M);
+
+	size_t n;
+	CHECK(strcmp(memstream_data(M, &n), "") == 0 && n == 0);
+	fprintf(fp, "x = %d, y = %.2f", 42, 1.5);
+	CHECK(strcmp(memstream_data(M, &n), "x = 42, y = 1.50") == 0);
+	CHECK(n == 16);
+
+	/* Grow well beyond the stdio buffer */
+	memstream_clear(M);
+	for (int i = 0; i < 100000; ++i)
+		fprintf(fp, "%05d\n", i);
+	const char* d = memstream_data(M, &n);
+	CHECK(n == 600000);
+	CHECK(memcmp(d, "00000\n00001\n", 12) == 0);
+	CHECK(memcmp(d + n - 6, "99999\n", 6) == 0);
+	CHECK(d[n] == '\0');
+	CHECK(memstream_close(M) == 0);
+	puts(" OK");
+}
+
+#define CSNIP_LOG_COMPONENT	"memstream_test"
+
+static void test_log_capture(void)
+{
+	printf("Log capture:");
+	int err;
+	memstream* M = memstream_open(0, &err);
+	CHECK(M != NULL);
+	csnip_log_configuration C = {
+		.filter_expr = "~0",
+		.logfmt = { "[{comp}] {msg}", "[{comp}] {msg}" },
+		.out_fp = memstream_fp(M),
+	};
+	CHECK(csnip_log_config(&C) == 0);
+	csnip_log_Mesg(CSNIP_LOG_PRIO_NOTICE, "value %d", 7);
+	CHECK(strcmp(memstream_data(M, NULL),
+		"[memstream_test] value 7\n") == 0);
+	C.out_fp = stderr;
+	CHECK(csnip_log_config(&C) == 0);
+	CHECK(memstream_close(M) == 0);
+	puts(" OK");
+}
+
+/* Concatenate the peeked areas. */
+static size_t peek_all(ringstream* R, char* out)
+{
+	struct x_iovec a[2];
+	const int na = ringstream_peek(R, a);
+	size_t n = 0;
+	for (int i = 0; i < na; ++i) {
+		memcpy(out + n, a[i].iov_base, a[i].iov_len);
+		n += a[i].iov_len;
+	}
+	return n;
+}
+
+static void test_overwrite(void)
+{
+	printf("Ringstream overwrite:");
+	int err;
+	ringstream* R = ringstream_open(1000, RINGSTREAM_OVERWRITE, 64, &err);
+	CHECK(R != NULL && err == 0);
+	FILE* fp = ringstream_fp(R);
+
+	fputs("hello", fp);
+	fflush(fp);
+	char buf[4096];
+	CHECK(peek_all(R, buf) == 5 && memcmp(buf, "hello", 5) == 0);
+	ringstream_consume(R, 2);
+	CHECK(ringstream_read(R, buf, sizeof buf) == 3);
+	CHECK(memcmp(buf, "llo", 3) == 0);
+
+	/* Write 3000 lines; the last 1024 bytes survive, and they
+	 * wrap around the ring.
+	 */
+	for (int i = 0; i < 3000; ++i)
+		fprintf(fp, "%07d\n", i);
+	fflush(fp);
+	const size_t n = peek_all(R, buf);
+	CHECK(n == 1024);
+	CHECK(ringstream_dropped(R) == 24000 - 1024);
+	CHECK(memcmp(buf + n - 8, "0002999\n", 8) == 0);
+	CHECK(memcmp(buf + n - 16, "0002998\n", 8) == 0);
+
+	/* A single write larger than the ring */
+	ringstream_consume(R, n);
+	static char big[5000];
+	memset(big, 'b', sizeof big);
+	big[sizeof big - 1] = 'e';
+	CHECK(fwrite(big, 1, sizeof big, fp) == sizeof big);
+	fflush(fp);
+	CHECK(peek_all(R, buf) == 1024);
+	CHECK(buf[0] == 'b' && buf[1023] == 'e');
+	CHECK(ringstream_close(R) == 0);
+
+	CHECK(ringstream_open(0, RINGSTREAM_BLOCK, 0, &err) == NULL);
+	CHECK(err == csnip_err_INVAL);
+	puts(" OK");
+}
+
+/* Blocking mode: a writer much larger than the ring, and a reader in
+ * another thread.
+ */
+enum { NLINES = 200000 };
+
+static void* writer(void* arg)
+{
+	ringstream* R = arg;
+	FILE* fp = ringstream_fp(R);
+	for (int i = 0; i < NLINES; ++i)
+		fprintf(fp, "%d\n", i);
+	fflush(fp);
+	return NULL;
+}
+
+static void test_block(void)
+{
+	printf("Ringstream block:");
+	int err;
+	ringstream* R = ringstream_open(256, RINGSTREAM_BLOCK, 1000, &err);
+	CHECK(R != NULL);
+	pthread_t t;
+	CHECK(pthread_create(&t, NULL, writer, R) == 0);
+
+	/* Parse the lines back and check for gaps */
+	int expect = 0, cur = 0;
+	char buf[100];
+	while (expect < NLINES) {
+		const size_t n = ringstream_read(R, buf, sizeof buf);
+		for (size_t i = 0; i < n; ++i) {
+			if (buf[i] == '\n') {
+				CHECK(cur == expect);
+				++expect;
+				cur = 0;
+			} else {
+				cur = cur * 10 + (buf[i] - '0');
+			}
+		}
+	}
+	CHECK(pthread_join(t, NULL) == 0);
+	CHECK(ringstream_dropped(R) == 0);
+	CHECK(ringstream_close(R) == 0);
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_memstream();
+	test_log_capture();
+	test_overwrite();
+	test_block();
+	return 0;
+}
@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/err.h>
+#include <csnip/mmapfile.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+static char input[20000];
+static size_t input_len;
+static char path[] = "mmapfile_test_XXXXXX";
+
+/* Lines of varying length, the last one without newline. */
+static void make_input(void)
+{
+	char* p = input;
+	for (int i = 0; i < 500; ++i) {
+		const int len = (i * 37) % 60;
+		for (int j = 0; j < len; ++j)
+			*p++ = 'a' + (i + j) % 26;
+		*p++ = '\n';
+	}
+	p += sprintf(p, "tail");
+	input_len = (size_t)(p - input);
+
+	const int fd = mkstemp(path);
+	CHECK(fd >= 0);
+	CHECK(write(fd, input, input_len) == (ssize_t)input_len);
+	close(fd);
+}
+
+static void check_lines(const mmapfile* M)
+{
+	CHECK(M->size == input_len);
+	CHECK(memcmp(M->data, input, input_len) == 0);
+	mmapfile_span rest = mmapfile_contents(M), line;
+	int n = 0;
+	while (mmapfile_next_line(&rest, '\n', &line)) {
+		CHECK(line.len > 0);
+		CHECK(memchr(line.ptr, '\n', line.len - 1) == NULL);
+		++n;
+	}
+	CHECK(n == 501);
+	CHECK(rest.len == 0);
+}
+
+static void test_open(void)
+{
+	printf("Mapping and line iteration:");
+	mmapfile M;
+	CHECK(mmapfile_open(&M, path, MMAPFILE_SEQUENTIAL
+		| MMAPFILE_WILLNEED | MMAPFILE_POPULATE) == 0);
+	CHECK(mmapfile_is_mapped(&M));
+	check_lines(&M);
+	mmapfile_close(&M);
+
+	CHECK(mmapfile_open(&M, path, MMAPFILE_NOMAP) == 0);
+	CHECK(!mmapfile_is_mapped(&M));
+	check_lines(&M);
+	mmapfile_close(&M);
+
+	CHECK(mmapfile_open(&M, "no/such/file", 0) == csnip_err_ERRNO);
+	puts(" OK");
+}
+
+static void test_pipe(void)
+{
+	printf("Pipe fallback:");
+	int p[2];
+	CHECK(pipe(p) == 0);
+	const pid_t pid = fork();
+	CHECK(pid >= 0);
+	if (pid == 0) {
+		/* Writer; the input exceeds the pipe buffer on some
+		 * systems, so write from a separate process.
+		 */
+		close(p[0]);
+		const ssize_t w = write(p[1], input, input_len);
+		_exit(w == (ssize_t)input_len ? 0 : 1);
+	}
+	close(p[1]);
+	mmapfile M;
+	CHECK(mmapfile_open_fd(&M, p[0], 0) == 0);
+	close(p[0]);
+	CHECK(!mmapfile_is_mapped(&M));
+	check_lines(&M);
+	mmapfile_close(&M);
+	puts(" OK");
+}
+
+static void test_records(void)
+{
+	printf("Record iteration:");
+	mmapfile M;
+	CHECK(mmapfile_open(&M, path, 0) == 0);
+	mmapfile_span rest = mmapfile_contents(&M), rec;
+	size_t n = 0;
+	while (mmapfile_next_record(&rest, 64, &rec)) {
+		CHECK(rec.len == 64);
+		CHECK(rec.ptr == M.data + 64 * n);
+		++n;
+	}
+	CHECK(n == input_len / 64);
+	CHECK(rest.len == input_len % 64);
+	mmapfile_close(&M);
+	puts(" OK");
+}
+
+/* Chunks must cover the input in order, and end at line ends. */
+static void test_chunks(void)
+{
+	printf("Line-aligned chunks:");
+	mmapfile M;
+	CHECK(mmapfile_open(&M, path, 0) == 0);
+	for (size_t n = 1; n <= 64; ++n) {
+		mmapfile_span ch[64];
+		const size_t nc = mmapfile_chunks(&M, n, '\n', ch);
+		CHECK(nc >= 1 && nc <= n);
+		const char* p = M.data;
+		for (size_t i = 0; i < nc; ++i) {
+			CHECK(ch[i].ptr == p && ch[i].len > 0);
+			p += ch[i].len;
+			if (i + 1 < nc)
+				CHECK(p[-1] == '\n');
+		}
+		CHECK(p == M.data + M.size);
+		if (n <= 16)
+			CHECK(nc == n);
+	}
+
+	/* A single long line can't be split */
+	mmapfile L = { "no newline here", 15 };
+	mmapfile_span ch[4];
+	CHECK(mmapfile_chunks(&L, 4, '\n', ch) == 1);
+	CHECK(ch[0].len == 15);
+	mmapfile_close(&M);
+	puts(" OK");
+}
+
+static void test_empty(void)
+{
+	printf("Empty file:");
+	FILE* fp = tmpfile();
+	CHECK(fp != NULL);
+	mmapfile M;
+	CHECK(mmapfile_open_fd(&M, fileno(fp), 0) == 0);
+	CHECK(M.size == 0);
+	mmapfile_span rest = mmapfile_contents(&M), line, ch[2];
+	CHECK(!mmapfile_next_line(&rest, '\n', &line));
+	CHECK(mmapfile_chunks(&M, 2, '\n', ch) == 0);
+	mmapfile_close(&M);
+	fclose(fp);
+	puts(" OK");
+}
+
+/* Files reporting size 0 may have contents */
+static void test_proc(void)
+{
+	printf("Proc file:");
+	mmapfile M;
+	if (mmapfile_open(&M, "/proc/self/status", 0) != 0) {
+		puts(" skipped (no /proc)");
+		return;
+	}
+	CHECK(!mmapfile_is_mapped(&M));
+	CHECK(M.size >= 5 && memcmp(M.data, "Name:", 5) == 0);
+	mmapfile_close(&M);
+	puts(" OK");
+}
+
+int main(void)
+{
+	make_input();
+	test_open();
+	test_pipe();
+	test_records();
+	test_chunks();
+	test_empty();
+	test_proc();
+	unlink(path);
+	return 0;
+}
@@ -0,0 +1,214 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/numfmt.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+static uint64_t rng_state = 0x853c49e6748fea9bU;
+
+static uint64_t rnd(void)
+{
+	/* xorshift64* */
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return rng_state * 0x2545f4914f6cdd1dU;
+}
+
+/* Random value with a random number of significant bits. */
+static uint64_t rnd_int(void)
+{
+	const int b = (int)(rnd() % 64);
+	return rnd() >> b;
+}
+
+static void test_int(void)
+{
+	printf("Integers:");
+	char buf[64], ref[64];
+	size_t n;
+
+	n = numfmt_u64(buf, 0);
+	CHECK(n == 1 && buf[0] == '0');
+	n = numfmt_u64(buf, UINT64_MAX);
+	CHECK(n == 20 && memcmp(buf, "18446744073709551615", n) == 0);
+	n = numfmt_i64(buf, INT64_MIN);
+	CHECK(n == 20 && memcmp(buf, "-9223372036854775808", n) == 0);
+
+	uint64_t p10 = 1;
+	for (int i = 0; i < 20; ++i) {
+		const uint64_t vs[] = { p10 - 1, p10, p10 + 1 };
+		for (int j = 0; j < 3; ++j) {
+			n = numfmt_u64(buf, vs[j]);
+			CHECK(n == (size_t)sprintf(ref, "%" PRIu64, vs[j]));
+			CHECK(memcmp(buf, ref, n) == 0);
+		}
+		p10 *= 10;
+	}
+
+	for (int i = 0; i < 100000; ++i) {
+		const uint64_t u = rnd_int();
+		n = numfmt_u64(buf, u);
+		CHECK(n == (size_t)sprintf(ref, "%" PRIu64, u));
+		CHECK(memcmp(buf, ref, n) == 0);
+
+		const int64_t s = (int64_t)rnd_int();
+		n = numfmt_i64(buf, s);
+		CHECK(n == (size_t)sprintf(ref, "%" PRId64, s));
+		CHECK(memcmp(buf, ref, n) == 0);
+
+		const int w = (int)(rnd() % 25);
+		n = numfmt_u64_pad(buf, u, w);
+		CHECK(n == (size_t)sprintf(ref, "%0*" PRIu64, w, u));
+		CHECK(memcmp(buf, ref, n) == 0);
+
+		const int wx = (int)(rnd() % 17);
+		n = numfmt_hex(buf, u, wx, 0);
+		CHECK(n == (size_t)sprintf(ref, "%0*" PRIx64, wx, u));
+		CHECK(memcmp(buf, ref, n) == 0);
+		n = numfmt_hex(buf, u, wx, 1);
+		CHECK(n == (size_t)sprintf(ref, "%0*" PRIX64, wx, u));
+		CHECK(memcmp(buf, ref, n) == 0);
+	}
+	puts(" OK");
+}
+
+static void check_str(double v, const char* expect)
+{
+	char buf[NUMFMT_DOUBLE_MAX + 1];
+	const size_t n = numfmt_double(buf, v);
+	buf[n] = '\0';
+	if (strcmp(buf, expect) != 0) {
+		fprintf(stderr, "got \"%s\", expected \"%s\"\n", buf, expect);
+		CHECK(0);
+	}
+}
+
+static void test_double_fixed(void)
+{
+	printf("Doubles, fixed cases:");
+	check_str(0.0, "0");
+	check_str(-0.0, "-0");
+	check_str(1.0, "1");
+	check_str(-2.5, "-2.5");
+	check_str(0.1, "0.1");
+	check_str(0.3, "0.3");
+	check_str(0.1 + 0.2, "0.30000000000000004");
+	check_str(123.456, "123.456");
+	check_str(1e-4, "0.0001");
+	check_str(1.5e-5, "1.5e-05");
+	check_str(1e16, "10000000000000000");
+	check_str(1e17, "1e+17");
+	check_str(1.2345e17, "1.2345e+17");
+	check_str(9007199254740993.0, "9007199254740992");
+	check_str(1e100, "1e+100");
+	check_str(5e-324, "5e-324");
+	check_str(2.2250738585072014e-308, "2.2250738585072014e-308");
+	check_str(1.7976931348623157e308, "1.7976931348623157e+308");
+	check_str(-1.2345678901234568e-300, "-1.2345678901234568e-300");
+	check_str(INFINITY, "inf");
+	check_str(-INFINITY, "-inf");
+	check_str(NAN, "nan");
+	puts(" OK");
+}
+
+/* Check that the output of numfmt_double() reads back as v, and that
+ * its digits are those of the shortest "%.*e" that does.  The latter
+ * is correctly rounded, so it can be one digit longer than necessary
+ * when only a neighbouring decimal of that length round trips; the
+ * output is allowed to be shorter then.
+ */
+static void check_double(double v)
+{
+	char buf[NUMFMT_DOUBLE_MAX + 1];
+	const size_t n = numfmt_double(buf, v);
+	CHECK(n <= NUMFMT_DOUBLE_MAX);
+	buf[n] = '\0';
+	CHECK(strtod(buf, NULL) == v);
+
+	/* Shortest round tripping %e */
+	char ref[40];
+	int prec = 0;
+	for (; prec < 17; ++prec) {
+		sprintf(ref, "%.*e", prec, v);
+		if (strtod(ref, NULL) == v)
+			break;
+	}
+
+	/* Compare the significant digits */
+	char d1[24], d2[24];
+	int n1 = 0, n2 = 0;
+	const char* p;
+	for (p = buf; *p && *p != 'e'; ++p) {
+		if (*p >= '0' && *p <= '9' && (n1 > 0 || *p != '0'))
+			d1[n1++] = *p;
+	}
+	while (n1 > 0 && d1[n1 - 1] == '0')
+		--n1;
+	for (p = ref; *p != 'e'; ++p) {
+		if (*p >= '0' && *p <= '9')
+			d2[n2++] = *p;
+	}
+	while (n2 > 0 && d2[n2 - 1] == '0')
+		--n2;
+	if (n1 > n2 || n1 < n2 - 1
+	  || (n1 == n2 && memcmp(d1, d2, (size_t)n1) != 0))
+	{
+		fprintf(stderr, "%s vs. %s\n", buf, ref);
+		CHECK(0);
+	}
+}
+
+static double from_bits(uint64_t b)
+{
+	double d;
+	memcpy(&d, &b, sizeof d);
+	return d;
+}
+
+static void test_double_random(void)
+{
+	printf("Doubles, random:");
+	for (int i = 0; i < 100000; ++i) {
+		const double d = from_bits(rnd());
+		if (d != d)
+			continue;
+		check_double(d);
+	}
+
+	/* Subnormals, powers of two, short decimals and integers */
+	for (int i = 0; i < 20000; ++i)
+		check_double(from_bits(rnd() >> 12));
+	for (int e = -1074; e <= 1023; ++e) {
+		check_double(ldexp(1.0, e));
+		check_double(-ldexp(1.0, e));
+	}
+	for (int i = 0; i < 20000; ++i) {
+		const double d = (double)(rnd() % 1000000)
+			* pow(10.0, (int)(rnd() % 40) - 20);
+		check_double(d);
+		check_double((double)(int64_t)rnd_int());
+	}
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_int();
+	test_double_fixed();
+	test_double_random();
+	return 0;
+}
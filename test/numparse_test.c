@@ -0,0 +1,253 @@
+#include <errno.h>
+#include <float.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/err.h>
+#include <csnip/numparse.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+static uint64_t seed = 1;
+
+static uint64_t rnd(void)
+{
+	seed = seed * 6364136223846793005U + 1442695040888963407U;
+	return seed >> 11;
+}
+
+static void check_u64(const char* s, int base, int err, uint64_t v,
+			size_t used)
+{
+	uint64_t r = 12345;
+	size_t u;
+	const int e = numparse_u64(s, strlen(s), base, &r, &u);
+	if (e != err || u != used
+	  || ((e == 0 || e == csnip_err_RANGE) && r != v))
+	{
+		fprintf(stderr, "u64 \"%s\": err %d, used %zu, "
+			"value %" PRIu64 "\n", s, e, u, r);
+		CHECK(0);
+	}
+}
+
+static void test_integers(void)
+{
+	printf("Integers:");
+	check_u64("0", 10, 0, 0, 1);
+	check_u64("+42x", 10, 0, 42, 3);
+	check_u64("123456789012345678", 10, 0, 123456789012345678U, 18);
+	check_u64("18446744073709551615", 10, 0, UINT64_MAX, 20);
+	check_u64("18446744073709551616", 10, csnip_err_RANGE,
+		UINT64_MAX, 20);
+	check_u64("99999999999999999999999", 10, csnip_err_RANGE,
+		UINT64_MAX, 23);
+	check_u64("0000000000000000000000018", 10, 0, 18, 25);
+	check_u64("-1", 10, csnip_err_FORMAT, 0, 0);
+	check_u64("", 10, csnip_err_FORMAT, 0, 0);
+	check_u64(" 1", 10, csnip_err_FORMAT, 0, 0);
+	check_u64("0x1fZ", 0, 0, 31, 4);
+	check_u64("0x", 0, 0, 0, 1);
+	check_u64("017", 0, 0, 15, 3);
+	check_u64("ffffffffffffffff", 16, 0, UINT64_MAX, 16);
+	check_u64("10000000000000000", 16, csnip_err_RANGE, UINT64_MAX, 17);
+	check_u64("zz", 36, 0, 35 * 36 + 35, 2);
+	check_u64("1", 1, csnip_err_INVAL, 0, 0);
+
+	/* Random values against strtoull() */
+	char buf[40];
+	for (int k = 0; k < 100000; ++k) {
+		const uint64_t x = rnd() >> (rnd() % 53);
+		const int n = sprintf(buf, "%" PRIu64, x);
+		uint64_t r;
+		size_t u;
+		CHECK(numparse_u64(buf, (size_t)n, 10, &r, &u) == 0);
+		CHECK(r == x && u == (size_t)n);
+		CHECK(r == strtoull(buf, NULL, 10));
+	}
+
+	int64_t i;
+	size_t u;
+	CHECK(numparse_i64("-9223372036854775808", 20, 10, &i, &u) == 0);
+	CHECK(i == INT64_MIN && u == 20);
+	CHECK(numparse_i64("-9223372036854775809", 20, 10, &i, &u)
+		== csnip_err_RANGE);
+	CHECK(i == INT64_MIN);
+	CHECK(numparse_i64("9223372036854775808", 19, 10, &i, &u)
+		== csnip_err_RANGE);
+	CHECK(i == INT64_MAX);
+	CHECK(numparse_i64("-0x10", 5, 0, &i, &u) == 0 && i == -16);
+	CHECK(numparse_i64("-", 1, 10, &i, &u) == csnip_err_FORMAT);
+	CHECK(u == 0);
+	puts(" OK");
+}
+
+/* Compare against strtod(), bit for bit. */
+static void check_double(const char* s, size_t len)
+{
+	char buf[1024];
+	memcpy(buf, s, len);
+	buf[len] = '\0';
+	char* end;
+	errno = 0;
+	const double ref = strtod(buf, &end);
+	const int ref_range = (errno == ERANGE
+		&& (ref == 0 || ref > DBL_MAX || ref < -DBL_MAX));
+
+	double r;
+	size_t u;
+	const int e = numparse_double(s, len, &r, &u);
+	if (end == buf) {
+		CHECK(e == csnip_err_FORMAT && u == 0);
+		return;
+	}
+	if (u != (size_t)(end - buf) || memcmp(&r, &ref, sizeof r) != 0
+	  || (e == csnip_err_RANGE) != ref_range)
+	{
+		fprintf(stderr, "\"%s\": got %.17g (err %d, used %zu), "
+			"expected %.17g (used %zu)\n", buf, r, e, u, ref,
+			(size_t)(end - buf));
+		CHECK(0);
+	}
+}
+
+static void check_str(const char* s)
+{
+	check_double(s, strlen(s));
+}
+
+static void test_double_cases(void)
+{
+	printf("Doubles, special cases:");
+	static const char* cases[] = {
+		"0", "-0", "+0.0e10", "1", "1.5", ".5", "5.", ".", "-.",
+		"1e", "1e+", "1e-5x", "1E308", "1e309", "-1e309", "1e-400",
+		"0e999999999999", "1e-99999999999999999",
+		"2.2250738585072011e-308", "2.2250738585072012e-308",
+		"2.2250738585072014e-308", "4.9406564584124654e-324",
+		"2.4703282292062327e-324", "2.4703282292062328e-324",
+		"1.7976931348623157e308", "1.7976931348623158e308",
+		"1.7976931348623159e308", "9007199254740993",
+		"9007199254740993.0000000000000000001",
+		"9007199254740992.9999999999999999999",
+		"0.1000000000000000055511151231257827021181583404541015625",
+		"0.1000000000000000055511151231257827021181583404541015624",
+		"123456789012345678901234567890",
+		"0.000000000000000000000000000001234567890123456789012",
+		"7.2057594037927933e16", "3.0517578125e-5",
+		"inf", "-Infinity", "INFINITE", "nan", "-NaN(123abc)",
+		"nan(", "in", "x", "", "+", "0x1.8p1", "-0x.8P-3", "0x",
+		"0x1p", "0x1.fffffffffffffp1023", "0xg", "1.2.3", "00012",
+		"1_000",
+	};
+	for (size_t k = 0; k < sizeof cases / sizeof cases[0]; ++k) {
+		if (strncmp(cases[k], "nan", 3) == 0
+		  || strncmp(cases[k], "-NaN", 4) == 0)
+		{
+			double r;
+			size_t u;
+			CHECK(numparse_double(cases[k], strlen(cases[k]), &r,
+				&u) == 0);
+			CHECK(r != r);
+			CHECK(u == (cases[k][0] == '-' ? 12 : 3));
+			continue;
+		}
+		check_str(cases[k]);
+	}
+
+	/* No reads past the span */
+	double r;
+	size_t u;
+	CHECK(numparse_double("12345678", 3, &r, &u) == 0);
+	CHECK(r == 123 && u == 3);
+	CHECK(numparse_double("1.5e10", 4, &r, &u) == 0);
+	CHECK(r == 1.5 && u == 3);
+	puts(" OK");
+}
+
+static void test_double_random(void)
+{
+	printf("Doubles, random:");
+	char buf[1024];
+
+	/* Shortest and longer representations of random doubles */
+	for (int k = 0; k < 200000; ++k) {
+		double d;
+		uint64_t bits = rnd() << 11 ^ rnd();
+		memcpy(&d, &bits, sizeof d);
+		if (d != d || d > DBL_MAX || d < -DBL_MAX)
+			continue;
+		const int prec = 1 + (int)(rnd() % 25);
+		check_double(buf, (size_t)sprintf(buf, "%.*g", prec, d));
+	}
+
+	/* Exact halfway points between adjacent doubles, and values
+	 * just next to them.
+	 */
+	for (int k = 0; k < 20000; ++k) {
+		double d;
+		uint64_t bits = (rnd() << 11 ^ rnd()) & ~((uint64_t)1 << 63);
+		memcpy(&d, &bits, sizeof d);
+		if (d != d || d > DBL_MAX)
+			continue;
+		double up = d;
+		++bits;
+		memcpy(&up, &bits, sizeof up);
+		if (up > DBL_MAX)
+			continue;
+		const long double mid = ((long double)d + up) / 2;
+		if (mid == d || mid == up)
+			continue;	/* No extended precision */
+		int n = sprintf(buf, "%.*Le", 20 + (int)(rnd() % 750), mid);
+		check_double(buf, (size_t)n);
+
+		/* Perturb the last significant digit */
+		char* e = strchr(buf, 'e');
+		char* q = e - 1;
+		if (*q > '0' && *q <= '9') {
+			--*q;
+			check_double(buf, (size_t)n);
+			++*q;
+		}
+		if (*q < '9') {
+			++*q;
+			check_double(buf, (size_t)n);
+		}
+	}
+
+	/* Random digit strings */
+	for (int k = 0; k < 200000; ++k) {
+		size_t n = 0;
+		if (rnd() % 2)
+			buf[n++] = '-';
+		const int nd = 1 + (int)(rnd() % 40);
+		const int dot = (int)(rnd() % (nd + 5));
+		for (int j = 0; j < nd; ++j) {
+			if (j == dot)
+				buf[n++] = '.';
+			buf[n++] = (char)('0' + rnd() % 10);
+		}
+		n += (size_t)sprintf(buf + n, "e%d",
+			(int)(rnd() % 700) - 360);
+		check_double(buf, n);
+	}
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_integers();
+	test_double_cases();
+	test_double_random();
+	return 0;
+}
@@ -0,0 +1,113 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/err.h>
+#include <csnip/perfctr.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+/* Touch fresh memory, to cause page faults */
+static void touch(size_t n)
+{
+	volatile char* p = malloc(n);
+	CHECK(p != NULL);
+	for (size_t i = 0; i < n; i += 4096)
+		p[i] = 1;
+	free((void*)p);
+}
+
+int main(void)
+{
+	printf("Names:");
+	CHECK(strcmp(perfctr_name(CSNIP_PERFCTR_I_CYCLES), "cycles") == 0);
+	CHECK(strcmp(perfctr_name(CSNIP_PERFCTR_I_DTLB_MISSES),
+			"dTLB-misses") == 0);
+	CHECK(perfctr_name(CSNIP_PERFCTR_N) == NULL);
+	CHECK(perfctr_name(-1) == NULL);
+	unsigned ev = 0;
+	CHECK(perfctr_parse("all", &ev) == 0 && ev == CSNIP_PERFCTR_ALL);
+	CHECK(perfctr_parse("hw", &ev) == 0 && ev == CSNIP_PERFCTR_HW);
+	CHECK(perfctr_parse("none", &ev) == 0 && ev == 0);
+	CHECK(perfctr_parse("cycles,page-faults", &ev) == 0
+		&& ev == (CSNIP_PERFCTR_CYCLES | CSNIP_PERFCTR_PAGE_FAULTS));
+	CHECK(perfctr_parse("cycles,cycle", &ev) == csnip_err_INVAL);
+	for (int i = 0; i < CSNIP_PERFCTR_N; ++i) {
+		CHECK(perfctr_parse(perfctr_name(i), &ev) == 0
+			&& ev == 1u << i);
+	}
+	puts(" OK");
+
+	printf("Nothing:");
+	perfctr P;
+	perfctr_counts C;
+	CHECK(perfctr_open(&P, 0) == csnip_err_UNSUPPORTED);
+	CHECK(perfctr_events(&P) == 0);
+	perfctr_Scoped(&P, &C, touch(1 << 20););
+	CHECK(C.valid == 0);
+	perfctr_close(&P);
+	puts(" OK");
+
+	/* Whatever is available; e.g., in containers or VMs typically
+	 * only the software events.
+	 */
+	printf("Counting:");
+	const int r = perfctr_open(&P, CSNIP_PERFCTR_ALL);
+	const unsigned open = perfctr_events(&P);
+	CHECK((r == 0) == (open != 0));
+	CHECK((open & ~CSNIP_PERFCTR_ALL) == 0);
+	for (int i = 0; i < CSNIP_PERFCTR_N; ++i) {
+		if (open & (1u << i))
+			printf(" %s", perfctr_name(i));
+	}
+
+	volatile uint64_t x = 0;
+	perfctr_Scoped(&P, &C,
+		for (int i = 0; i < 1000000; ++i)
+			x += i;
+		touch(16 << 20);
+	);
+	CHECK((C.valid & ~open) == 0);
+	if (C.valid & CSNIP_PERFCTR_INSTRUCTIONS)
+		CHECK(C.value[CSNIP_PERFCTR_I_INSTRUCTIONS] >= 1000000);
+	if (C.valid & CSNIP_PERFCTR_CYCLES)
+		CHECK(C.value[CSNIP_PERFCTR_I_CYCLES] > 0);
+	const uint64_t faults = C.value[CSNIP_PERFCTR_I_PAGE_FAULTS];
+	if (C.valid & CSNIP_PERFCTR_PAGE_FAULTS)
+		CHECK(faults > 0);
+	for (int i = 0; i < CSNIP_PERFCTR_N; ++i) {
+		if (!(C.valid & (1u << i)))
+			CHECK(C.value[i] == 0);
+	}
+	puts(" OK");
+
+	printf("Pause:");
+	perfctr_start(&P);
+	perfctr_pause(&P);
+	touch(16 << 20);
+	perfctr_resume(&P);
+	perfctr_stop(&P, &C);
+	if (C.valid & CSNIP_PERFCTR_PAGE_FAULTS)
+		CHECK(C.value[CSNIP_PERFCTR_I_PAGE_FAULTS] < faults);
+
+	/* Counting restarts from zero */
+	perfctr_start(&P);
+	perfctr_read(&P, &C);
+	perfctr_stop(&P, &C);
+	if (C.valid & CSNIP_PERFCTR_PAGE_FAULTS)
+		CHECK(C.value[CSNIP_PERFCTR_I_PAGE_FAULTS] < faults);
+	perfctr_close(&P);
+	CHECK(perfctr_events(&P) == 0);
+	puts(" OK");
+
+	return 0;
+}
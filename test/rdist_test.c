@@ -0,0 +1,304 @@
+/*
+ *  Goodness-of-fit tests for the rdist samplers.
+ *
+ *  Each sampler is checked with a chi-square test against the exact
+ *  distribution function; bins with small expected counts are pooled.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/rdist.h>
+#include <csnip/rng.h>
+#include <csnip/rng_mt.h>
+
+#define NSAMPLE		200000
+#define MAXBIN		512
+
+static rng_mt_state mt_state;
+static rng R;
+
+static void reseed(uint32_t seed)
+{
+	rng_mt_seed(&mt_state, 1, &seed);
+	R = rng_mt_makerng(&mt_state);
+}
+
+/* Chi-square test.
+ *
+ * Adjacent bins are pooled until each has an expected count of at
+ * least 5.  Fails if the statistic exceeds df + 6 sqrt(2 df), i.e.,
+ * about 6 standard deviations from its mean.
+ */
+static void chi2_check(const char* what,
+			const long* obs,
+			const double* prob,
+			int nbin)
+{
+	double s = 0;
+	int df = -1;
+	double e = 0;
+	long o = 0;
+	for (int i = 0; i < nbin; ++i) {
+		e += prob[i] * NSAMPLE;
+		o += obs[i];
+		if (e >= 5 || i == nbin - 1) {
+			s += (o - e) * (o - e) / e;
+			++df;
+			e = 0;
+			o = 0;
+		}
+	}
+	const double limit = df + 6 * sqrt(2.0 * df);
+	printf("%-28s chi2 = %8.2f, df = %3d, limit = %7.2f", what, s, df,
+		limit);
+	if (s > limit) {
+		printf(" FAIL\n");
+		exit(1);
+	}
+	puts(" OK");
+}
+
+/* Continuous distributions are binned on [lo, hi) with nbin - 2
+ * intervals, plus two tail bins.
+ */
+typedef double (*cdf_func)(double x, double param);
+
+static void continuous_check(const char* what,
+			double* sample,
+			cdf_func cdf,
+			double param,
+			double lo,
+			double hi,
+			int nbin)
+{
+	static long obs[MAXBIN];
+	static double prob[MAXBIN];
+	memset(obs, 0, sizeof obs);
+	const double w = (hi - lo) / (nbin - 2);
+	for (int i = 0; i < NSAMPLE; ++i) {
+		const double x = sample[i];
+		int b;
+		if (x < lo)
+			b = 0;
+		else if (x >= hi)
+			b = nbin - 1;
+		else
+			b = 1 + (int)((x - lo) / w);
+		if (b > nbin - 2 && x < hi)
+			b = nbin - 2;
+		++obs[b];
+	}
+	double prev = 0;
+	for (int b = 0; b < nbin - 1; ++b) {
+		const double c = cdf(lo + b * w, param);
+		prob[b] = c - prev;
+		prev = c;
+	}
+	prob[nbin - 1] = 1 - prev;
+	chi2_check(what, obs, prob, nbin);
+}
+
+static void discrete_check(const char* what,
+			const unsigned long* sample,
+			const double* pmf,
+			int nbin)
+{
+	static long obs[MAXBIN];
+	memset(obs, 0, sizeof obs);
+	for (int i = 0; i < NSAMPLE; ++i) {
+		const unsigned long k = sample[i];
+		++obs[k < (unsigned long)nbin ? k : (unsigned long)nbin - 1];
+	}
+	chi2_check(what, obs, pmf, nbin);
+}
+
+/* Distribution functions */
+
+static double normal_cdf(double x, double unused)
+{
+	(void)unused;
+	return 0.5 * erfc(-x / sqrt(2.0));
+}
+
+static double exp_cdf(double x, double unused)
+{
+	(void)unused;
+	return x <= 0 ? 0 : -expm1(-x);
+}
+
+static double gamma_cdf(double x, double shape)
+{
+	if (x <= 0)
+		return 0;
+	if (shape == 0.5)
+		return erf(sqrt(x));
+	if (shape == 1)
+		return -expm1(-x);
+	if (shape == 2)
+		return 1 - exp(-x) * (1 + x);
+	abort();
+}
+
+static void test_continuous(void)
+{
+	static double sample[NSAMPLE];
+
+	reseed(1);
+	rdist_normal_fill(&R, NSAMPLE, sample);
+	continuous_check("normal", sample, normal_cdf, 0, -4, 4, 66);
+
+	/* Check the tail explicitly */
+	reseed(2);
+	long ntail = 0;
+	for (int i = 0; i < 10 * NSAMPLE; ++i)
+		ntail += (fabs(rdist_normal(&R)) > 3.6541528853610088);
+	const double etail = 10.0 * NSAMPLE * 2 * normal_cdf(-3.6541528853610088, 0);
+	printf("%-28s %ld, expected %g", "normal tail count", ntail, etail);
+	if (fabs(ntail - etail) > 6 * sqrt(etail)) {
+		printf(" FAIL\n");
+		exit(1);
+	}
+	puts(" OK");
+
+	reseed(3);
+	rdist_exp_fill(&R, NSAMPLE, sample);
+	continuous_check("exponential", sample, exp_cdf, 0, 0, 10, 82);
+
+	const double shapes[] = { 0.5, 1, 2 };
+	for (int j = 0; j < 3; ++j) {
+		char name[64];
+		snprintf(name, sizeof name, "gamma(%g)", shapes[j]);
+		reseed(4 + j);
+		rdist_gamma_fill(&R, shapes[j], NSAMPLE, sample);
+		continuous_check(name, sample, gamma_cdf, shapes[j],
+			0, 12, 98);
+	}
+}
+
+static void test_poisson(void)
+{
+	static unsigned long sample[NSAMPLE];
+	static double pmf[MAXBIN];
+	const double mus[] = { 0.7, 3.5, 10, 40, 1000 };
+	for (int j = 0; j < 5; ++j) {
+		const double mu = mus[j];
+		reseed(10 + j);
+		rdist_poisson_fill(&R, mu, NSAMPLE, sample);
+
+		/* pmf up to MAXBIN - 1, last bin is the remainder */
+		double cum = 0;
+		for (int k = 0; k < MAXBIN - 1; ++k) {
+			pmf[k] = exp(-mu + k * log(mu) - lgamma(k + 1.0));
+			cum += pmf[k];
+		}
+		pmf[MAXBIN - 1] = 1 - cum < 0 ? 0 : 1 - cum;
+
+		/* For large mu, shift the window to the bulk */
+		if (mu > MAXBIN / 2) {
+			const int lo = (int)(mu - MAXBIN / 2);
+			static long obs[MAXBIN];
+			memset(obs, 0, sizeof obs);
+			for (int i = 0; i < NSAMPLE; ++i) {
+				long k = (long)sample[i] - lo;
+				if (k < 0) k = 0;
+				if (k > MAXBIN - 1) k = MAXBIN - 1;
+				++obs[k];
+			}
+			double c = 0;
+			for (int k = 0; k < MAXBIN; ++k) {
+				const int kk = k + lo;
+				pmf[k] = exp(-mu + kk * log(mu)
+					- lgamma(kk + 1.0));
+				c += pmf[k];
+			}
+			pmf[0] += (1 - c) / 2;
+			pmf[MAXBIN - 1] += (1 - c) / 2;
+			chi2_check("poisson(1000)", obs, pmf, MAXBIN);
+			continue;
+		}
+
+		char name[64];
+		snprintf(name, sizeof name, "poisson(%g)", mu);
+		discrete_check(name, sample, pmf, MAXBIN);
+	}
+}
+
+static void test_binomial(void)
+{
+	static unsigned long sample[NSAMPLE];
+	static double pmf[MAXBIN];
+	const struct { unsigned long n; double p; } par[] = {
+		{ 20, 0.3 },	/* inversion */
+		{ 50, 0.9 },	/* inversion, flipped */
+		{ 100, 0.8 },	/* BTRD, flipped */
+		{ 400, 0.4 },	/* BTRD */
+		{ 30, 0.5 },	/* BTRD, small */
+	};
+	for (int j = 0; j < 5; ++j) {
+		const unsigned long n = par[j].n;
+		const double p = par[j].p;
+		reseed(20 + j);
+		rdist_binomial_fill(&R, n, p, NSAMPLE, sample);
+		for (int k = 0; k < MAXBIN; ++k) {
+			if (k > (int)n) {
+				pmf[k] = 0;
+				continue;
+			}
+			pmf[k] = exp(lgamma(n + 1.0) - lgamma(k + 1.0)
+				- lgamma(n - k + 1.0)
+				+ k * log(p) + (n - k) * log1p(-p));
+		}
+		for (int i = 0; i < NSAMPLE; ++i) {
+			if (sample[i] > n) {
+				printf("binomial: value %lu > n FAIL\n",
+					sample[i]);
+				exit(1);
+			}
+		}
+		char name[64];
+		snprintf(name, sizeof name, "binomial(%lu, %g)", n, p);
+		discrete_check(name, sample, pmf, (int)n + 1);
+	}
+}
+
+/* The fill variants must produce the same values as repeated calls. */
+static void test_fill_consistency(void)
+{
+	enum { N = 1000 };
+	double a[N];
+	unsigned long u[N];
+
+	printf("%-28s", "fill vs. single calls");
+	reseed(99);
+	rdist_gamma_fill(&R, 2.5, N, a);
+	reseed(99);
+	for (int i = 0; i < N; ++i) {
+		if (rdist_gamma(&R, 2.5) != a[i]) {
+			printf(" FAIL\n");
+			exit(1);
+		}
+	}
+	reseed(98);
+	rdist_binomial_fill(&R, 1000, 0.25, N, u);
+	reseed(98);
+	for (int i = 0; i < N; ++i) {
+		if (rdist_binomial(&R, 1000, 0.25) != u[i]) {
+			printf(" FAIL\n");
+			exit(1);
+		}
+	}
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_continuous();
+	test_poisson();
+	test_binomial();
+	test_fill_consistency();
+	return 0;
+}
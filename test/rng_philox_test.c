@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/rng.h>
+#include <csnip/rng_philox.h>
+#include <csnip/runif.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+/* Known-answer tests from the Random123 distribution (kat_vectors). */
+static void test_philox_kat(void)
+{
+	static const struct {
+		uint32_t ctr[4];
+		uint32_t key[2];
+		uint32_t expect[4];
+	} kat[] = {
+		{ { 0, 0, 0, 0 },
+		  { 0, 0 },
+		  { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+		{ { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff },
+		  { 0xffffffff, 0xffffffff },
+		  { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+		{ { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 },
+		  { 0xa4093822, 0x299f31d0 },
+		  { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } },
+	};
+
+	printf("Philox4x32-10 known answers:");
+	for (int i = 0; i < sizeof(kat) / sizeof(kat[0]); ++i) {
+		uint32_t out[4];
+		rng_philox4x32(kat[i].ctr, kat[i].key, out);
+		CHECK(memcmp(out, kat[i].expect, sizeof(out)) == 0);
+	}
+	puts(" OK");
+}
+
+static void test_threefry_kat(void)
+{
+	printf("Threefry2x64-20 known answer:");
+	const uint64_t ctr[2] = { 0, 0 };
+	const uint64_t key[2] = { 0, 0 };
+	uint64_t out[2];
+	rng_threefry2x64(ctr, key, out);
+	CHECK(out[0] == 0xc2b6e3a8c2c69865ull);
+	CHECK(out[1] == 0x6f81ed42f350084dull);
+	puts(" OK");
+}
+
+/* The batch kernel must agree with the single block function,
+ * including across carries in the counter.
+ */
+static void test_batch(void)
+{
+	printf("Batch kernel vs. single blocks:");
+	const uint32_t key[2] = { 0x12345678, 0x9abcdef0 };
+	const uint32_t ctr0[4] = { 0xfffffff0, 0xffffffff, 7, 0 };
+	enum { NBLOCK = 45 };
+	uint32_t batch[4 * NBLOCK];
+	rng_philox4x32_batch(ctr0, key, NBLOCK, batch);
+
+	uint32_t ctr[4];
+	memcpy(ctr, ctr0, sizeof ctr);
+	for (int i = 0; i < NBLOCK; ++i) {
+		uint32_t out[4];
+		rng_philox4x32(ctr, key, out);
+		CHECK(memcmp(out, &batch[4 * i], sizeof out) == 0);
+
+		/* Increment counter */
+		for (int j = 0; j < 4 && ++ctr[j] == 0; ++j)
+			;
+	}
+	puts(" OK");
+}
+
+/* Streams with the same key are reproducible, streams with different
+ * keys differ.
+ */
+static void test_streams(void)
+{
+	printf("Streaming interface:");
+	rng_philox_state s1, s2, s3;
+	const uint32_t k1[2] = { 1, 0 };
+	const uint32_t k2[2] = { 2, 0 };
+	rng_philox_init(&s1, k1, NULL);
+	rng_philox_seed(&s2, 1, k1);
+	rng_philox_init(&s3, k2, NULL);
+
+	/* First words are the block for counter 0 */
+	uint32_t first[4];
+	const uint32_t zero[4] = { 0, 0, 0, 0 };
+	rng_philox4x32(zero, k1, first);
+
+	int ndiff = 0;
+	for (int i = 0; i < 1000; ++i) {
+		const uint32_t a = rng_philox_getnum(&s1);
+		const uint32_t b = rng_philox_getnum(&s2);
+		const uint32_t c = rng_philox_getnum(&s3);
+		CHECK(a == b);
+		if (i < 4)
+			CHECK(a == first[i]);
+		ndiff += (a != c);
+	}
+	CHECK(ndiff > 990);
+
+	/* Generic RNG adapter */
+	rng_philox_state st;
+	const rng R = rng_philox_makerng(&st);
+	const unsigned long seed = 1;
+	rng_seed(&R, 1, &seed);
+	rng_philox_init(&s1, k1, NULL);
+	for (int i = 0; i < 100; ++i)
+		CHECK(rng_getnum(&R) == rng_philox_getnum(&s1));
+
+	long int nOnes = 0;
+	for (int i = 0; i < 100000; ++i)
+		nOnes += runif_Geti(&R, 1);
+	CHECK(nOnes > 49000 && nOnes < 51000);
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_philox_kat();
+	test_threefry_kat();
+	test_batch();
+	test_streams();
+	return 0;
+}
@@ -2,7 +2,9 @@
  *  tests for the runif_Geti() macro and related functionality.
  */
 
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 
 #define CSNIP_SHORT_NAMES
@@ -138,6 +140,80 @@ void test_rand100(const rng* R)
 #undef Ncat
 }
 
+/* Tests for the full-range (32 bit) RNG fast path */
+
+void test_fullrange(void)
+{
+	puts("Sampling from the Mersenne twister (full range fast path).");
+	rng_mt_state mt_state;
+	const uint32_t v = 1;
+	rng_mt_seed(&mt_state, 1, &v);
+	const rng R = rng_mt_makerng(&mt_state);
+
+	/* Range checks for a few bounds, including ones exceeding the
+	 * 32 bit RNG output.
+	 */
+	const unsigned long long bounds[] = {
+		0, 1, 2, 6, 1000, 0x7FFFFFFFull, 0xFFFFFFFEull,
+		0xFFFFFFFFull, 0x100000000ull, 0x123456789ABull,
+		ULLONG_MAX - 1, ULLONG_MAX
+	};
+	for (int i = 0; i < sizeof(bounds) / sizeof(bounds[0]); ++i) {
+		for (int j = 0; j < 10000; ++j) {
+			const unsigned long long r =
+			  runif_getull(&R, bounds[i]);
+			if (r > bounds[i]) {
+				fprintf(stderr, "Error: Value %llu exceeds "
+				  "bound %llu.\n", r, bounds[i]);
+				exit(1);
+			}
+		}
+	}
+
+	/* Uniformity check of a non-power-of-2 range */
+	const int N = 1000000;
+#define Ncat 100
+	int nhit[Ncat] = { 0 };
+	for (int i = 0; i < N; ++i) {
+		unsigned int v = runif_Geti(&R, (unsigned int)Ncat - 1);
+		if (v >= Ncat) {
+			fprintf(stderr, "Error: runif_Geti() returned "
+			  "out-of-range value %u.\n", v);
+			exit(1);
+		}
+		nhit[v]++;
+	}
+	const double p0 = 1. / Ncat;
+	const double mean0 = N * p0;
+	const double sd0 = sqrt(N * p0 * (1 - p0));
+	double s = 0;
+	for (int i = 0; i < Ncat; ++i) {
+		const double u = (nhit[i] - mean0)/sd0;
+		s += u * u;
+	}
+	printf("-> test statistic Chi2 (degf = %d) : %g\n", Ncat - 1, s);
+	if (s > 200) {
+		fprintf(stderr, "Error: Chi2 statistic too large.\n");
+		exit(1);
+	}
+#undef Ncat
+
+	/* Floating point values must lie in [0, 1) on the 2^-53 grid */
+	for (int i = 0; i < 100000; ++i) {
+		const double d = runif_getd(&R, 1.0);
+		if (d < 0 || d >= 1 || ldexp(d, 53) != floor(ldexp(d, 53))) {
+			fprintf(stderr, "Error: Invalid double %a.\n", d);
+			exit(1);
+		}
+		const float f = runif_getf(&R, 1.0f);
+		if (f < 0 || f >= 1) {
+			fprintf(stderr, "Error: Invalid float %a.\n", f);
+			exit(1);
+		}
+	}
+	puts("");
+}
+
 int main()
 {
 	rng_sv_state state;
@@ -160,5 +236,8 @@ int main()
 	/* random integer in 0, ..., 99 */
 	test_rand100(&sv);
 
+	/* full range RNG fast path */
+	test_fullrange();
+
 	return 0;
 }
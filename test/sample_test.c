@@ -0,0 +1,257 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/err.h>
+#include <csnip/rng.h>
+#include <csnip/rng_mt.h>
+#include <csnip/sample.h>
+#include <csnip/util.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+static rng_mt_state mt_state;
+static rng R;
+
+static void reseed(uint32_t seed)
+{
+	rng_mt_seed(&mt_state, 1, &seed);
+	R = rng_mt_makerng(&mt_state);
+}
+
+/* Chi-square statistic against equal (or given) expected counts,
+ * checked against df + 6 sqrt(2 df).
+ */
+static void chi2_check(const long* obs, const double* expect, int nbin)
+{
+	double s = 0;
+	for (int i = 0; i < nbin; ++i) {
+		if (expect[i] == 0) {
+			CHECK(obs[i] == 0);
+			continue;
+		}
+		s += (obs[i] - expect[i]) * (obs[i] - expect[i]) / expect[i];
+	}
+	const int df = nbin - 1;
+	printf(" [chi2 = %.1f, df = %d]", s, df);
+	CHECK(s < df + 6 * sqrt(2.0 * df));
+}
+
+static void chi2_uniform(const long* obs, int nbin, double ntotal)
+{
+	double* e = malloc(nbin * sizeof(double));
+	for (int i = 0; i < nbin; ++i)
+		e[i] = ntotal / nbin;
+	chi2_check(obs, e, nbin);
+	free(e);
+}
+
+static void test_bounded_batch(void)
+{
+	printf("Batched bounded integers:");
+	reseed(1);
+	const uint64_t bound[3] = { 3, 5, 7 };
+	long cnt[105] = { 0 };
+	for (int i = 0; i < 105000; ++i) {
+		uint64_t r[3];
+		sample_bounded_batch(&R, 3, bound, r);
+		CHECK(r[0] < 3 && r[1] < 5 && r[2] < 7);
+		++cnt[(r[0] * 5 + r[1]) * 7 + r[2]];
+	}
+	chi2_uniform(cnt, 105, 105000);
+	puts(" OK");
+}
+
+/* Count all 24 permutations of 4 elements. */
+static void test_shuffle_small(void)
+{
+	printf("Shuffle, 4 elements:");
+	reseed(2);
+	long cnt[24] = { 0 };
+	for (int t = 0; t < 240000; ++t) {
+		int a[4] = { 0, 1, 2, 3 };
+		Shuffle(&R, u, v, Tswap(int, a[u], a[v]), 4);
+
+		/* Lehmer code of the permutation */
+		int code = 0;
+		for (int i = 0; i < 4; ++i) {
+			int c = 0;
+			for (int j = i + 1; j < 4; ++j)
+				c += (a[j] < a[i]);
+			code = code * (4 - i) + c;
+		}
+		++cnt[code];
+	}
+	chi2_uniform(cnt, 24, 240000);
+	puts(" OK");
+}
+
+/* Larger arrays exercise the smaller batch sizes; check that the
+ * result is a permutation, and that the first element ends up in a
+ * uniformly distributed position.
+ */
+static void test_shuffle_large(void)
+{
+	printf("Shuffle, large arrays:");
+	reseed(3);
+	const size_t sizes[] = { 5000, 70000 };
+	for (int s = 0; s < 2; ++s) {
+		const size_t n = sizes[s];
+		size_t* a = malloc(n * sizeof(size_t));
+		char* seen = calloc(n, 1);
+		for (size_t i = 0; i < n; ++i)
+			a[i] = i;
+		Shuffle(&R, u, v, Tswap(size_t, a[u], a[v]), n);
+		for (size_t i = 0; i < n; ++i) {
+			CHECK(a[i] < n && !seen[a[i]]);
+			seen[a[i]] = 1;
+		}
+		free(a);
+		free(seen);
+	}
+
+	enum { NB = 50, NT = 50000 };
+	long cnt[NB] = { 0 };
+	for (int t = 0; t < NT; ++t) {
+		size_t a[NB];
+		for (int i = 0; i < NB; ++i)
+			a[i] = i;
+		Shuffle(&R, u, v, Tswap(size_t, a[u], a[v]), NB);
+		for (int i = 0; i < NB; ++i) {
+			if (a[i] == 0)
+				++cnt[i];
+		}
+	}
+	chi2_uniform(cnt, NB, NT);
+	puts(" OK");
+}
+
+/* Every stream item must be included with probability k / n. */
+static void test_reservoir(void)
+{
+	printf("Reservoir sampling:");
+	reseed(4);
+	enum { N = 500, K = 10, NT = 20000 };
+	long cnt[N] = { 0 };
+	for (int t = 0; t < NT; ++t) {
+		int res[K];
+		sample_reservoir S;
+		sample_reservoir_init(&S, &R, K);
+		for (int i = 0; i < N; ++i) {
+			const size_t slot = sample_reservoir_offer(&S, &R);
+			if (slot != CSNIP_SAMPLE_SKIP) {
+				CHECK(slot < K);
+				res[slot] = i;
+			}
+		}
+		for (int j = 0; j < K; ++j)
+			++cnt[res[j]];
+	}
+	chi2_uniform(cnt, N, (double)NT * K);
+
+	/* Skipping ahead gives the same sample as offering every item */
+	int res1[K], res2[K];
+	sample_reservoir S;
+	reseed(5);
+	sample_reservoir_init(&S, &R, K);
+	for (int i = 0; i < 100000; ++i) {
+		const size_t slot = sample_reservoir_offer(&S, &R);
+		if (slot != CSNIP_SAMPLE_SKIP)
+			res1[slot] = i;
+	}
+	reseed(5);
+	sample_reservoir_init(&S, &R, K);
+	int i = 0;
+	while (i < 100000) {
+		const unsigned long long nskip = sample_reservoir_skip(&S);
+		i += (int)nskip;
+		if (i >= 100000)
+			break;
+		const size_t slot = sample_reservoir_offer(&S, &R);
+		CHECK(slot != CSNIP_SAMPLE_SKIP);
+		res2[slot] = i++;
+	}
+	CHECK(memcmp(res1, res2, sizeof res1) == 0);
+	puts(" OK");
+}
+
+static void test_alias(void)
+{
+	printf("Alias table:");
+	reseed(6);
+	const double w[] = { 1, 2, 3, 4, 0, 10, 0.5, 7.5 };
+	enum { NW = sizeof(w) / sizeof(w[0]), NT = 300000 };
+	sample_alias A;
+	CHECK(sample_alias_init(&A, NW, w) == 0);
+	long cnt[NW] = { 0 };
+	for (int t = 0; t < NT; ++t) {
+		const size_t i = sample_alias_draw(&A, &R);
+		CHECK(i < NW);
+		++cnt[i];
+	}
+	double e[NW];
+	for (int i = 0; i < NW; ++i)
+		e[i] = NT * w[i] / 28.0;
+	chi2_check(cnt, e, NW);
+	sample_alias_free(&A);
+
+	const double bad[] = { 1, -1 };
+	CHECK(sample_alias_init(&A, 2, bad) == csnip_err_INVAL);
+	const double zero[] = { 0, 0 };
+	CHECK(sample_alias_init(&A, 2, zero) == csnip_err_INVAL);
+	puts(" OK");
+}
+
+static void test_noreplace(void)
+{
+	printf("Sampling without replacement:");
+	reseed(7);
+	const struct { size_t n, k; int nt; } par[] = {
+		{ 1000, 10, 20000 },	/* sparse, Floyd */
+		{ 40, 20, 10000 },	/* dense, partial shuffle */
+		{ 16, 16, 10 },		/* everything */
+	};
+	for (int p = 0; p < 3; ++p) {
+		const size_t n = par[p].n, k = par[p].k;
+		long* cnt = calloc(n, sizeof(long));
+		size_t* out = malloc(k * sizeof(size_t));
+		char* seen = malloc(n);
+		for (int t = 0; t < par[p].nt; ++t) {
+			CHECK(sample_noreplace(&R, n, k, out) == 0);
+			memset(seen, 0, n);
+			for (size_t j = 0; j < k; ++j) {
+				CHECK(out[j] < n && !seen[out[j]]);
+				seen[out[j]] = 1;
+				++cnt[out[j]];
+			}
+		}
+		if (k < n)
+			chi2_uniform(cnt, (int)n, (double)par[p].nt * k);
+		free(cnt);
+		free(out);
+		free(seen);
+	}
+	size_t dummy[2];
+	CHECK(sample_noreplace(&R, 1, 2, dummy) == csnip_err_INVAL);
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_bounded_batch();
+	test_shuffle_small();
+	test_shuffle_large();
+	test_reservoir();
+	test_alias();
+	test_noreplace();
+	return 0;
+}
@@ -0,0 +1,244 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/simd.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15U;
+
+static uint64_t rnd(void)
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 7;
+	rng_state ^= rng_state << 17;
+	return rng_state;
+}
+
+/* Random bytes; with few distinct values, so that comparisons come
+ * out both ways.
+ */
+static void fill_u8(uint8_t* p, int n)
+{
+	const int narrow = (int)(rnd() & 1);
+	for (int i = 0; i < n; ++i) {
+		const uint64_t r = rnd();
+		p[i] = (uint8_t)(narrow ? 0x7e + r % 4 : r);
+	}
+}
+
+static void fill_i32(int32_t* p, int n)
+{
+	const int narrow = (int)(rnd() & 1);
+	for (int i = 0; i < n; ++i) {
+		const uint64_t r = rnd();
+		p[i] = (int32_t)(narrow ? (int64_t)(r % 5) - 2 : (int64_t)r);
+	}
+}
+
+/* Lane-by-lane reference results */
+
+static uint8_t ref_u8(int op, const uint8_t* a, const uint8_t* b, int i)
+{
+	switch (op) {
+	case 0: return (a[i] == b[i] ? 0xff : 0);
+	case 1: return (a[i] > b[i] ? 0xff : 0);
+	case 2: return (a[i] < b[i] ? a[i] : b[i]);
+	case 3: return (a[i] > b[i] ? a[i] : b[i]);
+	case 4: return a[i] & b[i];
+	case 5: return a[i] | b[i];
+	case 6: return (uint8_t)(a[i] >> (b[0] & 7));
+	case 7: return (b[i] & 0x80 ? 0 : a[(i & ~15) + (b[i] & 15)]);
+	}
+	return 0;
+}
+
+static int32_t ref_i32(int op, const int32_t* a, const int32_t* b, int i)
+{
+	switch (op) {
+	case 0: return (a[i] == b[i] ? -1 : 0);
+	case 1: return (a[i] > b[i] ? -1 : 0);
+	case 2: return (a[i] < b[i] ? a[i] : b[i]);
+	case 3: return (a[i] > b[i] ? a[i] : b[i]);
+	case 4: return (int32_t)((uint32_t)a[i] + (uint32_t)b[i]);
+	case 5: return (int32_t)((uint32_t)a[i] * (uint32_t)b[i]);
+	case 6: return a[i] & b[i];
+	case 7: return a[i] ^ b[i];
+	case 8: return (int32_t)((uint32_t)a[i] >> (b[0] & 31));
+	}
+	return 0;
+}
+
+#define V(be, name)	csnip_simd_ ## be ## _ ## name
+
+/* Instantiate the test for a backend.  Each backend is tested
+ * against the reference results, which the scalar backend must
+ * match as well.
+ */
+#define DEFINE_TEST(be, W, target) \
+	target static void test_ ## be(void) \
+	{ \
+		uint8_t a[W], b[W], r[W]; \
+		int32_t ia[W / 4], ib[W / 4], ir[W / 4]; \
+		for (int rep = 0; rep < 2000; ++rep) { \
+			fill_u8(a, W); \
+			fill_u8(b, W); \
+			const V(be, u8) va = V(be, u8_load)(a); \
+			const V(be, u8) vb = V(be, u8_load)(b); \
+			for (int op = 0; op < 8; ++op) { \
+				V(be, u8) vr; \
+				switch (op) { \
+				case 0: vr = V(be, u8_eq)(va, vb); break; \
+				case 1: vr = V(be, u8_gt)(va, vb); break; \
+				case 2: vr = V(be, u8_min)(va, vb); break; \
+				case 3: vr = V(be, u8_max)(va, vb); break; \
+				case 4: vr = V(be, u8_and)(va, vb); break; \
+				case 5: vr = V(be, u8_or)(va, vb); break; \
+				case 6: vr = V(be, u8_shr)(va, b[0] & 7); break; \
+				default: vr = V(be, u8_shuffle)(va, vb); break; \
+				} \
+				V(be, u8_store)(r, vr); \
+				uint64_t m = 0; \
+				for (int i = 0; i < W; ++i) { \
+					CHECK(r[i] == ref_u8(op, a, b, i)); \
+					m |= (uint64_t)(r[i] >> 7) << i; \
+				} \
+				CHECK(V(be, u8_movemask)(vr) == m); \
+			} \
+	\
+			/* Broadcasts */ \
+			V(be, u8_store)(r, V(be, u8_splat)(a[0])); \
+			for (int i = 0; i < W; ++i) \
+				CHECK(r[i] == a[0]); \
+			V(be, u8_store)(r, V(be, u8_load16)(b)); \
+			for (int i = 0; i < W; ++i) \
+				CHECK(r[i] == b[i % 16]); \
+	\
+			/* 32 bit lanes */ \
+			fill_i32(ia, W / 4); \
+			fill_i32(ib, W / 4); \
+			const V(be, i32) wa = V(be, i32_load)(ia); \
+			const V(be, i32) wb = V(be, i32_load)(ib); \
+			for (int op = 0; op < 9; ++op) { \
+				V(be, i32) wr; \
+				switch (op) { \
+				case 0: wr = V(be, i32_eq)(wa, wb); break; \
+				case 1: wr = V(be, i32_gt)(wa, wb); break; \
+				case 2: wr = V(be, i32_min)(wa, wb); break; \
+				case 3: wr = V(be, i32_max)(wa, wb); break; \
+				case 4: wr = V(be, i32_add)(wa, wb); break; \
+				case 5: wr = V(be, i32_mullo)(wa, wb); break; \
+				case 6: wr = V(be, i32_and)(wa, wb); break; \
+				case 7: wr = V(be, i32_xor)(wa, wb); break; \
+				default: \
+					wr = V(be, i32_shr)(wa, ib[0] & 31); \
+					break; \
+				} \
+				V(be, i32_store)(ir, wr); \
+				uint64_t m = 0; \
+				for (int i = 0; i < W / 4; ++i) { \
+					CHECK(ir[i] == ref_i32(op, ia, ib, i)); \
+					m |= (uint64_t)((uint32_t)ir[i] >> 31) << i; \
+				} \
+				CHECK(V(be, i32_movemask)(wr) == m); \
+			} \
+			V(be, i32_store)(ir, V(be, i32_splat)(ia[0])); \
+			for (int i = 0; i < W / 4; ++i) \
+				CHECK(ir[i] == ia[0]); \
+	\
+			/* Gather, at unaligned byte offsets */ \
+			for (int i = 0; i < W / 4; ++i) \
+				ib[i] = (int32_t)(rnd() % (W - 3)); \
+			V(be, i32_store)(ir, V(be, i32_gather)(a, \
+						V(be, i32_load)(ib))); \
+			for (int i = 0; i < W / 4; ++i) \
+				CHECK(memcmp(&ir[i], a + ib[i], 4) == 0); \
+		} \
+	}
+
+DEFINE_TEST(scalar, 16, )
+#if defined(CSNIP_SIMD_HAVE_SSE2)
+DEFINE_TEST(sse2, 16, CSNIP_SIMD_TARGET_SSE2)
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX2)
+DEFINE_TEST(avx2, 32, CSNIP_SIMD_TARGET_AVX2)
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX512)
+DEFINE_TEST(avx512, 64, CSNIP_SIMD_TARGET_AVX512)
+#endif
+#if defined(CSNIP_SIMD_HAVE_NEON)
+DEFINE_TEST(neon, 16, )
+#endif
+
+/* Whether the CPU supports a backend that the compiler does. */
+static int cpu_has(const char* be)
+{
+#if (defined(__GNUC__) || defined(__clang__)) \
+  && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (strcmp(be, "sse2") == 0)
+		return __builtin_cpu_supports("sse2");
+	if (strcmp(be, "avx2") == 0)
+		return __builtin_cpu_supports("avx2");
+	if (strcmp(be, "avx512") == 0) {
+		return __builtin_cpu_supports("avx512bw")
+			&& __builtin_cpu_supports("avx512dq");
+	}
+#endif
+	(void)be;
+	return 1;
+}
+
+static void run(const char* be, void (*test)(void))
+{
+	printf("Backend %s:", be);
+	if (!cpu_has(be)) {
+		puts(" skipped (not supported by the CPU)");
+		return;
+	}
+	test();
+	puts(" OK");
+}
+
+static void test_native(void)
+{
+	printf("Native backend:");
+	CHECK(sizeof(simd_u8) == CSNIP_SIMD_WIDTH);
+	uint8_t buf[CSNIP_SIMD_WIDTH];
+	memset(buf, 'a', sizeof buf);
+	buf[CSNIP_SIMD_WIDTH - 3] = 'x';
+	const uint64_t m = simd_u8_movemask(
+		simd_u8_eq(simd_u8_load(buf), simd_u8_splat('x')));
+	CHECK(simd_mask_popcount(m) == 1);
+	CHECK(simd_mask_ctz(m) == CSNIP_SIMD_WIDTH - 3);
+	puts(" OK");
+}
+
+int main(void)
+{
+	run("scalar", test_scalar);
+#if defined(CSNIP_SIMD_HAVE_SSE2)
+	run("sse2", test_sse2);
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX2)
+	run("avx2", test_avx2);
+#endif
+#if defined(CSNIP_SIMD_HAVE_AVX512)
+	run("avx512", test_avx512);
+#endif
+#if defined(CSNIP_SIMD_HAVE_NEON)
+	run("neon", test_neon);
+#endif
+	test_native();
+	return 0;
+}
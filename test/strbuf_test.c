@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/strbuf.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+static void test_append(void)
+{
+	printf("Append:");
+	strbuf S;
+	strbuf_init(&S);
+	CHECK(S.len == 0 && strcmp(S.ptr, "") == 0);
+
+	/* Stays in the inline buffer */
+	CHECK(strbuf_appends(&S, "Hello") == 0);
+	CHECK(strbuf_appendc(&S, ',') == 0);
+	CHECK(strbuf_append(&S, " world!!!", 7) == 0);
+	CHECK(S.len == 13 && strcmp(S.ptr, "Hello, world!") == 0);
+	CHECK(S.ptr == S.small);
+
+	/* Grow onto the heap */
+	char ref[10001];
+	for (int i = 0; i < 10000; ++i)
+		ref[i] = (char)('a' + i % 26);
+	ref[10000] = '\0';
+	strbuf_clear(&S);
+	for (int i = 0; i < 10000; ++i)
+		CHECK(strbuf_appendc(&S, ref[i]) == 0);
+	CHECK(S.len == 10000 && strcmp(S.ptr, ref) == 0);
+	CHECK(S.ptr != S.small);
+
+	strbuf_truncate(&S, 3);
+	CHECK(S.len == 3 && strcmp(S.ptr, "abc") == 0);
+	strbuf_truncate(&S, 10);
+	CHECK(S.len == 3);
+
+	/* Reserve */
+	CHECK(strbuf_reserve(&S, 100000) == 0);
+	char* const p = S.ptr;
+	for (int i = 0; i < 10; ++i)
+		CHECK(strbuf_append(&S, ref, 10000) == 0);
+	CHECK(S.ptr == p && S.len == 100003);
+
+	strbuf_free(&S);
+	CHECK(S.len == 0 && S.ptr == S.small);
+	puts(" OK");
+}
+
+static void test_appendf(void)
+{
+	printf("Appendf:");
+	strbuf S;
+	strbuf_init(&S);
+	CHECK(strbuf_appendf(&S, "%d-%s", 42, "x") == 0);
+	CHECK(strcmp(S.ptr, "42-x") == 0);
+
+	/* Larger than the spare capacity: retried after growing */
+	char big[500];
+	memset(big, 'z', sizeof big - 1);
+	big[sizeof big - 1] = '\0';
+	CHECK(strbuf_appendf(&S, "[%s]", big) == 0);
+	CHECK(S.len == 4 + 2 + 499);
+	CHECK(S.ptr[4] == '[' && S.ptr[5] == 'z' && S.ptr[504] == ']');
+	CHECK(S.ptr[505] == '\0');
+
+	/* Many small ones */
+	strbuf_clear(&S);
+	char ref[64];
+	size_t n = 0;
+	for (int i = 0; i < 1000; ++i) {
+		CHECK(strbuf_appendf(&S, "%d,", i) == 0);
+		n += (size_t)sprintf(ref, "%d,", i);
+	}
+	CHECK(S.len == n && strncmp(S.ptr + n - 4, "999,", 4) == 0);
+	strbuf_free(&S);
+	puts(" OK");
+}
+
+static void test_numbers(void)
+{
+	printf("Numbers:");
+	strbuf S;
+	strbuf_init(&S);
+	CHECK(strbuf_append_u64(&S, 18446744073709551615U) == 0);
+	CHECK(strbuf_appendc(&S, ' ') == 0);
+	CHECK(strbuf_append_i64(&S, -12) == 0);
+	CHECK(strbuf_appendc(&S, ' ') == 0);
+	CHECK(strbuf_append_hex(&S, 0xbeef, 8) == 0);
+	CHECK(strbuf_appendc(&S, ' ') == 0);
+	CHECK(strbuf_append_double(&S, 0.1) == 0);
+	CHECK(strcmp(S.ptr, "18446744073709551615 -12 0000beef 0.1") == 0);
+	strbuf_free(&S);
+	puts(" OK");
+}
+
+static void test_release(void)
+{
+	printf("Release:");
+	strbuf S;
+	strbuf_init(&S);
+
+	/* From the inline buffer: copied */
+	strbuf_appends(&S, "short");
+	size_t len;
+	char* r = strbuf_release(&S, &len);
+	CHECK(r != NULL && len == 5 && strcmp(r, "short") == 0);
+	CHECK(S.len == 0 && S.ptr == S.small);
+	free(r);
+
+	/* From the heap: handed over */
+	for (int i = 0; i < 100; ++i)
+		strbuf_appends(&S, "0123456789");
+	const char* p = S.ptr;
+	r = strbuf_release(&S, NULL);
+	CHECK(r == p && strlen(r) == 1000);
+	free(r);
+	strbuf_free(&S);
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_append();
+	test_appendf();
+	test_numbers();
+	test_release();
+	return 0;
+}
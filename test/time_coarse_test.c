@@ -0,0 +1,125 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/csnip_conf.h>
+#include <csnip/err.h>
+#include <csnip/log.h>
+#include <csnip/time.h>
+#include <csnip/x.h>
+
+#define CSNIP_LOG_COMPONENT	"coarse_test"
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+static double precise(int mono)
+{
+	struct timespec ts;
+	x_clock_gettime(mono ? CSNIP_X_CLOCK_MAYBE_MONOTONIC
+		: CSNIP_X_CLOCK_REALTIME, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double coarse(int clk)
+{
+	return time_coarse_now_ns(clk) * 1e-9;
+}
+
+/* The coarse clocks must agree with the precise clocks within a few
+ * refresh periods.
+ */
+static void check_agreement(void)
+{
+	const double d_rt = precise(0) - coarse(TIME_COARSE_REALTIME);
+	const double d_mt = precise(1) - coarse(TIME_COARSE_MONOTONIC);
+	printf(" [deltas %.2f ms, %.2f ms]", d_rt * 1e3, d_mt * 1e3);
+	CHECK(fabs(d_rt) < 0.05);
+	CHECK(fabs(d_mt) < 0.05);
+}
+
+static void test_fallback(void)
+{
+	printf("Coarse clock without refresh thread:");
+	check_agreement();
+	const struct timespec ts = time_coarse_now(TIME_COARSE_REALTIME);
+	CHECK(ts.tv_nsec >= 0 && ts.tv_nsec < 1000000000);
+	puts(" OK");
+}
+
+static void test_thread(void)
+{
+	printf("Coarse clock refresh thread:");
+	const int err = time_coarse_start(1000);
+#ifndef CSNIP_CONF__SUPPORT_THREADING
+	CHECK(err == csnip_err_UNSUPPORTED);
+	puts(" unsupported, OK");
+	return;
+#endif
+	CHECK(err == 0);
+	CHECK(time_coarse_start(500) == 0);
+	CHECK(time_coarse_start(0) == csnip_err_INVAL);
+
+	const int64_t t0 = time_coarse_now_ns(TIME_COARSE_MONOTONIC);
+	time_Sleep(0.02, _);
+	const int64_t t1 = time_coarse_now_ns(TIME_COARSE_MONOTONIC);
+	printf(" [advanced %.2f ms]", (t1 - t0) * 1e-6);
+	CHECK(t1 - t0 > 10000000);
+	check_agreement();
+
+	time_coarse_stop();
+	time_coarse_stop();
+	check_agreement();
+
+	/* Stopping does not wait out the refresh period */
+	CHECK(time_coarse_start(10000000) == 0);
+	const int64_t s0 = time_mono_ns();
+	time_coarse_stop();
+	const int64_t s1 = time_mono_ns();
+	printf(" [stop %.2f ms]", (s1 - s0) * 1e-6);
+	CHECK(s1 - s0 < 1000000000);
+	puts(" OK");
+}
+
+/* The logger renders timestamps from the coarse clock on request. */
+static void test_log(void)
+{
+	printf("Logger with coarse timestamps:");
+	FILE* fp = tmpfile();
+	CHECK(fp != NULL);
+	csnip_log_configuration cfg = {
+		.filter_expr = NULL,
+		.logfmt = { "{monotimenum} {msg}\n", NULL },
+		.out_fp = fp,
+		.coarse_time = 1,
+	};
+	CHECK(log_config(&cfg) == 0);
+	log_Mesg(LOG_PRIO_NOTICE, "hello");
+	fflush(fp);
+	rewind(fp);
+
+	double t;
+	char msg[16];
+	CHECK(fscanf(fp, "%lf %15s", &t, msg) == 2);
+	CHECK(strcmp(msg, "hello") == 0);
+	CHECK(fabs(t - precise(1)) < 0.05);
+	fclose(fp);
+	log_free();
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_fallback();
+	test_thread();
+	test_log();
+	return 0;
+}
@@ -0,0 +1,145 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/meanvar.h>
+#include <csnip/time.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+static volatile double sink;
+
+static void busy(int n)
+{
+	double s = 0;
+	for (int i = 0; i < n; ++i)
+		s += sqrt((double)i);
+	sink = s;
+}
+
+/* An explicit calibration before first use is kept:  the first query
+ * must not run the initial (5 ms) calibration over it.  Must run
+ * first.
+ */
+static void test_calibrate_first(void)
+{
+	printf("Calibration before first use:");
+	time_cycles_calibrate(0.02);
+	const int64_t t0 = time_mono_ns();
+	const double per_ns = time_cycles_per_ns();
+	const int64_t dt = time_mono_ns() - t0;
+	CHECK(per_ns > 0);
+	if (strcmp(time_cycles_source(), "clock_gettime") != 0)
+		CHECK(dt < 4000000);
+	CHECK(time_cycles_per_ns() == per_ns);
+	puts(" OK");
+}
+
+static void test_counter(void)
+{
+	printf("Counter source %s, invariant = %d:", time_cycles_source(),
+		time_cycles_invariant());
+	uint64_t prev = time_cycles();
+	for (int i = 0; i < 1000; ++i) {
+		const uint64_t c = time_cycles_fenced();
+		CHECK(c >= prev);
+		prev = c;
+	}
+	printf(" %.3f ticks/ns", time_cycles_per_ns());
+	CHECK(time_cycles_per_ns() > 0);
+	puts(" OK");
+}
+
+/* A 20 ms sleep must measure as at least 20 ms, and not too much
+ * more.
+ */
+static void test_sleep(void)
+{
+	printf("Timed sleep:");
+	const uint64_t c0 = time_cycles();
+	time_Sleep(0.02, _);
+	const double ns = time_cycles_to_ns(time_cycles_fenced() - c0);
+	printf(" %.2f ms", ns * 1e-6);
+	CHECK(ns >= 19.5e6 && ns < 500e6);
+
+	const double drift = time_cycles_drift_ppm();
+	printf(", drift %.1f ppm", drift);
+	if (time_cycles_invariant())
+		CHECK(fabs(drift) < 1e5);
+	puts(" OK");
+}
+
+static void test_stopwatch(void)
+{
+	printf("Stopwatch:");
+	time_stopwatch sw;
+	time_StopwatchStart(&sw);
+	busy(10000);
+	const double l1 = time_StopwatchLap(&sw);
+	busy(20000);
+	const double l2 = time_StopwatchLap(&sw);
+	const double total = time_StopwatchStop(&sw);
+	printf(" laps %.0f + %.0f ns, total %.0f ns", l1, l2, total);
+	CHECK(l1 > 0 && l2 > 0);
+	CHECK(total >= l1 + l2 - 1);
+	puts(" OK");
+}
+
+static void test_scoped(void)
+{
+	printf("Scoped timing:");
+	meanvar mv = { 0 };
+	time_histogram H = { { 0 } };
+	for (int i = 0; i < 100; ++i) {
+		time_ScopedMeanvar(&mv, busy(1000););
+		time_ScopedHistogram(&H, busy(1000););
+	}
+	CHECK(mv.count == 100);
+	CHECK(H.n == 100);
+	CHECK(meanvar_mean(&mv) > 0);
+
+	double last = 0;
+	int n = 0;
+	time_Scoped(ns, last = ns, busy(1000); ++n;);
+	CHECK(n == 1 && last > 0);
+	printf(" mean %.0f ns, median <= %.0f ns", meanvar_mean(&mv),
+		time_histogram_quantile(&H, 0.5));
+	puts(" OK");
+}
+
+static void test_histogram(void)
+{
+	printf("Histogram:");
+	time_histogram H = { { 0 } };
+	CHECK(time_histogram_quantile(&H, 0.5) == 0);
+	for (int i = 0; i < 90; ++i)
+		time_histogram_add(&H, 100);	/* bin [64, 128) */
+	for (int i = 0; i < 10; ++i)
+		time_histogram_add(&H, 5000);	/* bin [4096, 8192) */
+	time_histogram_add(&H, 0.5);
+	CHECK(H.count[0] == 1);
+	CHECK(time_histogram_quantile(&H, 0.5) == 128);
+	CHECK(time_histogram_quantile(&H, 0.95) == 8192);
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_calibrate_first();
+	test_counter();
+	test_sleep();
+	test_stopwatch();
+	test_scoped();
+	test_histogram();
+	return 0;
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/err.h>
+#include <csnip/time.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+/* The wakeup must never be early; the lateness is printed, but not
+ * checked, since test machines may be loaded.
+ */
+static void test_sleep_until(void)
+{
+	printf("Sleep until deadline:");
+	const int r = time_set_timer_slack(1000);
+	CHECK(r == 0 || r == csnip_err_UNSUPPORTED);
+	printf(" [spin window %.1f us]", time_sleep_spin(-1) * 1e-3);
+
+	int64_t worst = 0;
+	for (int i = 0; i < 20; ++i) {
+		const int64_t deadline = time_mono_ns() + 1000000;
+		CHECK(time_sleep_until_ns(deadline) == 0);
+		const int64_t late = time_mono_ns() - deadline;
+		CHECK(late >= 0);
+		if (late > worst)
+			worst = late;
+	}
+	printf(" [worst lateness %.1f us]", worst * 1e-3);
+
+	/* Deadlines in the past return immediately */
+	CHECK(time_sleep_until_ns(time_mono_ns() - 1000000) == 0);
+	struct timespec ts = { 0, 0 };
+	CHECK(time_sleep_until(ts) == 0);
+	puts(" OK");
+}
+
+/* The deadlines are start + k * period, exactly, even for periods
+ * that are not whole nanoseconds; k counts skipped deadlines too.
+ */
+static void test_pacer_drift(void)
+{
+	printf("Pacer without drift:");
+	time_pacer P;
+	CHECK(time_pacer_init(&P, 0.0) == csnip_err_INVAL);
+	CHECK(time_pacer_init(&P, 0.5e-9) == csnip_err_INVAL);
+	CHECK(time_pacer_init(&P, 1e-3 / 3) == 0);
+	const int64_t first = P.next;
+	const int64_t t0 = time_mono_ns();
+	for (int i = 0; i < 300; ++i)
+		CHECK(time_pacer_wait(&P) == 0);
+	const int64_t dt = time_mono_ns() - t0;
+	printf(" [300 ticks in %.3f ms, missed %llu]", dt * 1e-6,
+		(unsigned long long)P.missed);
+	CHECK(P.ticks == 300);
+	const int64_t n = (int64_t)(P.ticks + P.missed);
+	const int64_t span = P.next - first;
+	CHECK(llabs(3 * span - n * 1000000) <= 3);
+	puts(" OK");
+}
+
+static void test_pacer_skip(void)
+{
+	printf("Pacer skipping missed deadlines:");
+	time_pacer P;
+	CHECK(time_pacer_init(&P, 0.01) == 0);
+	const int64_t first = P.next;
+
+	/* Fall behind by 4.5 periods past the first deadline */
+	CHECK(time_sleep_until_ns(first + 45000000) == 0);
+	CHECK(time_pacer_wait(&P) == 0);
+	printf(" [missed %llu]", (unsigned long long)P.missed);
+	CHECK(P.missed >= 4);
+
+	/* The phase is kept */
+	CHECK((P.next - first) % 10000000 == 0);
+	const int64_t deadline = P.next;
+	CHECK(time_pacer_wait(&P) == 0);
+	CHECK(time_mono_ns() >= deadline);
+
+	/* Skip more than 2^32 periods of 1.75 ns, as after a stall of
+	 * some 10 s
+	 */
+	CHECK(time_pacer_init(&P, 1.75e-9) == 0);
+	P.next -= 21000000000;		/* 12e9 periods */
+	const int64_t start = P.next;
+	CHECK(time_pacer_wait(&P) == 0);
+	CHECK(P.missed >= 12000000000u);
+	const int64_t n = (int64_t)(P.ticks + P.missed);
+	CHECK(llabs(4 * (P.next - start) - 7 * n) <= 4);
+	CHECK(P.next <= time_mono_ns() + 4);
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_sleep_until();
+	test_pacer_drift();
+	test_pacer_skip();
+	return 0;
+}
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/err.h>
+#include <csnip/tokenize.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+/* Compare tokenize_find() against a naive search, for sets that
+ * take the different code paths.
+ */
+static void test_find(void)
+{
+	printf("Find:");
+	static const char* sets[] = {
+		",",			/* Compare */
+		",\t\n\r",		/* Compare */
+		" ,;:|\t\n",		/* Nibble lookup */
+		"\x01\x12\x23\x34\x45\x56\x67\x78\x89\x9a",  /* Scalar */
+		"\xff\x80",		/* High bytes */
+	};
+	static char buf[1000];
+	unsigned seed = 1;
+	for (size_t s = 0; s < sizeof sets / sizeof sets[0]; ++s) {
+		tokenize_set S;
+		tokenize_set_init(&S, sets[s]);
+		for (int c = 0; c < 256; ++c) {
+			CHECK(tokenize_set_has(&S, (unsigned char)c)
+				== (c != 0 && strchr(sets[s], c) != NULL));
+		}
+		for (int rep = 0; rep < 200; ++rep) {
+			/* Sparse delimiters at random positions */
+			const size_t len = (size_t)(rep * 5);
+			for (size_t i = 0; i < len; ++i) {
+				seed = seed * 1103515245u + 12345u;
+				buf[i] = (char)('a' + (seed >> 16) % 26);
+				if ((seed >> 8) % 97 == 0) {
+					const size_t n = strlen(sets[s]);
+					buf[i] = sets[s][(seed >> 20) % n];
+				}
+			}
+			for (size_t off = 0; off < len; off += 7) {
+				size_t expect = off;
+				while (expect < len
+				  && !tokenize_set_has(&S,
+					(unsigned char)buf[expect]))
+				{
+					++expect;
+				}
+				CHECK(off + tokenize_find(&S, buf + off,
+						len - off) == expect);
+			}
+		}
+	}
+
+	tokenize_set E;
+	tokenize_set_init(&E, "");
+	CHECK(tokenize_find(&E, "a\0b", 3) == 3);
+	puts(" OK");
+}
+
+static void test_strtok(void)
+{
+	printf("Strtok:");
+	char s[] = "  alpha, beta;;gamma  ";
+	tokenize_set S;
+	tokenize_set_init(&S, " ,;");
+	char* save;
+	CHECK(strcmp(tokenize_strtok(s, &S, &save), "alpha") == 0);
+	CHECK(strcmp(tokenize_strtok(NULL, &S, &save), "beta") == 0);
+	CHECK(strcmp(tokenize_strtok(NULL, &S, &save), "gamma") == 0);
+	CHECK(tokenize_strtok(NULL, &S, &save) == NULL);
+	CHECK(tokenize_strtok(NULL, &S, &save) == NULL);
+	puts(" OK");
+}
+
+static void test_split(void)
+{
+	printf("Split:");
+	tokenize_set S;
+	tokenize_set_init(&S, "\t");
+	const char line[] = "a\tbb\t\tlast field with spaces";
+	tokenize_span f[8];
+	CHECK(tokenize_split(&S, line, strlen(line), f, 8) == 4);
+	CHECK(f[0].len == 1 && f[0].ptr == line);
+	CHECK(f[1].len == 2 && memcmp(f[1].ptr, "bb", 2) == 0);
+	CHECK(f[2].len == 0);
+	CHECK(f[3].len == 22);
+
+	/* More fields than room */
+	CHECK(tokenize_split(&S, "1\t2\t3\t4\t5", 9, f, 2) == 5);
+	CHECK(f[1].len == 1 && f[1].ptr[0] == '2');
+	CHECK(tokenize_split(&S, "", 0, f, 8) == 1 && f[0].len == 0);
+	CHECK(tokenize_split(&S, "x\t", 2, f, 8) == 2 && f[1].len == 0);
+	puts(" OK");
+}
+
+static int field_is(const tokenize_span* f, const char* s)
+{
+	return f->len == strlen(s) && memcmp(f->ptr, s, f->len) == 0;
+}
+
+static void test_csv(void)
+{
+	printf("CSV:");
+	tokenize_csv C;
+	tokenize_csv_init(&C, ',', '"');
+	char buf[] = "plain,\"quoted, with comma\",\"say \"\"hi\"\"\"\r\n"
+		"\"multi\nline\",,end\n"
+		"a\"b,\"x\"y\n"
+		"last";
+	const size_t len = strlen(buf);
+	tokenize_span f[8];
+	size_t nf, used, pos = 0;
+
+	CHECK(tokenize_csv_record(&C, buf, len, f, 8, &nf, &used) == 0);
+	CHECK(nf == 3);
+	CHECK(field_is(&f[0], "plain"));
+	CHECK(field_is(&f[1], "quoted, with comma"));
+	CHECK(field_is(&f[2], "say \"hi\""));
+	pos += used;
+	CHECK(buf[pos] == '"');
+
+	CHECK(tokenize_csv_record(&C, buf + pos, len - pos, f, 8, &nf,
+		&used) == 0);
+	CHECK(nf == 3);
+	CHECK(field_is(&f[0], "multi\nline"));
+	CHECK(field_is(&f[1], ""));
+	CHECK(field_is(&f[2], "end"));
+	pos += used;
+
+	/* Stray quotes are kept */
+	CHECK(tokenize_csv_record(&C, buf + pos, len - pos, f, 8, &nf,
+		&used) == 0);
+	CHECK(nf == 2);
+	CHECK(field_is(&f[0], "a\"b"));
+	CHECK(field_is(&f[1], "xy"));
+	pos += used;
+
+	CHECK(tokenize_csv_record(&C, buf + pos, len - pos, f, 8, &nf,
+		&used) == 0);
+	CHECK(nf == 1 && field_is(&f[0], "last"));
+	CHECK(pos + used == len);
+
+	char bad[] = "a,\"unterminated\n";
+	CHECK(tokenize_csv_record(&C, bad, strlen(bad), f, 8, &nf, &used)
+		== csnip_err_FORMAT);
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_find();
+	test_strtok();
+	test_split();
+	test_csv();
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/csnip_conf.h>
+#include <csnip/err.h>
+#include <csnip/trace.h>
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+#include <pthread.h>
+#endif
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+static char dump[1 << 16];
+
+/* Dump the trace into the dump buffer */
+static void get_dump(void)
+{
+	FILE* fp = tmpfile();
+	CHECK(fp != NULL);
+	CHECK(trace_dump(fp) == 0);
+	rewind(fp);
+	const size_t n = fread(dump, 1, sizeof(dump) - 1, fp);
+	dump[n] = '\0';
+	fclose(fp);
+	CHECK(strncmp(dump, "{\"traceEvents\": [", 17) == 0);
+	CHECK(strstr(dump, "\"displayTimeUnit\": \"ns\"") != NULL);
+}
+
+static int count(const char* s)
+{
+	int n = 0;
+	for (const char* p = dump; (p = strstr(p, s)) != NULL; ++p)
+		++n;
+	return n;
+}
+
+static void traced(void)
+{
+	CSNIP_TRACE_SCOPE("traced");
+	CSNIP_TRACE_INSTANT("inside");
+}
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+static void* worker(void* arg)
+{
+	(void)arg;
+	trace_thread_name("worker");
+	CSNIP_TRACE_INSTANT("in worker");
+	return NULL;
+}
+#endif
+
+int main(void)
+{
+	printf("Disabled:");
+	CHECK(trace_enable(0) == csnip_err_INVAL);
+	CSNIP_TRACE_INSTANT("nothing");
+	get_dump();
+	CHECK(strstr(dump, "nothing") == NULL);
+	CHECK(count("\"ph\"") == 0);
+	puts(" OK");
+
+	printf("Events:");
+	CHECK(trace_enable(8) == 0);
+	trace_thread_name("main \"thread\"");
+	CSNIP_TRACE_BEGIN("span");
+	CSNIP_TRACE_END("span");
+	CSNIP_TRACE_COUNTER("count", 42);
+	traced();
+	get_dump();
+	CHECK(strstr(dump, "\"args\": {\"name\": \"main \\\"thread\\\"\"}")
+		!= NULL);
+	CHECK(count("\"ph\": \"B\"") == 1);
+	CHECK(count("\"ph\": \"E\"") == 1);
+	CHECK(strstr(dump, "\"name\": \"count\", \"ph\": \"C\"") != NULL);
+	CHECK(strstr(dump, "\"args\": {\"value\": 42}") != NULL);
+	CHECK(strstr(dump, "\"name\": \"inside\", \"ph\": \"i\"") != NULL);
+	CHECK(strstr(dump, "\"name\": \"traced\", \"ph\": \"X\"") != NULL);
+	CHECK(count("\"dur\": ") == 1);
+
+	/* The events were consumed */
+	get_dump();
+	CHECK(count("\"ph\": \"M\"") == 1);
+	CHECK(count("\"ph\"") == 1);
+	puts(" OK");
+
+	printf("Overwrite:");
+	for (int i = 0; i < 20; ++i)
+		CSNIP_TRACE_COUNTER("c", i);
+	get_dump();
+	CHECK(count("\"ph\": \"C\"") == 8);
+	CHECK(strstr(dump, "{\"value\": 11}") == NULL);
+	CHECK(strstr(dump, "{\"value\": 12}") != NULL);
+	CHECK(strstr(dump, "{\"value\": 19}") != NULL);
+	puts(" OK");
+
+#ifdef CSNIP_CONF__SUPPORT_THREADING
+	printf("Threads:");
+	pthread_t t;
+	CHECK(pthread_create(&t, NULL, worker, NULL) == 0);
+	CHECK(pthread_join(t, NULL) == 0);
+	get_dump();
+	CHECK(strstr(dump, "\"args\": {\"name\": \"worker\"}") != NULL);
+	CHECK(strstr(dump, "in worker") != NULL);
+
+	/* The exited thread is gone after its events were dumped */
+	get_dump();
+	CHECK(strstr(dump, "worker") == NULL);
+	puts(" OK");
+#endif
+
+	printf("Disable:");
+	trace_disable();
+	CSNIP_TRACE_INSTANT("off");
+	traced();
+	get_dump();
+	CHECK(count("\"ph\"") == 1);
+	puts(" OK");
+
+	return 0;
+}
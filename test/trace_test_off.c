@@ -0,0 +1,44 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CSNIP_TRACE_LEVEL 0
+#define CSNIP_SHORT_NAMES
+#include <csnip/trace.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+int main(void)
+{
+	printf("Compiled out:");
+	CHECK(trace_enable(16) == 0);
+
+	/* Nothing is recorded, and the arguments are not evaluated */
+	int n = 0;
+	CSNIP_TRACE_SCOPE("scope");
+	CSNIP_TRACE_BEGIN("span");
+	CSNIP_TRACE_END("span");
+	CSNIP_TRACE_INSTANT("instant");
+	CSNIP_TRACE_COUNTER("count", ++n);
+	CHECK(n == 0);
+
+	char buf[1024];
+	FILE* fp = tmpfile();
+	CHECK(fp != NULL);
+	CHECK(trace_dump(fp) == 0);
+	rewind(fp);
+	const size_t len = fread(buf, 1, sizeof(buf) - 1, fp);
+	buf[len] = '\0';
+	fclose(fp);
+	CHECK(strstr(buf, "\"ph\"") == NULL);
+	puts(" OK");
+
+	return 0;
+}
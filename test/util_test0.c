@@ -51,11 +51,24 @@ void test_container_of(void)
 	CHECK(Container_of(&c.u, struct X, u) == &c);
 }
 
+void test_mul64x64(void)
+{
+	uint64_t lo;
+	CHECK(mul64x64(0, UINT64_MAX, &lo) == 0 && lo == 0);
+	CHECK(mul64x64((uint64_t)1 << 32, (uint64_t)1 << 32, &lo) == 1
+		&& lo == 0);
+	CHECK(mul64x64(UINT64_MAX, UINT64_MAX, &lo) == UINT64_MAX - 1
+		&& lo == 1);
+	CHECK(mul64x64(0x123456789abcdef0, 0xfedcba9876543210, &lo)
+		== 0x121fa00ad77d7422 && lo == 0x236d88fe5618cf00);
+}
+
 int main(void)
 {
 	test_min();
 	test_max();
 	test_clamp();
 	test_container_of();
+	test_mul64x64();
 	return 0;
 }
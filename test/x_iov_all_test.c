@@ -0,0 +1,159 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define CSNIP_SHORT_NAMES
+#include <csnip/x.h>
+
+#define CHECK(x) \
+	do { \
+		if (!(x)) { \
+			printf(" FAIL\n"); \
+			fprintf(stderr, "check \"%s\" failed\n", #x); \
+			exit(1); \
+		} \
+	} while (0)
+
+enum { NBLK = 3000, BLKMAX = 700 };
+
+static char src[NBLK * BLKMAX];
+static char dst[NBLK * BLKMAX];
+
+/* Split buf into NBLK blocks of pseudo-random size. */
+static size_t make_iov(struct x_iovec* iov, char* buf, unsigned seed)
+{
+	size_t pos = 0;
+	for (int i = 0; i < NBLK; ++i) {
+		seed = seed * 1103515245u + 12345u;
+		const size_t len = (seed >> 16) % BLKMAX;
+		iov[i].iov_base = buf + pos;
+		iov[i].iov_len = len;
+		pos += len;
+	}
+	return pos;
+}
+
+static void set_nonblock(int fd)
+{
+	const int fl = fcntl(fd, F_GETFL);
+	CHECK(fl >= 0 && fcntl(fd, F_SETFL, fl | O_NONBLOCK) == 0);
+}
+
+/* Transfer more blocks than IOV_MAX through a non-blocking socket, with
+ * differently split iovec arrays on both ends.
+ */
+static void test_transfer(void)
+{
+	printf("Full transfer:");
+	static struct x_iovec wiov[NBLK], riov[NBLK];
+	for (size_t i = 0; i < sizeof src; ++i)
+		src[i] = (char)(i * 7 + i / 251);
+	const size_t wlen = make_iov(wiov, src, 1);
+
+	int s[2];
+	CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, s) == 0);
+	const pid_t pid = fork();
+	CHECK(pid >= 0);
+	if (pid == 0) {
+		close(s[0]);
+		set_nonblock(s[1]);
+		const x_ssize_t w = x_writev_all(s[1], wiov, NBLK, -1);
+		_exit(w == (x_ssize_t)wlen ? 0 : 1);
+	}
+	close(s[1]);
+
+	/* Read into a layout with a different split; make it longer
+	 * than the data, so that the read ends at EOF.
+	 */
+	size_t rlen = make_iov(riov, dst, 2);
+	CHECK(rlen > wlen);
+	const x_ssize_t r = x_readv_all(s[0], riov, NBLK, -1);
+	int status;
+	CHECK(waitpid(pid, &status, 0) == pid);
+	CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	printf(" [%zu bytes]", wlen);
+	CHECK(r == (x_ssize_t)wlen);
+	CHECK(memcmp(src, dst, wlen) == 0);
+
+	/* The read iovec array was advanced to the unfilled rest */
+	size_t rest = 0;
+	for (int i = 0; i < NBLK; ++i)
+		rest += riov[i].iov_len;
+	CHECK(rest == rlen - wlen);
+	close(s[0]);
+	puts(" OK");
+}
+
+/* Writes into a socket nobody reads from stall. */
+static void test_stall(void)
+{
+	printf("Stalled writes:");
+	static struct x_iovec iov[NBLK];
+	int s[2];
+	CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, s) == 0);
+	set_nonblock(s[0]);
+
+	const size_t len = make_iov(iov, src, 3);
+	errno = 0;
+	CHECK(x_writev_all(s[0], iov, NBLK, 0) == -1);
+	CHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+
+	/* Partial progress shows in the array */
+	size_t rest = 0;
+	for (int i = 0; i < NBLK; ++i)
+		rest += iov[i].iov_len;
+	CHECK(rest > 0 && rest < len);
+
+	CHECK(x_writev_all(s[0], iov, NBLK, 20) == -1);
+	CHECK(errno == ETIMEDOUT);
+	close(s[0]);
+	close(s[1]);
+	puts(" OK");
+}
+
+/* The fallback implementations transfer at least part of the data
+ * with a single call, and all of it if small.
+ */
+static void test_fallback(void)
+{
+	printf("Fallback readv / writev:");
+	int p[2];
+	CHECK(pipe(p) == 0);
+	char a[] = "Hello, ", b[] = "scattered ", c[] = "world";
+	struct x_iovec w[] = {
+		{ a, 7 }, { NULL, 0 }, { b, 10 }, { c, 5 },
+	};
+	CHECK(x_writev_imp(p[1], w, 4) == 22);
+
+	char r1[3], r2[30];
+	struct x_iovec r[] = { { r1, 3 }, { r2, 30 } };
+	CHECK(x_readv_imp(p[0], r, 2) == 22);
+	CHECK(memcmp(r1, "Hel", 3) == 0);
+	CHECK(memcmp(r2, "lo, scattered world", 19) == 0);
+
+	/* Large first block: a direct, possibly short, transfer */
+	static struct x_iovec big[2];
+	big[0].iov_base = src;
+	big[0].iov_len = 10000;
+	big[1].iov_base = src;
+	big[1].iov_len = 10;
+	set_nonblock(p[1]);
+	const x_ssize_t n = x_writev_imp(p[1], big, 2);
+	CHECK(n > 0 && n <= 10000);
+	close(p[0]);
+	close(p[1]);
+	puts(" OK");
+}
+
+int main(void)
+{
+	test_transfer();
+	test_stall();
+	test_fallback();
+	return 0;
+}